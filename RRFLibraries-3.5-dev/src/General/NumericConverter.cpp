@@ -316,7 +316,7 @@ uint32_t NumericConverter::GetUint32() const noexcept
 // This macro lets us use a double precision constant, by declaring it as a long double one and then casting it to double.
 #define DOUBLE(_x) ((double)( _x ## L ))
 
-static constexpr double PowersOfTen[] =
+const double NumericConverter::PowersOfTen[NumPowersOfTen] =
 {
 	DOUBLE(1.0),
 	DOUBLE(10.0),
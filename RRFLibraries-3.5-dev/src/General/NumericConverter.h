@@ -9,6 +9,7 @@
 #define SRC_GENERAL_NUMERICCONVERTER_H_
 
 #include <cstdint>
+#include <cstddef>
 #include "function_ref.h"
 
 // Class to read fixed and floating point numbers
@@ -24,6 +25,9 @@ public:
 	static constexpr OptionsType DefaultHex = 0x08;									// always interpret the number as in hex. Not compatible with AcceptFloat.
 	static constexpr OptionsType AcceptSignedFloat = AcceptNegative | AcceptFloat;
 
+	static constexpr size_t NumPowersOfTen = 11;
+	static const double PowersOfTen[NumPowersOfTen];								// 1.0 to 1.0e10 in double precision, also used by SafeStrtof
+
 	NumericConverter() noexcept {}
 	bool Accumulate(char c, OptionsType options, function_ref_noexcept<char() noexcept> NextChar) noexcept;
 	bool FitsInInt32() const noexcept;
@@ -34,8 +34,78 @@ constexpr int32_t Int32Min = std::numeric_limits<int32_t>::min();
 
 #include "NumericConverter.h"
 
+// Fast path for the usual format of numbers in GCode: an optional sign, then up to 9 significant digits with an optional decimal point and at most 10 digits after it, and no exponent.
+// For such numbers this does the same calculation as NumericConverter::GetFloat, so the result is identical to the one we get from the general code.
+// If the number is in that format, return true with the result in 'rslt' and 's' advanced past the number; else return false.
+static bool FastStrtof(const char *_ecv_array& s, float& rslt) noexcept
+{
+	const char *_ecv_array p = s;
+	const bool isNegative = (*p == '-');
+	if (isNegative || *p == '+')
+	{
+		++p;
+	}
+
+	uint32_t value = 0;
+	unsigned int significantDigits = 0, digitsAfterPoint = 0;
+	bool hadDigit = false, hadDecimalPoint = false;
+	for (;; ++p)
+	{
+		const char c = *p;
+		if (c >= '0' && c <= '9')
+		{
+			hadDigit = true;
+			if (value != 0 || c != '0')
+			{
+				if (significantDigits == 9)
+				{
+					return false;
+				}
+				++significantDigits;
+				value = (value * 10u) + (unsigned int)(c - '0');
+			}
+			if (hadDecimalPoint)
+			{
+				++digitsAfterPoint;
+			}
+		}
+		else if (c == '.' && !hadDecimalPoint)
+		{
+			hadDecimalPoint = true;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	if (!hadDigit || *p == 'e' || *p == 'E' || digitsAfterPoint >= NumericConverter::NumPowersOfTen)
+	{
+		return false;
+	}
+
+	double dvalue = (double)value;
+	if (digitsAfterPoint != 0 && value != 0)
+	{
+		dvalue /= NumericConverter::PowersOfTen[digitsAfterPoint];
+	}
+	rslt = (isNegative) ? -(float)dvalue : (float)dvalue;
+	s = p;
+	return true;
+}
+
 float SafeStrtof(const char *_ecv_array s, const char *_ecv_array *null endptr) noexcept
 {
+	float rslt;
+	if (FastStrtof(s, rslt))
+	{
+		if (endptr != nullptr)
+		{
+			*not_null(endptr) = s;
+		}
+		return rslt;
+	}
+
 	// Save the end pointer in case of failure
 	if (endptr != nullptr)
 	{
@@ -0,0 +1,144 @@
+/*
+ * CRC32Test.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Test of the software CRC32 algorithms. We build CRC32.cpp three times with 1, 4 and 8 lookup tables and check each one against a bitwise CRC,
+ * using every start alignment and short length so that the byte loops before and after the sliced loop are all exercised, and then random buffers.
+ */
+
+#include "TestHarness.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// Stop CRC32.h including the firmware headers, and select the software algorithm
+#define REPRAPFIRMWARE_H
+#define SAM4E	0
+#define SAME5x	0
+#define SAME70	0
+
+namespace Tables1
+{
+#define CRC32_SOFTWARE_TABLES	1
+#include <Storage/CRC32.cpp>
+}
+
+#undef CRC32_H
+#undef USE_SAME5x_HARDWARE_CRC
+#undef CRC32_SOFTWARE_TABLES
+
+namespace Tables4
+{
+#define CRC32_SOFTWARE_TABLES	4
+#include <Storage/CRC32.cpp>
+}
+
+#undef CRC32_H
+#undef USE_SAME5x_HARDWARE_CRC
+#undef CRC32_SOFTWARE_TABLES
+
+namespace Tables8
+{
+#define CRC32_SOFTWARE_TABLES	8
+#include <Storage/CRC32.cpp>
+}
+
+// Bitwise CRC32 with the reflected polynomial, the same as zlib
+static uint32_t ReferenceCrc(const char *s, size_t len) noexcept
+{
+	uint32_t crc = 0xFFFFFFFF;
+	while (len-- != 0)
+	{
+		crc ^= (uint8_t)*s++;
+		for (unsigned int i = 0; i < 8; ++i)
+		{
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+		}
+	}
+	return ~crc;
+}
+
+template<class C> static uint32_t BlockCrc(const char *s, size_t len) noexcept
+{
+	C crc;
+	crc.Update(s, len);
+	return crc.Get();
+}
+
+template<class C> static uint32_t ByteCrc(const char *s, size_t len) noexcept
+{
+	C crc;
+	while (len-- != 0)
+	{
+		crc.Update(*s++);
+	}
+	return crc.Get();
+}
+
+// Check all three variants against the reference CRC, both with one call and split into two calls at the given point
+static void CheckAll(const char *s, size_t len, size_t split) noexcept
+{
+	const uint32_t expected = ReferenceCrc(s, len);
+	CHECK_MSG(BlockCrc<Tables1::CRC32>(s, len) == expected, "1 table, offset %u length %u", (unsigned int)((uintptr_t)s & 7), (unsigned int)len);
+	CHECK_MSG(BlockCrc<Tables4::CRC32>(s, len) == expected, "4 tables, offset %u length %u", (unsigned int)((uintptr_t)s & 7), (unsigned int)len);
+	CHECK_MSG(BlockCrc<Tables8::CRC32>(s, len) == expected, "8 tables, offset %u length %u", (unsigned int)((uintptr_t)s & 7), (unsigned int)len);
+	CHECK(ByteCrc<Tables8::CRC32>(s, len) == expected);
+
+	Tables8::CRC32 crc;
+	crc.Update(s, split);
+	crc.Update(s + split, len - split);
+	CHECK_MSG(crc.Get() == expected, "8 tables split at %u, length %u", (unsigned int)split, (unsigned int)len);
+}
+
+static void KnownValueTest() noexcept
+{
+	static const char CheckString[] = "123456789";
+	CHECK(ReferenceCrc(CheckString, 9) == 0xCBF43926);
+	CheckAll(CheckString, 9, 4);
+	CheckAll(CheckString, 0, 0);
+}
+
+static void AlignmentTest(TestRandom& rng) noexcept
+{
+	alignas(8) char buffer[256 + 8];
+	for (char& c : buffer)
+	{
+		c = (char)rng.Next();
+	}
+	for (size_t offset = 0; offset < 8; ++offset)
+	{
+		for (size_t len = 0; len <= 256; ++len)
+		{
+			CheckAll(buffer + offset, len, len/3);
+		}
+	}
+}
+
+static void RandomTest(TestRandom& rng) noexcept
+{
+	std::vector<char> buffer(8192 + 8);
+	for (unsigned int i = 0; i < 2000; ++i)
+	{
+		const size_t len = rng.Next() % 8193;
+		const size_t offset = rng.Next() % 8;
+		for (size_t j = 0; j < len; ++j)
+		{
+			buffer[offset + j] = (char)rng.Next();
+		}
+		CheckAll(buffer.data() + offset, len, (len == 0) ? 0 : rng.Next() % len);
+	}
+}
+
+int main()
+{
+	TestRandom rng(4321);
+	KnownValueTest();
+	AlignmentTest(rng);
+	RandomTest(rng);
+	return TestResult("CRC32Test");
+}
+
+// End
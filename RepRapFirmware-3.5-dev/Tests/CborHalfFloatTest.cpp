@@ -0,0 +1,151 @@
+/*
+ * CborHalfFloatTest.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Test of the conversion of floats to half precision that the CBOR encoder uses. Every half precision value must convert back to itself,
+ * and a float must be reported as exactly representable if and only if it is equal to one of those values.
+ */
+
+#include "TestHarness.h"
+#include <ObjectModel/HalfFloat.h>
+#include <unordered_set>
+#include <cmath>
+#include <limits>
+
+// Reference conversion from half precision to float, written from the IEEE 754 definition
+static float HalfToFloat(uint16_t half) noexcept
+{
+	const int exponent = (half >> 10) & 0x1F;
+	const unsigned int mantissa = half & 0x03FF;
+	float val;
+	if (exponent == 0)
+	{
+		val = std::ldexp((float)mantissa, -24);
+	}
+	else if (exponent == 31)
+	{
+		val = (mantissa == 0) ? std::numeric_limits<float>::infinity() : std::numeric_limits<float>::quiet_NaN();
+	}
+	else
+	{
+		val = std::ldexp((float)(mantissa | 0x0400), exponent - 25);
+	}
+	return (half & 0x8000) ? -val : val;
+}
+
+static uint32_t FloatBits(float f) noexcept
+{
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+static float BitsToFloat(uint32_t bits) noexcept
+{
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+static bool IsHalfNaN(uint16_t half) noexcept
+{
+	return (half & 0x7C00) == 0x7C00 && (half & 0x03FF) != 0;
+}
+
+// Every half precision value must survive the round trip through float
+static void AllHalvesTest(std::unordered_set<uint32_t>& exactFloats) noexcept
+{
+	for (uint32_t h = 0; h < 0x10000; ++h)
+	{
+		const float f = HalfToFloat((uint16_t)h);
+		uint16_t half = 0;
+		const bool exact = FloatToHalf(f, half);
+		CHECK_MSG(exact, "half %04x", (unsigned int)h);
+		if (IsHalfNaN((uint16_t)h))
+		{
+			CHECK_MSG(IsHalfNaN(half) && (half & 0x8000) == (h & 0x8000), "half %04x gave %04x", (unsigned int)h, (unsigned int)half);
+		}
+		else
+		{
+			CHECK_MSG(half == h, "half %04x gave %04x", (unsigned int)h, (unsigned int)half);
+			exactFloats.insert(FloatBits(f));
+		}
+	}
+}
+
+// Random floats, with extra weight on the exponents near the half precision range, must be reported exact only if they are half precision values
+static void RandomFloatTest(TestRandom& rng, const std::unordered_set<uint32_t>& exactFloats) noexcept
+{
+	for (unsigned int i = 0; i < 2000000; ++i)
+	{
+		uint32_t bits = rng.Next();
+		if ((i & 1) != 0)
+		{
+			// Put the exponent in the range -30 to +20 and clear a random number of low mantissa bits, so that some of these are exact
+			const uint32_t exponent = 97 + rng.Next() % 51;
+			const unsigned int clearBits = rng.Next() % 24;
+			bits = (bits & 0x807FFFFF & ~((1u << clearBits) - 1)) | (exponent << 23);
+		}
+		const float f = BitsToFloat(bits);
+		if (std::isnan(f))
+		{
+			continue;
+		}
+		uint16_t half = 0;
+		const bool exact = FloatToHalf(f, half);
+		const bool expected = exactFloats.count(bits) != 0;
+		CHECK_MSG(exact == expected, "float %08x exact %d", (unsigned int)bits, (int)exact);
+		if (exact && expected)
+		{
+			CHECK_MSG(FloatBits(HalfToFloat(half)) == bits, "float %08x gave half %04x", (unsigned int)bits, (unsigned int)half);
+		}
+	}
+}
+
+// The half and single precision examples from RFC 8949 Appendix A
+static void RfcExamplesTest() noexcept
+{
+	struct Example { float val; bool exact; uint16_t half; };
+	static const Example examples[] =
+	{
+		{ 0.0f, true, 0x0000 },
+		{ -0.0f, true, 0x8000 },
+		{ 1.0f, true, 0x3C00 },
+		{ 1.5f, true, 0x3E00 },
+		{ 65504.0f, true, 0x7BFF },
+		{ 5.960464477539063e-8f, true, 0x0001 },
+		{ 0.00006103515625f, true, 0x0400 },
+		{ -4.0f, true, 0xC400 },
+		{ std::numeric_limits<float>::infinity(), true, 0x7C00 },
+		{ -std::numeric_limits<float>::infinity(), true, 0xFC00 },
+		{ std::numeric_limits<float>::quiet_NaN(), true, 0x7E00 },
+		{ 100000.0f, false, 0 },
+		{ 3.4028234663852886e+38f, false, 0 },
+		{ 1.1f, false, 0 },
+		{ 65520.0f, false, 0 },
+		{ 2.9802322387695312e-8f, false, 0 },
+	};
+
+	for (const Example& ex : examples)
+	{
+		uint16_t half = 0;
+		const bool exact = FloatToHalf(ex.val, half);
+		CHECK_MSG(exact == ex.exact, "%g", (double)ex.val);
+		if (ex.exact)
+		{
+			CHECK_MSG(half == ex.half, "%g gave %04x", (double)ex.val, (unsigned int)half);
+		}
+	}
+}
+
+int main()
+{
+	std::unordered_set<uint32_t> exactFloats;
+	TestRandom rng(1357);
+	RfcExamplesTest();
+	AllHalvesTest(exactFloats);
+	RandomFloatTest(rng, exactFloats);
+	return TestResult("CborHalfFloatTest");
+}
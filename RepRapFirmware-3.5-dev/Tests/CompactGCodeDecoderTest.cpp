@@ -0,0 +1,390 @@
+/*
+ * CompactGCodeDecoderTest.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Round trip test of the compact GCode block decoder. We encode random moves and other text into blocks the same way as Tools/CompactGCode/cgcode.py,
+ * decode them and check that we get the original text back. Then we check that blocks with out of range values or bad lengths are rejected,
+ * and that random data never makes the decoder write past the end of the text buffer.
+ */
+
+#include "TestHarness.h"
+#include <Storage/CompactGCodeDecoder.h>
+#include <vector>
+#include <string>
+#include <cstring>
+
+typedef CompactGCodeDecoder Decoder;
+
+static constexpr uint8_t MoveRecordFlag = 0x80, G0Flag = 0x20, FFirstFlag = 0x40;
+static constexpr unsigned int FField = 4;
+static const char FieldLetters[] = "XYZEF";
+
+static void PutVarint(std::vector<uint8_t>& out, uint64_t value) noexcept
+{
+	while (value >= 0x80)
+	{
+		out.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+}
+
+static uint64_t ZigZag(int64_t value) noexcept
+{
+	return (value >= 0) ? (uint64_t)value << 1 : (((uint64_t)-value) << 1) - 1;
+}
+
+// Format a quantised value the same way as format_number in cgcode.py
+static std::string FormatNumber(int64_t value, unsigned int decimals) noexcept
+{
+	const bool negative = (value < 0);
+	uint64_t magnitude = (negative) ? -(uint64_t)value : (uint64_t)value;
+	uint64_t scale = 1;
+	for (unsigned int i = 0; i < decimals; ++i)
+	{
+		scale *= 10;
+	}
+	std::string s = std::to_string(magnitude/scale);
+	if (decimals != 0)
+	{
+		std::string frac = std::to_string(magnitude % scale);
+		frac.insert(0, decimals - frac.size(), '0');
+		while (!frac.empty() && frac.back() == '0')
+		{
+			frac.pop_back();
+		}
+		if (!frac.empty())
+		{
+			s += "." + frac;
+		}
+	}
+	return (negative) ? "-" + s : s;
+}
+
+struct Block
+{
+	std::vector<uint8_t> encoded;
+	std::string text;
+};
+
+// Encoder that splits the text into blocks by the same rules as the Encoder class in cgcode.py
+class Encoder
+{
+public:
+	explicit Encoder(const uint8_t *p_decimals) noexcept : decimals(p_decimals) { StartBlock(); }
+
+	void AddText(std::string data) noexcept
+	{
+		while (!data.empty())
+		{
+			size_t n = std::min(data.size(), Decoder::MaxBlockTextLength - current.text.size());
+			while (n > 0 && current.encoded.size() + VerbatimRecordLength(verbatim.size() + n) > Decoder::MaxBlockEncodedLength)
+			{
+				--n;
+			}
+			if (n == 0)
+			{
+				FinishBlock();
+				continue;
+			}
+			verbatim += data.substr(0, n);
+			current.text += data.substr(0, n);
+			data.erase(0, n);
+		}
+	}
+
+	// Add a move with the specified values, of which only the fields in 'fieldMask' are present
+	void AddMove(bool isG0, bool fFirst, unsigned int fieldMask, const int64_t newValues[Decoder::NumFields]) noexcept
+	{
+		std::string line = (isG0) ? "G0" : "G1";
+		for (unsigned int n = 0; n < Decoder::NumFields; ++n)
+		{
+			const unsigned int field = (!fFirst) ? n : (n == 0) ? FField : n - 1;
+			if (fieldMask & (1u << field))
+			{
+				line += ' ';
+				line += FieldLetters[field];
+				line += FormatNumber(newValues[field], decimals[field]);
+			}
+		}
+		line += '\n';
+
+		std::vector<uint8_t> record = MoveRecord(isG0, fFirst, fieldMask, newValues);
+		if (   current.text.size() + line.size() > Decoder::MaxBlockTextLength
+			|| EncodedLength() + record.size() > Decoder::MaxBlockEncodedLength
+		   )
+		{
+			FinishBlock();
+			record = MoveRecord(isG0, fFirst, fieldMask, newValues);
+		}
+		FlushVerbatim();
+		current.encoded.insert(current.encoded.end(), record.begin(), record.end());
+		for (unsigned int field = 0; field < Decoder::NumFields; ++field)
+		{
+			if (fieldMask & (1u << field))
+			{
+				values[field] = newValues[field];
+			}
+		}
+		current.text += line;
+	}
+
+	const std::vector<Block>& Finish() noexcept
+	{
+		FinishBlock();
+		return blocks;
+	}
+
+private:
+	void StartBlock() noexcept
+	{
+		current = Block();
+		verbatim.clear();
+		for (int64_t& v : values)
+		{
+			v = 0;
+		}
+	}
+
+	static size_t VerbatimRecordLength(size_t n) noexcept
+	{
+		std::vector<uint8_t> v;
+		PutVarint(v, n);
+		return (n == 0) ? 0 : 1 + v.size() + n;
+	}
+
+	size_t EncodedLength() const noexcept { return current.encoded.size() + VerbatimRecordLength(verbatim.size()); }
+
+	void FlushVerbatim() noexcept
+	{
+		if (!verbatim.empty())
+		{
+			current.encoded.push_back(0);
+			PutVarint(current.encoded, verbatim.size());
+			current.encoded.insert(current.encoded.end(), verbatim.begin(), verbatim.end());
+			verbatim.clear();
+		}
+	}
+
+	void FinishBlock() noexcept
+	{
+		FlushVerbatim();
+		if (!current.text.empty())
+		{
+			blocks.push_back(current);
+		}
+		StartBlock();
+	}
+
+	std::vector<uint8_t> MoveRecord(bool isG0, bool fFirst, unsigned int fieldMask, const int64_t newValues[Decoder::NumFields]) const noexcept
+	{
+		std::vector<uint8_t> record;
+		record.push_back(MoveRecordFlag | ((isG0) ? G0Flag : 0) | ((fFirst) ? FFirstFlag : 0) | fieldMask);
+		for (unsigned int n = 0; n < Decoder::NumFields; ++n)
+		{
+			const unsigned int field = (!fFirst) ? n : (n == 0) ? FField : n - 1;
+			if (fieldMask & (1u << field))
+			{
+				PutVarint(record, ZigZag(newValues[field] - values[field]));
+			}
+		}
+		return record;
+	}
+
+	const uint8_t *decimals;
+	std::vector<Block> blocks;
+	Block current;
+	std::string verbatim;
+	int64_t values[Decoder::NumFields];
+};
+
+// Decode a block, returning the decoded length or -1. 'text' must have room for MaxBlockTextLength characters plus a guard area, which we check is untouched.
+static int Decode(const std::vector<uint8_t>& encoded, const uint8_t *decimals, char *text, size_t& maxReadLength) noexcept
+{
+	constexpr size_t GuardLength = 64;
+	memset(text, 0x55, Decoder::MaxBlockTextLength + GuardLength);
+	size_t pos = 0;
+	maxReadLength = 0;
+	auto readEncoded = [&encoded, &pos, &maxReadLength](uint8_t *buf, size_t length) noexcept -> bool
+						{
+							if (length > encoded.size() - pos)
+							{
+								return false;
+							}
+							memcpy(buf, encoded.data() + pos, length);
+							pos += length;
+							maxReadLength = std::max(maxReadLength, length);
+							return true;
+						};
+	Decoder decoder(readEncoded, decimals, text);
+	const int ret = decoder.DecodeBlock(encoded.size());
+	bool guardIntact = true;
+	for (size_t i = Decoder::MaxBlockTextLength; i < Decoder::MaxBlockTextLength + GuardLength; ++i)
+	{
+		guardIntact = guardIntact && text[i] == 0x55;
+	}
+	CHECK_MSG(guardIntact, "decoder wrote past the end of the text buffer");
+	return ret;
+}
+
+static char textBuffer[Decoder::MaxBlockTextLength + 64];
+
+static void RoundTripTest(TestRandom& rng) noexcept
+{
+	const uint8_t decimals[Decoder::NumFields] = { 3, 3, 2, 5, 0 };
+	Encoder encoder(decimals);
+	int64_t values[Decoder::NumFields] = { 0 };
+	for (unsigned int line = 0; line < 50000; ++line)
+	{
+		const unsigned int kind = rng.Next() % 20;
+		if (kind == 0)
+		{
+			encoder.AddText("; layer " + std::to_string(line) + " comment\n");
+		}
+		else if (kind == 1)
+		{
+			encoder.AddText(std::string(rng.Next() % 3000, 'a' + (char)(rng.Next() % 26)) + "\n");		// long lines that must be split between blocks
+		}
+		else
+		{
+			unsigned int fieldMask = rng.Next() & 0x1F;
+			if (fieldMask == 0)
+			{
+				fieldMask = 1;
+			}
+			for (unsigned int field = 0; field < Decoder::NumFields; ++field)
+			{
+				if (fieldMask & (1u << field))
+				{
+					// Mostly small changes, sometimes a jump to anywhere in the allowed range
+					values[field] = (rng.Next() % 100 == 0)
+									? (int64_t)((rng.Next() | ((uint64_t)rng.Next() << 32)) % (2 * (uint64_t)Decoder::MaxMagnitude - 1)) - (Decoder::MaxMagnitude - 1)
+									: values[field] + (int64_t)(rng.Next() % 20001) - 10000;
+					values[field] = std::max(-(Decoder::MaxMagnitude - 1), std::min(Decoder::MaxMagnitude - 1, values[field]));
+				}
+			}
+			encoder.AddMove(kind == 2, (fieldMask & (1u << FField)) != 0 && rng.Next() % 4 == 0, fieldMask, values);
+		}
+	}
+
+	size_t numBlocks = 0, worstReadLength = 0;
+	unsigned int mismatches = 0;
+	for (const Block& b : encoder.Finish())
+	{
+		CHECK(b.encoded.size() <= Decoder::MaxBlockEncodedLength && b.text.size() <= Decoder::MaxBlockTextLength);
+		size_t maxReadLength;
+		const int len = Decode(b.encoded, decimals, textBuffer, maxReadLength);
+		if (len != (int)b.text.size() || memcmp(textBuffer, b.text.data(), b.text.size()) != 0)
+		{
+			++mismatches;
+		}
+		worstReadLength = std::max(worstReadLength, maxReadLength);
+		++numBlocks;
+	}
+	CHECK_MSG(mismatches == 0, "%u of %zu blocks did not decode to the original text", mismatches, numBlocks);
+	printf("Compact GCode round trip: %zu blocks, largest single read of encoded data %zu bytes\n", numBlocks, worstReadLength);
+}
+
+static void EdgeValueTest() noexcept
+{
+	const uint8_t decimals[Decoder::NumFields] = { 9, 0, 9, 0, 1 };
+	Encoder encoder(decimals);
+	const int64_t high[Decoder::NumFields] = { Decoder::MaxMagnitude - 1, Decoder::MaxMagnitude - 1, 1, 0, -1 };
+	const int64_t low[Decoder::NumFields] = { -(Decoder::MaxMagnitude - 1), -(Decoder::MaxMagnitude - 1), -1, 0, 10 };
+	encoder.AddMove(false, false, 0x1F, high);
+	encoder.AddMove(true, true, 0x1F, low);
+	encoder.AddMove(false, false, 0x1F, high);
+	const std::vector<Block>& blocks = encoder.Finish();
+	CHECK(blocks.size() == 1);
+	size_t maxReadLength;
+	const int len = Decode(blocks[0].encoded, decimals, textBuffer, maxReadLength);
+	CHECK_MSG(len == (int)blocks[0].text.size() && memcmp(textBuffer, blocks[0].text.data(), blocks[0].text.size()) == 0,
+				"edge values decoded to \"%.*s\"", std::max(len, 0), textBuffer);
+}
+
+// Blocks that the converter could never have written must be rejected
+static void CorruptBlockTest() noexcept
+{
+	const uint8_t decimals[Decoder::NumFields] = { 3, 3, 3, 3, 0 };
+	size_t maxReadLength;
+	std::vector<uint8_t> b;
+
+	b = { MoveRecordFlag | 1 };
+	PutVarint(b, ZigZag(Decoder::MaxMagnitude - 1));
+	CHECK(Decode(b, decimals, textBuffer, maxReadLength) > 0);
+
+	b = { MoveRecordFlag | 1 };
+	PutVarint(b, ZigZag(Decoder::MaxMagnitude));
+	CHECK(Decode(b, decimals, textBuffer, maxReadLength) == -1);					// value out of range
+
+	b = { MoveRecordFlag | 1 };
+	PutVarint(b, ZigZag(-Decoder::MaxMagnitude));
+	CHECK(Decode(b, decimals, textBuffer, maxReadLength) == -1);
+
+	b = { MoveRecordFlag | 1 };
+	PutVarint(b, ZigZag(Decoder::MaxMagnitude/2));
+	b.push_back(MoveRecordFlag | 1);
+	PutVarint(b, ZigZag(Decoder::MaxMagnitude/2));
+	CHECK(Decode(b, decimals, textBuffer, maxReadLength) == -1);					// two deltas that are each in range but add up to a value that isn't
+
+	b = { MoveRecordFlag | 1 };
+	PutVarint(b, ~(uint64_t)0);
+	CHECK(Decode(b, decimals, textBuffer, maxReadLength) == -1);					// delta that would overflow the addition
+
+	b = { MoveRecordFlag | 1, 0x80, 0x80 };
+	CHECK(Decode(b, decimals, textBuffer, maxReadLength) == -1);					// truncated varint
+
+	b = { 0 };
+	PutVarint(b, 10);
+	b.insert(b.end(), 5, 'x');
+	CHECK(Decode(b, decimals, textBuffer, maxReadLength) == -1);					// verbatim text longer than the block
+
+	b.clear();
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+		b.push_back(0);
+		PutVarint(b, 400);
+		b.insert(b.end(), 400, 'y');
+	}
+	CHECK(Decode(b, decimals, textBuffer, maxReadLength) == -1);					// too much text for one block
+
+	b = { 0x23 };
+	CHECK(Decode(b, decimals, textBuffer, maxReadLength) == -1);					// unknown record type
+}
+
+// Random data must never make the decoder write past the end of the buffer or return more text than it can hold
+static void FuzzTest(TestRandom& rng) noexcept
+{
+	const uint8_t decimals[Decoder::NumFields] = { 9, 9, 9, 9, 9 };
+	unsigned int numAccepted = 0;
+	for (unsigned int i = 0; i < 200000; ++i)
+	{
+		std::vector<uint8_t> b(rng.Next() % (Decoder::MaxBlockEncodedLength + 1));
+		for (uint8_t& byte : b)
+		{
+			// Bias towards move records and short verbatim records so that we get past the first few bytes
+			const uint32_t r = rng.Next();
+			byte = (r % 4 == 0) ? (uint8_t)(MoveRecordFlag | (r >> 8)) : (r % 4 == 1) ? 0 : (uint8_t)(r >> 8);
+		}
+		size_t maxReadLength;
+		const int len = Decode(b, decimals, textBuffer, maxReadLength);
+		CHECK(len >= -1 && len <= (int)Decoder::MaxBlockTextLength);
+		if (len >= 0)
+		{
+			++numAccepted;
+		}
+	}
+	printf("Compact GCode fuzz: %u of 200000 random blocks decoded\n", numAccepted);
+}
+
+int main()
+{
+	TestRandom rng(2468);
+	RoundTripTest(rng);
+	EdgeValueTest();
+	CorruptBlockTest();
+	FuzzTest(rng);
+	return TestResult("CompactGCodeDecoderTest");
+}
@@ -0,0 +1,165 @@
+/*
+ * DeltaStepApproximationTest.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Check the error of the incremental delta step calculation (M665 S1) against the exact solution, on random delta geometries and moves.
+ * We step the carriage one step at a time the way DriveMovement::CalcNextStepTime does, using the approximation when it says it is accurate enough
+ * and otherwise doing the exact calculation and resetting the approximation.
+ */
+
+#include "TestHarness.h"
+#include <Movement/DeltaStepApproximation.h>
+#include <cmath>
+
+struct DeltaMove
+{
+	double minusAaPlusBbTimesS;			// -(aA + bB) * s
+	double dSquaredMinusAaMinusBbTimesSs;	// (D^2 - A^2 - B^2) * s^2
+	double dirZ;						// the Z component of the unit direction vector
+	double startHeight;					// the carriage height above Z at the start of the move, in steps
+	double maxDs;						// the length of the move in steps
+	bool up;							// true if the carriage moves up
+};
+
+// Calculate d*s at carriage height h using the exact formula that the firmware uses
+template<class T> static bool ExactDs(const DeltaMove& m, T h, T& t1, T& t2, T& ds) noexcept
+{
+	t1 = (T)m.minusAaPlusBbTimesS + h * (T)m.dirZ;
+	const T t2a = (T)m.dSquaredMinusAaMinusBbTimesSs - h * h + t1 * t1;
+	if (t2a < 0)
+	{
+		return false;
+	}
+	t2 = std::sqrt(t2a);
+	ds = (m.up) ? t1 - t2 : t1 + t2;
+	return true;
+}
+
+static DeltaMove RandomMove(TestRandom& rng) noexcept
+{
+	for (;;)
+	{
+		const double diagonal = rng.Uniform(150.0, 450.0);
+		const double stepsPerMm = rng.Uniform(40.0, 320.0);
+		const double radius = diagonal * rng.Uniform(0.4, 0.75);
+		const double towerAngle = rng.Uniform(0.0, 2 * M_PI);
+		const double towerX = radius * cos(towerAngle), towerY = radius * sin(towerAngle);
+
+		// Random start point within the print radius and random direction, with a Z component that is usually small
+		const double printRadius = radius * 0.7;
+		const double startAngle = rng.Uniform(0.0, 2 * M_PI), startRadius = printRadius * sqrt(rng.Uniform(0.0, 1.0));
+		const double x0 = startRadius * cos(startAngle), y0 = startRadius * sin(startAngle);
+		const double moveAngle = rng.Uniform(0.0, 2 * M_PI);
+		const double dz = (rng.Next() % 4 == 0) ? rng.Uniform(-0.5, 0.5) : 0.0;
+		const double dxy = sqrt(1.0 - dz * dz);
+
+		const double A = x0 - towerX, B = y0 - towerY;
+		const double dSqMinusAaMinusBb = diagonal * diagonal - A * A - B * B;
+		if (dSqMinusAaMinusBb <= 0.0)
+		{
+			continue;
+		}
+
+		DeltaMove m;
+		const double aAplusbB = A * dxy * cos(moveAngle) + B * dxy * sin(moveAngle);
+		m.minusAaPlusBbTimesS = -aAplusbB * stepsPerMm;
+		m.dSquaredMinusAaMinusBbTimesSs = dSqMinusAaMinusBb * stepsPerMm * stepsPerMm;
+		m.dirZ = dz;
+		m.startHeight = sqrt(dSqMinusAaMinusBb) * stepsPerMm;
+		m.maxDs = rng.Uniform(1.0, 2 * printRadius) * stepsPerMm;
+
+		// At the start of the move d*s is zero, so t2 = |t1|. The carriage moves up if t1 is positive, because then the zero root is t1 - t2.
+		const double t1 = m.minusAaPlusBbTimesS + m.startHeight * m.dirZ;
+		m.up = (t1 >= 0.0);
+		return m;
+	}
+}
+
+// Step through one move, returning the worst error of the approximated values and counting how many steps used the approximation
+template<class T> static double CheckMove(const DeltaMove& m, unsigned int& numApproximated, unsigned int& numSteps) noexcept
+{
+	DeltaStepApproximationT<T> approx{};
+	approx.Invalidate();
+	double worstError = 0.0;
+	T h = (T)m.startHeight;
+	for (unsigned int step = 0; step < 200000; ++step)
+	{
+		h += (m.up) ? (T)1.0 : (T)-1.0;
+		double exactT1, exactT2, exactDs;
+		if (!ExactDs<double>(m, (double)h, exactT1, exactT2, exactDs) || exactDs > m.maxDs || exactDs < 0.0)
+		{
+			break;									// reached the reversal point or the end of the move
+		}
+
+		++numSteps;
+		T ds;
+		if (approx.Estimate(h, ds))
+		{
+			++numApproximated;
+			worstError = std::max(worstError, std::fabs((double)ds - exactDs));
+		}
+		else
+		{
+			T t1 = 0, t2 = 0;
+			(void)ExactDs<T>(m, h, t1, t2, ds);
+			approx.SetBase(h, t1, t2, ds, (T)m.dirZ, m.up);
+		}
+	}
+	return worstError;
+}
+
+// Return the largest error of the firmware's single-precision exact calculation over the same move, so that we can allow for it
+static double FloatExactError(const DeltaMove& m) noexcept
+{
+	double worstError = 0.0;
+	double h = m.startHeight;
+	for (unsigned int step = 0; step < 200000; ++step)
+	{
+		h += (m.up) ? 1.0 : -1.0;
+		double t1, t2, ds;
+		if (!ExactDs<double>(m, h, t1, t2, ds) || ds > m.maxDs || ds < 0.0)
+		{
+			break;
+		}
+		float ft1, ft2, fds;
+		if (ExactDs<float>(m, (float)h, ft1, ft2, fds))
+		{
+			worstError = std::max(worstError, std::fabs((double)fds - ds));
+		}
+	}
+	return worstError;
+}
+
+int main()
+{
+	constexpr unsigned int NumMoves = 2000;
+	TestRandom rng(12345);
+	double worstDoubleError = 0.0, worstFloatExcess = 0.0;
+	unsigned int numApproximated = 0, numSteps = 0;
+	for (unsigned int i = 0; i < NumMoves; ++i)
+	{
+		const DeltaMove m = RandomMove(rng);
+
+		// With double precision arithmetic the only error is the truncation error, which must be within the tolerance
+		const double doubleError = CheckMove<double>(m, numApproximated, numSteps);
+		CHECK_MSG(doubleError <= DeltaStepApproximationT<double>::Tolerance, "move %u error %.5f", i, doubleError);
+		worstDoubleError = std::max(worstDoubleError, doubleError);
+
+		// With single precision arithmetic the firmware's exact calculation already has rounding errors of up to a few hundredths of a step.
+		// The approximation inherits that error from its base value and again from the derivatives calculated from the same rounded values,
+		// so we allow twice the rounding error of the exact calculation over the same move, plus the tolerance.
+		unsigned int dummyApproximated = 0, dummySteps = 0;
+		const double floatError = CheckMove<float>(m, dummyApproximated, dummySteps);
+		const double floatExactError = FloatExactError(m);
+		const double excess = floatError - 2.0 * floatExactError;
+		CHECK_MSG(excess <= DeltaStepApproximation::Tolerance, "move %u float error %.5f, exact float error %.5f", i, floatError, floatExactError);
+		worstFloatExcess = std::max(worstFloatExcess, excess);
+	}
+
+	printf("Delta step approximation: %u of %u steps approximated, worst truncation error %.5f steps, worst float error beyond twice the exact calculation's rounding error %.5f steps\n",
+			numApproximated, numSteps, worstDoubleError, worstFloatExcess);
+	CHECK(numApproximated > numSteps/2);			// the approximation must be used for most steps, otherwise it isn't worth having
+	return TestResult("DeltaStepApproximationTest");
+}
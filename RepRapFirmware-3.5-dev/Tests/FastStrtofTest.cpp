@@ -0,0 +1,131 @@
+/*
+ * FastStrtofTest.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Fuzz test of SafeStrtof against the general NumericConverter parser that it used before it had a fast path. The results must be bit-identical
+ * and the end pointers must be the same. Then time both on typical GCode numbers.
+ */
+
+#include "TestHarness.h"
+#include <General/SafeStrtod.h>
+#include <General/NumericConverter.h>
+#include <cstring>
+#include <chrono>
+
+// This is what SafeStrtof did before it had a fast path
+static float ReferenceStrtof(const char *s, const char **endptr) noexcept
+{
+	*endptr = s;
+	NumericConverter conv;
+	if (conv.Accumulate(*s, NumericConverter::AcceptSignedFloat, [&s]() noexcept -> char { ++s; return *s; } ))
+	{
+		*endptr = s;
+		return conv.GetFloat();
+	}
+	return 0.0f;
+}
+
+static bool SameResult(const char *str, unsigned int& numFailures) noexcept
+{
+	const char *end1, *end2;
+	const float f1 = SafeStrtof(str, &end1);
+	const float f2 = ReferenceStrtof(str, &end2);
+	uint32_t bits1, bits2;
+	memcpy(&bits1, &f1, sizeof(bits1));
+	memcpy(&bits2, &f2, sizeof(bits2));
+	if (bits1 != bits2 || end1 != end2)
+	{
+		if (++numFailures <= 10)
+		{
+			printf("\"%s\": got %.9g length %d, expected %.9g length %d\n", str, (double)f1, (int)(end1 - str), (double)f2, (int)(end2 - str));
+		}
+		return false;
+	}
+	return true;
+}
+
+// Make a random string from characters that occur in numbers, weighted towards digits
+static void RandomString(TestRandom& rng, char *buf, size_t maxLength) noexcept
+{
+	static const char Chars[] = "0123456789012345678901234567890123456789+-..eE xX";
+	const size_t length = 1 + rng.Next() % maxLength;
+	for (size_t i = 0; i < length; ++i)
+	{
+		buf[i] = Chars[rng.Next() % (sizeof(Chars) - 1)];
+	}
+	buf[length] = 0;
+}
+
+// Make a string in the format that GCode generators produce, e.g. -123.456
+static void GCodeNumber(TestRandom& rng, char *buf, size_t bufSize) noexcept
+{
+	const unsigned int decimals = rng.Next() % 6;
+	const double value = rng.Uniform(-500.0, 500.0);
+	snprintf(buf, bufSize, "%.*f", (int)decimals, value);
+}
+
+int main()
+{
+	TestRandom rng(24680);
+	char buf[32];
+
+	// Fixed cases around the limits of the fast path
+	static const char *const FixedCases[] =
+	{
+		"0", "-0", "+0", ".", "-", "+", "-.", "0.", ".5", "-.5", "1e3", "1.5E-2", "123456789", "1234567890", "0000000001234567891", "1.0000000000", "1.00000000000",
+		"0.12345678901", "999999999.9", "4294967295", "4294967296", "12..3", "1.2.3", "0x10", "1 2", "-1-2", "3.14159265358979", "0.0000000001", "00000000000.5"
+	};
+	unsigned int numFailures = 0;
+	for (const char *str : FixedCases)
+	{
+		CHECK_MSG(SameResult(str, numFailures), "\"%s\"", str);
+	}
+
+	// Random strings, most of which the fast path rejects part way through
+	constexpr unsigned int NumRandom = 2000000;
+	unsigned int randomFailures = 0;
+	for (unsigned int i = 0; i < NumRandom; ++i)
+	{
+		RandomString(rng, buf, 16);
+		(void)SameResult(buf, randomFailures);
+		GCodeNumber(rng, buf, sizeof(buf));
+		(void)SameResult(buf, randomFailures);
+	}
+	CHECK_MSG(randomFailures == 0, "%u of %u random strings differ", randomFailures, 2 * NumRandom);
+
+	// Time both on typical GCode numbers
+	constexpr unsigned int NumTimed = 1000;
+	constexpr unsigned int NumPasses = 1000;
+	static char numbers[NumTimed][16];
+	for (unsigned int i = 0; i < NumTimed; ++i)
+	{
+		GCodeNumber(rng, numbers[i], sizeof(numbers[i]));
+	}
+	float sum1 = 0.0, sum2 = 0.0;
+	const auto start1 = std::chrono::steady_clock::now();
+	for (unsigned int pass = 0; pass < NumPasses; ++pass)
+	{
+		for (unsigned int i = 0; i < NumTimed; ++i)
+		{
+			sum1 += SafeStrtof(numbers[i]);
+		}
+	}
+	const auto start2 = std::chrono::steady_clock::now();
+	for (unsigned int pass = 0; pass < NumPasses; ++pass)
+	{
+		for (unsigned int i = 0; i < NumTimed; ++i)
+		{
+			const char *end;
+			sum2 += ReferenceStrtof(numbers[i], &end);
+		}
+	}
+	const auto end2 = std::chrono::steady_clock::now();
+	CHECK(sum1 == sum2);
+	const double fastNs = std::chrono::duration<double, std::nano>(start2 - start1).count()/(NumTimed * NumPasses);
+	const double generalNs = std::chrono::duration<double, std::nano>(end2 - start2).count()/(NumTimed * NumPasses);
+	printf("SafeStrtof on GCode numbers: %.1fns with the fast path, %.1fns with the general parser\n", fastNs, generalNs);
+
+	return TestResult("FastStrtofTest");
+}
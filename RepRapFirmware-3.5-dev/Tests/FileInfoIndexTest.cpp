@@ -0,0 +1,321 @@
+/*
+ * FileInfoIndexTest.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Test of the file info index record format against a fake file held in RAM. We store, replace and remove records for a random set of file names
+ * in the same way as FileInfoIndex does, and after each change check that every name finds the information we last stored for it and that removed
+ * names find nothing. We also check that compacting keeps the index size in proportion to the number of live records, and that a record torn off
+ * part way through being written is ignored and doesn't stop later records being found.
+ */
+
+#include "TestHarness.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cctype>
+#include <string>
+#include <map>
+
+// Stop CRC32.h including the firmware headers, and select the software algorithm
+#define REPRAPFIRMWARE_H
+#define SAM4E	0
+#define SAME5x	0
+#define SAME70	0
+#include <Storage/CRC32.cpp>
+
+#include <Storage/FileInfoIndexFile.h>
+
+class FakeFile
+{
+public:
+	bool Seek(uint32_t p_pos) noexcept
+	{
+		if (p_pos > data.size())
+		{
+			return false;
+		}
+		pos = p_pos;
+		return true;
+	}
+
+	int Read(char *buf, size_t maxLength) noexcept
+	{
+		const size_t bytesToRead = std::min<size_t>(maxLength, data.size() - pos);
+		memcpy(buf, data.data() + pos, bytesToRead);
+		pos += bytesToRead;
+		return (int)bytesToRead;
+	}
+
+	bool Write(const char *buf, size_t length) noexcept
+	{
+		if (pos + length > data.size())
+		{
+			data.resize(pos + length);
+		}
+		memcpy(&data[pos], buf, length);
+		pos += length;
+		return true;
+	}
+
+	uint32_t Length() const noexcept { return data.size(); }
+
+	bool Truncate() noexcept
+	{
+		data.resize(pos);
+		return true;
+	}
+
+	std::string data;
+	uint32_t pos = 0;
+};
+
+struct TestInfo
+{
+	uint32_t fileSize;
+	uint32_t lastModifiedTime;
+	float layerHeight;
+	uint32_t numFilaments;
+	bool isValid;
+};
+
+constexpr size_t MaxNameLength = 120;
+constexpr uint32_t MinDeadBytesToCompact = 2048;			// smaller than the firmware uses so that we compact often
+
+typedef FileInfoIndexFile<FakeFile, TestInfo, MaxNameLength> IndexFile;
+typedef std::map<std::string, TestInfo> Reference;			// keyed by the lower case file name
+
+static std::string LowerCase(const std::string& s) noexcept
+{
+	std::string ret;
+	for (char c : s)
+	{
+		ret.push_back((char)tolower(c));
+	}
+	return ret;
+}
+
+static bool SameInfo(const TestInfo& a, const TestInfo& b) noexcept
+{
+	return a.fileSize == b.fileSize && a.lastModifiedTime == b.lastModifiedTime && a.layerHeight == b.layerHeight && a.numFilaments == b.numFilaments && a.isValid == b.isValid;
+}
+
+static std::string RandomName(TestRandom& rng, unsigned int numNames) noexcept
+{
+	// A small set of names so that we often replace and remove existing records. The length varies so that we exercise the padding.
+	const unsigned int n = rng.Next() % numNames;
+	std::string name = "part" + std::to_string(n);
+	for (unsigned int i = 0; i < n % 7; ++i)
+	{
+		name.push_back('x');
+	}
+	name += ".gcode";
+	if (rng.Next() & 1)
+	{
+		name[0] = 'P';											// FAT names are not case sensitive
+	}
+	return name;
+}
+
+static TestInfo RandomInfo(TestRandom& rng) noexcept
+{
+	TestInfo info;
+	memset(&info, 0, sizeof(info));								// so that the padding is the same every time
+	info.fileSize = rng.Next();
+	info.lastModifiedTime = rng.Next();
+	info.layerHeight = (float)(rng.Next() % 100) * 0.01f;
+	info.numFilaments = rng.Next() % 5;
+	info.isValid = true;
+	return info;
+}
+
+// Do what FileInfoIndex::Store does
+static bool Store(FakeFile& file, const std::string& name, const TestInfo& info, bool& compacted) noexcept
+{
+	IndexFile index(&file);
+	uint32_t endOfRecords;
+	return index.PrepareToStore(name.c_str(), MinDeadBytesToCompact, endOfRecords, compacted) && index.Append(endOfRecords, name.c_str(), info);
+}
+
+static void Remove(FakeFile& file, const std::string& name) noexcept
+{
+	IndexFile index(&file);
+	if (index.ReadHeader())
+	{
+		uint32_t liveBytes, deadBytes;
+		(void)index.KillMatchingRecords(name.c_str(), liveBytes, deadBytes);
+	}
+}
+
+static bool Find(FakeFile& file, const std::string& name, TestInfo& info) noexcept
+{
+	IndexFile index(&file);
+	return index.ReadHeader() && index.Find(name.c_str(), info);
+}
+
+static unsigned int CheckAll(FakeFile& file, const Reference& ref, unsigned int numNames) noexcept
+{
+	unsigned int failures = 0;
+	for (unsigned int n = 0; n < numNames; ++n)
+	{
+		for (unsigned int len = 0; len < 7; ++len)
+		{
+			std::string name = "part" + std::to_string(n) + std::string(len, 'x') + ".gcode";
+			TestInfo info;
+			const bool found = Find(file, name, info);
+			const auto it = ref.find(LowerCase(name));
+			if (it == ref.end())
+			{
+				if (found) { ++failures; }
+			}
+			else if (!found || !SameInfo(info, it->second))
+			{
+				++failures;
+			}
+		}
+	}
+	return failures;
+}
+
+static uint32_t LiveLength(const Reference& ref) noexcept
+{
+	uint32_t length = IndexFile::FirstRecordOffset();
+	for (const auto& entry : ref)
+	{
+		length += IndexFile::RecordLength(entry.first.size());
+	}
+	return length;
+}
+
+// Random stores, replacements and removals, checking the whole index after each one
+static void AppendKillCompactTest() noexcept
+{
+	TestRandom rng(1);
+	FakeFile file;
+	Reference ref;
+	constexpr unsigned int NumNames = 40;
+	unsigned int compactions = 0;
+	uint32_t maxLength = 0;
+
+	for (unsigned int i = 0; i < 3000; ++i)
+	{
+		const std::string name = RandomName(rng, NumNames);
+		if (rng.Next() % 4 == 0)
+		{
+			Remove(file, name);
+			ref.erase(LowerCase(name));
+		}
+		else
+		{
+			const TestInfo info = RandomInfo(rng);
+			bool compacted;
+			CHECK(Store(file, name, info, compacted));
+			ref[LowerCase(name)] = info;
+			if (compacted)
+			{
+				++compactions;
+				// After compacting, the index holds only the live records
+				CHECK_MSG(file.Length() == LiveLength(ref), "index length %u after compacting, expected %u", (unsigned int)file.Length(), (unsigned int)LiveLength(ref));
+			}
+		}
+		if (file.Length() > maxLength)
+		{
+			maxLength = file.Length();
+		}
+		const unsigned int failures = CheckAll(file, ref, NumNames);
+		CHECK_MSG(failures == 0, "%u lookups wrong after operation %u", failures, i);
+	}
+
+	// Dead records can take up at most MinDeadBytesToCompact or the space taken by the live ones, plus one record that was killed after the last store
+	const uint32_t allLive = IndexFile::FirstRecordOffset() + NumNames * IndexFile::RecordLength(MaxNameLength - 1);
+	CHECK_MSG(compactions > 10, "only %u compactions", compactions);
+	CHECK_MSG(maxLength <= 2 * allLive + MinDeadBytesToCompact, "index grew to %u bytes", (unsigned int)maxLength);
+	printf("File info index: %u operations on %u names, %u compactions, largest index %u bytes\n", 3000, NumNames, compactions, (unsigned int)maxLength);
+}
+
+// The last record is only partly written, e.g. because the card was removed or power failed
+static void TornRecordTest() noexcept
+{
+	TestRandom rng(2);
+	for (unsigned int trial = 0; trial < 200; ++trial)
+	{
+		FakeFile file;
+		Reference ref;
+		bool compacted;
+		for (unsigned int i = 0; i < 10; ++i)
+		{
+			const std::string name = RandomName(rng, 20);
+			const TestInfo info = RandomInfo(rng);
+			CHECK(Store(file, name, info, compacted));
+			ref[LowerCase(name)] = info;
+		}
+
+		// Store one more record for a new file and cut it short, leaving the data that was there before it in place
+		const std::string tornName = "torn" + std::to_string(trial) + ".gcode";
+		const uint32_t lengthBefore = file.Length();
+		CHECK(Store(file, tornName, RandomInfo(rng), compacted));
+		const uint32_t recordLength = file.Length() - lengthBefore;
+		CHECK(recordLength == IndexFile::RecordLength(tornName.size()));
+		const uint32_t keep = rng.Next() % recordLength;
+		if (rng.Next() & 1)
+		{
+			file.data.resize(lengthBefore + keep);					// the file was never extended past the point we reached
+		}
+		else
+		{
+			// The file was extended but the end of the record holds rubbish
+			for (uint32_t j = lengthBefore + keep; j < file.Length(); ++j)
+			{
+				file.data[j] = (char)rng.Next();
+			}
+		}
+
+		TestInfo info;
+		CHECK(!Find(file, tornName, info));
+		CHECK_MSG(CheckAll(file, ref, 20) == 0, "trial %u: intact records lost after a torn write", trial);
+
+		// Later records must be readable whether the next store overwrote the torn record or appended after it
+		const std::string name = RandomName(rng, 20);
+		const TestInfo newInfo = RandomInfo(rng);
+		CHECK(Store(file, name, newInfo, compacted));
+		ref[LowerCase(name)] = newInfo;
+		CHECK_MSG(CheckAll(file, ref, 20) == 0, "trial %u: records lost after storing over a torn write", trial);
+		const std::string nextName = "next" + std::to_string(trial) + ".gcode";
+		CHECK(Store(file, nextName, newInfo, compacted));
+		CHECK(Find(file, nextName, info) && SameInfo(info, newInfo));
+	}
+}
+
+// An index written with a different layout is ignored and replaced
+static void HeaderTest() noexcept
+{
+	TestRandom rng(3);
+	FakeFile file;
+	bool compacted;
+	const TestInfo info = RandomInfo(rng);
+	CHECK(Store(file, "a.gcode", info, compacted));
+	TestInfo found;
+	CHECK(Find(file, "A.GCODE", found) && SameInfo(found, info));
+
+	file.data[6] ^= 1;											// change the info size in the header
+	CHECK(!Find(file, "a.gcode", found));
+	CHECK(Store(file, "b.gcode", info, compacted));
+	CHECK(file.Length() == IndexFile::FirstRecordOffset() + IndexFile::RecordLength(7));
+	CHECK(!Find(file, "a.gcode", found));
+	CHECK(Find(file, "b.gcode", found) && SameInfo(found, info));
+
+	// Names that are too long or empty are not stored
+	CHECK(!Store(file, std::string(MaxNameLength, 'n'), info, compacted));
+	CHECK(!Store(file, "", info, compacted));
+}
+
+int main()
+{
+	AppendKillCompactTest();
+	TornRecordTest();
+	HeaderTest();
+	return TestResult("FileInfoIndexTest");
+}
+
+// End
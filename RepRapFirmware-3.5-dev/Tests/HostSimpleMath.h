@@ -0,0 +1,30 @@
+/*
+ * HostSimpleMath.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Forced include for library sources that we build on a 64-bit host. SimpleMath.h asserts that unsigned long is 32 bits, so we stop it being
+ * included and provide the parts of it that those sources use.
+ */
+
+#ifndef TESTS_HOSTSIMPLEMATH_H_
+#define TESTS_HOSTSIMPLEMATH_H_
+
+#define SRC_GENERAL_SIMPLEMATH_H_
+
+#include <cstddef>
+
+template<class X> inline constexpr X min(X _a, X _b) noexcept
+{
+	return (_a < _b) ? _a : _b;
+}
+
+template<class X> inline constexpr X max(X _a, X _b) noexcept
+{
+	return (_a > _b) ? _a : _b;
+}
+
+#define ARRAY_SIZE(_x)	(sizeof(_x)/sizeof((_x)[0]))
+
+#endif /* TESTS_HOSTSIMPLEMATH_H_ */
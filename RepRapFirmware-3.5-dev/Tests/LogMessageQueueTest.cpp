@@ -0,0 +1,234 @@
+/*
+ * LogMessageQueueTest.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Test of the lock-free queue used by the asynchronous logger. We check the padding record that is added when a record doesn't fit before the end
+ * of the buffer, that the consumer stops at a record that has been reserved but not committed, and that records are dropped when the queue is full.
+ * Then several producer threads add records of random length at the same time as a consumer thread removes them, with a small queue so that it
+ * wraps around many times, and we check that every record that wasn't dropped arrives intact and in the order that its producer added it.
+ */
+
+#include "TestHarness.h"
+#include <Platform/LogMessageQueue.h>
+#include <thread>
+#include <vector>
+
+struct TestHeader
+{
+	uint32_t producer;
+	uint32_t sequence;
+	uint32_t length;										// the number of data bytes after the header
+};
+
+constexpr size_t SmallQueueSize = 256;
+typedef LogMessageQueue<SmallQueueSize> SmallQueue;
+
+static char DataByte(uint32_t producer, uint32_t sequence, uint32_t i) noexcept
+{
+	return (char)(producer * 31 + sequence * 7 + i);
+}
+
+// Return true if the 'length' bytes at 'p' lie within the queue object
+static bool WithinQueue(const SmallQueue& queue, const void *p, size_t length) noexcept
+{
+	const char *const start = reinterpret_cast<const char *>(&queue);
+	const char *const cp = static_cast<const char *>(p);
+	return cp >= start && cp + length <= start + sizeof(queue);
+}
+
+static void PaddingTest() noexcept
+{
+	SmallQueue queue;
+
+	// A record that takes 208 bytes leaves 48 at the end, so a record that takes 112 bytes must start at the beginning after a padding record
+	void *const first = queue.Reserve(200);
+	CHECK(first != nullptr && WithinQueue(queue, first, 200));
+	memset(first, 'a', 200);
+	queue.Commit(first);
+	CHECK(queue.GetNext() == first);
+	queue.Release();
+	CHECK(queue.GetNext() == nullptr);
+	CHECK(queue.GetAndClearMaxUsed() == 208);
+
+	void *const second = queue.Reserve(100);
+	CHECK(second != nullptr && WithinQueue(queue, second, 100));
+	CHECK_MSG(second == first, "record after the padding doesn't start at the beginning of the buffer");
+	memset(second, 'b', 100);
+	queue.Commit(second);
+	CHECK_MSG(queue.GetAndClearMaxUsed() == 48 + 112, "space used didn't include the padding");
+	CHECK(queue.GetNext() == second);						// the padding record is skipped
+	queue.Release();
+	CHECK(queue.GetNext() == nullptr);
+	CHECK(queue.GetAndClearDropped() == 0);
+}
+
+static void CommitOrderTest() noexcept
+{
+	SmallQueue queue;
+
+	// The consumer must not pass a record that has been reserved but not committed, even if later records have been committed
+	void *const a = queue.Reserve(10);
+	void *const b = queue.Reserve(20);
+	CHECK(a != nullptr && b != nullptr);
+	queue.Commit(b);
+	CHECK(queue.GetNext() == nullptr);
+	queue.Commit(a);
+	CHECK(queue.GetNext() == a);
+	queue.Release();
+	CHECK(queue.GetNext() == b);
+	queue.Release();
+	CHECK(queue.GetNext() == nullptr);
+
+	// When the queue is full, records are dropped until the consumer has released some space. The first three full length records fit,
+	// but the fourth would need padding to the end of the buffer as well.
+	unsigned int added = 0;
+	void *p;
+	while ((p = queue.Reserve(SmallQueue::MaxDataLength)) != nullptr)
+	{
+		queue.Commit(p);
+		++added;
+	}
+	CHECK(added == 3);
+	CHECK(queue.GetAndClearDropped() == 1);
+	CHECK(queue.GetNext() != nullptr);
+	queue.Release();
+	p = queue.Reserve(SmallQueue::MaxDataLength);
+	CHECK(p != nullptr);
+	queue.Commit(p);
+	unsigned int removed = 0;
+	while (queue.GetNext() != nullptr)
+	{
+		queue.Release();
+		++removed;
+	}
+	CHECK(removed == added);									// one released before the last reserve, one added by it
+}
+
+static void MultipleProducerTest() noexcept
+{
+	constexpr unsigned int NumProducers = 4;
+	constexpr uint32_t RecordsPerProducer = 50000;
+	constexpr size_t MaxLength = SmallQueue::MaxDataLength - sizeof(TestHeader);
+
+	SmallQueue queue;
+	std::atomic<unsigned int> producersRunning(NumProducers);
+	uint32_t dropped[NumProducers] = { 0 };
+
+	std::vector<std::thread> producers;
+	for (unsigned int producer = 0; producer < NumProducers; ++producer)
+	{
+		producers.emplace_back([&queue, &producersRunning, &dropped, producer]() noexcept
+			{
+				TestRandom rng(producer + 10);
+				for (uint32_t seq = 0; seq < RecordsPerProducer; ++seq)
+				{
+					const uint32_t length = rng.Next() % (MaxLength + 1);
+					TestHeader *const hdr = static_cast<TestHeader *>(queue.Reserve(sizeof(TestHeader) + length));
+					if (hdr == nullptr)
+					{
+						++dropped[producer];
+						std::this_thread::yield();
+						continue;
+					}
+					hdr->producer = producer;
+					hdr->sequence = seq;
+					hdr->length = length;
+					char *const data = reinterpret_cast<char *>(hdr + 1);
+					for (uint32_t i = 0; i < length; ++i)
+					{
+						data[i] = DataByte(producer, seq, i);
+					}
+					if ((rng.Next() & 15) == 0)
+					{
+						std::this_thread::yield();			// give other producers and the consumer a chance to run while this record is uncommitted
+					}
+					queue.Commit(hdr);
+				}
+				--producersRunning;
+			});
+	}
+
+	// Consume in this thread until all the producers have finished and the queue is empty
+	uint32_t received[NumProducers] = { 0 };
+	int32_t lastSequence[NumProducers];
+	for (int32_t& s : lastSequence) { s = -1; }
+	unsigned int badRecords = 0, outOfOrder = 0, outsideQueue = 0;
+	for (;;)
+	{
+		const bool finished = (producersRunning == 0);
+		const TestHeader *hdr;
+		bool gotAny = false;
+		while ((hdr = static_cast<const TestHeader *>(queue.GetNext())) != nullptr)
+		{
+			gotAny = true;
+			if (hdr->producer >= NumProducers || hdr->length > MaxLength)
+			{
+				++badRecords;
+			}
+			else
+			{
+				if (!WithinQueue(queue, hdr, sizeof(TestHeader) + hdr->length))
+				{
+					++outsideQueue;
+				}
+				const char *const data = reinterpret_cast<const char *>(hdr + 1);
+				for (uint32_t i = 0; i < hdr->length; ++i)
+				{
+					if (data[i] != DataByte(hdr->producer, hdr->sequence, i))
+					{
+						++badRecords;
+						break;
+					}
+				}
+				if ((int32_t)hdr->sequence <= lastSequence[hdr->producer])
+				{
+					++outOfOrder;
+				}
+				lastSequence[hdr->producer] = (int32_t)hdr->sequence;
+				++received[hdr->producer];
+			}
+			queue.Release();
+		}
+		if (finished)
+		{
+			break;
+		}
+		if (!gotAny)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	for (std::thread& t : producers)
+	{
+		t.join();
+	}
+
+	CHECK_MSG(badRecords == 0, "%u records corrupted", badRecords);
+	CHECK_MSG(outOfOrder == 0, "%u records out of order", outOfOrder);
+	CHECK_MSG(outsideQueue == 0, "%u records not contiguous", outsideQueue);
+	uint32_t totalReceived = 0, totalDropped = 0;
+	for (unsigned int producer = 0; producer < NumProducers; ++producer)
+	{
+		CHECK_MSG(received[producer] + dropped[producer] == RecordsPerProducer, "producer %u: %u received + %u dropped", producer, received[producer], dropped[producer]);
+		totalReceived += received[producer];
+		totalDropped += dropped[producer];
+	}
+	CHECK(queue.GetAndClearDropped() == totalDropped);
+	CHECK(queue.GetAndClearMaxUsed() <= SmallQueueSize);
+	CHECK_MSG(totalReceived > RecordsPerProducer, "only %u records received", totalReceived);
+	printf("Log message queue: %u producers, %u records received, %u dropped, queue of %u bytes\n",
+			NumProducers, totalReceived, totalDropped, (unsigned int)SmallQueueSize);
+}
+
+int main()
+{
+	PaddingTest();
+	CommitOrderTest();
+	MultipleProducerTest();
+	return TestResult("LogMessageQueueTest");
+}
+
+// End
@@ -0,0 +1,223 @@
+/*
+ * LoopBodyCacheTest.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Test of the 'while' loop body cache against a fake file held in RAM. We read each iteration of a loop the way FileGCodeInput does,
+ * in chunks of random size, and check that every iteration returns what is in the file at the time, that later iterations of a short loop
+ * don't read the file, and that the cache is refilled when the storage sequence number changes or the loop is somewhere else.
+ */
+
+#include "TestHarness.h"
+#include <GCodes/LoopBodyCache.h>
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+typedef LoopBodyCache::Position Position;
+
+class FakeFile
+{
+public:
+	explicit FakeFile(size_t length) noexcept
+	{
+		for (size_t i = 0; i < length; ++i)
+		{
+			data.push_back((char)('A' + (i * 7 + i/29) % 26));
+		}
+	}
+
+	int Read(char *buf, size_t maxLength) noexcept
+	{
+		++reads;
+		if (failReads)
+		{
+			return -1;
+		}
+		const size_t bytesToRead = (pos < data.size()) ? std::min<size_t>(maxLength, data.size() - pos) : 0;
+		memcpy(buf, data.data() + pos, bytesToRead);
+		pos += bytesToRead;
+		return (int)bytesToRead;
+	}
+
+	bool Seek(Position p_pos) noexcept
+	{
+		pos = p_pos;
+		return p_pos <= data.size();
+	}
+
+	std::string data;
+	Position pos = 0;
+	unsigned int reads = 0;
+	bool failReads = false;
+};
+
+// Read one iteration of a loop from loopStart up to loopEnd, as FileGCodeInput does
+static std::string ReadIteration(LoopBodyCache& cache, FakeFile& file, Position loopStart, Position loopEnd, uint32_t seq, bool& hit, TestRandom& rng) noexcept
+{
+	auto readData = [&file](Position pos, char *buf, size_t maxLength) noexcept -> int { return (file.Seek(pos)) ? file.Read(buf, maxLength) : -1; };
+	if (!cache.Restart(loopStart, seq, readData, hit))
+	{
+		(void)file.Seek(loopStart);
+	}
+
+	std::string got;
+	while (got.size() < loopEnd - loopStart)
+	{
+		char buf[64];
+		const size_t maxLength = std::min<size_t>(1 + rng.Next() % sizeof(buf), loopEnd - loopStart - got.size());
+		size_t length = 0;
+		if (cache.IsReplaying())
+		{
+			length = cache.Replay(buf, maxLength);
+			if (length == 0)
+			{
+				(void)file.Seek(cache.GetEnd());		// carry on reading the file after the cached data
+			}
+			else if ((rng.Next() & 7) == 0)
+			{
+				// Pretend that a nested macro was started before we used all the data, so we give some of it back
+				const size_t unused = rng.Next() % (length + 1);
+				cache.Unread(unused);
+				length -= unused;
+			}
+		}
+		if (length == 0 && !cache.IsReplaying())
+		{
+			const int bytesRead = file.Read(buf, maxLength);
+			if (bytesRead <= 0)
+			{
+				break;
+			}
+			length = (size_t)bytesRead;
+		}
+		got.append(buf, length);
+	}
+	return got;
+}
+
+static void ShortLoopTest() noexcept
+{
+	TestRandom rng(1);
+	FakeFile file(5000);
+	LoopBodyCache cache;
+	const Position loopStart = 1000, loopEnd = 1000 + LoopBodyCache::Size - 100;
+	bool hit;
+
+	CHECK(ReadIteration(cache, file, loopStart, loopEnd, 0, hit, rng) == file.data.substr(loopStart, loopEnd - loopStart));
+	CHECK(!hit);
+	const unsigned int readsAfterFirstIteration = file.reads;
+	for (unsigned int i = 0; i < 100; ++i)
+	{
+		CHECK(ReadIteration(cache, file, loopStart, loopEnd, 0, hit, rng) == file.data.substr(loopStart, loopEnd - loopStart));
+		CHECK(hit);
+	}
+	CHECK_MSG(file.reads == readsAfterFirstIteration, "%u reads after the first iteration", file.reads - readsAfterFirstIteration);
+}
+
+static void LongLoopTest() noexcept
+{
+	TestRandom rng(2);
+	FakeFile file(10000);
+	LoopBodyCache cache;
+	const Position loopStart = 123, loopEnd = 123 + 3 * LoopBodyCache::Size + 17;
+	bool hit;
+
+	for (unsigned int i = 0; i < 50; ++i)
+	{
+		CHECK(ReadIteration(cache, file, loopStart, loopEnd, 0, hit, rng) == file.data.substr(loopStart, loopEnd - loopStart));
+		CHECK(hit == (i != 0));
+	}
+
+	// A loop that reaches the end of the file
+	const Position tailStart = file.data.size() - 300;
+	for (unsigned int i = 0; i < 5; ++i)
+	{
+		CHECK(ReadIteration(cache, file, tailStart, file.data.size(), 0, hit, rng) == file.data.substr(tailStart));
+		CHECK(hit == (i != 0));
+	}
+}
+
+// Edits to the file must be seen at the next iteration once the storage sequence number has changed
+static void InvalidationTest() noexcept
+{
+	TestRandom rng(3);
+	FakeFile file(4000);
+	LoopBodyCache cache;
+	const Position loopStart = 200, loopEnd = 700;
+	uint32_t seq = 5;
+	bool hit;
+
+	for (unsigned int i = 0; i < 200; ++i)
+	{
+		if (rng.Next() % 4 == 0)
+		{
+			// Edit the loop body as a file upload would, which changes the sequence number
+			for (unsigned int j = 0; j < 10; ++j)
+			{
+				file.data[loopStart + rng.Next() % (loopEnd - loopStart)] = (char)('a' + rng.Next() % 26);
+			}
+			++seq;
+			CHECK(ReadIteration(cache, file, loopStart, loopEnd, seq, hit, rng) == file.data.substr(loopStart, loopEnd - loopStart));
+			CHECK_MSG(!hit, "iteration %u used the cache after the file was edited", i);
+		}
+		else
+		{
+			CHECK(ReadIteration(cache, file, loopStart, loopEnd, seq, hit, rng) == file.data.substr(loopStart, loopEnd - loopStart));
+			CHECK(hit || i == 0);
+		}
+	}
+
+	// A loop elsewhere in the file replaces the cached one, and a loop that starts inside the cached data uses it
+	CHECK(ReadIteration(cache, file, 2000, 2100, seq, hit, rng) == file.data.substr(2000, 100));
+	CHECK(!hit);
+	CHECK(ReadIteration(cache, file, 2050, 2100, seq, hit, rng) == file.data.substr(2050, 50));
+	CHECK(hit);
+	CHECK(ReadIteration(cache, file, loopStart, loopEnd, seq, hit, rng) == file.data.substr(loopStart, loopEnd - loopStart));
+	CHECK(!hit);
+
+	// Invalidate forgets the data
+	cache.Invalidate();
+	CHECK(!cache.IsReplaying());
+	CHECK(ReadIteration(cache, file, loopStart, loopEnd, seq, hit, rng) == file.data.substr(loopStart, loopEnd - loopStart));
+	CHECK(!hit);
+}
+
+static void ReadFailureTest() noexcept
+{
+	TestRandom rng(4);
+	FakeFile file(2000);
+	LoopBodyCache cache;
+	auto readData = [&file](Position pos, char *buf, size_t maxLength) noexcept -> int { return (file.Seek(pos)) ? file.Read(buf, maxLength) : -1; };
+	bool hit;
+
+	file.failReads = true;
+	CHECK(!cache.Restart(100, 0, readData, hit));
+	CHECK(!hit && !cache.IsReplaying());
+
+	// A loop at the end of the file has nothing to cache
+	file.failReads = false;
+	CHECK(!cache.Restart(2000, 0, readData, hit));
+	CHECK(!cache.IsReplaying());
+
+	// After a failure the next restart must read the file again
+	CHECK(cache.Restart(100, 0, readData, hit));
+	CHECK(!hit && cache.IsReplaying() && cache.GetReplayPosition() == 100);
+	file.failReads = true;
+	CHECK(!cache.Restart(1500, 0, readData, hit));
+	file.failReads = false;
+	CHECK(ReadIteration(cache, file, 100, 400, 0, hit, rng) == file.data.substr(100, 300));
+	CHECK(!hit);
+}
+
+int main()
+{
+	ShortLoopTest();
+	LongLoopTest();
+	InvalidationTest();
+	ReadFailureTest();
+	return TestResult("LoopBodyCacheTest");
+}
+
+// End
@@ -0,0 +1,206 @@
+/*
+ * SectorReadAheadTest.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Test of the SD card sector read-ahead buffer against a fake card held in RAM. We make the same calls as disk_read and disk_write do,
+ * using a random mixture of sequential single-sector reads, random reads, multi-sector reads and writes, and check that every read returns
+ * what is on the card at the time, that we never read past the end of the card, and that sequential reads are turned into multi-block reads.
+ */
+
+#include "TestHarness.h"
+#include <Storage/SectorReadAhead.h>
+#include <vector>
+#include <cstring>
+
+typedef SectorReadAhead::SectorNumber SectorNumber;
+static constexpr size_t SectorSize = SectorReadAhead::SectorSize;
+
+class FakeCard
+{
+public:
+	explicit FakeCard(SectorNumber p_numSectors) noexcept : numSectors(p_numSectors), data(p_numSectors * SectorSize)
+	{
+		for (size_t i = 0; i < data.size(); ++i)
+		{
+			data[i] = (uint8_t)(i * 7 + (i >> 9));
+		}
+	}
+
+	SectorNumber LastSector() const noexcept { return numSectors - 1; }
+	const uint8_t *Sector(SectorNumber sector) const noexcept { return data.data() + sector * SectorSize; }
+
+	bool ReadSectors(uint8_t *buf, SectorNumber sector, unsigned int count) noexcept
+	{
+		++transfers;
+		if (count > 1) { ++multiBlockTransfers; }
+		if (count == 0 || sector > LastSector() || count > numSectors - sector)
+		{
+			outOfRange = true;
+			return false;
+		}
+		if (failNextRead)
+		{
+			failNextRead = false;
+			return false;
+		}
+		memcpy(buf, Sector(sector), count * SectorSize);
+		return true;
+	}
+
+	void WriteSectors(const uint8_t *buf, SectorNumber sector, unsigned int count) noexcept
+	{
+		memcpy(data.data() + sector * SectorSize, buf, count * SectorSize);
+	}
+
+	unsigned int transfers = 0, multiBlockTransfers = 0;
+	bool outOfRange = false;
+	bool failNextRead = false;
+
+private:
+	SectorNumber numSectors;
+	std::vector<uint8_t> data;
+};
+
+// This does what disk_read does
+static bool DiskRead(SectorReadAhead& readAhead, FakeCard& card, uint8_t *buff, SectorNumber sector, unsigned int count) noexcept
+{
+	auto readSectors = [&card](uint8_t *buf, SectorNumber p_sector, unsigned int p_count) noexcept -> bool { return card.ReadSectors(buf, p_sector, p_count); };
+	return readAhead.Read(sector, count, card.LastSector(), buff, readSectors) || card.ReadSectors(buff, sector, count);
+}
+
+// This does what disk_write does
+static void DiskWrite(SectorReadAhead& readAhead, FakeCard& card, const uint8_t *buff, SectorNumber sector, unsigned int count) noexcept
+{
+	readAhead.Invalidate(sector, count);
+	card.WriteSectors(buff, sector, count);
+}
+
+static void TestSequentialReads() noexcept
+{
+	static SectorReadAhead readAhead;
+	readAhead.Invalidate();
+	FakeCard card(1000);
+	uint8_t buf[SectorSize];
+
+	// The first read isn't sequential, so it goes to the card. After that, every NumSectors reads should need one multi-block transfer.
+	const unsigned int numReads = 1 + 10 * SectorReadAhead::NumSectors;
+	for (SectorNumber sector = 100; sector < 100 + numReads; ++sector)
+	{
+		CHECK(DiskRead(readAhead, card, buf, sector, 1));
+		CHECK(memcmp(buf, card.Sector(sector), SectorSize) == 0);
+	}
+	CHECK_MSG(card.transfers == 11, "transfers %u", card.transfers);
+	CHECK_MSG(card.multiBlockTransfers == 10, "multi-block transfers %u", card.multiBlockTransfers);
+
+	uint32_t readAheads, hits;
+	readAhead.GetAndClearCounts(readAheads, hits);
+	CHECK_MSG(readAheads == 10 && hits == 10 * (SectorReadAhead::NumSectors - 1), "read-aheads %u hits %u", (unsigned int)readAheads, (unsigned int)hits);
+	readAhead.GetAndClearCounts(readAheads, hits);
+	CHECK(readAheads == 0 && hits == 0);
+}
+
+static void TestEndOfCard() noexcept
+{
+	static SectorReadAhead readAhead;
+	readAhead.Invalidate();
+	uint8_t buf[SectorSize];
+
+	// Read sequentially up to the last sector, starting at each offset from the end so that the read-ahead is truncated by differing amounts
+	for (SectorNumber numSectors = 1; numSectors <= 3 * SectorReadAhead::NumSectors; ++numSectors)
+	{
+		FakeCard card(numSectors);
+		readAhead.Invalidate();
+		for (SectorNumber sector = 0; sector <= card.LastSector(); ++sector)
+		{
+			CHECK(DiskRead(readAhead, card, buf, sector, 1));
+			CHECK(memcmp(buf, card.Sector(sector), SectorSize) == 0);
+		}
+		CHECK_MSG(!card.outOfRange, "read past the end of a card of %u sectors", (unsigned int)numSectors);
+	}
+}
+
+static void TestReadFailure() noexcept
+{
+	static SectorReadAhead readAhead;
+	readAhead.Invalidate();
+	FakeCard card(100);
+	uint8_t buf[SectorSize];
+
+	CHECK(DiskRead(readAhead, card, buf, 10, 1));
+	CHECK(DiskRead(readAhead, card, buf, 11, 1));
+
+	// Make the read-ahead of sector 21 fail. The buffer must not be used afterwards, and the caller's own read should then succeed.
+	readAhead.Invalidate();
+	CHECK(DiskRead(readAhead, card, buf, 20, 1));
+	card.failNextRead = true;
+	CHECK(DiskRead(readAhead, card, buf, 21, 1));
+	CHECK(memcmp(buf, card.Sector(21), SectorSize) == 0);
+	const unsigned int transfers = card.transfers;
+	CHECK(DiskRead(readAhead, card, buf, 22, 1));
+	CHECK(memcmp(buf, card.Sector(22), SectorSize) == 0);
+	CHECK_MSG(card.transfers == transfers + 1, "%s", "sector 22 was not read from the card after a failed read-ahead");
+}
+
+// Random mixture of reads and writes, checking that we never return stale data
+static void TestRandomAccess() noexcept
+{
+	static SectorReadAhead readAhead;
+	readAhead.Invalidate();
+	TestRandom rng(42);
+	const SectorNumber numSectors = 64;
+	FakeCard card(numSectors);
+	uint8_t buf[8 * SectorSize];
+	SectorNumber next = 0;
+
+	for (unsigned int i = 0; i < 200000; ++i)
+	{
+		const unsigned int op = rng.Next() % 10;
+		if (op < 6)
+		{
+			// Sequential single-sector read, like FatFs reading a directory
+			if (next > card.LastSector())
+			{
+				next = 0;
+			}
+			CHECK(DiskRead(readAhead, card, buf, next, 1));
+			CHECK_MSG(memcmp(buf, card.Sector(next), SectorSize) == 0, "stale data in sector %u at step %u", (unsigned int)next, i);
+			++next;
+		}
+		else if (op < 8)
+		{
+			// Random read of one or more sectors
+			const unsigned int count = 1 + rng.Next() % 8;
+			const SectorNumber sector = rng.Next() % (numSectors - count + 1);
+			CHECK(DiskRead(readAhead, card, buf, sector, count));
+			CHECK_MSG(memcmp(buf, card.Sector(sector), count * SectorSize) == 0, "stale data in sectors %u to %u at step %u", (unsigned int)sector, (unsigned int)(sector + count - 1), i);
+		}
+		else
+		{
+			// Write one or more sectors, often the ones we are reading
+			const unsigned int count = 1 + rng.Next() % 4;
+			const SectorNumber sector = (rng.Next() & 1) ? next : rng.Next() % (numSectors - count + 1);
+			if (sector + count <= numSectors)
+			{
+				for (size_t j = 0; j < count * SectorSize; ++j)
+				{
+					buf[j] = (uint8_t)rng.Next();
+				}
+				DiskWrite(readAhead, card, buf, sector, count);
+			}
+		}
+	}
+	CHECK(!card.outOfRange);
+}
+
+int main()
+{
+	TestSequentialReads();
+	TestEndOfCard();
+	TestReadFailure();
+	TestRandomAccess();
+	return TestResult("SectorReadAheadTest");
+}
+
+// End
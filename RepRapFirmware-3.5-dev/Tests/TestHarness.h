@@ -0,0 +1,47 @@
+/*
+ * TestHarness.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Minimal support for the host tests. Each test program calls CHECK for each condition it tests and returns TestResult() from main.
+ */
+
+#ifndef TESTS_TESTHARNESS_H_
+#define TESTS_TESTHARNESS_H_
+
+#include <cstdio>
+#include <cstdint>
+
+static unsigned int numChecks = 0, numFailures = 0;
+
+#define CHECK(_cond)	do { ++numChecks; if (!(_cond)) { ++numFailures; printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #_cond); } } while (false)
+#define CHECK_MSG(_cond, ...)	do { ++numChecks; if (!(_cond)) { ++numFailures; printf("%s:%d: check failed: %s: ", __FILE__, __LINE__, #_cond); printf(__VA_ARGS__); printf("\n"); } } while (false)
+
+inline int TestResult(const char *testName) noexcept
+{
+	printf("%s: %u checks, %u failed\n", testName, numChecks, numFailures);
+	return (numFailures == 0) ? 0 : 1;
+}
+
+// Simple repeatable pseudo-random number generator, so that failures can be reproduced
+class TestRandom
+{
+public:
+	explicit TestRandom(uint32_t seed) noexcept : state(seed) { }
+
+	uint32_t Next() noexcept
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	double Uniform(double low, double high) noexcept { return low + (high - low) * (double)Next()/4294967296.0; }
+
+private:
+	uint32_t state;
+};
+
+#endif /* TESTS_TESTHARNESS_H_ */
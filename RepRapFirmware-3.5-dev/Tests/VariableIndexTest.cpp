@@ -0,0 +1,164 @@
+/*
+ * VariableIndexTest.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Check the variable hash index against a linear search of the same entries after random additions and removals, including entries with the same key
+ * and keys with colliding hashes, in the same way that VariableSet uses it. Then time removing and re-adding a variable with and without a rebuild
+ * of the index, which is what VariableSet used to do on every Delete and scope end.
+ */
+
+#include "TestHarness.h"
+#include <ObjectModel/VariableIndex.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+
+struct Entry
+{
+	uint32_t hash;
+	unsigned int key;
+	bool isParameter;
+};
+
+static uint32_t HashOf(unsigned int key, uint32_t hashMask) noexcept
+{
+	return (key * 2654435761u) & hashMask;
+}
+
+// Model of a VariableSet: entries are held most recent first, as in its linked list
+class Model
+{
+public:
+	explicit Model(uint32_t p_hashMask) noexcept : hashMask(p_hashMask) { }
+	~Model() { for (Entry *e : entries) { delete e; } }
+
+	void Insert(unsigned int key, bool isParameter) noexcept
+	{
+		Entry *const e = new Entry{ HashOf(key, hashMask), key, isParameter };
+		entries.insert(entries.begin(), e);
+		if (index.IsAllocated() && index.HasRoomFor(entries.size()))
+		{
+			index.Add(e, [e](const Entry *other) noexcept -> bool { return other->key == e->key && other->isParameter == e->isParameter; });
+		}
+		else
+		{
+			Rebuild();
+		}
+	}
+
+	void Remove(size_t n, bool rebuild) noexcept
+	{
+		Entry *const e = entries[n];
+		entries.erase(entries.begin() + n);
+		if (rebuild)
+		{
+			Rebuild();
+		}
+		else
+		{
+			index.Remove(e);
+		}
+		delete e;
+	}
+
+	void Rebuild() noexcept
+	{
+		index.Allocate(entries.size());
+		for (Entry *e : entries)
+		{
+			index.Add(e, [](const Entry *) noexcept -> bool { return false; });
+		}
+	}
+
+	const Entry *IndexFind(unsigned int key, bool isParameter) const noexcept
+	{
+		return index.Find(HashOf(key, hashMask), [key, isParameter](const Entry *e) noexcept -> bool { return e->key == key && e->isParameter == isParameter; });
+	}
+
+	const Entry *LinearFind(unsigned int key, bool isParameter) const noexcept
+	{
+		for (const Entry *e : entries)
+		{
+			if (e->key == key && e->isParameter == isParameter)
+			{
+				return e;
+			}
+		}
+		return nullptr;
+	}
+
+	size_t Size() const noexcept { return entries.size(); }
+
+private:
+	uint32_t hashMask;
+	std::vector<Entry *> entries;
+	VariableIndex<Entry> index;
+};
+
+static void RandomTest(uint32_t hashMask, unsigned int numKeys, TestRandom& rng) noexcept
+{
+	Model model(hashMask);
+	unsigned int mismatches = 0;
+	for (unsigned int op = 0; op < 20000; ++op)
+	{
+		if (model.Size() < 8 || (model.Size() < 200 && rng.Next() % 2 == 0))
+		{
+			model.Insert(rng.Next() % numKeys, rng.Next() % 4 == 0);
+		}
+		else
+		{
+			model.Remove(rng.Next() % model.Size(), false);
+		}
+
+		for (unsigned int key = 0; key < numKeys; ++key)
+		{
+			for (bool isParameter : { false, true })
+			{
+				if (model.IndexFind(key, isParameter) != model.LinearFind(key, isParameter))
+				{
+					++mismatches;
+				}
+			}
+		}
+	}
+	CHECK_MSG(mismatches == 0, "hash mask %08" PRIx32 ", %u keys: %u mismatches", hashMask, numKeys, mismatches);
+}
+
+static double TimeRemoveAndAdd(size_t numVariables, bool rebuild) noexcept
+{
+	constexpr unsigned int NumIterations = 100000;
+	Model model(0xFFFFFFFF);
+	for (unsigned int key = 0; key < numVariables; ++key)
+	{
+		model.Insert(key, false);
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < NumIterations; ++i)
+	{
+		model.Remove(0, rebuild);										// remove the most recent variable, as ending a scope usually does
+		model.Insert(numVariables + i, false);
+	}
+	const auto end = std::chrono::steady_clock::now();
+	CHECK(model.IndexFind(numVariables + NumIterations - 1, false) != nullptr);
+	return std::chrono::duration<double, std::nano>(end - start).count()/NumIterations;
+}
+
+int main()
+{
+	TestRandom rng(54321);
+	RandomTest(0xFFFFFFFF, 50, rng);								// few collisions, many duplicate keys
+	RandomTest(0x7, 50, rng);										// all hashes collide into 8 values, so clusters are long
+	RandomTest(0xFFFFFFFF, 1000, rng);								// mostly distinct keys
+
+	for (size_t numVariables : { 16, 64, 256 })
+	{
+		const double rebuildNs = TimeRemoveAndAdd(numVariables, true);
+		const double incrementalNs = TimeRemoveAndAdd(numVariables, false);
+		printf("Remove and add with %zu variables: %.0fns rebuilding the index, %.0fns updating it\n", numVariables, rebuildNs, incrementalNs);
+	}
+	return TestResult("VariableIndexTest");
+}
@@ -0,0 +1,217 @@
+/*
+ * WebSocketProtocolTest.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Test of the WebSocket handshake key, frame header and frame parser, using the examples in RFC 6455 and then random streams of masked frames
+ * encoded the way a browser does. We check that each frame is reported complete at its last byte and not before, and that the frames
+ * which the protocol forbids are rejected.
+ */
+
+#include "TestHarness.h"
+#include <Networking/WebSocketProtocol.h>
+#include <vector>
+#include <cstring>
+
+typedef WebSocketFrameParser Parser;
+
+// Feed bytes to the parser until it returns a result other than incomplete, returning that result and the number of bytes it used
+static Parser::Result Feed(Parser& parser, const std::vector<uint8_t>& bytes, size_t& used) noexcept
+{
+	Parser::Result result = Parser::Result::incomplete;
+	for (used = 0; used < bytes.size() && result == Parser::Result::incomplete; ++used)
+	{
+		result = parser.ProcessByte(bytes[used]);
+	}
+	return result;
+}
+
+// Feed a frame to the parser, checking that it doesn't report anything until the last byte
+static Parser::Result FeedFrame(Parser& parser, const std::vector<uint8_t>& frame) noexcept
+{
+	size_t used;
+	const Parser::Result result = Feed(parser, frame, used);
+	CHECK_MSG(used == frame.size(), "result %u after %u bytes of %u", (unsigned int)result, (unsigned int)used, (unsigned int)frame.size());
+	return result;
+}
+
+// Encode a masked frame as a client would
+static std::vector<uint8_t> ClientFrame(uint8_t opcode, bool isFinal, const std::vector<uint8_t>& payload, uint32_t mask) noexcept
+{
+	std::vector<uint8_t> frame;
+	frame.push_back((isFinal ? 0x80 : 0) | opcode);
+	const size_t len = payload.size();
+	if (len < 126)
+	{
+		frame.push_back(0x80 | (uint8_t)len);
+	}
+	else if (len <= 0xFFFF)
+	{
+		frame.push_back(0x80 | 126);
+		frame.push_back((uint8_t)(len >> 8));
+		frame.push_back((uint8_t)len);
+	}
+	else
+	{
+		frame.push_back(0x80 | 127);
+		for (int shift = 56; shift >= 0; shift -= 8)
+		{
+			frame.push_back((uint8_t)((uint64_t)len >> shift));
+		}
+	}
+	const uint8_t maskBytes[4] = { (uint8_t)(mask >> 24), (uint8_t)(mask >> 16), (uint8_t)(mask >> 8), (uint8_t)mask };
+	frame.insert(frame.end(), maskBytes, maskBytes + 4);
+	for (size_t i = 0; i < len; ++i)
+	{
+		frame.push_back(payload[i] ^ maskBytes[i & 3]);
+	}
+	return frame;
+}
+
+static void HandshakeTest() noexcept
+{
+	// The example in section 1.3 of RFC 6455
+	char acceptKey[WebSocketAcceptKeyLength + 1];
+	CHECK(MakeWebSocketAcceptKey("dGhlIHNhbXBsZSBub25jZQ==", acceptKey));
+	CHECK_MSG(strcmp(acceptKey, "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") == 0, "got %s", acceptKey);
+
+	// The example in the Mozilla WebSocket server guide
+	CHECK(MakeWebSocketAcceptKey("x3JJHMbDL1EzLkh9GBhXDw==", acceptKey));
+	CHECK_MSG(strcmp(acceptKey, "HSmrc0sMlYUkAGmm5OPpG2HaGWk=") == 0, "got %s", acceptKey);
+}
+
+static void FrameHeaderTest() noexcept
+{
+	struct Example { size_t length; size_t headerLength; uint8_t header[MaxWebSocketFrameHeaderLength]; };
+	static const Example examples[] =
+	{
+		{ 0,		2,	{ 0x81, 0 } },
+		{ 125,		2,	{ 0x81, 125 } },
+		{ 126,		4,	{ 0x81, 126, 0, 126 } },
+		{ 0xFFFF,	4,	{ 0x81, 126, 0xFF, 0xFF } },
+		{ 0x10000,	10,	{ 0x81, 127, 0, 0, 0, 0, 0, 1, 0, 0 } },
+		{ 0x123456,	10,	{ 0x81, 127, 0, 0, 0, 0, 0, 0x12, 0x34, 0x56 } },
+	};
+	for (const Example& ex : examples)
+	{
+		uint8_t header[MaxWebSocketFrameHeaderLength];
+		const size_t headerLength = MakeWebSocketFrameHeader(WsOpText, ex.length, header);
+		CHECK_MSG(headerLength == ex.headerLength && memcmp(header, ex.header, headerLength) == 0, "payload length %u", (unsigned int)ex.length);
+	}
+}
+
+// The examples in section 5.7 of RFC 6455 and other frames that a client might send
+static void RfcExamplesTest() noexcept
+{
+	Parser parser;
+
+	// A single-frame masked text message containing "Hello"
+	CHECK(FeedFrame(parser, { 0x81, 0x85, 0x37, 0xfa, 0x21, 0x3d, 0x7f, 0x9f, 0x4d, 0x51, 0x58 }) == Parser::Result::frameComplete);
+	CHECK(parser.GetOpcode() == WsOpText && parser.IsFinal() && parser.GetPayloadLength() == 5);
+
+	// A fragmented text message containing "Hel" then "lo"
+	const std::vector<uint8_t> hel = { 'H', 'e', 'l' }, lo = { 'l', 'o' };
+	CHECK(FeedFrame(parser, ClientFrame(WsOpText, false, hel, 0x12345678)) == Parser::Result::frameComplete);
+	CHECK(parser.GetOpcode() == WsOpText && !parser.IsFinal() && parser.GetPayloadLength() == 3);
+	CHECK(FeedFrame(parser, ClientFrame(WsOpContinuation, true, lo, 0x9ABCDEF0)) == Parser::Result::frameComplete);
+	CHECK(parser.GetOpcode() == WsOpContinuation && parser.IsFinal() && parser.GetPayloadLength() == 2);
+
+	// A masked ping containing "Hello", whose payload we must keep to return in the pong
+	CHECK(FeedFrame(parser, { 0x89, 0x85, 0x37, 0xfa, 0x21, 0x3d, 0x7f, 0x9f, 0x4d, 0x51, 0x58 }) == Parser::Result::frameComplete);
+	CHECK(parser.GetOpcode() == WsOpPing && parser.GetPayloadLength() == 5 && memcmp(parser.GetControlData(), "Hello", 5) == 0);
+
+	// A close frame with status 1001
+	CHECK(FeedFrame(parser, ClientFrame(WsOpClose, true, { 0x03, 0xE9 }, 0xA5A55A5A)) == Parser::Result::frameComplete);
+	CHECK(parser.GetOpcode() == WsOpClose && parser.GetPayloadLength() == 2 && parser.GetControlData()[0] == 0x03 && parser.GetControlData()[1] == 0xE9);
+
+	// A binary frame of 256 bytes with a 16-bit length, and one of 65536 bytes with a 64-bit length
+	CHECK(FeedFrame(parser, ClientFrame(WsOpBinary, true, std::vector<uint8_t>(256, 0x55), 0)) == Parser::Result::frameComplete);
+	CHECK(parser.GetOpcode() == WsOpBinary && parser.GetPayloadLength() == 256);
+	CHECK(FeedFrame(parser, ClientFrame(WsOpBinary, true, std::vector<uint8_t>(65536, 0xAA), 0x01020304)) == Parser::Result::frameComplete);
+	CHECK(parser.GetOpcode() == WsOpBinary && parser.GetPayloadLength() == 65536);
+
+	// An empty pong
+	CHECK(FeedFrame(parser, ClientFrame(WsOpPong, true, { }, 0)) == Parser::Result::frameComplete);
+	CHECK(parser.GetOpcode() == WsOpPong && parser.GetPayloadLength() == 0);
+}
+
+static void BadFramesTest() noexcept
+{
+	size_t used;
+
+	// Unmasked frame
+	{
+		Parser parser;
+		CHECK(parser.ProcessByte(0x81) == Parser::Result::incomplete);
+		CHECK(parser.ProcessByte(0x05) == Parser::Result::protocolError);
+	}
+
+	// Reserved bits set, as if an extension had been negotiated
+	for (uint8_t rsv = 0x10; rsv <= 0x40; rsv <<= 1)
+	{
+		Parser parser;
+		CHECK(parser.ProcessByte(0x81 | rsv) == Parser::Result::protocolError);
+	}
+
+	// Control frame longer than 125 bytes
+	{
+		Parser parser;
+		CHECK(Feed(parser, ClientFrame(WsOpPing, true, std::vector<uint8_t>(126, 0), 0), used) == Parser::Result::protocolError);
+	}
+
+	// Fragmented control frame
+	{
+		Parser parser;
+		CHECK(Feed(parser, ClientFrame(WsOpClose, false, { 0x03, 0xE8 }, 0), used) == Parser::Result::protocolError);
+	}
+
+	// Payload length of 2^32 or more
+	{
+		Parser parser;
+		std::vector<uint8_t> frame = { 0x82, 0x80 | 127, 0, 0, 0, 1, 0, 0, 0, 0 };
+		CHECK(Feed(parser, frame, used) == Parser::Result::tooBig);
+	}
+}
+
+// Random stream of frames, each of which must be reported complete at its last byte
+static void RandomStreamTest(TestRandom& rng) noexcept
+{
+	static const uint8_t DataOpcodes[] = { WsOpContinuation, WsOpText, WsOpBinary };
+	static const uint8_t ControlOpcodes[] = { WsOpClose, WsOpPing, WsOpPong };
+	Parser parser;
+	for (unsigned int i = 0; i < 20000; ++i)
+	{
+		const bool isControl = (rng.Next() & 3) == 0;
+		const uint8_t opcode = (isControl) ? ControlOpcodes[rng.Next() % 3] : DataOpcodes[rng.Next() % 3];
+		const bool isFinal = isControl || (rng.Next() & 1);
+		const unsigned int sizeClass = rng.Next() % 8;
+		const size_t maxLength = (isControl) ? Parser::MaxControlDataLength : (sizeClass < 5) ? 125 : (sizeClass < 7) ? 0xFFFF : 0x12000;
+		std::vector<uint8_t> payload(rng.Next() % (maxLength + 1));
+		for (uint8_t& b : payload)
+		{
+			b = (uint8_t)rng.Next();
+		}
+
+		const Parser::Result result = FeedFrame(parser, ClientFrame(opcode, isFinal, payload, rng.Next()));
+		CHECK_MSG(result == Parser::Result::frameComplete, "frame %u result %u", i, (unsigned int)result);
+		CHECK(parser.GetOpcode() == opcode && parser.IsFinal() == isFinal && parser.GetPayloadLength() == payload.size());
+		if (isControl)
+		{
+			CHECK_MSG(memcmp(parser.GetControlData(), payload.data(), payload.size()) == 0, "frame %u control data", i);
+		}
+	}
+}
+
+int main()
+{
+	TestRandom rng(6455);
+	HandshakeTest();
+	FrameHeaderTest();
+	RfcExamplesTest();
+	BadFramesTest();
+	RandomStreamTest(rng);
+	return TestResult("WebSocketProtocolTest");
+}
+
+// End
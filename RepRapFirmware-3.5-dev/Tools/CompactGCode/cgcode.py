@@ -0,0 +1,283 @@
+#!/usr/bin/env python3
+"""Convert a GCode file to the compact pre-tokenised format (.cgcode) that RepRapFirmware can print directly.
+
+G0 and G1 commands whose parameters are all X, Y, Z, E and F values are stored as delta-encoded integers.
+All other text (comments, other commands, and moves that would not decode to exactly the same text) is stored verbatim,
+so the firmware reproduces the original file byte for byte. See src/Storage/CompactGCodeReader.h for the file format.
+
+Usage:
+    cgcode.py input.gcode [output.cgcode] [--verify]
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+MAGIC = b"RRFCGC1\n"
+HEADER_LENGTH = 28
+MAX_BLOCK_TEXT_LENGTH = 1024
+MAX_BLOCK_ENCODED_LENGTH = 1024
+MAX_DECIMALS = 9
+MAX_MAGNITUDE = 1 << 53
+
+FIELDS = b"XYZEF"
+F_FIELD = 4
+MOVE_RECORD_FLAG = 0x80
+G0_FLAG = 0x20
+F_FIRST_FLAG = 0x40
+
+MOVE_LINE = re.compile(rb"^G([01])((?: [XYZEF]-?[0-9]+(?:\.[0-9]+)?)+)\n$")
+PARAMETER = re.compile(rb" ([XYZEF])(-?)([0-9]+)(?:\.([0-9]+))?")
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        b = value & 0x7F
+        value >>= 7
+        if value == 0:
+            out.append(b)
+            return bytes(out)
+        out.append(b | 0x80)
+
+
+def zigzag(value):
+    return (value << 1) if value >= 0 else ((-value << 1) - 1)
+
+
+def format_number(value, decimals):
+    """Format a quantised value the same way as CompactGCodeDecoder::AppendNumber"""
+    negative = value < 0
+    magnitude = -value if negative else value
+    int_part, frac_part = divmod(magnitude, 10 ** decimals)
+    s = str(int_part)
+    if decimals != 0:
+        frac = str(frac_part).rjust(decimals, "0").rstrip("0")
+        if frac:
+            s += "." + frac
+    return ("-" + s) if negative else s
+
+
+def parse_move(line):
+    """Return (is_g0, [(field, sign, int_digits, frac_digits)]) if the line looks like a simple move, else None"""
+    m = MOVE_LINE.match(line)
+    if m is None:
+        return None
+    params = [(FIELDS.index(p.group(1)), p.group(2), p.group(3), p.group(4) or b"") for p in PARAMETER.finditer(m.group(2))]
+    return (m.group(1) == b"0", params)
+
+
+def choose_decimals(lines):
+    decimals = [0] * len(FIELDS)
+    for line in lines:
+        move = parse_move(line)
+        if move is not None:
+            for field, _, _, frac in move[1]:
+                if len(frac) <= MAX_DECIMALS:
+                    decimals[field] = max(decimals[field], len(frac))
+    return decimals
+
+
+def encode_move(line, decimals):
+    """Return (flags, [(field, quantised value)]) if the line decodes back to exactly the same text, else None"""
+    move = parse_move(line)
+    if move is None:
+        return None
+    is_g0, params = move
+    fields = [p[0] for p in params]
+    if len(set(fields)) != len(fields):
+        return None
+    if fields != sorted(fields):
+        # The only other order we support is F first followed by the others in the usual order
+        if fields[0] != F_FIELD or fields[1:] != sorted(fields[1:]):
+            return None
+        flags = F_FIRST_FLAG
+    else:
+        flags = 0
+    if is_g0:
+        flags |= G0_FLAG
+
+    values = []
+    for field, sign, int_digits, frac_digits in params:
+        if len(frac_digits) > decimals[field]:
+            return None
+        value = int(int_digits + frac_digits.ljust(decimals[field], b"0"))
+        if sign:
+            value = -value
+        if abs(value) >= MAX_MAGNITUDE:
+            return None
+        original = sign + int_digits + ((b"." + frac_digits) if frac_digits else b"")
+        if format_number(value, decimals[field]).encode() != original:
+            return None
+        flags |= 1 << field
+        values.append((field, value))
+    return (flags, values)
+
+
+class Encoder:
+    def __init__(self, decimals):
+        self.decimals = decimals
+        self.blocks = []            # list of (text start, encoded bytes, text length)
+        self.text_position = 0
+        self.start_block()
+
+    def start_block(self):
+        self.block_text_start = self.text_position
+        self.block_text_length = 0
+        self.records = bytearray()
+        self.verbatim = bytearray()
+        self.values = [0] * len(FIELDS)
+
+    def verbatim_record_length(self, n):
+        return 0 if n == 0 else 1 + len(varint(n)) + n
+
+    def encoded_length(self):
+        return len(self.records) + self.verbatim_record_length(len(self.verbatim))
+
+    def flush_verbatim(self):
+        if self.verbatim:
+            self.records += b"\x00" + varint(len(self.verbatim)) + self.verbatim
+            self.verbatim = bytearray()
+
+    def finish_block(self):
+        self.flush_verbatim()
+        if self.block_text_length != 0:
+            self.blocks.append((self.block_text_start, bytes(self.records), self.block_text_length))
+        self.start_block()
+
+    def add_text(self, data):
+        while data:
+            n = min(len(data), MAX_BLOCK_TEXT_LENGTH - self.block_text_length)
+            while n > 0 and len(self.records) + self.verbatim_record_length(len(self.verbatim) + n) > MAX_BLOCK_ENCODED_LENGTH:
+                n -= 1
+            if n == 0:
+                self.finish_block()
+                continue
+            self.verbatim += data[:n]
+            self.block_text_length += n
+            self.text_position += n
+            data = data[n:]
+
+    def move_record(self, flags, values):
+        record = bytearray([MOVE_RECORD_FLAG | flags])
+        for field, value in values:
+            record += varint(zigzag(value - self.values[field]))
+        return record
+
+    def add_line(self, line):
+        move = encode_move(line, self.decimals)
+        if move is None:
+            self.add_text(line)
+            return
+        flags, values = move
+        record = self.move_record(flags, values)
+        if (self.block_text_length + len(line) > MAX_BLOCK_TEXT_LENGTH
+                or self.encoded_length() + len(record) > MAX_BLOCK_ENCODED_LENGTH):
+            self.finish_block()
+            record = self.move_record(flags, values)
+        self.flush_verbatim()
+        self.records += record
+        for field, value in values:
+            self.values[field] = value
+        self.block_text_length += len(line)
+        self.text_position += len(line)
+
+    def output(self):
+        self.finish_block()
+        out = bytearray(HEADER_LENGTH)
+        index = bytearray()
+        for text_start, records, text_length in self.blocks:
+            index += struct.pack("<II", text_start, len(out))
+            out += struct.pack("<HH", len(records), text_length) + records
+        index_offset = len(out)
+        out += index
+        out[0:HEADER_LENGTH] = MAGIC + struct.pack("<III", self.text_position, index_offset, len(self.blocks)) + bytes(self.decimals) + bytes(3)
+        return bytes(out)
+
+
+def encode(text):
+    lines = text.splitlines(keepends=True)
+    encoder = Encoder(choose_decimals(lines))
+    for line in lines:
+        encoder.add_line(line)
+    return encoder.output()
+
+
+def get_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if b & 0x80 == 0:
+            return value, pos
+        shift += 7
+
+
+def decode(data):
+    """Decode a compact GCode file in the same way as the firmware does, returning the original text"""
+    if data[:8] != MAGIC:
+        raise ValueError("not a compact GCode file")
+    text_length, index_offset, num_blocks = struct.unpack_from("<III", data, 8)
+    decimals = data[20:25]
+    out = bytearray()
+    for block in range(num_blocks):
+        text_start, offset = struct.unpack_from("<II", data, index_offset + 8 * block)
+        if text_start != len(out):
+            raise ValueError("block %d index entry is wrong" % block)
+        encoded_length, block_text_length = struct.unpack_from("<HH", data, offset)
+        pos = offset + 4
+        end = pos + encoded_length
+        values = [0] * len(FIELDS)
+        block_text = bytearray()
+        while pos < end:
+            record_type = data[pos]
+            pos += 1
+            if record_type == 0:
+                n, pos = get_varint(data, pos)
+                block_text += data[pos:pos + n]
+                pos += n
+            elif record_type & MOVE_RECORD_FLAG:
+                block_text += b"G0" if record_type & G0_FLAG else b"G1"
+                order = [F_FIELD, 0, 1, 2, 3] if record_type & F_FIRST_FLAG else [0, 1, 2, 3, F_FIELD]
+                for field in order:
+                    if record_type & (1 << field):
+                        z, pos = get_varint(data, pos)
+                        values[field] += (z >> 1) ^ -(z & 1)
+                        block_text += b" " + FIELDS[field:field + 1] + format_number(values[field], decimals[field]).encode()
+                block_text += b"\n"
+            else:
+                raise ValueError("bad record type in block %d" % block)
+        if len(block_text) != block_text_length:
+            raise ValueError("block %d decodes to the wrong length" % block)
+        out += block_text
+    if len(out) != text_length:
+        raise ValueError("decoded text has the wrong length")
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert a GCode file to compact RepRapFirmware format")
+    parser.add_argument("input", help="GCode file to convert")
+    parser.add_argument("output", nargs="?", help="output file, default is the input file name with extension .cgcode")
+    parser.add_argument("--verify", action="store_true", help="decode the output and check that it matches the input")
+    args = parser.parse_args()
+
+    output = args.output
+    if output is None:
+        output = args.input.rsplit(".", 1)[0] + ".cgcode"
+
+    with open(args.input, "rb") as f:
+        text = f.read()
+    data = encode(text)
+    if args.verify and decode(data) != text:
+        sys.exit("Verification failed")
+    with open(output, "wb") as f:
+        f.write(data)
+    print("%s: %d bytes -> %s: %d bytes (%.1f%%)" % (args.input, len(text), output, len(data), 100.0 * len(data) / max(len(text), 1)))
+
+
+if __name__ == "__main__":
+    main()
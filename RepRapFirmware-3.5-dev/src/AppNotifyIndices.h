@@ -32,6 +32,9 @@ namespace NotifyIndices
 	constexpr uint32_t Tmc = FirstAvailableApp + 2;
 	constexpr uint32_t Move = FirstAvailableApp + 2;
 	constexpr uint32_t DueX = FirstAvailableApp + 2;
+	constexpr uint32_t FileReadAhead = FirstAvailableApp + 2;
+	constexpr uint32_t Logger = FirstAvailableApp + 2;
+	constexpr uint32_t FileWriteBehind = FirstAvailableApp + 2;
 	constexpr uint32_t CanMessageQueue = FirstAvailableApp + 3;
 	constexpr uint32_t CanSender = FirstAvailableApp + 3;
 	constexpr uint32_t SbcInterface = FirstAvailableApp + 3;
@@ -13,6 +13,7 @@
 #include <CanMessageFormats.h>
 #include "CanInterface.h"
 #include <General/FreelistManager.h>
+#include <Movement/MovePrepProfiler.h>
 
 namespace CanMotion
 {
@@ -179,6 +180,7 @@ void CanMotion::AddExtruderMovement(const PrepParams& params, DriverId canDriver
 // This is called by DDA::Prepare when all DMs for CAN drives have been processed. Return the calculated move time in steps, or 0 if there are no CAN moves
 uint32_t CanMotion::FinishMovement(const DDA& dda, uint32_t moveStartTime, bool simulating) noexcept
 {
+	PROFILE_MOVE_PREP_STAGE(canFinishMovement);
 	uint32_t clocks = 0;
 	if (simulating || dda.GetState() == DDA::completed)
 	{
@@ -95,12 +95,22 @@ constexpr unsigned int MaxBlockIndent = 10;				// maximum indentation of GCode.
 //     Using single-precision maths and up to 9-factor calibration: (9 + 5) * 4 bytes per point
 //     Using double-precision maths and up to 9-factor calibration: (9 + 5) * 8 bytes per point
 //   So 32 points using double precision arithmetic need 3584 bytes of stack space.
-#if SAME70
-constexpr size_t MaxGridProbePoints = 961;				// 961 allows us to probe e.g. 300x300 at 10mm intervals
+// The height map uses 4 bytes + 2 bits per grid point, or 2 bytes + 2 bits when SUPPORT_COMPACT_HEIGHT_MAP is set.
+#if SUPPORT_COMPACT_HEIGHT_MAP
+# if SAME70
+constexpr size_t MaxGridProbePoints = 1764;				// 1764 allows us to probe e.g. 410x410 at 10mm intervals in about the same RAM as 961 float points
+# else
+constexpr size_t MaxGridProbePoints = 784;				// 784 allows us to probe e.g. 540x540 at 20mm intervals in about the same RAM as 441 float points
+# endif
+constexpr size_t MaxAxis0GridPoints = 81;				// Maximum number of grid points in one X row
 #else
+# if SAME70
+constexpr size_t MaxGridProbePoints = 961;				// 961 allows us to probe e.g. 300x300 at 10mm intervals
+# else
 constexpr size_t MaxGridProbePoints = 441;				// 441 allows us to probe e.g. 400x400 at 20mm intervals
-#endif
+# endif
 constexpr size_t MaxAxis0GridPoints = 41;				// Maximum number of grid points in one X row
+#endif
 constexpr size_t MaxProbePoints = 32;					// Maximum number of G30 probe points
 constexpr size_t MaxCalibrationPoints = 32;				// Should a power of 2 for speed
 
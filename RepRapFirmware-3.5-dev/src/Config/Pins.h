@@ -253,6 +253,119 @@
 # define SUPPORT_PROBE_POINTS_FILE	0
 #endif
 
+// Set SUPPORT_COMPACT_HEIGHT_MAP to store height map points as 16-bit integer micrometres instead of floats, allowing larger grids in the same RAM.
+// Large format machines with scanning probes are the ones that need big grids, and they use Duet 3 main boards.
+#ifndef SUPPORT_COMPACT_HEIGHT_MAP
+# if SAME70
+#  define SUPPORT_COMPACT_HEIGHT_MAP	1
+# else
+#  define SUPPORT_COMPACT_HEIGHT_MAP	0
+# endif
+#endif
+
+// Set SUPPORT_MOVE_PREP_PROFILING to record histograms of the time taken by each stage of move preparation (reported by M122 and in move.prepTimings)
+// This adds timing code to the move preparation path including the step interrupt, so it is only intended for debug builds
+#ifndef SUPPORT_MOVE_PREP_PROFILING
+# define SUPPORT_MOVE_PREP_PROFILING	0
+#endif
+
+// Set SUPPORT_LOOP_BODY_CACHE to keep the body of the most recently restarted 'while' loop in RAM, so that later iterations don't need to read the file again
+#ifndef SUPPORT_LOOP_BODY_CACHE
+# if SAME70 || SAME5x
+#  define SUPPORT_LOOP_BODY_CACHE		1
+# else
+#  define SUPPORT_LOOP_BODY_CACHE		0
+# endif
+#endif
+
+// Set SUPPORT_OBJECT_MODEL_CBOR to allow clients to fetch the object model in CBOR format instead of JSON
+#ifndef SUPPORT_OBJECT_MODEL_CBOR
+# if SUPPORT_OBJECT_MODEL && (SAME70 || SAME5x)
+#  define SUPPORT_OBJECT_MODEL_CBOR		1
+# else
+#  define SUPPORT_OBJECT_MODEL_CBOR		0
+# endif
+#endif
+
+// Set SUPPORT_WEBSOCKETS to allow HTTP clients to upgrade an rr_model request to a WebSocket on which we push object model changes
+#ifndef SUPPORT_WEBSOCKETS
+# if SUPPORT_HTTP && SUPPORT_OBJECT_MODEL && (SAME70 || SAME5x)
+#  define SUPPORT_WEBSOCKETS			1
+# else
+#  define SUPPORT_WEBSOCKETS			0
+# endif
+#endif
+
+// Set SUPPORT_COMPACT_GCODE to allow printing files in the compact pre-tokenised GCode format (.cgcode files)
+#ifndef SUPPORT_COMPACT_GCODE
+# if HAS_MASS_STORAGE && (SAME70 || SAME5x)
+#  define SUPPORT_COMPACT_GCODE			1
+# else
+#  define SUPPORT_COMPACT_GCODE			0
+# endif
+#endif
+
+// Set SUPPORT_FILE_READ_AHEAD to read the file being printed into RAM in a separate task ahead of the position being parsed
+#ifndef SUPPORT_FILE_READ_AHEAD
+# if HAS_MASS_STORAGE && (SAME70 || SAME5x)
+#  define SUPPORT_FILE_READ_AHEAD		1
+# else
+#  define SUPPORT_FILE_READ_AHEAD		0
+# endif
+#endif
+
+// Set SUPPORT_SD_READ_AHEAD to turn sequential single-sector reads from SD cards into multi-block reads of several sectors.
+// This is off by default because SUPPORT_FILE_READ_AHEAD already reads the print file in large blocks,
+// and the gain for directory and FAT reads has not been measured. M122 reports the single and multi-block read counts to help evaluate it.
+#ifndef SUPPORT_SD_READ_AHEAD
+# define SUPPORT_SD_READ_AHEAD			0
+#endif
+
+// Set SUPPORT_FILE_INFO_INDEX to keep the information parsed from G-code files in a hidden index file in each directory, so that we don't parse the files again
+#ifndef SUPPORT_FILE_INFO_INDEX
+# if HAS_MASS_STORAGE && (SAME70 || SAME5x)
+#  define SUPPORT_FILE_INFO_INDEX		1
+# else
+#  define SUPPORT_FILE_INFO_INDEX		0
+# endif
+#endif
+
+// Set SUPPORT_DIRECTORY_CURSORS to remember where a paged directory listing stopped, so that fetching the next page doesn't need to read the directory from the start
+#ifndef SUPPORT_DIRECTORY_CURSORS
+# if HAS_MASS_STORAGE && (SAME70 || SAME5x)
+#  define SUPPORT_DIRECTORY_CURSORS		1
+# else
+#  define SUPPORT_DIRECTORY_CURSORS		0
+# endif
+#endif
+
+// Set SUPPORT_ASYNC_LOGGER to queue log messages in RAM and write them to the log file from a separate task, so that SD card latency doesn't hold up the tasks that log them
+#ifndef SUPPORT_ASYNC_LOGGER
+# if HAS_MASS_STORAGE && (SAME70 || SAME5x)
+#  define SUPPORT_ASYNC_LOGGER			1
+# else
+#  define SUPPORT_ASYNC_LOGGER			0
+# endif
+#endif
+
+// Set SUPPORT_UPLOAD_WRITE_BEHIND to queue uploaded data in RAM and write it to the file from a separate task, so that SD card latency doesn't hold up the network task
+#ifndef SUPPORT_UPLOAD_WRITE_BEHIND
+# if HAS_MASS_STORAGE && (SAME70 || SAME5x)
+#  define SUPPORT_UPLOAD_WRITE_BEHIND	1
+# else
+#  define SUPPORT_UPLOAD_WRITE_BEHIND	0
+# endif
+#endif
+
+// Set SUPPORT_PARSE_AHEAD to decode simple motion commands in the file being printed while the previous move is waiting to be queued
+#ifndef SUPPORT_PARSE_AHEAD
+# if (HAS_MASS_STORAGE || HAS_EMBEDDED_FILES) && (SAME70 || SAME5x)
+#  define SUPPORT_PARSE_AHEAD			1
+# else
+#  define SUPPORT_PARSE_AHEAD			0
+# endif
+#endif
+
 // Optional kinematics support, to allow us to reduce flash memory usage
 #ifndef SUPPORT_LINEAR_DELTA
 # define SUPPORT_LINEAR_DELTA	1
@@ -376,6 +376,9 @@ void GCodeBuffer::ForkFrom(const GCodeBuffer& other) noexcept
 	while (ms != nullptr)
 	{
 		GCodeMachineState *const msToDelete = ms;
+#if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
+		ReleaseFileInput(*msToDelete);
+#endif
 		ms = ms->GetPrevious();
 		delete msToDelete;
 	}
@@ -387,8 +390,8 @@ void GCodeBuffer::ForkFrom(const GCodeBuffer& other) noexcept
 	if (!isBinaryBuffer && !reprap.UsingSbcInterface())
 # endif
 	{
+		GetFileInput()->Reset(machineState->fileState);		// do this before we seek, because it may set the file position
 		machineState->fileState.Seek(other.GetJobFilePosition());
-		GetFileInput()->Reset(machineState->fileState);
 		stringParser.StartNewFile();
 	}
 }
@@ -1012,6 +1015,9 @@ bool GCodeBuffer::PopState(bool withinSameFile) noexcept
 		}
 
 		poppedFileState = !ms->localPush;
+#if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
+		ReleaseFileInput(*ms);
+#endif
 		machineState = ms->Pop();						// get the previous state and copy down any error message
 		delete ms;
 	} while (!withinSameFile && !poppedFileState);
@@ -1270,6 +1276,9 @@ void GCodeBuffer::SavePrintingFilePosition() noexcept
 
 void GCodeBuffer::WaitForAcknowledgement(uint32_t seq) noexcept
 {
+#if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
+	ReleaseFileInput(*machineState);					// the machine state closes its file
+#endif
 	machineState->WaitForAcknowledgement(seq);
 #if HAS_SBC_INTERFACE
 	if (reprap.UsingSbcInterface())
@@ -1325,6 +1334,71 @@ void GCodeBuffer::RestartFrom(FilePosition pos) noexcept
 	Init();											// clear the next move
 }
 
+#if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
+
+// Tell the file input that a machine state is about to close its file, so that the file input discards any data and releases any loop body cache it holds for it.
+// We don't do this if the previous machine state is using the same file, because then the file stays open.
+void GCodeBuffer::ReleaseFileInput(const GCodeMachineState& ms) noexcept
+{
+	if (ms.fileState.IsLive() && (ms.GetPrevious() == nullptr || ms.GetPrevious()->fileState != ms.fileState))
+	{
+		fileInput->Reset(ms.fileState);
+	}
+}
+
+#endif
+
+// Go back to the start of a loop in the current file
+void GCodeBuffer::RestartLoop(FilePosition loopStart) noexcept
+{
+#if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
+	if (machineState->fileState.IsLive())
+	{
+		fileInput->RestartLoop(machineState->fileState, loopStart);
+	}
+#endif
+	Init();
+}
+
+#if SUPPORT_PARSE_AHEAD
+
+// If the current command is a G0, G1, G2 or G3 command from a file that is waiting for the movement system to accept it,
+// decode the simple motion commands that follow it so that we can execute them sooner.
+// The file input is shared between channels, so we only do this if the data it holds is already from our file. Otherwise reading our file
+// would make it give up the data of the file that another channel is reading (e.g. daemon.g), and that channel would then do the same to us.
+void GCodeBuffer::ParseAhead() noexcept
+{
+	if (   IsDoingLocalFile()
+# if HAS_SBC_INTERFACE
+		&& !reprap.UsingSbcInterface()
+# endif
+		&& machineState->fileState.IsLive()
+		&& fileInput->IsHoldingDataFor(machineState->fileState)
+		&& GetCommandLetter() == 'G' && GetCommandNumber() >= 0 && GetCommandNumber() <= 3
+	   )
+	{
+		FileData& fd = machineState->fileState;
+		if (fileInput->ReadFromFile(fd, IsFileChannel() && !IsDoingFileMacro()) == GCodeInputReadResult::haveData)
+		{
+			fileInput->ParseAhead(fd);
+		}
+	}
+}
+
+// If the next line of the file has been decoded, make it the current command and return true
+bool GCodeBuffer::UsePreDecodedLine() noexcept
+{
+	const PreDecodedLine *_ecv_null const line = fileInput->GetPreDecodedLine(machineState->fileState);
+	if (line != nullptr && stringParser.LoadPreDecodedLine(*line))
+	{
+		fileInput->ConsumePreDecodedLine();
+		return true;
+	}
+	return false;
+}
+
+#endif
+
 const char* GCodeBuffer::DataStart() const noexcept
 {
 	return PARSER_OPERATION(DataStart());
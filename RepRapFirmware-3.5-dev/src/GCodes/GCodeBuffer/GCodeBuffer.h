@@ -289,6 +289,11 @@ public:
 	bool IsCancelWaitRequested() noexcept;
 
 	void RestartFrom(FilePosition pos) noexcept;
+	void RestartLoop(FilePosition loopStart) noexcept;
+#if SUPPORT_PARSE_AHEAD
+	void ParseAhead() noexcept;									// Decode simple motion commands that follow the current one while it waits to be executed
+	bool UsePreDecodedLine() noexcept;							// If the next line of the file has been decoded, make it the current command
+#endif
 
 #if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
 	FileGCodeInput *GetFileInput() const noexcept { return fileInput; }
@@ -329,6 +334,10 @@ private:
 	const char *GetStateText() const noexcept;
 #endif
 
+#if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
+	void ReleaseFileInput(const GCodeMachineState& ms) noexcept;		// tell the file input that a machine state is about to stop using its file
+#endif
+
 	FilePosition printFilePositionAtMacroStart;			// the saved file position when we started executing a macro
 	GCodeInput *normalInput;							// Our normal input stream, or nullptr if there isn't one
 
@@ -37,6 +37,9 @@ void StringParser::Init() noexcept
 	gcodeLineEnd = 0;
 	commandStart = commandLength = 0;								// set both to zero so that calls to GetFilePosition don't return negative values
 	readPointer = -1;
+#if SUPPORT_PARSE_AHEAD
+	numPreDecodedValues = 0;
+#endif
 	hadLineNumber = hadChecksum = overflowed = seenExpression = false;
 	computedChecksum = 0;
 	gb.bufferState = GCodeBufferState::parseNotStarted;
@@ -402,7 +405,7 @@ bool StringParser::CheckMetaCommand(const StringRef& reply) THROWS(GCodeExceptio
 #if SUPPORT_ASYNC_MOVES
 				gb.CurrentFileMachineState().fpos = gb.GetBlockState().GetFilePosition();
 #endif
-				gb.RestartFrom(gb.GetBlockState().GetFilePosition());
+				gb.RestartLoop(gb.GetBlockState().GetFilePosition());
 				Init();
 				return true;
 			}
@@ -437,6 +440,49 @@ bool StringParser::CheckMetaCommand(const StringRef& reply) THROWS(GCodeExceptio
 	return b;
 }
 
+#if SUPPORT_PARSE_AHEAD
+
+// Make a line that was decoded ahead of time the current command, instead of assembling it from the input stream and decoding it.
+// Return false if we can't use it because we have already started to assemble a line, or the line might be part of a block.
+bool StringParser::LoadPreDecodedLine(const PreDecodedLine& line) noexcept
+{
+	if (   gb.bufferState != GCodeBufferState::parseNotStarted
+		|| gcodeLineEnd != 0
+		|| indentToSkipTo != NoIndentSkip
+		|| gb.GetBlockIndent() != 0
+		|| fileBeingWritten != nullptr
+		|| reprap.GetDebugFlags(Module::Gcodes).IsBitSet(gb.GetChannel().ToBaseType())		// so that LineFinished prints the line
+	   )
+	{
+		return false;
+	}
+
+	memcpy(gb.buffer, line.text, line.textLength);
+	gb.buffer[line.textLength] = 0;
+	commandStart = 0;
+	parameterStart = line.parameterStart;
+	commandEnd = gcodeLineEnd = line.textLength;
+	commandLength = line.lineLength;
+	parametersPresent = line.parameters;
+	commandLetter = 'G';
+	hasCommandNumber = true;
+	commandNumber = line.commandNumber;
+	commandFraction = -1;
+	numPreDecodedValues = line.numValues;
+	memcpy(preDecodedValues, line.values, line.numValues * sizeof(PreDecodedLine::Value));
+	seenLeadingSpace = seenLeadingTab = false;					// as CheckMetaCommand does for a line that isn't indented
+
+	// Do what LineFinished does for a line read from a file
+	++gb.CurrentFileMachineState().lineNumber;
+#if SUPPORT_ASYNC_MOVES
+	gb.CurrentFileMachineState().fpos = line.position;
+#endif
+	gb.bufferState = GCodeBufferState::ready;
+	return true;
+}
+
+#endif
+
 void StringParser::CheckForMixedSpacesAndTabs() noexcept
 {
 	if (seenMetaCommand && !warnedAboutMixedSpacesAndTabs && seenLeadingSpace && seenLeadingTab)
@@ -673,7 +719,7 @@ void StringParser::ProcessContinueCommand() THROWS(GCodeException)
 #if SUPPORT_ASYNC_MOVES
 	gb.CurrentFileMachineState().fpos = gb.GetBlockState().GetFilePosition();
 #endif
-	gb.RestartFrom(gb.GetBlockState().GetFilePosition());
+	gb.RestartLoop(gb.GetBlockState().GetFilePosition());
 }
 
 void StringParser::ProcessVarOrGlobalCommand(bool isGlobal) THROWS(GCodeException)
@@ -1195,7 +1241,7 @@ FilePosition StringParser::GetFilePosition() const noexcept
 	   )
 	{
 		const FileData &file = ms->fileState;
-		return file.GetPosition() - gb.fileInput->FileBytesCached(file) - commandLength + commandStart;
+		return gb.fileInput->GetPosition(file) - commandLength + commandStart;
 	}
 #endif
 	return noFilePosition;
@@ -1940,6 +1986,17 @@ float StringParser::ReadFloatValue() THROWS(GCodeException)
 		return val;
 	}
 
+#if SUPPORT_PARSE_AHEAD
+	for (size_t i = 0; i < numPreDecodedValues; ++i)
+	{
+		if (preDecodedValues[i].start == (unsigned int)readPointer)
+		{
+			readPointer = preDecodedValues[i].end;
+			return preDecodedValues[i].value;
+		}
+	}
+#endif
+
 	const char *endptr;
 	const float rslt = SafeStrtof(gb.buffer + readPointer, &endptr);
 	CheckNumberFound(endptr);
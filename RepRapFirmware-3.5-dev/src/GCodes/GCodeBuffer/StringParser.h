@@ -34,6 +34,9 @@ public:
 	void StartNewFile() noexcept;											// Called when we start a new file
 	bool FileEnded() noexcept;												// Called when we reach the end of the file we are reading from
 	bool CheckMetaCommand(const StringRef& reply) THROWS(GCodeException);	// Check whether the current command is a meta command, or we are skipping block
+#if SUPPORT_PARSE_AHEAD
+	bool LoadPreDecodedLine(const PreDecodedLine& line) noexcept;			// Make a line that was decoded ahead the current command
+#endif
 
 	// The following may be called after calling DecodeCommand
 	char GetCommandLetter() const noexcept { return commandLetter; }
@@ -136,6 +139,10 @@ private:
 	unsigned int gcodeLineEnd;							// Number of characters in the entire line of gcode
 	ParameterLettersBitmap parametersPresent;			// which parameters are present in this command
 	int readPointer;									// Where in the buffer to read next, or -1
+#if SUPPORT_PARSE_AHEAD
+	size_t numPreDecodedValues;							// The number of parameter values that were decoded ahead, zero if the line wasn't decoded ahead
+	PreDecodedLine::Value preDecodedValues[PreDecodedLine::MaxValues];
+#endif
 
 	FileStore *fileBeingWritten;						// If we are copying GCodes to a file, which file it is
 	FilePosition writingFileSize;						// Size of the file being written, or zero if not known
@@ -11,6 +11,10 @@
 #include "GCodes.h"
 #include "GCodeBuffer/GCodeBuffer.h"
 
+#if SUPPORT_FILE_READ_AHEAD
+# include <Movement/StepTimer.h>
+#endif
+
 const size_t GCodeInputFileReadThreshold = 128;		// How many free bytes must be available before data is read from the file
 const size_t GCodeInputUSBReadThreshold = 128;		// How many free bytes must be available before we read more data from USB
 
@@ -252,9 +256,32 @@ bool NetworkGCodeInput::FillBuffer(GCodeBuffer *gb) noexcept /*override*/
 
 // File-based G-code input source
 
+#if SUPPORT_LOOP_BODY_CACHE
+LoopBodyCache FileGCodeInput::loopCache;
+FileGCodeInput *_ecv_null FileGCodeInput::loopCacheUser = nullptr;
+FileData FileGCodeInput::cachedFile;
+#endif
+
 // Reset this input. Should be called when the associated file is being closed
 void FileGCodeInput::Reset() noexcept
 {
+#if SUPPORT_LOOP_BODY_CACHE
+	if (IsUsingLoopCache(lastFileRead))
+	{
+		ReleaseLoopCache();
+	}
+#endif
+#if SUPPORT_FILE_READ_AHEAD
+	if (IsReadingAhead(lastFileRead))
+	{
+		readAhead->Stop();
+	}
+	directData = nullptr;
+	directLength = directOffset = 0;
+#endif
+#if SUPPORT_PARSE_AHEAD
+	parseAhead.Clear();
+#endif
 	lastFileRead.Close();
 	RegularGCodeInput::Reset();
 }
@@ -262,31 +289,172 @@ void FileGCodeInput::Reset() noexcept
 // Reset this input. Should be called when a specific G-code or macro file is closed outside of the reading context
 void FileGCodeInput::Reset(const FileData &file) noexcept
 {
+#if SUPPORT_LOOP_BODY_CACHE
+	if (IsUsingLoopCache(file))
+	{
+		ReleaseLoopCache();
+	}
+#endif
+#if SUPPORT_FILE_READ_AHEAD
+	// The caller sets the file position, so we don't need to set it to the position that we had read up to
+	if (IsReadingAhead(file))
+	{
+		readAhead->Stop();
+	}
+#endif
+#if SUPPORT_PARSE_AHEAD
+	if (parseAhead.IsFor(file))
+	{
+		parseAhead.Clear();
+	}
+#endif
 	if (lastFileRead == file)
 	{
 		Reset();
 	}
 }
 
+#if SUPPORT_FILE_READ_AHEAD
+
+// How many bytes have been cached? This includes data in the current read-ahead buffer that we haven't passed on yet.
+size_t FileGCodeInput::BytesCached() const noexcept
+{
+	return RegularGCodeInput::BytesCached() + (directLength - directOffset);
+}
+
+// Get the next byte. Any data in our own buffer precedes the read-ahead data.
+char FileGCodeInput::ReadByte() noexcept
+{
+	return (readingPointer == writingPointer && directOffset < directLength) ? directData[directOffset++] : RegularGCodeInput::ReadByte();
+}
+
+#endif
+
+// Get the position in the file of the next byte that has not been passed to a GCodeBuffer
+FilePosition FileGCodeInput::GetPosition(const FileData &file) const noexcept
+{
+#if SUPPORT_FILE_READ_AHEAD
+	if (IsReadingAhead(file))
+	{
+		// Any data in our own buffer was read from the file just before the read-ahead started
+		return (lastFileRead == file)
+				? readAhead->GetPosition() + directOffset - RegularGCodeInput::BytesCached()
+					: readAhead->GetPosition();
+	}
+#endif
+#if SUPPORT_LOOP_BODY_CACHE
+	const FilePosition readPos = (IsReplaying(file)) ? loopCache.GetReplayPosition() : file.GetPosition();
+#else
+	const FilePosition readPos = file.GetPosition();
+#endif
+	return readPos - FileBytesCached(file);
+}
+
+// Go back to the start of a loop in the specified file, discarding any buffered data from that file.
+// The first time we do this for a loop we read as much of the file from the start of the loop as will fit into the loop body cache, then on subsequent iterations we replay it from RAM.
+// If any file has been written, renamed or deleted since we filled the cache then we read it again, in case the loop body has been edited.
+void FileGCodeInput::RestartLoop(FileData &file, FilePosition loopStart) noexcept
+{
+#if SUPPORT_FILE_READ_AHEAD
+	// We are about to seek the file, so there is no need to set its position to the position that we had read up to
+	if (IsReadingAhead(file))
+	{
+		readAhead->Stop();
+	}
+	if (lastFileRead == file)
+	{
+		directData = nullptr;
+		directLength = directOffset = 0;
+	}
+#endif
+	if (lastFileRead == file)
+	{
+		lastFileRead.Close();
+		RegularGCodeInput::Reset();
+	}
+
+#if SUPPORT_LOOP_BODY_CACHE
+	if (loopCacheUser != nullptr && !IsUsingLoopCache(file))
+	{
+		loopCacheUser->ReleaseLoopCache();
+	}
+
+# if HAS_MASS_STORAGE
+	const uint32_t storageSeq = MassStorage::GetStorageSeq();	// this changes if the file may have been edited since we cached it
+# else
+	const uint32_t storageSeq = 0;								// embedded files never change
+# endif
+	auto readData = [&file](FilePosition pos, char *_ecv_array buf, size_t maxLength) noexcept -> int
+						{ return (file.Seek(pos)) ? file.Read(buf, maxLength) : -1; };
+	bool hit;
+	if (loopCache.Restart(loopStart, storageSeq, readData, hit))
+	{
+		if (hit)
+		{
+			++loopCacheHits;
+		}
+		else
+		{
+			++loopCacheMisses;
+		}
+		if (loopCacheUser == nullptr)
+		{
+			cachedFile.CopyFrom(file);
+			loopCacheUser = this;
+		}
+		return;
+	}
+
+	++loopCacheMisses;
+	ReleaseLoopCache();
+#endif
+
+	(void)file.Seek(loopStart);
+}
+
 // How many bytes have been cached for the given file?
 size_t FileGCodeInput::FileBytesCached(const FileData &file) const noexcept
 {
-	return (lastFileRead == file) ? RegularGCodeInput::BytesCached() : 0;
+	return (lastFileRead == file) ? BytesCached() : 0;
 }
 
 // Read another chunk of G-codes from the file and return true if more data is available
-GCodeInputReadResult FileGCodeInput::ReadFromFile(FileData &file) noexcept
+GCodeInputReadResult FileGCodeInput::ReadFromFile(FileData &file, bool isPrintFile) noexcept
 {
 	size_t bytesCached = RegularGCodeInput::BytesCached();
 
 	// Keep track of the last file we read from
 	if (lastFileRead != file)
 	{
+#if SUPPORT_FILE_READ_AHEAD
+		if (IsReadingAhead(lastFileRead))
+		{
+			// Leave the read-ahead task running so that the data is ready when we return to the file, unless we have data in our own buffer that precedes it
+			if (bytesCached == 0)
+			{
+				ReleaseReadAheadData();
+			}
+			else
+			{
+				StopReadAhead(lastFileRead);
+			}
+		}
+		else
+#endif
 		if (lastFileRead.IsLive() && bytesCached > 0)
 		{
 			// Rewind back to the right position so we can resume at the right position later.
 			// This may be necessary when nested macros are executed.
-			lastFileRead.Seek(lastFileRead.GetPosition() - bytesCached);
+#if SUPPORT_LOOP_BODY_CACHE
+			if (IsReplaying(lastFileRead))
+			{
+				loopCache.Unread(bytesCached);
+			}
+			else
+#endif
+			{
+				lastFileRead.Seek(lastFileRead.GetPosition() - bytesCached);
+			}
 		}
 
 		RegularGCodeInput::Reset();
@@ -295,6 +463,13 @@ GCodeInputReadResult FileGCodeInput::ReadFromFile(FileData &file) noexcept
 		lastFileRead.CopyFrom(file);
 	}
 
+#if SUPPORT_FILE_READ_AHEAD
+	if (IsReadingAhead(file))
+	{
+		return GetReadAheadData(bytesCached);
+	}
+#endif
+
 	// Read more from the file
 	if (bytesCached < GCodeInputFileReadThreshold)
 	{
@@ -304,10 +479,41 @@ GCodeInputReadResult FileGCodeInput::ReadFromFile(FileData &file) noexcept
 			readingPointer = writingPointer = 0;
 		}
 
+		const size_t maxBytes = min<size_t>(BufferSpaceLeft(), GCodeInputBufferSize - writingPointer);
+#if SUPPORT_LOOP_BODY_CACHE
+		if (IsReplaying(file))
+		{
+			const size_t bytesCopied = loopCache.Replay(buffer + writingPointer, maxBytes);
+			if (bytesCopied != 0)
+			{
+				++fileReadsAvoided;
+				writingPointer = (writingPointer + bytesCopied) % GCodeInputBufferSize;
+				return GCodeInputReadResult::haveData;
+			}
+
+			// We have replayed all the cached data, so carry on reading from the file after the end of it
+			if (file.GetPosition() != loopCache.GetEnd() && !file.Seek(loopCache.GetEnd()))
+			{
+				return GCodeInputReadResult::error;
+			}
+		}
+#endif
+
+#if SUPPORT_FILE_READ_AHEAD
+		if (isPrintFile && StartReadAhead(file))
+		{
+			return GetReadAheadData(bytesCached);
+		}
+		const uint32_t startTime = StepTimer::GetTimerTicks();
+#endif
+
 		// The code here used to read into a local buffer in blocks that are multiples of 4 bytes.
 		// However, unless we can use a buffer of at least 512 bytes then that is redundant,
 		// because the data will be copied via the sector buffer in FatFS anyway. So we don't do that any more.
-		const int bytesRead = file.Read(buffer + writingPointer, min<size_t>(BufferSpaceLeft(), GCodeInputBufferSize - writingPointer));
+		const int bytesRead = file.Read(buffer + writingPointer, maxBytes);
+#if SUPPORT_FILE_READ_AHEAD
+		readTicks += StepTimer::GetTimerTicks() - startTime;
+#endif
 		if (bytesRead < 0)
 		{
 			return GCodeInputReadResult::error;
@@ -322,6 +528,219 @@ GCodeInputReadResult FileGCodeInput::ReadFromFile(FileData &file) noexcept
 	return (bytesCached > 0) ? GCodeInputReadResult::haveData : GCodeInputReadResult::noData;
 }
 
+#if SUPPORT_FILE_READ_AHEAD
+
+// Start reading the rest of the file ahead in the background if it is worth doing, returning true if we started.
+// We only do this for the file being printed, because macros are usually short and we don't want them to stop the print file being read ahead.
+bool FileGCodeInput::StartReadAhead(const FileData &file) noexcept
+{
+	if (file.Length() < file.GetPosition() + FileReadAhead::MinimumRemainingLength)
+	{
+		return false;
+	}
+	if (readAhead == nullptr)
+	{
+		readAhead = FileReadAhead::Create();
+		if (readAhead == nullptr)
+		{
+			return false;
+		}
+	}
+	return readAhead->Start(file);
+}
+
+// Get more data for the file that the read-ahead task is reading. We don't refill our own buffer, so any data in it precedes the read-ahead data.
+GCodeInputReadResult FileGCodeInput::GetReadAheadData(size_t bytesCached) noexcept
+{
+	if (bytesCached != 0 || directOffset < directLength)
+	{
+		return GCodeInputReadResult::haveData;						// pass on the data we already have first
+	}
+
+	ReleaseReadAheadData();
+	const char *_ecv_array data;
+	size_t length;
+	switch (readAhead->GetData(data, length))
+	{
+	case ReadAheadResult::haveData:
+		if (stalled)
+		{
+			stallTicks += StepTimer::GetTimerTicks() - stallStartTime;
+			stalled = false;
+		}
+		directData = data;
+		directLength = length;
+		directOffset = 0;
+		return GCodeInputReadResult::haveData;
+
+	case ReadAheadResult::notReady:
+		if (!stalled)
+		{
+			stallStartTime = StepTimer::GetTimerTicks();
+			stalled = true;
+			++numStalls;
+		}
+		return GCodeInputReadResult::notReady;
+
+	case ReadAheadResult::endOfFile:
+		stalled = false;
+		return GCodeInputReadResult::noData;
+
+	case ReadAheadResult::error:
+	default:
+		stalled = false;
+		return GCodeInputReadResult::error;
+	}
+}
+
+// Tell the read-ahead task how much of the current read-ahead buffer we have used, and stop using it
+void FileGCodeInput::ReleaseReadAheadData() noexcept
+{
+	readAhead->Consume(directOffset);
+	directData = nullptr;
+	directLength = directOffset = 0;
+}
+
+// Stop reading ahead and set the position of the file to the next byte that we haven't passed on, so that we can carry on reading it directly
+void FileGCodeInput::StopReadAhead(FileData &file) noexcept
+{
+	const FilePosition pos = GetPosition(file);
+	readAhead->Stop();
+	if (lastFileRead == file)
+	{
+		directData = nullptr;
+		directLength = directOffset = 0;
+		RegularGCodeInput::Reset();
+	}
+	(void)file.Seek(pos);
+}
+
+#endif
+
+#if SUPPORT_PARSE_AHEAD
+
+// Decode simple motion commands that follow the current position in the file, if we have already read them
+void FileGCodeInput::ParseAhead(const FileData &file) noexcept
+{
+	if (lastFileRead != file)
+	{
+		return;														// the data we hold is from a different file
+	}
+
+	const FilePosition pos = GetPosition(file);
+	parseAhead.Synchronise(file, pos);
+	for (size_t linesLeft = ParseAheadQueue::MaxLinesPerCall; linesLeft != 0 && parseAhead.CanDecode(); --linesLeft)
+	{
+		char data[ParseAheadQueue::MaxLineLength];
+		const size_t length = PeekData(parseAhead.GetDecodePosition() - pos, data, sizeof(data));
+		if (!parseAhead.DecodeNextLine(data, length))
+		{
+			break;
+		}
+	}
+}
+
+// If the next line of the file has been decoded and we still hold all of it, return it
+const PreDecodedLine *_ecv_null FileGCodeInput::GetPreDecodedLine(const FileData &file) noexcept
+{
+	if (lastFileRead != file || !parseAhead.IsFor(file))
+	{
+		return nullptr;
+	}
+
+	const FilePosition pos = GetPosition(file);
+	parseAhead.Synchronise(file, pos);
+	const PreDecodedLine *_ecv_null const line = parseAhead.GetLine(pos);
+	return (line != nullptr && BytesCached() >= line->lineLength) ? line : nullptr;
+}
+
+// Skip the line that GetPreDecodedLine returned, because the GCodeBuffer has used the decoded version
+void FileGCodeInput::ConsumePreDecodedLine() noexcept
+{
+	const PreDecodedLine *_ecv_null const line = parseAhead.GetLine(GetPosition(lastFileRead));
+	if (line != nullptr)
+	{
+		SkipData(line->lineLength);
+		parseAhead.RemoveLine();
+	}
+}
+
+// Copy data that we hold starting at the specified offset from the next byte to be read, without consuming it. Return the number of bytes copied.
+size_t FileGCodeInput::PeekData(size_t offset, char *_ecv_array dst, size_t maxLength) const noexcept
+{
+	size_t copied = 0;
+	const size_t bytesInBuffer = RegularGCodeInput::BytesCached();
+	while (offset < bytesInBuffer && copied < maxLength)
+	{
+		dst[copied++] = buffer[(readingPointer + offset) % GCodeInputBufferSize];
+		++offset;
+	}
+# if SUPPORT_FILE_READ_AHEAD
+	// Any data in our own buffer precedes the read-ahead data
+	const size_t directStart = directOffset + (offset - bytesInBuffer);
+	if (copied < maxLength && directStart < directLength)
+	{
+		const size_t bytesToCopy = min<size_t>(maxLength - copied, directLength - directStart);
+		memcpy(dst + copied, directData + directStart, bytesToCopy);
+		copied += bytesToCopy;
+	}
+# endif
+	return copied;
+}
+
+// Consume data without passing it to a GCodeBuffer
+void FileGCodeInput::SkipData(size_t length) noexcept
+{
+	const size_t bytesFromBuffer = min<size_t>(length, RegularGCodeInput::BytesCached());
+	readingPointer = (readingPointer + bytesFromBuffer) % GCodeInputBufferSize;
+# if SUPPORT_FILE_READ_AHEAD
+	directOffset += length - bytesFromBuffer;
+# endif
+}
+
+#endif
+
+#if SUPPORT_LOOP_BODY_CACHE
+
+// Stop using the loop body cache and release our reference to the file it came from
+void FileGCodeInput::ReleaseLoopCache() noexcept
+{
+	if (loopCacheUser == this)
+	{
+		if (loopCache.IsReplaying())
+		{
+			// Put the real file position where the logical position is, so that reading can continue from the file
+			(void)cachedFile.Seek(loopCache.GetReplayPosition());
+		}
+		loopCache.Invalidate();
+		cachedFile.Close();
+		loopCacheUser = nullptr;
+	}
+}
+
+#endif
+
+#if SUPPORT_LOOP_BODY_CACHE || SUPPORT_FILE_READ_AHEAD || SUPPORT_PARSE_AHEAD
+
+void FileGCodeInput::Diagnostics(MessageType mtype, const char *_ecv_array channelName) noexcept
+{
+# if SUPPORT_LOOP_BODY_CACHE
+	reprap.GetPlatform().MessageF(mtype, "%s loop body cache hits %" PRIu32 ", misses %" PRIu32 ", file reads avoided %" PRIu32 "\n",
+									channelName, loopCacheHits, loopCacheMisses, fileReadsAvoided);
+	loopCacheHits = loopCacheMisses = fileReadsAvoided = 0;
+# endif
+# if SUPPORT_FILE_READ_AHEAD
+	reprap.GetPlatform().MessageF(mtype, "%s input blocked on reads %.1fms, waited for read-ahead %.1fms (%" PRIu32 " times)\n",
+									channelName, (double)(StepTimer::TicksToFloatMicroseconds(readTicks) * 0.001), (double)(StepTimer::TicksToFloatMicroseconds(stallTicks) * 0.001), numStalls);
+	readTicks = stallTicks = numStalls = 0;
+# endif
+# if SUPPORT_PARSE_AHEAD
+	parseAhead.Diagnostics(mtype, channelName);
+# endif
+}
+
+#endif
+
 #endif
 
 // End
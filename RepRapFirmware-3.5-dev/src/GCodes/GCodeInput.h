@@ -14,6 +14,16 @@
 
 #include <Stream.h>
 
+#if SUPPORT_PARSE_AHEAD
+# include "ParseAheadQueue.h"
+#endif
+#if SUPPORT_FILE_READ_AHEAD
+# include <Storage/FileReadAhead.h>
+#endif
+#if SUPPORT_LOOP_BODY_CACHE
+# include "LoopBodyCache.h"
+#endif
+
 const size_t GCodeInputBufferSize = 256;						// How many bytes can we cache per input source? Make this a power of 2 for efficiency
 
 // This base class provides incoming G-codes for the GCodeBuffer class
@@ -99,7 +109,7 @@ private:
 	Stream &device;
 };
 
-enum class GCodeInputReadResult : uint8_t { haveData, noData, error };
+enum class GCodeInputReadResult : uint8_t { haveData, noData, error, notReady };		// notReady means that the data is still being read ahead, so try again later
 
 #if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
 
@@ -112,13 +122,72 @@ public:
 	FileGCodeInput() noexcept : RegularGCodeInput() { }
 
 	void Reset() noexcept override;								// Clears the buffer. Should be called when the associated file is being closed
+#if SUPPORT_FILE_READ_AHEAD
+	size_t BytesCached() const noexcept override;				// How many bytes have been cached?
+#endif
 	void Reset(const FileData &file) noexcept;					// Clears the buffer of a specific file. Should be called when it is closed or re-opened outside the reading context
 	size_t FileBytesCached(const FileData &file) const noexcept;	// How many bytes have been cached for the given file?
 
-	GCodeInputReadResult ReadFromFile(FileData &file) noexcept;	// Read another chunk of G-codes from the file and return true if more data is available
+	GCodeInputReadResult ReadFromFile(FileData &file, bool isPrintFile) noexcept;	// Read another chunk of G-codes from the file and return true if more data is available
+	FilePosition GetPosition(const FileData &file) const noexcept;	// Get the position in the file of the next byte to be processed
+	void RestartLoop(FileData &file, FilePosition loopStart) noexcept;	// Go back to the start of a loop, using the loop body cache if possible
+
+#if SUPPORT_PARSE_AHEAD
+	bool IsHoldingDataFor(const FileData& file) const noexcept { return lastFileRead == file; }	// Is the data we hold from this file?
+	void ParseAhead(const FileData& file) noexcept;				// Decode simple motion commands in the data we have already read from the file
+	const PreDecodedLine *_ecv_null GetPreDecodedLine(const FileData& file) noexcept;	// If the next line of the file has been decoded, return it
+	void ConsumePreDecodedLine() noexcept;						// Skip the line returned by GetPreDecodedLine because the GCodeBuffer has used it
+#endif
+
+#if SUPPORT_LOOP_BODY_CACHE || SUPPORT_FILE_READ_AHEAD || SUPPORT_PARSE_AHEAD
+	void Diagnostics(MessageType mtype, const char *_ecv_array channelName) noexcept;
+#endif
+
+#if SUPPORT_FILE_READ_AHEAD
+protected:
+	char ReadByte() noexcept override;
+#endif
 
 private:
 	FileData lastFileRead;
+
+#if SUPPORT_FILE_READ_AHEAD
+	bool IsReadingAhead(const FileData& file) const noexcept { return readAhead != nullptr && readAhead->IsReadingFor(file); }
+	bool StartReadAhead(const FileData& file) noexcept;
+	GCodeInputReadResult GetReadAheadData(size_t bytesCached) noexcept;
+	void ReleaseReadAheadData() noexcept;
+	void StopReadAhead(FileData& file) noexcept;
+
+	FileReadAhead *_ecv_null readAhead = nullptr;				// created when we first print a file that is long enough to be worth reading ahead
+	const char *_ecv_array null directData = nullptr;			// data in a read-ahead buffer that we pass to the GCodeBuffer without copying it into our own buffer
+	size_t directLength = 0;									// the number of bytes at directData
+	size_t directOffset = 0;									// the number of bytes at directData that we have already passed on
+	uint32_t readTicks = 0;										// time spent waiting for direct reads from the file
+	uint32_t stallStartTime = 0;								// when we started waiting for the read-ahead task to provide more data
+	uint32_t stallTicks = 0;									// time spent waiting for the read-ahead task
+	uint32_t numStalls = 0;
+	bool stalled = false;
+#endif
+
+#if SUPPORT_PARSE_AHEAD
+	size_t PeekData(size_t offset, char *_ecv_array dst, size_t maxLength) const noexcept;
+	void SkipData(size_t length) noexcept;
+
+	ParseAheadQueue parseAhead;
+#endif
+
+#if SUPPORT_LOOP_BODY_CACHE
+	bool IsUsingLoopCache(const FileData& file) const noexcept { return loopCacheUser == this && cachedFile == file; }
+	bool IsReplaying(const FileData& file) const noexcept { return IsUsingLoopCache(file) && loopCache.IsReplaying(); }
+	void ReleaseLoopCache() noexcept;
+
+	// There is a single loop body cache, used by whichever file input restarted a loop most recently, so it costs at most 1K of RAM
+	static LoopBodyCache loopCache;
+	static FileGCodeInput *_ecv_null loopCacheUser;				// the input that is using the loop body cache
+	static FileData cachedFile;									// the file that the loop body cache holds data from. Holding a reference stops the file being closed and reopened as another file,
+																// so GCodeBuffer calls Reset(file) whenever a machine state stops using its file.
+	uint32_t loopCacheHits = 0, loopCacheMisses = 0, fileReadsAvoided = 0;
+#endif
 };
 
 #endif
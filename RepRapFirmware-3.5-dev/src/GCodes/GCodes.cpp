@@ -532,6 +532,12 @@ bool GCodes::StartNextGCode(GCodeBuffer& gb, const StringRef& reply) noexcept
 	else if (gb.IsReady() || gb.IsExecuting())
 	{
 		gb.SetFinished(ActOnCode(gb, reply));
+#if SUPPORT_PARSE_AHEAD
+		if (gb.IsExecuting())
+		{
+			gb.ParseAhead();								// use the time while the command waits to decode the following moves
+		}
+#endif
 		return true;
 	}
 	else if (gb.IsDoingFile())
@@ -674,9 +680,16 @@ bool GCodes::DoFilePrint(GCodeBuffer& gb, const StringRef& reply) noexcept
 		FileData& fd = gb.LatestMachineState().fileState;
 
 		// Do we have more data to process?
-		switch (gb.GetFileInput()->ReadFromFile(fd))
+		switch (gb.GetFileInput()->ReadFromFile(fd, gb.IsFileChannel() && !gb.IsDoingFileMacro()))
 		{
 		case GCodeInputReadResult::haveData:
+#if SUPPORT_PARSE_AHEAD
+			if (gb.UsePreDecodedLine())
+			{
+				gb.SetFinished(ActOnCode(gb, reply));
+				return true;
+			}
+#endif
 			if (gb.GetFileInput()->FillBuffer(&gb))
 			{
 				bool done;
@@ -708,6 +721,9 @@ bool GCodes::DoFilePrint(GCodeBuffer& gb, const StringRef& reply) noexcept
 			}
 			return true;
 
+		case GCodeInputReadResult::notReady:
+			return false;											// the file is being read ahead and the data isn't available yet
+
 		case GCodeInputReadResult::error:
 		default:
 			AbortPrint(gb);
@@ -1658,6 +1674,13 @@ void GCodes::Diagnostics(MessageType mtype) noexcept
 	{
 		ms.Diagnostics(mtype);
 	}
+
+#if (SUPPORT_LOOP_BODY_CACHE || SUPPORT_FILE_READ_AHEAD || SUPPORT_PARSE_AHEAD) && (HAS_MASS_STORAGE || HAS_EMBEDDED_FILES)
+	FileGCode()->GetFileInput()->Diagnostics(mtype, "File");
+# if SUPPORT_ASYNC_MOVES
+	File2GCode()->GetFileInput()->Diagnostics(mtype, "File2");
+# endif
+#endif
 }
 
 #if SUPPORT_ASYNC_MOVES
@@ -3384,6 +3407,9 @@ bool GCodes::QueueFileToPrint(const char* fileName, const StringRef& reply) noex
 	FileStore * const f = platform.OpenFile(Platform::GetGCodeDir(), fileName, OpenMode::read);
 	if (f != nullptr)
 	{
+#if SUPPORT_COMPACT_GCODE
+		(void)f->UseCompactGCodeReader();
+#endif
 		fileToPrint.Set(f);
 		return true;
 	}
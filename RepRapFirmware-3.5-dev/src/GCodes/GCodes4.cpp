@@ -944,7 +944,11 @@ void GCodes::RunStateMachine(GCodeBuffer& gb, const StringRef& reply) noexcept
 		{
 			if (acceptReading)
 			{
-				reprap.GetMove().AccessHeightMap().SetGridHeight(gridAxis0Index, gridAxis1Index, g30zHeightError);
+				if (!reprap.GetMove().AccessHeightMap().SetGridHeight(gridAxis0Index, gridAxis1Index, g30zHeightError))
+				{
+					platform.MessageF(WarningMessage, "Height error %.3fmm at grid point %u,%u is too large to store, so the point has been skipped\n",
+										(double)g30zHeightError, (unsigned int)gridAxis0Index, (unsigned int)gridAxis1Index);
+				}
 				gb.AdvanceState();
 			}
 			else
@@ -1113,10 +1117,15 @@ void GCodes::RunStateMachine(GCodeBuffer& gb, const StringRef& reply) noexcept
 					scanningResult = rslt;
 				}
 			}
+			else if (!hm.SetGridHeight(gridAxis0Index, gridAxis1Index, -heightError))
+			{
+				if (scanningResult == GCodeResult::ok)
+				{
+					scanningResult = GCodeResult::error;		// the reading is too large to store in the height map
+				}
+			}
 			else
 			{
-				hm.SetGridHeight(gridAxis0Index, gridAxis1Index, -heightError);
-
 				if (lastAxis0Index != gridAxis0Index)			// if more than one point
 				{
 					SetMoveBufferDefaults(ms);
@@ -175,9 +175,9 @@ void GCodes::TakeScanningProbeReading() noexcept
 			scanningResult = rslt;
 		}
 	}
-	else
+	else if (!reprap.GetMove().AccessHeightMap().SetGridHeight(gridAxis0Index, gridAxis1Index, -heightError) && scanningResult == GCodeResult::ok)
 	{
-		reprap.GetMove().AccessHeightMap().SetGridHeight(gridAxis0Index, gridAxis1Index, -heightError);
+		scanningResult = GCodeResult::error;				// the reading is too large to store in the height map
 	}
 
 	if (gridAxis0Index != lastAxis0Index)
@@ -0,0 +1,97 @@
+/*
+ * LoopBodyCache.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * RAM copy of the start of a 'while' loop body, so that later iterations of the loop can be replayed without reading the file again.
+ * The cache records the storage sequence number when it was filled, which changes whenever a file is written, renamed or deleted or a volume
+ * is mounted or unmounted. A restart only uses the cached data if the sequence number is unchanged, so edits to the file are seen at the next iteration.
+ * This class knows nothing about files and has no dependencies on the rest of the firmware, so that it can be tested on a host.
+ */
+
+#ifndef SRC_GCODES_LOOPBODYCACHE_H_
+#define SRC_GCODES_LOOPBODYCACHE_H_
+
+#include <ecv_duet3d.h>
+#include <General/function_ref.h>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+class LoopBodyCache
+{
+public:
+	typedef uint32_t Position;										// the same as FilePosition
+
+	static constexpr size_t Size = 1024;							// the maximum number of bytes of a loop body (starting at the 'while' line) that we keep
+
+	// Function to read up to maxLength bytes from the file starting at the specified position, returning the number of bytes read or -1 if it failed
+	typedef function_ref_noexcept<int(Position pos, char *_ecv_array buf, size_t maxLength) noexcept> ReadFunction;
+
+	LoopBodyCache() noexcept : data(nullptr), start(0), end(0), replayPos(0), seq(0), replaying(false) { }
+
+	// Start replaying from the start of a loop. If we don't hold the data at loopStart or the files may have changed since we read it,
+	// read the file into the cache first. Return true if we are replaying, false if the caller must read the file itself.
+	bool Restart(Position loopStart, uint32_t storageSeq, ReadFunction readData, bool& hit) noexcept;
+
+	// Copy up to maxLength bytes of cached data from the replay position. Return 0 and stop replaying when all the cached data has been used.
+	size_t Replay(char *_ecv_array dst, size_t maxLength) noexcept;
+
+	void Unread(size_t length) noexcept pre(length <= replayPos - start) { replayPos -= length; }	// go back over data that the caller has not used
+	void StopReplaying() noexcept { replaying = false; }
+	void Invalidate() noexcept { start = end = 0; replaying = false; }
+
+	bool IsReplaying() const noexcept { return replaying; }
+	Position GetReplayPosition() const noexcept { return replayPos; }
+	Position GetEnd() const noexcept { return end; }
+
+private:
+	char *_ecv_array null data;										// allocated when first needed, so that the cache costs no RAM if loops are never used
+	Position start, end;											// the range of file positions held in the cache
+	Position replayPos;												// the file position of the next byte to replay
+	uint32_t seq;													// the storage sequence number when we filled the cache
+	bool replaying;
+};
+
+inline bool LoopBodyCache::Restart(Position loopStart, uint32_t storageSeq, ReadFunction readData, bool& hit) noexcept
+{
+	hit = (loopStart >= start && loopStart < end && storageSeq == seq);
+	if (!hit)
+	{
+		Invalidate();
+		if (data == nullptr)
+		{
+			data = new char[Size];
+		}
+		const int bytesRead = readData(loopStart, data, Size);
+		if (bytesRead <= 0)
+		{
+			return false;
+		}
+		start = loopStart;
+		end = loopStart + (Position)bytesRead;
+		seq = storageSeq;
+	}
+	replayPos = loopStart;
+	replaying = true;
+	return true;
+}
+
+inline size_t LoopBodyCache::Replay(char *_ecv_array dst, size_t maxLength) noexcept
+{
+	const size_t bytesLeft = (replayPos < end) ? end - replayPos : 0;
+	const size_t bytesToCopy = (bytesLeft < maxLength) ? bytesLeft : maxLength;
+	if (bytesToCopy == 0)
+	{
+		replaying = false;
+	}
+	else
+	{
+		memcpy(dst, data + (replayPos - start), bytesToCopy);
+		replayPos += bytesToCopy;
+	}
+	return bytesToCopy;
+}
+
+#endif /* SRC_GCODES_LOOPBODYCACHE_H_ */
@@ -0,0 +1,237 @@
+/*
+ * ParseAheadQueue.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ */
+
+#include "ParseAheadQueue.h"
+
+#if SUPPORT_PARSE_AHEAD
+
+#include "GCodes.h"
+#include <Platform/RepRap.h>
+#include <Platform/Platform.h>
+
+void ParseAheadQueue::Clear() noexcept
+{
+	head = count = 0;
+	blocked = false;
+	file.Close();
+}
+
+// Make sure that the queue holds lines from the specified file starting at the specified position, which is the position of the next line to be parsed
+void ParseAheadQueue::Synchronise(const FileData& f, FilePosition pos) noexcept
+{
+	if (!IsFor(f))
+	{
+		Clear();
+		file.CopyFrom(f);
+		decodePosition = pos;
+		return;
+	}
+
+	// Discard lines that were parsed normally instead of being taken from the queue
+	while (count != 0 && lines[head].position < pos)
+	{
+		head = (head + 1) % QueueLength;
+		--count;
+	}
+
+	if ((count != 0) ? lines[head].position != pos : decodePosition != pos)
+	{
+		// The file has been repositioned, or we have passed the barrier
+		count = 0;
+		decodePosition = pos;
+		blocked = false;
+	}
+}
+
+// Try to decode the line at the decode position. 'data' holds the data at that position that we have already read from the file.
+// Return true if we decoded the line and there may be more to decode, false if the line is a barrier or is incomplete.
+bool ParseAheadQueue::DecodeNextLine(const char *_ecv_array data, size_t length) noexcept
+{
+	const char *_ecv_array _ecv_null const lineEnd = (const char *_ecv_array _ecv_null)memchr(data, '\n', length);
+	if (lineEnd == nullptr)
+	{
+		if (length >= MaxLineLength)
+		{
+			blocked = true;								// the line is too long for us to decode
+			++barriersFound;
+		}
+		return false;									// else we haven't read the whole line from the file yet
+	}
+
+	PreDecodedLine& line = lines[(head + count) % QueueLength];
+	const size_t lineLength = lineEnd - data + 1;
+	if (!DecodeLine(data, lineLength - 1, line))
+	{
+		blocked = true;
+		++barriersFound;
+		return false;
+	}
+
+	line.position = decodePosition;
+	line.lineLength = lineLength;
+	decodePosition += lineLength;
+	++count;
+	++linesDecoded;
+	return true;
+}
+
+// Decode a line of GCode excluding the line ending, returning true if it is a simple motion command
+/*static*/ bool ParseAheadQueue::DecodeLine(const char *_ecv_array data, size_t length, PreDecodedLine& line) noexcept
+{
+	// Remove any trailing CR and comment. The string parser discards these, so they don't form part of the command.
+	size_t textLength = length;
+	if (textLength != 0 && data[textLength - 1] == '\r')
+	{
+		--textLength;
+	}
+	const char *_ecv_array _ecv_null const commentStart = (const char *_ecv_array _ecv_null)memchr(data, ';', textLength);
+	if (commentStart != nullptr)
+	{
+		textLength = commentStart - data;
+	}
+	if (textLength >= PreDecodedLine::MaxTextLength || textLength == 0 || data[0] != 'G')
+	{
+		return false;
+	}
+
+	// Read the command number, allowing for a leading zero
+	size_t i = 1;
+	unsigned int commandNumber = 0;
+	while (i < textLength && isdigit(data[i]))
+	{
+		commandNumber = (10 * commandNumber) + (data[i] - '0');
+		++i;
+	}
+	if (i == 1 || i > 3 || commandNumber > 3)
+	{
+		return false;
+	}
+
+	const size_t commandNumberEnd = i;
+	while (i < textLength && (data[i] == ' ' || data[i] == '\t'))
+	{
+		++i;
+	}
+	if (i == commandNumberEnd || i == textLength)
+	{
+		return false;									// no space after the command number, or no parameters
+	}
+	line.parameterStart = i;
+
+	// Read the parameters. Each one must be a letter followed by a plain decimal number, with white space between parameters.
+	const char *_ecv_array const axisLetters = reprap.GetGCodes().GetAxisLetters();
+	const bool isArc = (commandNumber >= 2);
+	line.parameters.Clear();
+	line.numValues = 0;
+	do
+	{
+		const char letter = data[i];
+		if (line.numValues == PreDecodedLine::MaxValues || !IsAllowedLetter(letter, isArc, axisLetters))
+		{
+			return false;
+		}
+
+		++i;
+		const size_t numberStart = i;
+		if (i < textLength && data[i] == '-')
+		{
+			++i;
+		}
+		bool seenDigit = false, seenPoint = false;
+		while (i < textLength)
+		{
+			const char c = data[i];
+			if (isdigit(c))
+			{
+				seenDigit = true;
+			}
+			else if (c == '.' && !seenPoint)
+			{
+				seenPoint = true;
+			}
+			else
+			{
+				break;
+			}
+			++i;
+		}
+		if (!seenDigit || (i < textLength && data[i] != ' ' && data[i] != '\t'))
+		{
+			return false;
+		}
+
+		const char *_ecv_array endptr;
+		const float value = SafeStrtof(data + numberStart, &endptr);
+		if (endptr != data + i)
+		{
+			return false;
+		}
+
+		PreDecodedLine::Value& v = line.values[line.numValues++];
+		v.start = numberStart;
+		v.end = i;
+		v.value = value;
+		line.parameters.SetBit(letter - 'A');
+
+		while (i < textLength && (data[i] == ' ' || data[i] == '\t'))
+		{
+			++i;
+		}
+	} while (i < textLength);
+
+	memcpy(line.text, data, textLength);
+	line.textLength = textLength;
+	line.commandNumber = commandNumber;
+	return true;
+}
+
+// Return true if the letter is one that a simple motion command may have as a parameter, given the current axis letters
+/*static*/ bool ParseAheadQueue::IsAllowedLetter(char letter, bool isArc, const char *_ecv_array axisLetters) noexcept
+{
+	return letter == 'E' || letter == 'F'
+		|| (isArc && (letter == 'I' || letter == 'J' || letter == 'K' || letter == 'R'))
+		|| (letter >= 'A' && letter <= 'Z' && strchr(axisLetters, letter) != nullptr);
+}
+
+// Get the decoded line at the specified position if we have it.
+// The axis letters may have been changed by M584 on another channel since we decoded the line, so we check its parameter letters again here.
+// If they are no longer all allowed then we don't return the line, so it gets parsed normally.
+const PreDecodedLine *_ecv_null ParseAheadQueue::GetLine(FilePosition pos) const noexcept
+{
+	if (count == 0 || lines[head].position != pos)
+	{
+		return nullptr;
+	}
+
+	const PreDecodedLine& line = lines[head];
+	const char *_ecv_array const axisLetters = reprap.GetGCodes().GetAxisLetters();
+	const bool isArc = (line.commandNumber >= 2);
+	return (line.parameters.IterateWhile([isArc, axisLetters](unsigned int bit, unsigned int) noexcept -> bool
+											{ return IsAllowedLetter('A' + bit, isArc, axisLetters); }))
+			? &line : nullptr;
+}
+
+// Remove the first line from the queue because it has been used
+void ParseAheadQueue::RemoveLine() noexcept
+{
+	if (count != 0)
+	{
+		head = (head + 1) % QueueLength;
+		--count;
+		++linesUsed;
+	}
+}
+
+void ParseAheadQueue::Diagnostics(MessageType mtype, const char *_ecv_array channelName) noexcept
+{
+	reprap.GetPlatform().MessageF(mtype, "%s parse-ahead lines decoded %" PRIu32 ", used %" PRIu32 ", barriers %" PRIu32 "\n", channelName, linesDecoded, linesUsed, barriersFound);
+	linesDecoded = linesUsed = barriersFound = 0;
+}
+
+#endif
+
+// End
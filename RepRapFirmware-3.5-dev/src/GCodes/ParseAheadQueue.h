@@ -0,0 +1,84 @@
+/*
+ * ParseAheadQueue.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * While a G0/G1/G2/G3 command from a file is waiting for the movement system to accept it, we decode the lines that follow it
+ * if they are already in the file input buffer. Lines that hold a single G0, G1, G2 or G3 command with plain numeric parameters are decoded
+ * and kept in this queue, keyed by their file positions. Any other line (comments, meta commands, expressions, other commands) is a barrier:
+ * we stop decoding there until it has been processed in the normal way, because it may change how the following lines should be interpreted.
+ * The decoded lines stay in the file input buffer until they are used, so if a decoded line can't be used for any reason then it is parsed normally.
+ */
+
+#ifndef SRC_GCODES_PARSEAHEADQUEUE_H_
+#define SRC_GCODES_PARSEAHEADQUEUE_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_PARSE_AHEAD
+
+#include <Storage/FileData.h>
+
+// A line of GCode that has been decoded ahead of being executed
+struct PreDecodedLine
+{
+	static constexpr size_t MaxTextLength = 64;			// the maximum length of the command, excluding any trailing comment and the line ending
+	static constexpr size_t MaxValues = 8;				// the maximum number of parameters
+
+	struct Value
+	{
+		uint8_t start;									// the index in the text of the first character of the number
+		uint8_t end;									// the index in the text of the character after the number
+		float value;
+	};
+
+	FilePosition position;								// the file position of the start of the line
+	uint16_t lineLength;								// the number of characters in the line, including any comment and the line ending
+	uint8_t textLength;									// the number of characters of the line that we pass to the parser
+	uint8_t parameterStart;								// the index in the text of the first parameter letter
+	uint8_t commandNumber;								// 0, 1, 2 or 3
+	uint8_t numValues;
+	ParameterLettersBitmap parameters;
+	Value values[MaxValues];
+	char text[MaxTextLength];
+};
+
+class ParseAheadQueue
+{
+public:
+#if SAME70
+	static constexpr size_t QueueLength = 8;
+#else
+	static constexpr size_t QueueLength = 4;
+#endif
+	static constexpr size_t MaxLineLength = 160;		// the longest line we decode, including any trailing comment and the line ending
+	static constexpr size_t MaxLinesPerCall = 2;		// the maximum number of lines we decode per call, to limit the delay to other input channels
+
+	void Clear() noexcept;
+	bool IsFor(const FileData& f) const noexcept { return file.IsLive() && file == f; }
+	void Synchronise(const FileData& f, FilePosition pos) noexcept;	// discard lines before the specified position and restart decoding if the file has been repositioned
+	bool CanDecode() const noexcept { return !blocked && count < QueueLength; }
+	FilePosition GetDecodePosition() const noexcept { return decodePosition; }
+	bool DecodeNextLine(const char *_ecv_array data, size_t length) noexcept;	// try to decode the line at the decode position, returning true if we can try another one
+	const PreDecodedLine *_ecv_null GetLine(FilePosition pos) const noexcept;	// get the decoded line at the specified position if we have it and its axis letters are still valid
+	void RemoveLine() noexcept;							// remove the first line from the queue after it has been used
+
+	void Diagnostics(MessageType mtype, const char *_ecv_array channelName) noexcept;
+
+private:
+	static bool DecodeLine(const char *_ecv_array data, size_t length, PreDecodedLine& line) noexcept;
+	static bool IsAllowedLetter(char letter, bool isArc, const char *_ecv_array axisLetters) noexcept;
+
+	FileData file;										// the file that the decoded lines came from. Holding a reference stops the file being closed and reopened as another file.
+	FilePosition decodePosition = 0;					// the file position of the next line to decode
+	size_t head = 0;									// index of the first line in the queue
+	size_t count = 0;									// number of lines in the queue
+	bool blocked = false;								// true if the line at decodePosition is a barrier
+	uint32_t linesDecoded = 0, linesUsed = 0, barriersFound = 0;
+	PreDecodedLine lines[QueueLength];
+};
+
+#endif
+
+#endif /* SRC_GCODES_PARSEAHEADQUEUE_H_ */
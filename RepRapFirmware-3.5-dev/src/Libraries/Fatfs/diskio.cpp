@@ -54,11 +54,21 @@
 #include <Libraries/sd_mmc/ctrl_access.h>
 #include <Libraries/sd_mmc/conf_sd_mmc.h>
 
+#if SUPPORT_SD_READ_AHEAD
+# include <Storage/SectorReadAhead.h>
+#endif
+
 #include <cstring>
 
 static unsigned int highestSdRetriesDone = 0;
 static uint32_t longestWriteTime = 0;
 static uint32_t longestReadTime = 0;
+static DiskioTransferCounts transferCounts[NumSdCards] = { 0 };	// each volume has its own mutex, so each needs its own counts
+
+#if SUPPORT_SD_READ_AHEAD
+static_assert(sizeof(LBA_t) == sizeof(SectorReadAhead::SectorNumber));
+static SectorReadAhead readAheadBuffers[NumSdCards];		// each volume has its own mutex, so each needs its own buffer
+#endif
 
 unsigned int DiskioGetAndClearMaxRetryCount() noexcept
 {
@@ -81,6 +91,16 @@ float DiskioGetAndClearLongestWriteTime() noexcept
 	return ret;
 }
 
+// The caller must hold the mutex of the volume on this card
+void DiskioGetAndClearTransferCounts(size_t card, DiskioTransferCounts& counts) noexcept
+{
+	counts = transferCounts[card];
+	transferCounts[card] = { 0 };
+#if SUPPORT_SD_READ_AHEAD
+	readAheadBuffers[card].GetAndClearCounts(counts.readAheads, counts.readAheadHits);
+#endif
+}
+
 //void debugPrintf(const char*, ...);
 
 //#if (SAM3S || SAM3U || SAM3N || SAM3XA_SERIES || SAM4S)
@@ -134,6 +154,14 @@ DSTATUS disk_initialize(BYTE drv) noexcept
 		return STA_NOINIT;
 	}
 
+#if SUPPORT_SD_READ_AHEAD
+	// The card may have been changed
+	if (drv < NumSdCards)
+	{
+		readAheadBuffers[drv].Invalidate();
+	}
+#endif
+
 	/* Check Write Protection Status */
 	if (mem_wr_protect(drv)) {
 		return STA_PROTECT;
@@ -173,28 +201,9 @@ DSTATUS disk_status(BYTE drv) noexcept
  *
  * \return RES_OK for success, otherwise DRESULT error code.
  */
-DRESULT disk_read(BYTE drv, BYTE *buff, LBA_t sector, UINT count) noexcept
+// Read sectors from the card, retrying if necessary
+static DRESULT ReadSectors(BYTE drv, BYTE *buff, LBA_t sector, UINT count) noexcept
 {
-	if (reprap.Debug(Module::Storage))
-	{
-		debugPrintf("Read %u %u %lu\n", drv, count, sector);
-	}
-
-	const uint8_t uc_sector_size = mem_sector_size(drv);
-	if (uc_sector_size == 0)
-	{
-		return RES_ERROR;
-	}
-
-	/* Check valid address */
-	uint32_t ul_last_sector_num;
-	mem_read_capacity(drv, &ul_last_sector_num);
-	if ((sector + count * uc_sector_size) > (ul_last_sector_num + 1) * uc_sector_size)
-	{
-		return RES_PARERR;
-	}
-
-	/* Read the data */
 	unsigned int retryNumber = 0;
 	uint32_t retryDelay = SdCardRetryDelay;
 	for (;;)
@@ -231,9 +240,56 @@ DRESULT disk_read(BYTE drv, BYTE *buff, LBA_t sector, UINT count) noexcept
 		highestSdRetriesDone = retryNumber;
 	}
 
+	if (drv < NumSdCards)
+	{
+		if (count == 1)
+		{
+			++transferCounts[drv].singleBlockReads;
+		}
+		else
+		{
+			++transferCounts[drv].multiBlockReads;
+		}
+	}
 	return RES_OK;
 }
 
+DRESULT disk_read(BYTE drv, BYTE *buff, LBA_t sector, UINT count) noexcept
+{
+	if (reprap.Debug(Module::Storage))
+	{
+		debugPrintf("Read %u %u %lu\n", drv, count, sector);
+	}
+
+	const uint8_t uc_sector_size = mem_sector_size(drv);
+	if (uc_sector_size == 0)
+	{
+		return RES_ERROR;
+	}
+
+	/* Check valid address */
+	uint32_t ul_last_sector_num;
+	mem_read_capacity(drv, &ul_last_sector_num);
+	if ((sector + count * uc_sector_size) > (ul_last_sector_num + 1) * uc_sector_size)
+	{
+		return RES_PARERR;
+	}
+
+#if SUPPORT_SD_READ_AHEAD
+	if (drv < NumSdCards && uc_sector_size == SECTOR_SIZE_512)
+	{
+		auto readSectors = [drv](uint8_t *_ecv_array buf, LBA_t p_sector, unsigned int p_count) noexcept -> bool
+									{ return ReadSectors(drv, buf, p_sector, p_count) == RES_OK; };
+		if (readAheadBuffers[drv].Read(sector, count, ul_last_sector_num, buff, readSectors))
+		{
+			return RES_OK;
+		}
+	}
+#endif
+
+	return ReadSectors(drv, buff, sector, count);
+}
+
 /**
  * \brief  Write sector(s).
  *
@@ -272,6 +328,13 @@ DRESULT disk_write(BYTE drv, BYTE const *buff, LBA_t sector, UINT count) noexcep
 		return RES_PARERR;
 	}
 
+#if SUPPORT_SD_READ_AHEAD
+	if (drv < NumSdCards)
+	{
+		readAheadBuffers[drv].Invalidate(sector, count);
+	}
+#endif
+
 	// Write the data
 
 	unsigned int retryNumber = 0;
@@ -310,6 +373,17 @@ DRESULT disk_write(BYTE drv, BYTE const *buff, LBA_t sector, UINT count) noexcep
 		highestSdRetriesDone = retryNumber;
 	}
 
+	if (drv < NumSdCards)
+	{
+		if (count == 1)
+		{
+			++transferCounts[drv].singleBlockWrites;
+		}
+		else
+		{
+			++transferCounts[drv].multiBlockWrites;
+		}
+	}
 	return RES_OK;
 }
 
@@ -11,6 +11,16 @@ unsigned int DiskioGetAndClearMaxRetryCount() noexcept;
 float DiskioGetAndClearLongestReadTime() noexcept;
 float DiskioGetAndClearLongestWriteTime() noexcept;
 
+// Counts of the transfers to and from the SD cards, for diagnostics
+struct DiskioTransferCounts
+{
+	uint32_t singleBlockReads, multiBlockReads;
+	uint32_t singleBlockWrites, multiBlockWrites;
+	uint32_t readAheads, readAheadHits;
+};
+
+void DiskioGetAndClearTransferCounts(size_t card, DiskioTransferCounts& counts) noexcept;	// the caller must hold the volume mutex
+
 extern "C" {
 
 #endif
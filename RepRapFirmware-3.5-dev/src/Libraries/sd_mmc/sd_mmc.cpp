@@ -2079,6 +2079,14 @@ sd_mmc_err_t sd_mmc_init_write_blocks(uint8_t slot, uint32_t start, uint16_t nb_
 
 	struct sd_mmc_card * const sd_mmc_card = &sd_mmc_cards[slot];
 
+	// Tell SD cards how many blocks we are about to write so that they can pre-erase them, which speeds up multi-block writes.
+	// This is only a hint, so we ignore any failure.
+	if (nb_block > 1 && (sd_mmc_card->type & CARD_TYPE_SD)) {
+		if (sd_mmc_card->iface->send_cmd(SDMMC_CMD55_APP_CMD, (uint32_t)sd_mmc_card->rca << 16)) {
+			(void)sd_mmc_card->iface->send_cmd(SD_ACMD23_SET_WR_BLK_ERASE_COUNT, nb_block);
+		}
+	}
+
 	/*
 	 * SDSC Card (CCS=0) uses byte unit address,
 	 * SDHC and SDXC Cards (CCS=1) use block unit address (512 Bytes unit).
@@ -13,6 +13,7 @@
 #include "DDA.h"
 #include "MoveSegment.h"
 #include "MoveDebugFlags.h"
+#include "MovePrepProfiler.h"
 
 // Object model table and functions
 // Note: if using GCC version 7.3.1 20180622 and lambda functions are used in this table, you must compile this file with option -std=gnu++17.
@@ -311,6 +312,8 @@ GCodeResult AxisShaper::EutSetInputShaping(const CanMessageSetInputShaping& msg,
 // Calculate the input shaping parameters that we can derive from the primary ones
 void AxisShaper::CalculateDerivedParameters() noexcept
 {
+	ClearPlanCache();												// any plans we have cached were calculated using the old parameters
+
 	// Calculate the total extra duration of input shaping
 	totalShapingClocks = 0.0;
 	extraClocksAtStart = 0.0;
@@ -389,6 +392,7 @@ void AxisShaper::CalculateDerivedParameters() noexcept
 // Currently we use a single input shaper for all axes, so the move segments are attached to the DDA not the DM
 void AxisShaper::PlanShaping(DDA& dda, PrepParams& params, bool shapingEnabled) noexcept
 {
+	PROFILE_MOVE_PREP_STAGE(planShaping);
 	params.SetFromDDA(dda);												// set up the provisional parameters
 	if (numExtraImpulses != 0)
 	{
@@ -422,9 +426,11 @@ void AxisShaper::PlanShaping(DDA& dda, PrepParams& params, bool shapingEnabled)
 			}
 		}
 
-		// If the ideal plan includes any shaping, try to implement it
-		if (idealPlan.IsShaped())
+		// If the ideal plan includes any shaping, try to implement it unless we planned an identical move recently
+		const ShapingPlanKey key(dda.startSpeed, dda.endSpeed, params, idealPlan);
+		if (idealPlan.IsShaped() && !LookupCachedPlan(key, params))
 		{
+			const ShapingCounts countsBefore = GetShapingCounts();
 			// Calculate the shaping we need if we preserve the original top speed
 			unsigned int triesDone = 0;
 			for (;;)
@@ -583,6 +589,7 @@ void AxisShaper::PlanShaping(DDA& dda, PrepParams& params, bool shapingEnabled)
 					break;
 				}
 			}
+			StoreCachedPlan(key, params, countsBefore);
 		}
 	}
 
@@ -1181,9 +1188,100 @@ inline float AxisShaper::GetExtraDecelEndDistance(float endSpeed, float decelera
 
 void AxisShaper::Diagnostics(MessageType mtype) noexcept
 {
-	reprap.GetPlatform().MessageF(mtype, "Moves shaped first try %" PRIu32 ", on retry %" PRIu32 ", too short %" PRIu32 ", wrong shape %" PRIu32 ", maybepossible %" PRIu32 "\n",
-							movesShapedFirstTry, movesShapedOnRetry, movesTooShortToShape, movesWrongShapeToShape, movesCouldPossiblyShape);
+	const uint32_t planLookups = planCacheHits + planCacheMisses;
+	reprap.GetPlatform().MessageF(mtype, "Moves shaped first try %" PRIu32 ", on retry %" PRIu32 ", too short %" PRIu32 ", wrong shape %" PRIu32 ", maybepossible %" PRIu32
+											", plan cache hits %" PRIu32 " (%.1f%%)\n",
+							movesShapedFirstTry, movesShapedOnRetry, movesTooShortToShape, movesWrongShapeToShape, movesCouldPossiblyShape,
+							planCacheHits, (planLookups == 0) ? 0.0 : (double)(100.0 * (float)planCacheHits/(float)planLookups));
 	movesShapedFirstTry = movesShapedOnRetry = movesTooShortToShape = movesWrongShapeToShape = movesCouldPossiblyShape = 0;
+	planCacheHits = planCacheMisses = 0;
+}
+
+AxisShaper::ShapingPlanKey::ShapingPlanKey(float p_startSpeed, float p_endSpeed, const PrepParams& params, InputShaperPlan p_idealPlan) noexcept
+	: startSpeed(p_startSpeed), endSpeed(p_endSpeed), topSpeed(params.topSpeed),
+	  acceleration(params.acceleration), deceleration(params.deceleration),
+	  totalDistance(params.totalDistance), accelDistance(params.accelDistance), decelStartDistance(params.decelStartDistance),
+	  idealPlan(p_idealPlan.all)
+{
+}
+
+// Hash the bit patterns of the key so that most cache misses can be detected without comparing the whole key
+uint32_t AxisShaper::ShapingPlanKey::Hash() const noexcept
+{
+	static_assert(sizeof(ShapingPlanKey) % sizeof(uint32_t) == 0);
+	const uint32_t *p = reinterpret_cast<const uint32_t*>(this);
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < sizeof(ShapingPlanKey)/sizeof(uint32_t); ++i)
+	{
+		h = (h ^ p[i]) * 16777619u;
+	}
+	return h;
+}
+
+// Look for a plan for an identical move in the cache. If we find one then update the params from it and return true.
+bool AxisShaper::LookupCachedPlan(const ShapingPlanKey& key, PrepParams& params) noexcept
+{
+	// Don't use the cache if we are debugging input shaping, because we want to see the debug output from planning every move
+	if (!reprap.Debug(Module::InputShaping))
+	{
+		const uint32_t hash = key.Hash();
+		for (size_t i = 0; i < numCachedPlans; ++i)
+		{
+			const ShapingPlanCacheEntry& entry = planCache[i];
+			if (entry.hash == hash && entry.key == key)
+			{
+				params.accelDistance = entry.accelDistance;
+				params.decelStartDistance = entry.decelStartDistance;
+				params.accelClocks = entry.accelClocks;
+				params.decelClocks = entry.decelClocks;
+				params.acceleration = entry.acceleration;
+				params.deceleration = entry.deceleration;
+				params.topSpeed = entry.topSpeed;
+				params.shapingPlan = entry.shapingPlan;
+				params.modified = entry.modified;
+				movesShapedFirstTry += entry.countIncrements.shapedFirstTry;
+				movesShapedOnRetry += entry.countIncrements.shapedOnRetry;
+				movesTooShortToShape += entry.countIncrements.tooShort;
+				movesWrongShapeToShape += entry.countIncrements.wrongShape;
+				movesCouldPossiblyShape += entry.countIncrements.couldPossiblyShape;
+				++planCacheHits;
+				return true;
+			}
+		}
+	}
+	++planCacheMisses;
+	return false;
+}
+
+// Store the result of planning a move in the cache, replacing the oldest entry if the cache is full
+void AxisShaper::StoreCachedPlan(const ShapingPlanKey& key, const PrepParams& params, const ShapingCounts& countsBefore) noexcept
+{
+	ShapingPlanCacheEntry& entry = planCache[nextCachedPlanToReplace];
+	entry.key = key;
+	entry.hash = key.Hash();
+	entry.accelDistance = params.accelDistance;
+	entry.decelStartDistance = params.decelStartDistance;
+	entry.accelClocks = params.accelClocks;
+	entry.decelClocks = params.decelClocks;
+	entry.acceleration = params.acceleration;
+	entry.deceleration = params.deceleration;
+	entry.topSpeed = params.topSpeed;
+	entry.shapingPlan = params.shapingPlan;
+	entry.modified = params.modified;
+
+	// Diagnostics may have cleared the statistics while we were planning the move, in which case the current value is the increment
+	const auto increment = [](uint32_t now, uint32_t before) noexcept -> uint32_t { return (now >= before) ? now - before : now; };
+	entry.countIncrements.shapedFirstTry = increment(movesShapedFirstTry, countsBefore.shapedFirstTry);
+	entry.countIncrements.shapedOnRetry = increment(movesShapedOnRetry, countsBefore.shapedOnRetry);
+	entry.countIncrements.tooShort = increment(movesTooShortToShape, countsBefore.tooShort);
+	entry.countIncrements.wrongShape = increment(movesWrongShapeToShape, countsBefore.wrongShape);
+	entry.countIncrements.couldPossiblyShape = increment(movesCouldPossiblyShape, countsBefore.couldPossiblyShape);
+
+	nextCachedPlanToReplace = (nextCachedPlanToReplace + 1) % PlanCacheSize;
+	if (numCachedPlans < PlanCacheSize)
+	{
+		++numCachedPlans;
+	}
 }
 
 // Calculate the move segments when input shaping is not in use
@@ -71,6 +71,46 @@ protected:
 	DECLARE_OBJECT_MODEL_WITH_ARRAYS
 
 private:
+	// Key for the cache of recent shaping plans. This holds every input that the plan depends on, so that a cached plan is identical to a freshly calculated one.
+	struct ShapingPlanKey
+	{
+		float startSpeed, endSpeed, topSpeed;
+		float acceleration, deceleration;
+		float totalDistance, accelDistance, decelStartDistance;
+		uint32_t idealPlan;
+
+		ShapingPlanKey() noexcept { }
+		ShapingPlanKey(float p_startSpeed, float p_endSpeed, const PrepParams& params, InputShaperPlan p_idealPlan) noexcept;
+
+		uint32_t Hash() const noexcept;
+		bool operator==(const ShapingPlanKey& other) const noexcept { return memcmp(this, &other, sizeof(ShapingPlanKey)) == 0; }
+	};
+
+	// Snapshot of the shaping statistics, used to find out which of them planning a move incremented
+	struct ShapingCounts
+	{
+		uint32_t shapedFirstTry, shapedOnRetry, tooShort, wrongShape, couldPossiblyShape;
+	};
+
+	// Entry in the cache of recent shaping plans
+	struct ShapingPlanCacheEntry
+	{
+		ShapingPlanKey key;
+		uint32_t hash;
+		float accelDistance, decelStartDistance;
+		float accelClocks, decelClocks;
+		float acceleration, deceleration;
+		float topSpeed;
+		InputShaperPlan shapingPlan;
+		bool modified;
+		ShapingCounts countIncrements;						// how much planning this move added to each statistic, so that we can count cache hits the same way
+	};
+
+	ShapingCounts GetShapingCounts() const noexcept { return { movesShapedFirstTry, movesShapedOnRetry, movesTooShortToShape, movesWrongShapeToShape, movesCouldPossiblyShape }; }
+	bool LookupCachedPlan(const ShapingPlanKey& key, PrepParams& params) noexcept;
+	void StoreCachedPlan(const ShapingPlanKey& key, const PrepParams& params, const ShapingCounts& countsBefore) noexcept;
+	void ClearPlanCache() noexcept { numCachedPlans = 0; nextCachedPlanToReplace = 0; }
+
 	void CalculateDerivedParameters() noexcept;
 	MoveSegment *GetAccelerationSegments(const DDA& dda, PrepParams& params) const noexcept;
 	MoveSegment *GetDecelerationSegments(const DDA& dda, PrepParams& params) const noexcept;
@@ -98,6 +138,7 @@ private:
 	static constexpr float DefaultDamping = 0.1;
 	static constexpr float DefaultReductionLimit = 0.25;
 	static constexpr float MinimumMiddleSegmentTime = 5.0/1000.0;	// minimum length of the segment between shaped start and shaped end of an acceleration or deceleration
+	static constexpr size_t PlanCacheSize = 8;						// the number of recent shaping plans that we remember
 
 	// Input shaping parameters input by the user
 	InputShaperType type;								// the type of the input shaper, from which we can find its name
@@ -131,6 +172,13 @@ private:
 	uint32_t movesTooShortToShape = 0;
 	uint32_t movesWrongShapeToShape = 0;
 	uint32_t movesCouldPossiblyShape = 0;
+
+	// Cache of recent shaping plans, so that sequences of identical moves (e.g. infill) don't need to be planned again. Cleared whenever the shaping parameters change.
+	ShapingPlanCacheEntry planCache[PlanCacheSize];
+	size_t numCachedPlans = 0;
+	size_t nextCachedPlanToReplace = 0;
+	uint32_t planCacheHits = 0;
+	uint32_t planCacheMisses = 0;
 };
 
 #endif /* SRC_MOVEMENT_AXISSHAPER_H_ */
@@ -335,19 +335,46 @@ void HeightMap::ClearGridHeights() noexcept
 #endif
 }
 
-// Set the height of a grid point
-void HeightMap::SetGridHeight(size_t axis0Index, size_t axis1Index, float height) noexcept
+// Set the height of a grid point, returning false if the height is too large to store
+bool HeightMap::SetGridHeight(size_t axis0Index, size_t axis1Index, float height) noexcept
 {
-	SetGridHeight(axis1Index * def.nums[0] + axis0Index, height);
+	return SetGridHeight(axis1Index * def.nums[0] + axis0Index, height);
 }
 
-void HeightMap::SetGridHeight(size_t index, float height) noexcept
+bool HeightMap::SetGridHeight(size_t index, float height) noexcept
 {
+#if SUPPORT_COMPACT_HEIGHT_MAP
+	if (!(fabsf(height) <= MaxStoredHeight))							// this also rejects NaNs
+	{
+		return false;
+	}
+#endif
 	if (index < MaxGridProbePoints)
 	{
-		gridHeights[index] = height;
+		StoreHeight(index, height);
 		gridHeightSet.SetBit(index);
 	}
+	return true;
+}
+
+inline float HeightMap::GetStoredHeight(size_t index) const noexcept
+{
+#if SUPPORT_COMPACT_HEIGHT_MAP
+	return (float)gridHeights[index] * StoredHeightUnit;
+#else
+	return gridHeights[index];
+#endif
+}
+
+// Store a height that has already been range checked, or one that we have extrapolated or interpolated from heights that were range checked
+inline void HeightMap::StoreHeight(size_t index, float height) noexcept
+{
+#if SUPPORT_COMPACT_HEIGHT_MAP
+	// Round to the nearest micrometre. Only an extrapolated height can be out of range, and we limit it to the nearest value we can store.
+	gridHeights[index] = (StoredHeight)lrintf(constrain<float>(height, -MaxStoredHeight, MaxStoredHeight) * (1.0/StoredHeightUnit));
+#else
+	gridHeights[index] = height;
+#endif
 }
 
 // Return the minimum number of segments for a move by this X or Y amount
@@ -410,7 +437,7 @@ bool HeightMap::SaveToFile(FileStore *f, const char *fname, float zOffset) noexc
 			}
 			if (gridHeightSet.IsBitSet(index))
 			{
-				buf.catf("%7.3f", (double)(gridHeights[index] + zOffset));
+				buf.catf("%7.3f", (double)(GetStoredHeight(index) + zOffset));
 			}
 			else
 			{
@@ -429,6 +456,32 @@ bool HeightMap::SaveToFile(FileStore *f, const char *fname, float zOffset) noexc
 	return false;
 }
 
+// Read the next comma-separated value in a row of the height map file into buf, skipping leading spaces and truncating it if it is too long.
+// Return the character that ended it, which is ',' or '\n', or 0 at the end of the file.
+static char ReadGridValue(FileStore *f, char *_ecv_array buf, size_t bufLen) noexcept
+{
+	size_t len = 0;
+	char c;
+	for (;;)
+	{
+		if (!f->Read(c))
+		{
+			c = 0;
+			break;
+		}
+		if (c == ',' || c == '\n')
+		{
+			break;
+		}
+		if (c != '\r' && (len != 0 || (c != ' ' && c != '\t')) && len + 1 < bufLen)
+		{
+			buf[len++] = c;
+		}
+	}
+	buf[len] = 0;
+	return c;
+}
+
 // Load the grid from file, returning true if an error occurred with the error reason appended to the buffer
 bool HeightMap::LoadFromFile(FileStore *f, const char *fname, const StringRef& r
 # if SUPPORT_PROBE_POINTS_FILE
@@ -436,7 +489,7 @@ bool HeightMap::LoadFromFile(FileStore *f, const char *fname, const StringRef& r
 # endif
 							) noexcept
 {
-	const size_t MaxLineLength = (MaxAxis0GridPoints * 8) + 2;					// maximum length of a line in the height map file, need 8 characters per grid point
+	const size_t MaxLineLength = 330;											// maximum length of a header line; grid rows can be longer, so we read them a value at a time
 	const char* const readFailureText = "failed to read line from file";
 	char buffer[MaxLineLength + 1];
 	StringRef s(buffer, ARRAY_SIZE(buffer));
@@ -484,35 +537,37 @@ bool HeightMap::LoadFromFile(FileStore *f, const char *fname, const StringRef& r
 		SetGrid(newGrid);
 		for (uint32_t row = 0; row < def.nums[1]; ++row)	// read the grid a row at a time
 		{
-			if (f->ReadLine(buffer, sizeof(buffer)) <= 0)
-			{
-				r.cat(readFailureText);
-				return true;								// failed to read a line
-			}
-			const char *p = buffer;
+			char terminator = ',';
 			for (uint32_t col = 0; col < def.nums[0]; ++col)
 			{
-				while (*p == ' ' || *p == '\t')
+				if (terminator != ',')
+				{
+					r.catf("number expected at line %" PRIu32 " value %" PRIu32, row + 3, col + 1);
+					return true;							// the row is too short
+				}
+				char value[16];
+				terminator = ReadGridValue(f, value, sizeof(value));
+				if (terminator == 0 && col == 0 && value[0] == 0)
 				{
-					++p;
+					r.cat(readFailureText);
+					return true;							// failed to read a line
 				}
 				if (
 #if SUPPORT_PROBE_POINTS_FILE
 					!isPointsFile &&
 #endif
-						(*p == '0' && (p[1] == ',' || p[1] == 0))
+						(value[0] == '0' && value[1] == 0)
 				   )
 				{
 					// Values of 0 with no decimal places in un-probed values, so leave the point set as not valid
-					++p;
 				}
 				else
 				{
 					const char* np;
-					const float f = SafeStrtof(p, &np);
-					if (np == p)
+					const float f = SafeStrtof(value, &np);
+					if (np == value)
 					{
-						r.catf("number expected at line %" PRIu32 " column %d", row + 3, (p - buffer) + 1);
+						r.catf("number expected at line %" PRIu32 " value %" PRIu32, row + 3, col + 1);
 						return true;						// failed to read a number
 					}
 #if SUPPORT_PROBE_POINTS_FILE
@@ -529,16 +584,19 @@ bool HeightMap::LoadFromFile(FileStore *f, const char *fname, const StringRef& r
 					}
 					else
 #endif
+					if (!SetGridHeight(col, row, f))
 					{
-						SetGridHeight(col, row, f);
+						r.catf("height %.3f at line %" PRIu32 " value %" PRIu32 " is out of range", (double)f, row + 3, col + 1);
+						return true;
 					}
-					p = np;
-				}
-				if (*p == ',')
-				{
-					++p;
 				}
 			}
+
+			while (terminator == ',')						// ignore any extra values at the end of the row
+			{
+				char value[16];
+				terminator = ReadGridValue(f, value, sizeof(value));
+			}
 		}
 #if SUPPORT_PROBE_POINTS_FILE
 		if (!isPointsFile)
@@ -566,7 +624,7 @@ unsigned int HeightMap::GetStatistics(Deviation& deviation, float& minError, flo
 		if (gridHeightSet.IsBitSet(i))
 		{
 			++numProbed;
-			const float fHeightError = gridHeights[i];
+			const float fHeightError = GetStoredHeight(i);
 			if (fHeightError > maxError)
 			{
 				maxError = fHeightError;
@@ -644,10 +702,15 @@ float HeightMap::InterpolateAxis0Axis1(size_t axis0Index, size_t axis1Index, flo
 	const uint32_t indexX1Y1 = indexX0Y1 + 1;						// (X1,Y1)
 
 	const float xyFrac = axis0Frac * axis1Frac;
-	return (gridHeights[indexX0Y0] * (1.0 - axis0Frac - axis1Frac + xyFrac))
-			+ (gridHeights[indexX1Y0] * (axis0Frac - xyFrac))
-			+ (gridHeights[indexX0Y1] * (axis1Frac - xyFrac))
-			+ (gridHeights[indexX1Y1] * xyFrac);
+	const float height = ((float)gridHeights[indexX0Y0] * (1.0 - axis0Frac - axis1Frac + xyFrac))
+						+ ((float)gridHeights[indexX1Y0] * (axis0Frac - xyFrac))
+						+ ((float)gridHeights[indexX0Y1] * (axis1Frac - xyFrac))
+						+ ((float)gridHeights[indexX1Y1] * xyFrac);
+#if SUPPORT_COMPACT_HEIGHT_MAP
+	return height * StoredHeightUnit;						// scale once after interpolating instead of once per grid point
+#else
+	return height;
+#endif
 }
 
 void HeightMap::ExtrapolateMissing() noexcept
@@ -667,7 +730,7 @@ void HeightMap::ExtrapolateMissing() noexcept
 			{
 				const float fAxis0 = (def.spacings[0] * iAxis0) + def.mins[0];
 				const float fAxis1 = (def.spacings[1] * iAxis1) + def.mins[1];
-				const float fZ = gridHeights[index];
+				const float fZ = GetStoredHeight(index);
 
 				n++;
 				sumAxis0 += fAxis0; sumAxis1 += fAxis1; sumZ += fZ;
@@ -691,7 +754,7 @@ void HeightMap::ExtrapolateMissing() noexcept
 			{
 				const float fAxis0 = (def.spacings[0] * iAxis0) + def.mins[0];
 				const float fAxis1 = (def.spacings[1] * iAxis1) + def.mins[1];
-				const float fZ = gridHeights[index];
+				const float fZ = GetStoredHeight(index);
 
 				const float rAxis0 = fAxis0 - centAxis0;
 				const float rAxis1 = fAxis1 - centAxis1;
@@ -734,13 +797,18 @@ void HeightMap::ExtrapolateMissing() noexcept
 			{
 #if SUPPORT_PROBE_POINTS_FILE
 				// The point may be surrounded by points we have probed, in which case we need to interpolate instead of extrapolate
-				if (!InterpolateMissingPoint(iAxis0, iAxis1, gridHeights[index]))
+				float interpolatedZ;
+				if (InterpolateMissingPoint(iAxis0, iAxis1, interpolatedZ))
+				{
+					StoreHeight(index, interpolatedZ);		// fill in Z but don't mark it as set
+				}
+				else
 #endif
 				{
 					const float fAxis0 = (def.spacings[0] * iAxis0) + def.mins[0];
 					const float fAxis1 = (def.spacings[1] * iAxis1) + def.mins[1];
 					const float fZ = (d - (a * fAxis0 + b * fAxis1)) * invC;
-					gridHeights[index] = fZ;	// fill in Z but don't mark it as set so we can always differentiate between measured and extrapolated
+					StoreHeight(index, fZ);		// fill in Z but don't mark it as set so we can always differentiate between measured and extrapolated
 				}
 			}
 		}
@@ -763,7 +831,7 @@ bool HeightMap::InterpolateMissingPoint(size_t axis0Index, size_t axis1Index, fl
 		&& gridHeightSet.IsBitSet(GetMapIndex(axis0Index + 1, axis1Index))
 	   )
 	{
-		total += gridHeights[GetMapIndex(axis0Index - 1, axis1Index)] + gridHeights[GetMapIndex(axis0Index + 1, axis1Index)];
+		total += GetStoredHeight(GetMapIndex(axis0Index - 1, axis1Index)) + GetStoredHeight(GetMapIndex(axis0Index + 1, axis1Index));
 		numPointsUsed += 2;
 	}
 
@@ -776,7 +844,7 @@ bool HeightMap::InterpolateMissingPoint(size_t axis0Index, size_t axis1Index, fl
 			&& gridHeightSet.IsBitSet(GetMapIndex(axis0Index, axis1Index + 1))
 		   )
 		{
-			total += gridHeights[GetMapIndex(axis0Index, axis1Index - 1)] + gridHeights[GetMapIndex(axis0Index, axis1Index + 1)];
+			total += GetStoredHeight(GetMapIndex(axis0Index, axis1Index - 1)) + GetStoredHeight(GetMapIndex(axis0Index, axis1Index + 1));
 			numPointsUsed += 2;
 		}
 
@@ -788,12 +856,12 @@ bool HeightMap::InterpolateMissingPoint(size_t axis0Index, size_t axis1Index, fl
 		{
 			if (gridHeightSet.IsBitSet(GetMapIndex(axis0Index - 1, axis1Index - 1)) && gridHeightSet.IsBitSet(GetMapIndex(axis0Index + 1, axis1Index + 1)))
 			{
-				total += gridHeights[GetMapIndex(axis0Index - 1, axis1Index - 1)] + gridHeights[GetMapIndex(axis0Index + 1, axis1Index + 1)];
+				total += GetStoredHeight(GetMapIndex(axis0Index - 1, axis1Index - 1)) + GetStoredHeight(GetMapIndex(axis0Index + 1, axis1Index + 1));
 				numPointsUsed += 2;
 			}
 			if (gridHeightSet.IsBitSet(GetMapIndex(axis0Index - 1, axis1Index + 1)) && gridHeightSet.IsBitSet(GetMapIndex(axis0Index + 1, axis1Index - 1)))
 			{
-				total += gridHeights[GetMapIndex(axis0Index - 1, axis1Index + 1)] + gridHeights[GetMapIndex(axis0Index + 1, axis1Index - 1)];
+				total += GetStoredHeight(GetMapIndex(axis0Index - 1, axis1Index + 1)) + GetStoredHeight(GetMapIndex(axis0Index + 1, axis1Index - 1));
 				numPointsUsed += 2;
 			}
 		}
@@ -78,7 +78,7 @@ public:
 
 	float GetInterpolatedHeightError(float axis0, float axis1) const noexcept;			// Compute the interpolated height error at the specified point
 	void ClearGridHeights() noexcept;													// Clear all grid height corrections
-	void SetGridHeight(size_t axis0Index, size_t axis1Index, float height) noexcept;	// Set the height of a grid point
+	bool SetGridHeight(size_t axis0Index, size_t axis1Index, float height) noexcept;	// Set the height of a grid point, returning false if it is out of range
 
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 	bool SaveToFile(FileStore *f, const char *fname, float zOffset) noexcept			// Save the grid to file returning true if an error occurred
@@ -116,8 +116,17 @@ private:
 # endif
 #endif
 
+#if SUPPORT_COMPACT_HEIGHT_MAP
+	// Heights are stored as signed integer micrometres. This matches the 3 decimal places we use in the height map file, so save/load round trips are exact.
+	typedef int16_t StoredHeight;
+	static constexpr float StoredHeightUnit = 0.001;				// the height in mm represented by one unit of StoredHeight
+	static constexpr float MaxStoredHeight = (float)INT16_MAX * StoredHeightUnit;
+#else
+	typedef float StoredHeight;
+#endif
+
 	GridDefinition def;
-	float gridHeights[MaxGridProbePoints];							// The Z coordinates of the points on the bed that were probed
+	StoredHeight gridHeights[MaxGridProbePoints];					// The Z coordinates of the points on the bed that were probed
 	LargeBitmap<MaxGridProbePoints> gridHeightSet;					// Bitmap of which heights are set
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 	String<MaxFilenameLength> fileName;								// The name of the file that this height map was loaded from or saved to
@@ -128,7 +137,9 @@ private:
 	bool useMap;													// True to do bed compensation
 
 	size_t GetMapIndex(size_t axis0Index, size_t axis1Index) const noexcept { return (axis1Index * def.NumAxisPoints(0)) + axis0Index; }
-	void SetGridHeight(size_t index, float height) noexcept;							// Set the height of a grid point
+	bool SetGridHeight(size_t index, float height) noexcept;							// Set the height of a grid point, returning false if it is out of range
+	float GetStoredHeight(size_t index) const noexcept;									// Get the height of a grid point whether or not it was probed
+	void StoreHeight(size_t index, float height) noexcept;								// Store the height of a grid point without marking it as probed
 
 	float InterpolateAxis0Axis1(size_t axis0Index, size_t axis1Index, float axis0Frac, float axis1Frac) const noexcept;
 
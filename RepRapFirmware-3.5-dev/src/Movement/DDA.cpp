@@ -1350,6 +1350,7 @@ void DDA::ReleaseSegments() noexcept
 // This must not be called with interrupts disabled, because it calls Platform::EnableDrive.
 void DDA::Prepare(SimulationMode simMode) noexcept
 {
+	PROFILE_MOVE_PREP_STAGE(ddaPrepare);
 	flags.wasAccelOnlyMove = IsAccelerationMove();			// save this for the next move to look at
 
 #if SUPPORT_LASER
@@ -0,0 +1,76 @@
+/*
+ * DeltaStepApproximation.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Quadratic approximation of the distance moved by the head as a function of the height of a delta tower carriage, used by M665 S1
+ * to avoid a square root for most delta tower steps. This has no dependencies on the rest of the firmware so that it can be tested on a host.
+ *
+ * With h = carriage height above Z in steps, d*s = t1 -/+ g where t1 = -(aA + bB)*s + c*h and g = sqrt(D^2*s^2 - h^2 + t1^2).
+ * The derivatives of g are g' = (c*t1 - h)/g, g'' = (c^2 - 1 - g'^2)/g and g''' = -3*g'*g''/g, so after k steps the truncation error
+ * of the quadratic approximation is approximately |g'*g''|/(2*g) * k^3. That estimate ignores the higher order terms, so we only use the
+ * approximation while the estimate is within half the tolerance.
+ * The firmware uses it with float arithmetic. The host test also instantiates it with double arithmetic, to check the truncation error on its own.
+ */
+
+#ifndef SRC_MOVEMENT_DELTASTEPAPPROXIMATION_H_
+#define SRC_MOVEMENT_DELTASTEPAPPROXIMATION_H_
+
+#include <cmath>
+#include <limits>
+
+template<class T> class DeltaStepApproximationT
+{
+public:
+	static constexpr T Tolerance = 0.01;							// the maximum error in d*s that we allow when we use the approximation
+	static constexpr T ErrorEstimateLimit = 0.5 * Tolerance;		// the limit for the estimated truncation error, leaving a margin for the terms it ignores
+	static constexpr T MaxSteps = 64.0;								// the maximum number of carriage steps between exact calculations
+	static constexpr T MinRoot = 1.0;								// don't approximate when the square root term is smaller than this (i.e. close to reversal)
+
+	void Invalidate() noexcept { baseHeight = 0.0; errorCoeff = std::numeric_limits<T>::infinity(); }
+
+	// Set up the approximation from an exact calculation of d*s at carriage height h. 'up' is true if the carriage is moving up.
+	void SetBase(T h, T t1, T t2, T ds, T dirZ, bool up) noexcept
+	{
+		if (t2 < MinRoot)
+		{
+			Invalidate();											// too close to the reversal point, the derivatives are too large
+		}
+		else
+		{
+			const T recipT2 = (T)1.0/t2;
+			const T dg = (dirZ * t1 - h) * recipT2;
+			const T d2g = (dirZ * dirZ - (T)1.0 - dg * dg) * recipT2;
+			baseHeight = h;
+			baseDs = ds;
+			deriv1 = (up) ? dirZ - dg : dirZ + dg;
+			halfDeriv2 = (up) ? (T)-0.5 * d2g : (T)0.5 * d2g;
+			errorCoeff = std::fabs(dg * d2g) * (T)0.5 * recipT2;
+		}
+	}
+
+	// If the approximation is accurate enough at carriage height h, set ds and return true
+	bool Estimate(T h, T& ds) const noexcept
+	{
+		const T heightChange = h - baseHeight;
+		const T absHeightChange = std::fabs(heightChange);
+		if (absHeightChange <= MaxSteps && absHeightChange * absHeightChange * absHeightChange * errorCoeff <= ErrorEstimateLimit)
+		{
+			ds = baseDs + heightChange * (deriv1 + heightChange * halfDeriv2);
+			return true;
+		}
+		return false;
+	}
+
+private:
+	T baseHeight;													// the carriage height at which we last calculated d*s exactly
+	T baseDs;														// the value of d*s at that carriage height
+	T deriv1;														// the first derivative of d*s with respect to carriage height
+	T halfDeriv2;													// half the second derivative of d*s with respect to carriage height
+	T errorCoeff;													// the coefficient of the cubic truncation error term, or infinity if the base values are not valid
+};
+
+typedef DeltaStepApproximationT<float> DeltaStepApproximation;
+
+#endif /* SRC_MOVEMENT_DELTASTEPAPPROXIMATION_H_ */
@@ -185,6 +185,7 @@ bool DriveMovement::NewDeltaSegment(const DDA& dda) noexcept
 		{
 			direction = false;					// we must have been going up, so now we are going down
 			directionChanged = directionReversed = true;
+			mp.delta.approx.Invalidate();		// the sign of the square root term has changed
 		}
 
 		if (currentSegment->GetNext() == nullptr)
@@ -347,6 +348,7 @@ bool DriveMovement::NewExtruderSegment() noexcept
 // Prepare this DM for a Cartesian axis move, returning true if there are steps to do
 bool DriveMovement::PrepareCartesianAxis(const DDA& dda) noexcept
 {
+	PROFILE_MOVE_PREP_STAGE(prepareCartesianAxis);
 	distanceSoFar = 0.0;
 	timeSoFar = 0.0;
 	mp.cart.pressureAdvanceK = 0.0;
@@ -467,6 +469,7 @@ bool DriveMovement::PrepareCartesianAxis(const DDA& dda) noexcept
 // Prepare this DM for a Delta axis move, returning true if there are steps to do
 bool DriveMovement::PrepareDeltaAxis(const DDA& dda, const PrepParams& params) noexcept
 {
+	PROFILE_MOVE_PREP_STAGE(prepareDeltaAxis);
 	const float stepsPerMm = reprap.GetPlatform().DriveStepsPerUnit(drive);
 	const float A = params.initialX - params.dparams->GetTowerX(drive);
 	const float B = params.initialY - params.dparams->GetTowerY(drive);
@@ -480,6 +483,8 @@ bool DriveMovement::PrepareDeltaAxis(const DDA& dda, const PrepParams& params) n
 	mp.delta.fHmz0s = h0MinusZ0 * stepsPerMm;
 	mp.delta.fMinusAaPlusBbTimesS = -(aAplusbB * stepsPerMm);
 	mp.delta.fDSquaredMinusAsquaredMinusBsquaredTimesSsquared = dSquaredMinusAsquaredMinusBsquared * fsquare(stepsPerMm);
+	mp.delta.approx.Invalidate();							// the first step is always calculated exactly
+	useIncrementalDelta = params.dparams->UseIncrementalStepGeneration();
 	reverseStartStep = totalSteps + 1;						// set up the default
 
 	// Calculate the distance at which we need to reverse direction.
@@ -588,6 +593,7 @@ bool DriveMovement::PrepareDeltaAxis(const DDA& dda, const PrepParams& params) n
 // effStepsPerMm is the number of extruder steps needed per mm of totalDistance before we apply pressure advance
 void DriveMovement::PrepareExtruder(const DDA& dda, float signedEffStepsPerMm) noexcept
 {
+	PROFILE_MOVE_PREP_STAGE(prepareExtruder);
 	const float effStepsPerMm = fabsf(signedEffStepsPerMm);
 	mp.cart.effectiveStepsPerMm = effStepsPerMm;
 	mp.cart.effectiveMmPerStep = 1.0/effStepsPerMm;
@@ -617,6 +623,7 @@ void DriveMovement::PrepareExtruder(const DDA& dda, float signedEffStepsPerMm) n
 // behave in a similar way to a retraction move.
 bool DriveMovement::LatePrepareExtruder(const DDA& dda) noexcept
 {
+	PROFILE_MOVE_PREP_STAGE(latePrepareExtruder);
 	const size_t logicalDrive =
 #if SUPPORT_REMOTE_COMMANDS
 								(dda.flags.isRemote) ? drive : LogicalDriveToExtruder(drive);
@@ -791,6 +798,7 @@ pre(nextStep <= totalSteps; stepsTillRecalc == 0)
 			direction = false;
 			directionChanged = directionReversed = true;
 			state = DMState::deltaNormal;
+			mp.delta.approx.Invalidate();
 		}
 		// no break
 	case DMState::deltaNormal:
@@ -806,12 +814,21 @@ pre(nextStep <= totalSteps; stepsTillRecalc == 0)
 				mp.delta.fHmz0s -= steps;						// get new carriage height above Z in steps
 			}
 
-			const float hmz0sc = mp.delta.fHmz0s * dda.directionVector[Z_AXIS];
-			const float t1 = mp.delta.fMinusAaPlusBbTimesS + hmz0sc;
-			const float t2a = mp.delta.fDSquaredMinusAsquaredMinusBsquaredTimesSsquared - fsquare(mp.delta.fHmz0s) + fsquare(t1);
-			// Due to rounding error we can end up trying to take the square root of a negative number if we do not take precautions here
-			const float t2 = fastLimSqrtf(t2a);
-			const float ds = (direction) ? t1 - t2 : t1 + t2;
+			float ds;
+			// If we are close enough to the last exact calculation, use the quadratic approximation which avoids the square root
+			if (!useIncrementalDelta || !mp.delta.approx.Estimate(mp.delta.fHmz0s, ds))
+			{
+				const float hmz0sc = mp.delta.fHmz0s * dda.directionVector[Z_AXIS];
+				const float t1 = mp.delta.fMinusAaPlusBbTimesS + hmz0sc;
+				const float t2a = mp.delta.fDSquaredMinusAsquaredMinusBsquaredTimesSsquared - fsquare(mp.delta.fHmz0s) + fsquare(t1);
+				// Due to rounding error we can end up trying to take the square root of a negative number if we do not take precautions here
+				const float t2 = fastLimSqrtf(t2a);
+				ds = (direction) ? t1 - t2 : t1 + t2;
+				if (useIncrementalDelta)
+				{
+					mp.delta.approx.SetBase(mp.delta.fHmz0s, t1, t2, ds, dda.directionVector[Z_AXIS], direction);
+				}
+			}
 
 			// Now feed ds into the step algorithm for Cartesian motion
 			if (ds < 0.0)
@@ -12,6 +12,10 @@
 #include <Platform/Tasks.h>
 #include "MoveSegment.h"
 
+#if SUPPORT_LINEAR_DELTA
+# include "DeltaStepApproximation.h"
+#endif
+
 class LinearDeltaKinematics;
 class PrepParams;
 
@@ -111,7 +115,7 @@ private:
 			directionReversed : 1,						// true if we have reversed the requested motion direction because of pressure advance
 			isDelta : 1,								// true if this motor is executing a delta tower move
 			isExtruder : 1,								// true if this DM is for an extruder (only matters if !isDelta)
-					: 1,								// padding to make the next field last
+			useIncrementalDelta : 1,					// true if this delta tower uses the incremental step time calculation (M665 S1)
 			stepsTakenThisSegment : 2;					// how many steps we have taken this phase, counts from 0 to 2. Last field in the byte so that we can increment it efficiently.
 	uint8_t stepsTillRecalc;							// how soon we need to recalculate
 
@@ -181,6 +185,8 @@ private:
 			float fHmz0s;								// the starting height less the starting Z height, multiplied by the Z movement fraction (can go negative)
 			float fMinusAaPlusBbTimesS;
 			float reverseStartDistance;					// the overall move distance at which movement reversal occurs
+
+			DeltaStepApproximation approx;				// used by the incremental calculation, which approximates d*s by a quadratic in carriage height between exact calculations
 		} delta;
 #endif
 
@@ -80,6 +80,7 @@ void LinearDeltaKinematics::Init() noexcept
 	printRadius = DefaultPrintRadius;
 	homedHeight = DefaultDeltaHomedHeight;
     doneAutoCalibration = false;
+	incrementalStepGeneration = false;
 
 	for (size_t axis = 0; axis < UsualNumTowers; ++axis)
 	{
@@ -807,9 +808,11 @@ bool LinearDeltaKinematics::WriteCalibrationParameters(FileStore *f) const noexc
 			scratchString.catf("%c%.3f", (tower == 0) ? 'L' : ':', (double)diagonals[tower]);
 		}
 
-		scratchString.catf(" R%.3f H%.3f B%.1f X%.3f Y%.3f Z%.3f\n",
+		// Include the step generation mode so that M501 restores it along with the geometry
+		scratchString.catf(" R%.3f H%.3f B%.1f X%.3f Y%.3f Z%.3f S%u\n",
 			(double)radius, (double)homedHeight, (double)printRadius,
-			(double)angleCorrections[DELTA_A_AXIS], (double)angleCorrections[DELTA_B_AXIS], (double)angleCorrections[DELTA_C_AXIS]);
+			(double)angleCorrections[DELTA_A_AXIS], (double)angleCorrections[DELTA_B_AXIS], (double)angleCorrections[DELTA_C_AXIS],
+			(incrementalStepGeneration) ? 1u : 0u);
 		ok = f->Write(scratchString.c_str());
 		if (ok)
 		{
@@ -844,7 +847,7 @@ bool LinearDeltaKinematics::Configure(unsigned int mCode, GCodeBuffer& gb, const
 	{
 	case 665:
 		{
-			bool seen = false;
+			bool seen = false, seenNonGeometry = false;
 			if (gb.Seen('L'))
 			{
 				seen = true;
@@ -882,11 +885,18 @@ bool LinearDeltaKinematics::Configure(unsigned int mCode, GCodeBuffer& gb, const
 				seen = true;
 			}
 
+			if (gb.Seen('S'))
+			{
+				// This doesn't change the geometry so we don't need to call Recalc
+				incrementalStepGeneration = (gb.GetLimitedUIValue('S', 2) == 1);
+				seenNonGeometry = true;
+			}
+
 			if (seen)
 			{
 				Recalc();
 			}
-			else
+			else if (!seenNonGeometry)
 			{
 				reply.copy("Diagonals");
 				for (size_t tower = 0; tower < numTowers; ++tower)
@@ -898,6 +908,7 @@ bool LinearDeltaKinematics::Configure(unsigned int mCode, GCodeBuffer& gb, const
 							 (double)radius,
 							 (double)homedHeight, (double)printRadius,
 							 (double)angleCorrections[DELTA_A_AXIS], (double)angleCorrections[DELTA_B_AXIS], (double)angleCorrections[DELTA_C_AXIS]);
+				reply.catf(", %s step generation", (incrementalStepGeneration) ? "incremental" : "exact");
 			}
 			return seen;
 		}
@@ -56,6 +56,7 @@ public:
 	float GetDiagonalSquared(size_t tower) const noexcept { return D2[tower]; }
     float GetTowerX(size_t axis) const noexcept { return towerX[axis]; }
     float GetTowerY(size_t axis) const noexcept { return towerY[axis]; }
+	bool UseIncrementalStepGeneration() const noexcept { return incrementalStepGeneration; }
 
 protected:
 	DECLARE_OBJECT_MODEL_WITH_ARRAYS
@@ -106,6 +107,7 @@ private:
 	float alwaysReachableHeight;
 
 	bool doneAutoCalibration;							// True if we have done auto calibration
+	bool incrementalStepGeneration;						// True to calculate tower step times incrementally instead of solving the quadratic for every step (M665 S1)
 };
 
 #endif	// SUPPORT_LINEAR_DELTA
@@ -127,6 +127,9 @@ constexpr ObjectModelTableEntry Move::objectModelTable[] =
 	{ "kinematics",				OBJECT_MODEL_FUNC(self->kinematics),															ObjectModelEntryFlags::none },
 	{ "limitAxes",				OBJECT_MODEL_FUNC_NOSELF(reprap.GetGCodes().LimitAxes()),										ObjectModelEntryFlags::none },
 	{ "noMovesBeforeHoming",	OBJECT_MODEL_FUNC_NOSELF(reprap.GetGCodes().NoMovesBeforeHoming()),								ObjectModelEntryFlags::none },
+#if SUPPORT_MOVE_PREP_PROFILING
+	{ "prepTimings",			OBJECT_MODEL_FUNC(&self->prepProfiler, 0),														ObjectModelEntryFlags::none },
+#endif
 	{ "printingAcceleration",	OBJECT_MODEL_FUNC_NOSELF(InverseConvertAcceleration(reprap.GetGCodes().GetPrimaryMaxPrintingAcceleration()), 1),	ObjectModelEntryFlags::none },
 	{ "queue",					OBJECT_MODEL_FUNC_ARRAY(2),																		ObjectModelEntryFlags::none },
 #if SUPPORT_COORDINATE_ROTATION
@@ -197,7 +200,7 @@ constexpr ObjectModelTableEntry Move::objectModelTable[] =
 constexpr uint8_t Move::objectModelTableDescriptor[] =
 {
 	9 + SUPPORT_COORDINATE_ROTATION,
-	17 + SUPPORT_COORDINATE_ROTATION + SUPPORT_KEEPOUT_ZONES,
+	17 + SUPPORT_COORDINATE_ROTATION + SUPPORT_KEEPOUT_ZONES + SUPPORT_MOVE_PREP_PROFILING,
 	2,
 	5 + SUPPORT_LASER,
 	3,
@@ -601,6 +604,9 @@ void Move::Diagnostics(MessageType mtype) noexcept
 	StepTimer::Diagnostics(scratchString.GetRef());
 	p.MessageF(mtype, "%s\n", scratchString.c_str());
 	axisShaper.Diagnostics(mtype);
+#if SUPPORT_MOVE_PREP_PROFILING
+	prepProfiler.Diagnostics(mtype, false);
+#endif
 
 	for (size_t i = 0; i < ARRAY_SIZE(rings); ++i)
 	{
@@ -11,6 +11,7 @@
 #include <RepRapFirmware.h>
 #include "AxisShaper.h"
 #include "ExtruderShaper.h"
+#include "MovePrepProfiler.h"
 #include "DDARing.h"
 #include "DDA.h"								// needed because of our inline functions
 #include "BedProbing/RandomProbePointSet.h"
@@ -115,6 +116,9 @@ public:
 #endif
 
 	AxisShaper& GetAxisShaper() noexcept { return axisShaper; }
+#if SUPPORT_MOVE_PREP_PROFILING
+	const MovePrepProfiler& GetPrepProfiler() const noexcept { return prepProfiler; }
+#endif
 	ExtruderShaper& GetExtruderShaper(size_t extruder) noexcept { return extruderShapers[extruder]; }
 
 	void Diagnostics(MessageType mtype) noexcept;							// Report useful stuff
@@ -311,6 +315,9 @@ private:
 
 	AxisShaper axisShaper;
 	ExtruderShaper extruderShapers[MaxExtruders];
+#if SUPPORT_MOVE_PREP_PROFILING
+	MovePrepProfiler prepProfiler;
+#endif
 
 	float specialMoveCoords[MaxDriversPerAxis];			// Amounts by which to move individual Z motors (leadscrew adjustment move)
 
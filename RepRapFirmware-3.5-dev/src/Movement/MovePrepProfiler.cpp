@@ -0,0 +1,131 @@
+/*
+ * MovePrepProfiler.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ */
+
+#include "MovePrepProfiler.h"
+
+#if SUPPORT_MOVE_PREP_PROFILING
+
+#include <Platform/RepRap.h>
+#include <Platform/Platform.h>
+
+// Object model table and functions
+// Note: if using GCC version 7.3.1 20180622 and lambda functions are used in this table, you must compile this file with option -std=gnu++17.
+// Otherwise the table will be allocated in RAM instead of flash, which wastes too much RAM.
+
+// Macro to build a standard lambda function that includes the necessary type conversions
+#define OBJECT_MODEL_FUNC(...)					OBJECT_MODEL_FUNC_BODY(MovePrepProfiler, __VA_ARGS__)
+#define OBJECT_MODEL_FUNC_IF(_condition, ...)	OBJECT_MODEL_FUNC_IF_BODY(MovePrepProfiler, _condition, __VA_ARGS__)
+
+constexpr ObjectModelArrayTableEntry MovePrepProfiler::objectModelArrayTable[] =
+{
+	// 0. Stages
+	{
+		nullptr,					// no lock needed
+		[] (const ObjectModel *self, const ObjectExplorationContext& context) noexcept -> size_t { return MovePrepStage::NumValues; },
+		[] (const ObjectModel *self, ObjectExplorationContext& context) noexcept -> ExpressionValue { return ExpressionValue(self, 1); }
+	},
+	// 1. Histogram of a stage
+	{
+		nullptr,					// no lock needed
+		[] (const ObjectModel *self, const ObjectExplorationContext& context) noexcept -> size_t { return NumBuckets; },
+		[] (const ObjectModel *self, ObjectExplorationContext& context) noexcept
+											-> ExpressionValue { return ExpressionValue((uint32_t)timings[context.GetIndex(1)].buckets[context.GetLastIndex()]); }
+	},
+};
+
+DEFINE_GET_OBJECT_MODEL_ARRAY_TABLE(MovePrepProfiler)
+
+constexpr ObjectModelTableEntry MovePrepProfiler::objectModelTable[] =
+{
+	// Within each group, these entries must be in alphabetical order
+	// 0. MovePrepProfiler members
+	{ "stages",					OBJECT_MODEL_FUNC_ARRAY(0), 																	ObjectModelEntryFlags::live },
+
+	// 1. Stage members
+	{ "count",					OBJECT_MODEL_FUNC_NOSELF((uint32_t)timings[context.GetLastIndex()].count),						ObjectModelEntryFlags::live },
+	{ "histogram",				OBJECT_MODEL_FUNC_ARRAY(1),																		ObjectModelEntryFlags::live },
+	{ "max",					OBJECT_MODEL_FUNC_NOSELF(timings[context.GetLastIndex()].GetMaxMicroseconds(), 1),				ObjectModelEntryFlags::live },
+	{ "mean",					OBJECT_MODEL_FUNC_NOSELF(timings[context.GetLastIndex()].GetMeanMicroseconds(), 1),				ObjectModelEntryFlags::live },
+	{ "name",					OBJECT_MODEL_FUNC_NOSELF(MovePrepStage((MovePrepStage::BaseType)context.GetLastIndex()).ToString()),	ObjectModelEntryFlags::none },
+};
+
+constexpr uint8_t MovePrepProfiler::objectModelTableDescriptor[] = { 2, 1, 5 };
+
+DEFINE_GET_OBJECT_MODEL_TABLE(MovePrepProfiler)
+
+MovePrepProfiler::StageTimings MovePrepProfiler::timings[MovePrepStage::NumValues];
+
+// Record the time taken by one execution of a stage.
+// This is called from the Move task and from the step ISR (for latePrepareExtruder). We don't disable interrupts here because that would add latency to the step ISR.
+// Each stage other than latePrepareExtruder is only timed by the Move task, so the only possible conflict is the step ISR recording latePrepareExtruder
+// while the Move task is recording the same stage, which at worst loses one sample.
+void MovePrepProfiler::Record(MovePrepStage stage, uint32_t ticks) noexcept
+{
+	const uint32_t microseconds = ticks/MovePrepClock::TicksPerMicrosecond;
+	const size_t bucket = (microseconds == 0) ? 0 : min<size_t>(32 - __builtin_clz(microseconds), NumBuckets - 1);
+
+	StageTimings& st = timings[stage.ToBaseType()];
+	++st.count;
+	st.totalTicks += ticks;
+	if (ticks > st.maxTicks)
+	{
+		st.maxTicks = ticks;
+	}
+	++st.buckets[bucket];
+}
+
+// Clear all the timings. Called by M122 P111.
+void MovePrepProfiler::Reset() noexcept
+{
+	AtomicCriticalSectionLocker lock;
+	memset((void *)timings, 0, sizeof(timings));
+}
+
+// Report the timings. The timings are not cleared, because we want to accumulate them over a whole print. Use M122 P111 to clear them.
+void MovePrepProfiler::Diagnostics(MessageType mtype, bool printHistograms) const noexcept
+{
+	Platform& p = reprap.GetPlatform();
+	p.Message(mtype, "Move preparation times count/mean/max us");
+	for (size_t i = 0; i < MovePrepStage::NumValues; ++i)
+	{
+		const StageTimings& st = timings[i];
+		p.MessageF(mtype, "%c %s %" PRIu32 "/%.1f/%.1f", (i == 0) ? ':' : ',', MovePrepStage((MovePrepStage::BaseType)i).ToString(),
+						st.count, (double)st.GetMeanMicroseconds(), (double)st.GetMaxMicroseconds());
+	}
+	p.Message(mtype, "\n");
+
+	if (printHistograms)
+	{
+		String<StringLength256> scratchString;
+		for (size_t i = 0; i < MovePrepStage::NumValues; ++i)
+		{
+			const StageTimings& st = timings[i];
+			scratchString.printf("%s:", MovePrepStage((MovePrepStage::BaseType)i).ToString());
+			for (size_t bucket = 0; bucket < NumBuckets; ++bucket)
+			{
+				if (bucket == 0)
+				{
+					scratchString.catf(" <1us %" PRIu32, st.buckets[bucket]);
+				}
+				else if (bucket + 1 == NumBuckets)
+				{
+					scratchString.catf(", >=%uus %" PRIu32, 1u << (bucket - 1), st.buckets[bucket]);
+				}
+				else
+				{
+					scratchString.catf(", <%uus %" PRIu32, 1u << bucket, st.buckets[bucket]);
+				}
+			}
+			scratchString.cat('\n');
+			p.Message(mtype, scratchString.c_str());
+		}
+	}
+}
+
+#endif	// SUPPORT_MOVE_PREP_PROFILING
+
+// End
@@ -0,0 +1,117 @@
+/*
+ * MovePrepProfiler.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Instrumentation to record how long each stage of move preparation takes, so that we can make evidence-based choices of ring length and segmentation.
+ * Each stage has a histogram of execution times in power-of-2 microsecond buckets. Stages nest, so e.g. the ddaPrepare time includes the planShaping time.
+ */
+
+#ifndef SRC_MOVEMENT_MOVEPREPPROFILER_H_
+#define SRC_MOVEMENT_MOVEPREPPROFILER_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_MOVE_PREP_PROFILING
+
+#include <General/NamedEnum.h>
+#include <ObjectModel/ObjectModel.h>
+
+#if !defined(__ARM_ARCH_7M__) && !defined(__ARM_ARCH_7EM__)
+# include <chrono>
+#endif
+
+// The stages of move preparation that we time. These names must be in alphabetical order and lowercase.
+NamedEnum(MovePrepStage, uint8_t,
+	canFinishMovement,
+	ddaPrepare,
+	latePrepareExtruder,
+	planShaping,
+	prepareCartesianAxis,
+	prepareDeltaAxis,
+	prepareExtruder,
+	prepareMoves
+);
+
+// Portable high resolution clock used to time the stages.
+// On Cortex-M3/M4/M7 processors we use the DWT cycle counter. When building for a host (e.g. to run the movement code in a test harness) we use std::chrono::steady_clock.
+namespace MovePrepClock
+{
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+	constexpr uint32_t TicksPerMicrosecond = SystemCoreClockFreq/1000000;
+
+	inline void Init() noexcept
+	{
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	}
+
+	inline uint32_t GetTicks() noexcept { return DWT->CYCCNT; }
+#else
+	constexpr uint32_t TicksPerMicrosecond = 1000;
+
+	inline void Init() noexcept { }
+
+	inline uint32_t GetTicks() noexcept
+	{
+		return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+#endif
+}
+
+class MovePrepProfiler INHERIT_OBJECT_MODEL
+{
+public:
+	// Histogram bucket 0 counts times below 1us, bucket N counts times from 2^(N-1)us up to 2^N us, and the last bucket also counts all longer times
+	static constexpr size_t NumBuckets = 12;
+
+	MovePrepProfiler() noexcept { MovePrepClock::Init(); Reset(); }
+
+	static void Record(MovePrepStage stage, uint32_t ticks) noexcept;
+	static void Reset() noexcept;
+
+	void Diagnostics(MessageType mtype, bool printHistograms) const noexcept;
+
+protected:
+	DECLARE_OBJECT_MODEL_WITH_ARRAYS
+
+private:
+	struct StageTimings
+	{
+		uint64_t totalTicks;
+		uint32_t count;
+		uint32_t maxTicks;
+		uint32_t buckets[NumBuckets];
+
+		float GetMeanMicroseconds() const noexcept { return (count == 0) ? 0.0 : (float)totalTicks/((float)count * (float)MovePrepClock::TicksPerMicrosecond); }
+		float GetMaxMicroseconds() const noexcept { return (float)maxTicks * (1.0/(float)MovePrepClock::TicksPerMicrosecond); }
+	};
+
+	static StageTimings timings[MovePrepStage::NumValues];
+};
+
+// Class to time a stage of move preparation from its construction to its destruction
+class MovePrepTimer
+{
+public:
+	explicit MovePrepTimer(MovePrepStage s) noexcept : startTicks(MovePrepClock::GetTicks()), stage(s) { }
+	~MovePrepTimer() { MovePrepProfiler::Record(stage, MovePrepClock::GetTicks() - startTicks); }
+
+	MovePrepTimer(const MovePrepTimer&) = delete;
+	MovePrepTimer& operator=(const MovePrepTimer&) = delete;
+
+private:
+	uint32_t startTicks;
+	MovePrepStage stage;
+};
+
+# define PROFILE_MOVE_PREP_STAGE(_stage)	MovePrepTimer prepTimer(MovePrepStage::_stage)
+
+#else
+
+# define PROFILE_MOVE_PREP_STAGE(_stage)	(void)0
+
+#endif	// SUPPORT_MOVE_PREP_PROFILING
+
+#endif /* SRC_MOVEMENT_MOVEPREPPROFILER_H_ */
@@ -552,6 +552,7 @@ void WiFiInterface::Start() noexcept
 
 	// Make sure it has time to reset - no idea how long it needs, but 20ms should be plenty
 	delay(50);
+	moduleMaxSocketDataLength = 0;					// until the module tells us
 
 	// Release the reset on the ESP8266
 	StartWiFi();
@@ -665,6 +666,12 @@ void WiFiInterface::Spin() noexcept
 						wiFiServerVersion.copy(status.Value().versionText);
 						macAddress.SetFromBytes(status.Value().macAddress);
 
+						// Record the largest socket data transfer that the module accepts. Older module firmware doesn't report it, so it only accepts MaxDataLength.
+						// We don't make use of larger transfers yet, but the field lets later firmware on both sides agree on them without breaking older modules.
+						moduleMaxSocketDataLength = (rc >= (int32_t)(offsetof(NetworkStatusResponse, maxSocketDataLength) + sizeof(status.Value().maxSocketDataLength)))
+													? max<size_t>(status.Value().maxSocketDataLength, MaxDataLength)
+														: MaxDataLength;
+
 						// Set the hostname before anything else is done
 						rc = SendCommand(NetworkCommand::networkSetHostName, 0, 0, 0, reprap.GetNetwork().GetHostname(), HostNameLength, nullptr, 0);
 						if (rc != ResponseEmpty)
@@ -929,11 +936,15 @@ void WiFiInterface::Diagnostics(MessageType mtype) noexcept
 	platform.MessageF(mtype,
 						"=== WiFi ===\nInterface state: %s\n"
 						"Module is %s\n"
-						"Failed messages: pending %u, notrdy %u, noresp %u\n",
+						"Failed messages: pending %u, notrdy %u, noresp %u\n"
+						"Data frames sent %u, average %" PRIu32 " bytes, module accepts %u\n",
 						 	 GetStateName(),
 							 TranslateWiFiState(currentMode),
-							 transferAlreadyPendingCount, readyTimeoutCount, responseTimeoutCount
+							 transferAlreadyPendingCount, readyTimeoutCount, responseTimeoutCount,
+							 dataFramesSent, (dataFramesSent == 0) ? 0 : dataBytesSent/dataFramesSent, moduleMaxSocketDataLength
 					 );
+	dataFramesSent = 0;
+	dataBytesSent = 0;
 
 	if (GetState() != NetworkState::disabled && GetState() != NetworkState::starting1 && GetState() != NetworkState::starting2)
 	{
@@ -2098,6 +2109,18 @@ void WiFiInterface::SetupSpi() noexcept
 
 // Send a command to the ESP and get the result
 int32_t WiFiInterface::SendCommand(NetworkCommand cmd, SocketNumber socketNum, uint8_t flags, uint32_t param32, const void *dataOut, size_t dataOutLength, void* dataIn, size_t dataInLength) noexcept
+{
+	return DoSendCommand(cmd, socketNum, flags, param32, dataOut, nullptr, dataOutLength, dataIn, dataInLength);
+}
+
+// Send a command to the ESP taking the data from a chain of output buffers, so that several buffers can be sent in a single SPI transfer
+int32_t WiFiInterface::SendCommand(NetworkCommand cmd, SocketNumber socketNum, uint8_t flags, const OutputBuffer *dataOut, size_t dataOutLength) noexcept
+{
+	return DoSendCommand(cmd, socketNum, flags, 0, nullptr, dataOut, dataOutLength, nullptr, 0);
+}
+
+// Send a command to the ESP and get the result. If gatherOut is not null then the data is taken from it and the buffers chained to it, otherwise from dataOut.
+int32_t WiFiInterface::DoSendCommand(NetworkCommand cmd, SocketNumber socketNum, uint8_t flags, uint32_t param32, const void *dataOut, const OutputBuffer *gatherOut, size_t dataOutLength, void* dataIn, size_t dataInLength) noexcept
 {
 	if (GetState() == NetworkState::disabled)
 	{
@@ -2148,11 +2171,26 @@ int32_t WiFiInterface::SendCommand(NetworkCommand cmd, SocketNumber socketNum, u
 	{
 		memcpy(bufferOut->data, dataOut, dataOutLength);
 	}
+	else if (gatherOut != nullptr)
+	{
+		size_t bytesCopied = 0;
+		for (const OutputBuffer *buf = gatherOut; buf != nullptr && bytesCopied < dataOutLength; buf = buf->Next())
+		{
+			const size_t bytesToCopy = min<size_t>(buf->BytesLeft(), dataOutLength - bytesCopied);
+			memcpy(bufferOut->data + bytesCopied, buf->UnreadData(), bytesToCopy);
+			bytesCopied += bytesToCopy;
+		}
+	}
+	if (cmd == NetworkCommand::connWrite && dataOutLength != 0)
+	{
+		++dataFramesSent;
+		dataBytesSent += dataOutLength;
+	}
 	bufferIn->hdr.formatVersion = InvalidFormatVersion;
 	espWaitingTask = TaskBase::GetCallerTaskHandle();
 	transferPending = true;
 
-	Cache::FlushBeforeDMASend(bufferOut, (dataOut != nullptr) ? sizeof(bufferOut->hdr) + dataOutLength : sizeof(bufferOut->hdr));
+	Cache::FlushBeforeDMASend(bufferOut, (dataOut != nullptr || gatherOut != nullptr) ? sizeof(bufferOut->hdr) + dataOutLength : sizeof(bufferOut->hdr));
 
 #if SAME5x
     spi_slave_dma_setup(dataOutLength, dataInLength);
@@ -116,12 +116,15 @@ private:
 	void SetupSpi() noexcept;
 
 	int32_t SendCommand(NetworkCommand cmd, SocketNumber socket, uint8_t flags, uint32_t param32, const void *dataOut, size_t dataOutLength, void* dataIn, size_t dataInLength) noexcept;
+	int32_t SendCommand(NetworkCommand cmd, SocketNumber socket, uint8_t flags, const OutputBuffer *dataOut, size_t dataOutLength) noexcept;
 
 	template<class T> int32_t SendCommand(NetworkCommand cmd, SocketNumber socket, uint8_t flags, const void *dataOut, size_t dataOutLength, Receiver<T>& recvr) noexcept
 	{
 		return SendCommand(cmd, socket, flags, 0, dataOut, dataOutLength, recvr.DmaPointer(), recvr.Size());
 	}
 
+	int32_t DoSendCommand(NetworkCommand cmd, SocketNumber socket, uint8_t flags, uint32_t param32, const void *dataOut, const OutputBuffer *gatherOut, size_t dataOutLength, void* dataIn, size_t dataInLength) noexcept;
+
 	void SendListenCommand(TcpPort port, NetworkProtocol protocol, unsigned int maxConnections) noexcept;
 	void SendConnectCommand(TcpPort port, NetworkProtocol protocol, uint32_t ip) noexcept;
 	void GetNewStatus() noexcept;
@@ -170,6 +173,9 @@ private:
 	unsigned int transferAlreadyPendingCount = 0;
 	unsigned int readyTimeoutCount = 0;
 	unsigned int responseTimeoutCount = 0;
+	size_t moduleMaxSocketDataLength = 0;					// the maximum data length of a connRead or connWrite command that the WiFi module accepts, or 0 if not known yet
+	unsigned int dataFramesSent = 0;
+	uint32_t dataBytesSent = 0;
 
 	String<StringLength20> wiFiServerVersion;
 
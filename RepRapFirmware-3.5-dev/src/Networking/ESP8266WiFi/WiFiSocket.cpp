@@ -358,6 +358,34 @@ size_t WiFiSocket::Send(const uint8_t *data, size_t length) noexcept
 	return 0;
 }
 
+// Send data from an OutputBuffer chain, returning the length buffered. We send as many of the buffers as will fit in one SPI transfer.
+size_t WiFiSocket::Send(OutputBuffer *buf) noexcept
+{
+	if (state == SocketState::connected && txBufferSpace != 0)
+	{
+		const size_t maxToSend = min<size_t>(txBufferSpace, MaxDataLength);
+		size_t lengthToSend = 0;
+		for (const OutputBuffer *item = buf; item != nullptr && lengthToSend < maxToSend; item = item->Next())
+		{
+			lengthToSend += item->BytesLeft();
+		}
+		lengthToSend = min<size_t>(lengthToSend, maxToSend);
+
+		const int32_t reply = GetInterface()->SendCommand(NetworkCommand::connWrite, socketNum, 0, buf, lengthToSend);
+		if (reply >= 0 && (size_t)reply <= lengthToSend)
+		{
+			txBufferSpace -= (size_t)reply;
+			return (size_t)reply;
+		}
+		if (reprap.Debug(Module::Network))
+		{
+			debugPrintf("Send failed, terminating\n");
+		}
+		state = SocketState::broken;							// something is not right, terminate the socket soon
+	}
+	return 0;
+}
+
 // Tell the interface to send the outstanding data
 void WiFiSocket::Send() noexcept
 {
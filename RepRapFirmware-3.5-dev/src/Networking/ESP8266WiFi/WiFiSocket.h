@@ -37,6 +37,7 @@ public:
 	bool CanRead() const noexcept override;
 	bool CanSend() const noexcept override;
 	size_t Send(const uint8_t *data, size_t length) noexcept override;
+	size_t Send(OutputBuffer *buf) noexcept override;
 	void Send() noexcept override;
 
 private:
@@ -357,7 +357,7 @@ void FtpResponder::DoUpload() noexcept
 		}
 
 		dataSocket->Taken(len);
-		if (!fileBeingUploaded.Write(buffer, len))
+		if (!WriteUploadData(buffer, len))
 		{
 			uploadError = true;
 			GetPlatform().Message(ErrorMessage, "FTP: could not write upload data\n");
@@ -24,8 +24,6 @@ static_assert(ARRAY_SIZE(serviceUnavailableResponse) <= OUTPUT_BUFFER_SIZE, "OUT
 
 const uint32_t HttpReceiveTimeout = 2000;
 
-const HttpSessionKey NoSessionKey = 0;
-
 // Text for a human-readable 404 page
 const char* const ErrorPagePart1 =
 	"<html>\n"
@@ -39,6 +37,9 @@ const char* const ErrorPagePart2 =
 	"</body>\n";
 
 HttpResponder::HttpResponder(NetworkResponder *n) noexcept : UploadingNetworkResponder(n)
+#if SUPPORT_WEBSOCKETS
+	, webSocket(nullptr)
+#endif
 {
 }
 
@@ -114,6 +115,11 @@ bool HttpResponder::Spin() noexcept
 		(void)SendFileInfo(millis() - startedProcessingRequestAt >= MaxFileInfoGetTime);
 		return true;
 
+#if SUPPORT_WEBSOCKETS
+	case ResponderState::webSocket:
+		return DoWebSocket();
+#endif
+
 #if HAS_MASS_STORAGE
 	case ResponderState::uploading:
 		DoUpload();
@@ -453,9 +459,10 @@ bool HttpResponder::CharFromClient(char c) noexcept
 // 'value' is null-terminated, but we also pass its length in case it contains embedded nulls, which matters when uploading files.
 // Return true if we generated a json response to send, false if we didn't and changed the state instead.
 // This may also return true with response == nullptr if we tried to generate a response but ran out of buffers.
-bool HttpResponder::GetJsonResponse(const char *_ecv_array request, OutputBuffer *&response, bool& keepOpen) noexcept
+bool HttpResponder::GetJsonResponse(const char *_ecv_array request, OutputBuffer *&response, bool& keepOpen, bool& isCbor) noexcept
 {
 	keepOpen = false;	// assume we don't want to persist the connection
+	isCbor = false;		// assume we are returning JSON
 
 	const char *parameter;
 	if (StringEqualsIgnoreCase(request, "connect") && (parameter = GetKeyValue("password")) != nullptr)
@@ -506,11 +513,15 @@ bool HttpResponder::GetJsonResponse(const char *_ecv_array request, OutputBuffer
 		OutputBuffer::ReleaseAll(response);
 		const char *const filterVal = GetKeyValue("key");
 		const char *const flagsVal = GetKeyValue("flags");
+#if SUPPORT_OBJECT_MODEL_CBOR
+		const char *const formatVal = GetKeyValue("format");
+		isCbor = (formatVal != nullptr && StringEqualsIgnoreCase(formatVal, "cbor"));
+#endif
 
 		MutexLocker lock(reprap.GetObjectModelReportMutex());				// grab the mutex to prevent PanelDue retrieving the OM at the same time, which can result in running out of buffers
 		if (OutputBuffer::GetFreeBuffers() >= MinimumBuffersForObjectModel)
 		{
-			response = reprap.GetModelResponse(nullptr, filterVal, flagsVal);
+			response = reprap.GetModelResponse(nullptr, filterVal, flagsVal, isCbor);
 		}
 		else if (millis() - startedProcessingRequestAt < 500)
 		{
@@ -789,7 +800,12 @@ bool HttpResponder::Authenticate(bool withSessionKey, HttpSessionKey &sessionKey
 // Check and update the authentication
 bool HttpResponder::CheckAuthenticated() noexcept
 {
-	const HttpSessionKey key = GetSessionKey();
+	return CheckAuthenticated(GetSessionKey());
+}
+
+// Check and update the authentication of the session with the specified key
+bool HttpResponder::CheckAuthenticated(HttpSessionKey key) noexcept
+{
 	const IPAddress remoteIP = GetRemoteIP();
 	for (size_t i = 0; i < numSessions; i++)
 	{
@@ -1044,6 +1060,14 @@ void HttpResponder::SendJsonResponse(const char *_ecv_array command) noexcept
 		Authenticate(false, dummy);
 	}
 
+#if SUPPORT_WEBSOCKETS
+	if (StringEqualsIgnoreCase(command, "model") && IsWebSocketUpgrade())
+	{
+		StartWebSocket();
+		return;
+	}
+#endif
+
 	// Try to handle "text/plain" requests here
 	if (CheckAuthenticated())
 	{
@@ -1068,10 +1092,10 @@ void HttpResponder::SendJsonResponse(const char *_ecv_array command) noexcept
 
 	// Try to process a request for JSON responses
 	OutputBuffer *jsonResponse;
-	bool mayKeepOpen;
+	bool mayKeepOpen, isCbor = false;
 	if (OutputBuffer::Allocate(jsonResponse))
 	{
-		const bool gotResponse = GetJsonResponse(command, jsonResponse, mayKeepOpen);
+		const bool gotResponse = GetJsonResponse(command, jsonResponse, mayKeepOpen, isCbor);
 		if (!gotResponse)
 		{
 			// GetJsonResponse() changed the state instead of returning a response
@@ -1115,8 +1139,8 @@ void HttpResponder::SendJsonResponse(const char *_ecv_array command) noexcept
 					"Cache-Control: no-cache, no-store, must-revalidate\r\n"
 					"Pragma: no-cache\r\n"
 					"Expires: 0\r\n"
-					"Content-Type: application/json\r\n"
 				);
+	outBuf->catf("Content-Type: %s\r\n", (isCbor) ? "application/cbor" : "application/json");
 	const unsigned int replyLength = (jsonResponse != nullptr) ? jsonResponse->Length() : 0;
 	outBuf->catf("Content-Length: %u\r\n", replyLength);
 	AddCorsHeader();
@@ -1372,7 +1396,7 @@ void HttpResponder::DoUpload() noexcept
 			(void)CheckAuthenticated();						// uploading may take a long time, so make sure the requester IP is not timed out
 			timer = millis();								// reset the timer
 
-			const bool ok = dummyUpload || fileBeingUploaded.Write(buffer, len);
+			const bool ok = dummyUpload || WriteUploadData(buffer, len);
 			skt->Taken(len);
 			uploadedBytes += len;
 
@@ -1599,6 +1623,9 @@ void HttpResponder::Diagnostics(MessageType mt) const noexcept
 /*static*/ void HttpResponder::CommonDiagnostics(MessageType mtype) noexcept
 {
 	GetPlatform().MessageF(mtype, "HTTP sessions: %u of %u\n", numSessions, MaxHttpSessions);
+#if SUPPORT_WEBSOCKETS
+	WebSocketDiagnostics(mtype);
+#endif
 }
 
 void HttpResponder::AddCorsHeader() noexcept
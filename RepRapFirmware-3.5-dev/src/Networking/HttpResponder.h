@@ -12,6 +12,8 @@
 
 typedef unsigned int HttpSessionKey;
 
+const HttpSessionKey NoSessionKey = 0;
+
 class HttpResponder : public UploadingNetworkResponder
 {
 public:
@@ -33,6 +35,9 @@ public:
 protected:
 	void CancelUpload() noexcept override;
 	void SendData() noexcept override;
+#if SUPPORT_WEBSOCKETS
+	void ConnectionLost() noexcept override;
+#endif
 
 private:
 	static const size_t MaxHttpSessions = 8;			// maximum number of simultaneous HTTP sessions
@@ -43,6 +48,12 @@ private:
 	static const uint32_t HttpSessionTimeout = 8000;	// HTTP session timeout in milliseconds
 	static const uint32_t MaxFileInfoGetTime = 2000;	// maximum length of time we spend getting file info, to avoid the client timing out (actual time will be a little longer than this)
 	static const uint32_t MaxBufferWaitTime = 1000;		// maximum length of time we spend waiting for a buffer before we discard gcodeReply buffers
+#if SUPPORT_WEBSOCKETS
+	static const uint32_t WebSocketDefaultInterval = 250;	// default minimum interval between object model updates sent to a WebSocket client in milliseconds
+	static const uint32_t WebSocketMinInterval = 50;		// the smallest minimum interval that a WebSocket client may request
+	static const uint32_t WebSocketPingInterval = 5000;		// how long we wait for anything from a WebSocket client before we send it a ping
+	static const uint32_t WebSocketTimeout = 15000;			// how long we wait for anything from a WebSocket client before we drop the connection
+#endif
 
 	enum class HttpParseState
 	{
@@ -79,13 +90,14 @@ private:
 
 	bool Authenticate(bool withSessionKey, HttpSessionKey &sessionKey) noexcept;
 	bool CheckAuthenticated() noexcept;
+	bool CheckAuthenticated(HttpSessionKey key) noexcept;
 	bool RemoveAuthentication() noexcept;
 
 	bool CharFromClient(char c) noexcept;
 	void SendFile(const char *_ecv_array nameOfFileToSend, bool isWebFile) noexcept;
 	void SendGCodeReply() noexcept;
 	void SendJsonResponse(const char *_ecv_array command) noexcept;
-	bool GetJsonResponse(const char *_ecv_array request, OutputBuffer *&response, bool& keepOpen) noexcept;
+	bool GetJsonResponse(const char *_ecv_array request, OutputBuffer *&response, bool& keepOpen, bool& isCbor) noexcept;
 	void ProcessMessage() noexcept;
 	void ProcessRequest() noexcept;
 	void RejectMessage(const char *_ecv_array s, unsigned int code = 500) noexcept;
@@ -96,6 +108,22 @@ private:
 	void DoUpload() noexcept;
 #endif
 
+#if SUPPORT_WEBSOCKETS
+	struct WebSocketClient;
+
+	bool IsWebSocketUpgrade() const noexcept;
+	void StartWebSocket() noexcept;
+	bool DoWebSocket() noexcept;
+	bool WebSocketCharFromClient(uint8_t c) noexcept;
+	bool ProcessWebSocketFrame() noexcept;
+	bool SendWebSocketUpdate() noexcept;
+	bool StartWebSocketFrame(uint8_t opcode, size_t length) noexcept;
+	void CloseWebSocket(uint16_t statusCode) noexcept;
+	void EndWebSocket() noexcept;
+
+	static void WebSocketDiagnostics(MessageType mtype) noexcept;
+#endif
+
 	const char *_ecv_array null GetKeyValue(const char *_ecv_array key) const noexcept;		// return the value of the specified key, or nullptr if not present
 	const char *_ecv_array null GetHeaderValue(const char *_ecv_array key) const noexcept;	// return the value of the specified header, or nullptr if not present
 	HttpSessionKey GetSessionKey() const noexcept;	// try to get the optional X-Session-Key header value used to identify HTTP sessions
@@ -126,6 +154,10 @@ private:
 	time_t fileLastModified;
 	bool postFileGotCrc;
 
+#if SUPPORT_WEBSOCKETS
+	WebSocketClient *webSocket;						// the WebSocket client details if this connection has been upgraded to a WebSocket, else nullptr
+#endif
+
 	// Keeping track of HTTP sessions
 	static HttpSession sessions[MaxHttpSessions];
 	static unsigned int numSessions;
@@ -135,6 +167,12 @@ private:
 	static volatile uint16_t seq;					// Sequence number for G-Code replies
 	static volatile OutputStack gcodeReply;
 	static Mutex gcodeReplyMutex;
+
+#if SUPPORT_WEBSOCKETS
+	// WebSocket clients. We keep these separately from the responders to save RAM, because only a few responders can be WebSockets.
+	static WebSocketClient webSocketClients[];
+	static unsigned int webSocketUpdatesSent;
+#endif
 };
 
 #endif /* SRC_NETWORKING_HTTPRESPONDER_H_ */
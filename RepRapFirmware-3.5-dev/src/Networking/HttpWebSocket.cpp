@@ -0,0 +1,370 @@
+/*
+ * HttpWebSocket.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * WebSocket (RFC 6455) support for the HTTP responder.
+ * A client that sends an rr_model request with an "Upgrade: websocket" header is switched to a WebSocket. We then push an object model
+ * report to it whenever the sequence-numbered parts of the object model change, but no more often than the minimum interval requested
+ * by the client. Each update after the first reports only the root keys that changed since the previous one, plus the live values.
+ * The rr_model parameters 'key', 'flags' and 'format' apply to every update. Additional parameters are:
+ *  interval=<ms>	the minimum interval between updates
+ *  sessionKey=<n>	the session key returned by rr_connect, because browsers can't add the X-Session-Key header to a WebSocket request
+ * Any text or binary message from the client requests an immediate update, e.g. to fetch live values that don't cause any change notification.
+ */
+
+#include "HttpResponder.h"
+
+#if SUPPORT_WEBSOCKETS
+
+#include "Network.h"
+#include "Socket.h"
+#include "WebSocketProtocol.h"
+#include <Platform/Platform.h>
+
+// Details of a connection that has been upgraded to a WebSocket
+struct HttpResponder::WebSocketClient
+{
+	static constexpr size_t MaxFilterLength = StringLength50;
+	static constexpr size_t MaxFlagsLength = StringLength20;
+
+	String<MaxFilterLength> filter;					// the object model key to report, or empty to report the whole object model
+	String<MaxFlagsLength> flags;					// the object model report flags
+	HttpSessionKey sessionKey;
+	uint32_t minInterval;							// the minimum interval between updates
+	uint32_t generationSent;						// the object model generation number when we built the last update we sent
+	uint32_t lastUpdateTime;						// when we last sent or attempted to send an update
+	uint32_t lastPingTime;							// when we last sent a ping
+	uint32_t lastReceiveTime;						// when we last received anything
+	bool inUse;
+	bool isCbor;									// true if the client wants updates in CBOR format
+	bool updateRequested;							// true if we should send an update even if the object model hasn't changed
+	WebSocketFrameParser parser;
+};
+
+HttpResponder::WebSocketClient HttpResponder::webSocketClients[MaxWebSocketClients];
+unsigned int HttpResponder::webSocketUpdatesSent = 0;
+
+// Return true if the current request asks to upgrade the connection to a WebSocket
+bool HttpResponder::IsWebSocketUpgrade() const noexcept
+{
+	const char *const _ecv_array null val = GetHeaderValue("Upgrade");
+	return val != nullptr && StringEqualsIgnoreCase(val, "websocket");
+}
+
+// Upgrade the connection to a WebSocket in response to an rr_model request
+void HttpResponder::StartWebSocket() noexcept
+{
+	HttpSessionKey key = GetSessionKey();
+	if (key == NoSessionKey)
+	{
+		const char *const _ecv_array null keyVal = GetKeyValue("sessionKey");
+		if (keyVal != nullptr)
+		{
+			key = StrToU32(keyVal);
+		}
+	}
+
+	if (!CheckAuthenticated(key))
+	{
+		RejectMessage("Not authorized", 401);
+		return;
+	}
+
+	const char *const _ecv_array null wsKey = GetHeaderValue("Sec-WebSocket-Key");
+	const char *const _ecv_array null wsVersion = GetHeaderValue("Sec-WebSocket-Version");
+	if (wsKey == nullptr || wsVersion == nullptr || StrToU32(wsVersion) != 13)
+	{
+		RejectMessage("bad WebSocket request", 400);
+		return;
+	}
+
+	const char *const _ecv_array null filterVal = GetKeyValue("key");
+	const char *const _ecv_array null flagsVal = GetKeyValue("flags");
+	if ((filterVal != nullptr && strlen(filterVal) > WebSocketClient::MaxFilterLength) || (flagsVal != nullptr && strlen(flagsVal) > WebSocketClient::MaxFlagsLength))
+	{
+		RejectMessage("WebSocket parameter too long", 400);
+		return;
+	}
+
+	WebSocketClient *ws = nullptr;
+	for (WebSocketClient& client : webSocketClients)
+	{
+		if (!client.inUse)
+		{
+			ws = &client;
+			break;
+		}
+	}
+	if (ws == nullptr)
+	{
+		RejectMessage("too many WebSocket clients", 503);
+		return;
+	}
+
+	char acceptKey[WebSocketAcceptKeyLength + 1];
+	if (!MakeWebSocketAcceptKey(wsKey, acceptKey))
+	{
+		RejectMessage("WebSocket key hash failed");
+		return;
+	}
+
+	outBuf->copy(	"HTTP/1.1 101 Switching Protocols\r\n"
+					"Upgrade: websocket\r\n"
+					"Connection: Upgrade\r\n"
+				);
+	outBuf->catf("Sec-WebSocket-Accept: %s\r\n\r\n", acceptKey);
+	if (outBuf->HadOverflow())
+	{
+		OutputBuffer::ReleaseAll(outBuf);
+		ReportOutputBufferExhaustion(__FILE__, __LINE__);
+		responderState = ResponderState::free;
+		return;
+	}
+
+	const uint32_t now = millis();
+	ws->filter.copy((filterVal != nullptr) ? filterVal : "");
+	ws->flags.copy((flagsVal != nullptr) ? flagsVal : "");
+#if SUPPORT_OBJECT_MODEL_CBOR
+	const char *const _ecv_array null formatVal = GetKeyValue("format");
+	ws->isCbor = (formatVal != nullptr && StringEqualsIgnoreCase(formatVal, "cbor"));
+#else
+	ws->isCbor = false;
+#endif
+	const char *const _ecv_array null intervalVal = GetKeyValue("interval");
+	ws->minInterval = (intervalVal != nullptr) ? max<uint32_t>(StrToU32(intervalVal), WebSocketMinInterval) : WebSocketDefaultInterval;
+	ws->sessionKey = key;
+	ws->generationSent = 0;										// so that the first update is a full snapshot
+	ws->updateRequested = true;
+	ws->lastUpdateTime = now - ws->minInterval;
+	ws->lastPingTime = ws->lastReceiveTime = now;
+	ws->parser.Reset();
+	ws->inUse = true;
+	webSocket = ws;
+
+	if (reprap.Debug(Module::Webserver))
+	{
+		debugPrintf("WebSocket connection accepted\n");
+	}
+	Commit(ResponderState::webSocket, false);
+}
+
+// Service a WebSocket connection, returning true if we did anything significant
+bool HttpResponder::DoWebSocket() noexcept
+{
+	const uint32_t now = millis();
+	bool readSomething = false;
+	char c;
+	while (skt->ReadChar(c))
+	{
+		readSomething = true;
+		webSocket->lastReceiveTime = now;
+		if (WebSocketCharFromClient((uint8_t)c))
+		{
+			return true;										// we changed state to send a reply
+		}
+	}
+
+	if (!skt->CanRead() || now - webSocket->lastReceiveTime >= WebSocketTimeout)
+	{
+		ConnectionLost();
+		return true;
+	}
+
+	// Keep the session alive while the WebSocket is open, but close the WebSocket if the session has been removed
+	if (!CheckAuthenticated(webSocket->sessionKey))
+	{
+		CloseWebSocket(WsClosePolicyViolation);
+		return true;
+	}
+
+	// Send a ping if we haven't heard from the client for a while, and again at the same interval until it replies. Its pong resets the timeout.
+	// Do this before sending any update, because a busy printer may have an update ready every time we get here.
+	if (   now - webSocket->lastReceiveTime >= WebSocketPingInterval && now - webSocket->lastPingTime >= WebSocketPingInterval
+		&& StartWebSocketFrame(WsOpPing, 0)
+	   )
+	{
+		webSocket->lastPingTime = now;
+		Commit(ResponderState::webSocket, false);
+		return true;
+	}
+
+	if ((webSocket->updateRequested || reprap.GetModelGeneration() != webSocket->generationSent) && now - webSocket->lastUpdateTime >= webSocket->minInterval)
+	{
+		return SendWebSocketUpdate();
+	}
+
+	return readSomething;
+}
+
+// Process a byte received from a WebSocket client, returning true if we changed state to send a reply
+bool HttpResponder::WebSocketCharFromClient(uint8_t c) noexcept
+{
+	switch (webSocket->parser.ProcessByte(c))
+	{
+	case WebSocketFrameParser::Result::incomplete:
+	default:
+		return false;
+
+	case WebSocketFrameParser::Result::frameComplete:
+		return ProcessWebSocketFrame();
+
+	case WebSocketFrameParser::Result::protocolError:
+		CloseWebSocket(WsCloseProtocolError);
+		return true;
+
+	case WebSocketFrameParser::Result::tooBig:
+		CloseWebSocket(WsCloseMessageTooBig);
+		return true;
+	}
+}
+
+// Act on a complete frame from the client, returning true if we changed state to send a reply. We don't need the content of data frames.
+bool HttpResponder::ProcessWebSocketFrame() noexcept
+{
+	const WebSocketFrameParser& frame = webSocket->parser;
+	switch (frame.GetOpcode())
+	{
+	case WsOpContinuation:
+	case WsOpText:
+	case WsOpBinary:
+		if (frame.IsFinal())
+		{
+			webSocket->updateRequested = true;
+		}
+		return false;
+
+	case WsOpClose:
+		// Echo the status code back to the client
+		CloseWebSocket((frame.GetPayloadLength() >= 2) ? ((uint16_t)frame.GetControlData()[0] << 8) | frame.GetControlData()[1] : WsCloseNormal);
+		return true;
+
+	case WsOpPing:
+		if (StartWebSocketFrame(WsOpPong, frame.GetPayloadLength()))
+		{
+			outBuf->cat(reinterpret_cast<const char *>(frame.GetControlData()), frame.GetPayloadLength());
+			Commit(ResponderState::webSocket, false);
+			return true;
+		}
+		return false;
+
+	case WsOpPong:
+		return false;
+
+	default:
+		CloseWebSocket(WsCloseProtocolError);
+		return true;
+	}
+}
+
+// Send an object model update to the client, returning true if we did anything significant
+bool HttpResponder::SendWebSocketUpdate() noexcept
+{
+	if (OutputBuffer::GetFreeBuffers() < MinimumBuffersForObjectModel)
+	{
+		return false;											// try again later
+	}
+
+	// Report the root keys that have changed since the last update we sent
+	const uint32_t generation = reprap.GetModelGeneration();
+	String<StringLength50> flags;
+	flags.printf("%sc%" PRIu32, webSocket->flags.c_str(), webSocket->generationSent);
+
+	OutputBuffer *response;
+	{
+		MutexLocker lock(reprap.GetObjectModelReportMutex());	// grab the mutex to prevent PanelDue retrieving the OM at the same time, which can result in running out of buffers
+		response = reprap.GetModelResponse(nullptr, (webSocket->filter.IsEmpty()) ? nullptr : webSocket->filter.c_str(), flags.c_str(), webSocket->isCbor);
+	}
+
+	const uint32_t now = millis();
+	webSocket->lastUpdateTime = now;
+	if (response == nullptr || response->HadOverflow())
+	{
+		OutputBuffer::ReleaseAll(response);
+		ReportOutputBufferExhaustion(__FILE__, __LINE__);
+		return true;											// try again after the minimum interval
+	}
+
+	if (!StartWebSocketFrame((webSocket->isCbor) ? WsOpBinary : WsOpText, response->Length()))
+	{
+		OutputBuffer::ReleaseAll(response);
+		return true;
+	}
+	outBuf->Append(response);
+
+	webSocket->generationSent = generation;
+	webSocket->updateRequested = false;
+	++webSocketUpdatesSent;
+	Commit(ResponderState::webSocket, false);
+	return true;
+}
+
+// Allocate outBuf if necessary and write the header of an unfragmented frame to it, returning false if no buffer is available
+bool HttpResponder::StartWebSocketFrame(uint8_t opcode, size_t length) noexcept
+{
+	if (outBuf == nullptr && !OutputBuffer::Allocate(outBuf))
+	{
+		return false;
+	}
+
+	uint8_t header[MaxWebSocketFrameHeaderLength];
+	const size_t headerLength = MakeWebSocketFrameHeader(opcode, length, header);
+	outBuf->cat(reinterpret_cast<const char *>(header), headerLength);
+	return true;
+}
+
+// Send a close frame with the specified status code and close the connection when it has been sent
+void HttpResponder::CloseWebSocket(uint16_t statusCode) noexcept
+{
+	EndWebSocket();
+	if (StartWebSocketFrame(WsOpClose, 2))
+	{
+		outBuf->cat((char)(statusCode >> 8));
+		outBuf->cat((char)(statusCode & 0xFF));
+		Commit(ResponderState::free, false);
+	}
+	else
+	{
+		ConnectionLost();
+	}
+}
+
+// Release the WebSocket client details, if this connection has them
+void HttpResponder::EndWebSocket() noexcept
+{
+	if (webSocket != nullptr)
+	{
+		webSocket->inUse = false;
+		webSocket = nullptr;
+		if (reprap.Debug(Module::Webserver))
+		{
+			debugPrintf("WebSocket connection ended\n");
+		}
+	}
+}
+
+// This overrides the version in class UploadingNetworkResponder
+void HttpResponder::ConnectionLost() noexcept
+{
+	EndWebSocket();
+	UploadingNetworkResponder::ConnectionLost();
+}
+
+/*static*/ void HttpResponder::WebSocketDiagnostics(MessageType mtype) noexcept
+{
+	unsigned int numClients = 0;
+	for (const WebSocketClient& client : webSocketClients)
+	{
+		if (client.inUse)
+		{
+			++numClients;
+		}
+	}
+	GetPlatform().MessageF(mtype, "WebSocket clients: %u of %u, updates sent %u\n", numClients, MaxWebSocketClients, webSocketUpdatesSent);
+	webSocketUpdatesSent = 0;
+}
+
+#endif
+
+// End
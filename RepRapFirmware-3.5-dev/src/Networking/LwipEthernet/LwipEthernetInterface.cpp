@@ -450,6 +450,10 @@ void LwipEthernetInterface::Diagnostics(MessageType mtype) noexcept
 	}
 	platform.Message(mtype, "\n");
 
+	uint32_t bytesReferenced, bytesCopied;
+	LwipSocket::GetAndClearSendCounts(bytesReferenced, bytesCopied);
+	platform.MessageF(mtype, "Bytes sent from output buffers %" PRIu32 " without copying, %" PRIu32 " copied\n", bytesReferenced, bytesCopied);
+
 #if LWIP_STATS
 	if (reprap.Debug(Module::Network))
 	{
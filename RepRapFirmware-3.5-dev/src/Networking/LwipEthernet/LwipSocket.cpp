@@ -17,6 +17,9 @@
 
 extern Mutex lwipMutex;
 
+uint32_t LwipSocket::bytesSentByReference = 0;
+uint32_t LwipSocket::bytesSentByCopying = 0;
+
 // ERR_IS_FATAL was defined like this in lwip 2.0.3 file err.h but isn't in 2.1.2
 #define ERR_IS_FATAL(e) ((e) <= ERR_ABRT)
 
@@ -81,7 +84,7 @@ static err_t conn_sent(void *arg, tcp_pcb *pcb, u16_t len)
 // LwipSocket class
 
 LwipSocket::LwipSocket(NetworkInterface *iface) noexcept : Socket(iface), connectionPcb(nullptr),
-		receivedData(nullptr), state(SocketState::disabled)
+		receivedData(nullptr), state(SocketState::disabled), numSentBuffers(0)
 {
 	ReInit();
 }
@@ -141,6 +144,9 @@ void LwipSocket::DataSent(size_t numBytes) noexcept
 		unAcked = 0;
 	}
 
+	bytesAcked += numBytes;
+	ReleaseSentBuffers(false);
+
 	if (unAcked == 0)
 	{
 		// Reset the write timer when all data has been ACKed
@@ -174,6 +180,7 @@ void LwipSocket::ConnectionError(err_t err) noexcept
 {
 	DiscardReceivedData();
 	connectionPcb = nullptr;
+	ReleaseSentBuffers(true);								// LwIP has freed the PCB and its queued data
 
 	state = (localPort == 0)
 				? SocketState::disabled
@@ -205,6 +212,8 @@ void LwipSocket::ReInit() noexcept
 	whenConnected = whenWritten = whenClosed = 0;
 	responderFound = false;
 	readIndex = unAcked = 0;
+	ReleaseSentBuffers(true);
+	bytesQueued = bytesAcked = 0;
 }
 
 // Close a connection when the last packet has been sent
@@ -240,6 +249,7 @@ void LwipSocket::Terminate() noexcept
 		}
 
 		DiscardReceivedData();
+		ReleaseSentBuffers(true);
 		whenClosed = millis();
 		state = (localPort == 0) ? SocketState::disabled : SocketState::listening;
 	}
@@ -416,6 +426,7 @@ void LwipSocket::Poll() noexcept
 			if (receivedData == nullptr || timeoutExceeded)
 			{
 				DiscardReceivedData();
+				ReleaseSentBuffers(true);
 				state = (localPort == 0) ? SocketState::disabled : SocketState::listening;
 			}
 		}
@@ -500,6 +511,7 @@ size_t LwipSocket::Send(const uint8_t *data, size_t length) noexcept
 		// We could successfully send some data
 		whenWritten = millis();
 		unAcked += bytesToSend;
+		bytesQueued += bytesToSend;
 
 		return bytesToSend;
 	}
@@ -507,6 +519,115 @@ size_t LwipSocket::Send(const uint8_t *data, size_t length) noexcept
 	return 0;
 }
 
+// Send data from an OutputBuffer chain without copying it, returning the length queued.
+// We can queue data from several buffers in one call, and we keep a reference to each buffer until its data has been acknowledged.
+size_t LwipSocket::Send(OutputBuffer *buf) noexcept
+{
+	MutexLocker lock(lwipMutex);
+
+	if (!CanSend())
+	{
+		return 0;
+	}
+
+	size_t totalQueued = 0;
+	for (OutputBuffer *item = buf; item != nullptr; item = item->Next())
+	{
+		const bool copy = numSentBuffers == MaxSentBuffers || OutputBuffer::GetFreeBuffers() < MinFreeBuffersToHold;
+		if (copy && item != buf)
+		{
+			break;									// only copy data from the first buffer, so that the responder can release it and the buffer pool can recover
+		}
+
+		const size_t length = item->BytesLeft();
+		if (length == 0)
+		{
+			continue;
+		}
+
+		const size_t bytesLeft = tcp_sndbuf(connectionPcb);
+		if (bytesLeft == 0 || tcp_sndqueuelen(connectionPcb) >= TCP_SND_QUEUELEN)
+		{
+			break;
+		}
+
+		const size_t bytesToSend = min<size_t>(length, bytesLeft);
+		const err_t err = tcp_write(connectionPcb, item->UnreadData(), bytesToSend,
+									((copy) ? TCP_WRITE_FLAG_COPY : 0) | ((item->Next() != nullptr) ? TCP_WRITE_FLAG_MORE : 0));
+		if (ERR_IS_FATAL(err))
+		{
+			Terminate();
+			return 0;
+		}
+		if (err != ERR_OK)
+		{
+			break;									// out of memory, so try again later
+		}
+
+		totalQueued += bytesToSend;
+		bytesQueued += bytesToSend;
+		if (copy)
+		{
+			bytesSentByCopying += bytesToSend;
+			break;
+		}
+
+		item->AddReference();
+		bytesSentByReference += bytesToSend;
+		sentBuffers[numSentBuffers] = item;
+		sentBufferEnds[numSentBuffers] = bytesQueued;
+		++numSentBuffers;
+
+		if (bytesToSend < length)
+		{
+			break;
+		}
+	}
+
+	// Try to send it now
+	if (ERR_IS_FATAL(tcp_output(connectionPcb)))
+	{
+		Terminate();
+		return 0;
+	}
+
+	if (totalQueued != 0)
+	{
+		whenWritten = millis();
+		unAcked += totalQueued;
+	}
+	return totalQueued;
+}
+
+/*static*/ void LwipSocket::GetAndClearSendCounts(uint32_t& referenced, uint32_t& copied) noexcept
+{
+	MutexLocker lock(lwipMutex);
+	referenced = bytesSentByReference;
+	copied = bytesSentByCopying;
+	bytesSentByReference = bytesSentByCopying = 0;
+}
+
+// Release the output buffers whose data has all been acknowledged, or all of them if LwIP no longer holds any data for this connection
+void LwipSocket::ReleaseSentBuffers(bool all) noexcept
+{
+	size_t numReleased = 0;
+	while (numReleased < numSentBuffers && (all || (int32_t)(bytesAcked - sentBufferEnds[numReleased]) >= 0))
+	{
+		OutputBuffer::ReleaseReference(sentBuffers[numReleased]);
+		++numReleased;
+	}
+
+	if (numReleased != 0)
+	{
+		numSentBuffers -= numReleased;
+		for (size_t i = 0; i < numSentBuffers; ++i)
+		{
+			sentBuffers[i] = sentBuffers[i + numReleased];
+			sentBufferEnds[i] = sentBufferEnds[i + numReleased];
+		}
+	}
+}
+
 #endif	// HAS_LWIP_NETWORKING
 
 // End
@@ -47,8 +47,11 @@ public:
 	bool CanRead() const noexcept override;
 	bool CanSend() const noexcept override;
 	size_t Send(const uint8_t *data, size_t length) noexcept override;
+	size_t Send(OutputBuffer *buf) noexcept override;
 	void Send() noexcept override { }
 
+	static void GetAndClearSendCounts(uint32_t& referenced, uint32_t& copied) noexcept;
+
 private:
 	enum class SocketState : uint8_t
 	{
@@ -61,8 +64,14 @@ private:
 		aborted
 	};
 
+	// LwIP doesn't copy the data we send from output buffers, so we keep a reference to each buffer until all the data we sent from it has been acknowledged.
+	// Holding buffers for a whole round trip could starve the rest of the firmware of output buffers, so when few are free we let LwIP copy the data instead.
+	static constexpr size_t MaxSentBuffers = 4;
+	static constexpr unsigned int MinFreeBuffersToHold = 2 * RESERVED_OUTPUT_BUFFERS;
+
 	void ReInit() noexcept;
 	void DiscardReceivedData() noexcept;
+	void ReleaseSentBuffers(bool all) noexcept;
 	pbuf *GetNextReceivedPbuf() noexcept;
 
 	uint32_t whenConnected;
@@ -76,6 +85,15 @@ private:
 
 	SocketState state;
 	size_t unAcked;
+
+	OutputBuffer *sentBuffers[MaxSentBuffers];				// output buffers that LwIP may still be reading from
+	uint32_t sentBufferEnds[MaxSentBuffers];				// the value of bytesQueued after we queued the data from each of those buffers
+	size_t numSentBuffers;
+	uint32_t bytesQueued;									// the total number of bytes we have passed to LwIP on this connection
+	uint32_t bytesAcked;									// the total number of bytes that have been acknowledged on this connection
+
+	static uint32_t bytesSentByReference;					// bytes sent from output buffers without copying them, for diagnostics
+	static uint32_t bytesSentByCopying;						// bytes from output buffers that LwIP copied because few output buffers were free
 };
 
 #endif	// HAS_LWIP_NETWORKING
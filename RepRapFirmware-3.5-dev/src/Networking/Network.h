@@ -38,6 +38,10 @@ const size_t NumTelnetResponders = 1;	// the number of concurrent Telnet session
 
 const size_t NumFtpResponders = 1;		// the number of concurrent FTP sessions we support
 
+#if SUPPORT_WEBSOCKETS
+const size_t MaxWebSocketClients = NumHttpResponders - 2;	// each WebSocket client ties up an HTTP responder, so leave some for ordinary requests
+#endif
+
 #define HAS_RESPONDERS	(SUPPORT_HTTP || SUPPORT_FTP || SUPPORT_TELNET)
 
 // Forward declarations
@@ -58,7 +58,7 @@ void NetworkResponder::SendData() noexcept
 		}
 		else
 		{
-			const size_t sent = skt->Send(reinterpret_cast<const uint8_t *>(outBuf->UnreadData()), bytesLeft);
+			size_t sent = skt->Send(outBuf);
 			if (sent == 0)
 			{
 				// Check whether the connection has been closed
@@ -74,12 +74,18 @@ void NetworkResponder::SendData() noexcept
 				return;
 			}
 
-			outBuf->Taken(sent);				// tell the output buffer how much data we have taken
-			if (sent < bytesLeft)
+			// The socket may have taken data from several buffers in the chain, so release the ones that have been sent completely
+			do
 			{
-				return;
-			}
-			outBuf = OutputBuffer::Release(outBuf);
+				const size_t taken = min<size_t>(sent, outBuf->BytesLeft());
+				outBuf->Taken(taken);			// tell the output buffer how much data we have taken
+				sent -= taken;
+				if (outBuf->BytesLeft() != 0)
+				{
+					return;
+				}
+				outBuf = OutputBuffer::Release(outBuf);
+			} while (sent != 0 && outBuf != nullptr);
 		}
 	}
 
@@ -44,6 +44,7 @@ protected:
 		// HTTP responder additional states
 		processingRequest,
 		gettingFileInfo,								// getting file info
+		webSocket,										// connection has been upgraded to a WebSocket
 
 		// FTP responder additional states
 		waitingForPasvPort,
@@ -10,6 +10,7 @@
 
 #include "NetworkDefs.h"
 #include "General/IPAddress.h"
+#include <Platform/OutputMemory.h>
 
 const uint32_t FindResponderTimeout = 2000;		// how long we wait for a responder to become available
 const uint32_t ConnectTimeout = 2000;			// how long we wait for an outgoing connection attempt
@@ -47,6 +48,11 @@ public:
 	virtual size_t Send(const uint8_t *data, size_t length) noexcept = 0;
 	virtual void Send() noexcept = 0;
 
+	// Send data from an OutputBuffer chain starting at the unread data in the first buffer, returning the number of bytes accepted.
+	// Sockets that can do better may take data from several buffers at once, but they must not mark any data as taken.
+	virtual size_t Send(OutputBuffer *buf) noexcept
+		{ return Send(reinterpret_cast<const uint8_t *>(buf->UnreadData()), buf->BytesLeft()); }
+
 protected:
 	enum class SocketState : uint8_t
 	{
@@ -9,6 +9,10 @@
 #include "Socket.h"
 #include <Platform/Platform.h>
 
+#if SUPPORT_UPLOAD_WRITE_BEHIND
+# include <Storage/FileWriteBehind.h>
+#endif
+
 UploadingNetworkResponder::UploadingNetworkResponder(NetworkResponder *n) noexcept : NetworkResponder(n)
 #if HAS_MASS_STORAGE
 	, uploadError(false), dummyUpload(false)
@@ -29,6 +33,12 @@ void UploadingNetworkResponder::CancelUpload() noexcept
 #if HAS_MASS_STORAGE
 	if (fileBeingUploaded.IsLive())
 	{
+# if SUPPORT_UPLOAD_WRITE_BEHIND
+		if (FileWriteBehind::IsWritingFor(this))
+		{
+			FileWriteBehind::Abort();
+		}
+# endif
 		fileBeingUploaded.Close();
 		if (!filenameBeingProcessed.IsEmpty())
 		{
@@ -69,6 +79,9 @@ bool UploadingNetworkResponder::StartUpload(const char* folder, const char *file
 		}
 		fileBeingUploaded.Set(file);
 		dummyUpload = false;
+#if SUPPORT_UPLOAD_WRITE_BEHIND
+		(void)FileWriteBehind::Start(this, fileBeingUploaded);		// if another upload is using write-behind then we write this one directly
+#endif
 	}
 	responderState = ResponderState::uploading;
 	uploadError = false;
@@ -80,6 +93,15 @@ void UploadingNetworkResponder::FinishUpload(uint32_t fileLength, time_t fileLas
 {
 	if (!dummyUpload)
 	{
+#if SUPPORT_UPLOAD_WRITE_BEHIND
+		// Wait for the write-behind task to write any data that it still holds
+		if (FileWriteBehind::IsWritingFor(this) && !FileWriteBehind::Finish())
+		{
+			uploadError = true;
+			GetPlatform().Message(ErrorMessage, "Could not write queued data while finishing upload\n");
+		}
+#endif
+
 		// Flush remaining data for FSO
 		if (!fileBeingUploaded.Flush())
 		{
@@ -132,6 +154,9 @@ void UploadingNetworkResponder::FinishUpload(uint32_t fileLength, time_t fileLas
 					// Update the file timestamp if it was specified
 					(void)MassStorage::SetLastModifiedTime(origFilename.c_str(), fileLastModified);
 				}
+#if SUPPORT_FILE_INFO_INDEX
+				MassStorage::FileWritten(origFilename.c_str());
+#endif
 #if 0	// Temporary code to save files with upload errors and report successful uploads
 				GetPlatform().Message(GenericMessage, "Successful upload\n");
 #endif
@@ -141,6 +166,18 @@ void UploadingNetworkResponder::FinishUpload(uint32_t fileLength, time_t fileLas
 	}
 }
 
+// Write some upload data to the file, returning true if successful
+bool UploadingNetworkResponder::WriteUploadData(const uint8_t *_ecv_array data, size_t length) noexcept
+{
+#if SUPPORT_UPLOAD_WRITE_BEHIND
+	if (FileWriteBehind::IsWritingFor(this))
+	{
+		return FileWriteBehind::Write(data, length);
+	}
+#endif
+	return fileBeingUploaded.Write(data, length);
+}
+
 #endif
 
 // End
@@ -21,6 +21,7 @@ protected:
 #if HAS_MASS_STORAGE
 	bool StartUpload(const char* folder, const char *fileName, const OpenMode mode, const uint32_t preAllocSize = 0) noexcept;
 	void FinishUpload(uint32_t fileLength, time_t fileLastModified, bool gotCrc, uint32_t expectedCrc) noexcept;
+	bool WriteUploadData(const uint8_t *_ecv_array data, size_t length) noexcept;
 
 	// File uploads
 	FileData fileBeingUploaded;
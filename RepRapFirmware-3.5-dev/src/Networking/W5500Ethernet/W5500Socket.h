@@ -30,6 +30,7 @@ public:
 	bool CanSend() const noexcept override;
 	size_t Send(const uint8_t *data, size_t length) noexcept override;
 	void Send() noexcept override;
+	using Socket::Send;									// this socket copies the data anyway, so use the default Send(OutputBuffer*)
 
 private:
 	void ReInit() noexcept;
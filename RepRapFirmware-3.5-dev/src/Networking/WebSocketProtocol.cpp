@@ -0,0 +1,167 @@
+/*
+ * WebSocketProtocol.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ */
+
+#include "WebSocketProtocol.h"
+#include <Libraries/sha1/sha1.h>
+#include <cstring>
+
+static const char *_ecv_array const WebSocketGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+// Encode binary data in base64, returning the number of characters written excluding the null terminator. There must be room for 4 * ((len + 2)/3) + 1 characters.
+static size_t Base64Encode(const uint8_t *_ecv_array src, size_t len, char *_ecv_array dst) noexcept
+{
+	static const char *_ecv_array const Base64Chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	char *_ecv_array p = dst;
+	for (size_t i = 0; i < len; i += 3)
+	{
+		const uint32_t val = ((uint32_t)src[i] << 16) | ((i + 1 < len) ? (uint32_t)src[i + 1] << 8 : 0) | ((i + 2 < len) ? (uint32_t)src[i + 2] : 0);
+		*p++ = Base64Chars[(val >> 18) & 0x3F];
+		*p++ = Base64Chars[(val >> 12) & 0x3F];
+		*p++ = (i + 1 < len) ? Base64Chars[(val >> 6) & 0x3F] : '=';
+		*p++ = (i + 2 < len) ? Base64Chars[val & 0x3F] : '=';
+	}
+	*p = 0;
+	return p - dst;
+}
+
+size_t MakeWebSocketFrameHeader(uint8_t opcode, size_t payloadLength, uint8_t header[MaxWebSocketFrameHeaderLength]) noexcept
+{
+	size_t headerLength;
+	header[0] = 0x80 | opcode;									// FIN bit and opcode
+	if (payloadLength < 126)
+	{
+		header[1] = (uint8_t)payloadLength;
+		headerLength = 2;
+	}
+	else if (payloadLength <= 0xFFFF)
+	{
+		header[1] = 126;
+		headerLength = 4;
+	}
+	else
+	{
+		header[1] = 127;
+		headerLength = 10;
+	}
+
+	// Store the extended payload length, if any, in big-endian order
+	uint64_t val = payloadLength;
+	for (size_t i = headerLength - 1; i >= 2; --i)
+	{
+		header[i] = (uint8_t)(val & 0xFF);
+		val >>= 8;
+	}
+	return headerLength;
+}
+
+// The accept key is the base64-encoded SHA1 hash of the client's key and the WebSocket GUID
+bool MakeWebSocketAcceptKey(const char *_ecv_array clientKey, char acceptKey[WebSocketAcceptKeyLength + 1]) noexcept
+{
+	SHA1Context hash;
+	SHA1Reset(&hash);
+	SHA1Input(&hash, reinterpret_cast<const uint8_t *>(clientKey), strlen(clientKey));
+	SHA1Input(&hash, reinterpret_cast<const uint8_t *>(WebSocketGuid), strlen(WebSocketGuid));
+	if (!SHA1Result(&hash))
+	{
+		return false;
+	}
+
+	uint8_t digest[20];
+	for (size_t i = 0; i < 5; ++i)
+	{
+		const uint32_t word = hash.Message_Digest[i];
+		digest[4 * i] = (uint8_t)(word >> 24);
+		digest[4 * i + 1] = (uint8_t)(word >> 16);
+		digest[4 * i + 2] = (uint8_t)(word >> 8);
+		digest[4 * i + 3] = (uint8_t)word;
+	}
+	static_assert(4 * ((sizeof(digest) + 2)/3) == WebSocketAcceptKeyLength);
+	(void)Base64Encode(digest, sizeof(digest), acceptKey);
+	return true;
+}
+
+WebSocketFrameParser::Result WebSocketFrameParser::ProcessByte(uint8_t c) noexcept
+{
+	switch (parseState)
+	{
+	case ParseState::opcode:
+		if ((c & 0x70) != 0)
+		{
+			return Result::protocolError;						// reserved bits must be zero because we don't negotiate any extensions
+		}
+		isFinal = (c & 0x80) != 0;
+		opcode = c & 0x0F;
+		parseState = ParseState::length;
+		break;
+
+	case ParseState::length:
+		if ((c & 0x80) == 0)
+		{
+			return Result::protocolError;						// frames from the client must be masked
+		}
+		c &= 0x7F;
+		payloadLength = 0;
+		if (c >= 126)
+		{
+			bytesLeft = (c == 126) ? 2 : 8;
+			parseState = ParseState::extendedLength;
+		}
+		else
+		{
+			payloadLength = c;
+			bytesLeft = sizeof(mask);
+			parseState = ParseState::mask;
+		}
+		break;
+
+	case ParseState::extendedLength:
+		if (payloadLength > 0x00FFFFFF)
+		{
+			return Result::tooBig;
+		}
+		payloadLength = (payloadLength << 8) | c;
+		if (--bytesLeft == 0)
+		{
+			bytesLeft = sizeof(mask);
+			parseState = ParseState::mask;
+		}
+		break;
+
+	case ParseState::mask:
+		mask[sizeof(mask) - bytesLeft] = c;
+		if (--bytesLeft == 0)
+		{
+			if (opcode >= WsOpClose && (payloadLength > sizeof(controlData) || !isFinal))
+			{
+				return Result::protocolError;					// control frames must be short and not fragmented
+			}
+			payloadIndex = 0;
+			parseState = ParseState::payload;
+			if (payloadLength == 0)
+			{
+				return EndOfFrame();
+			}
+		}
+		break;
+
+	case ParseState::payload:
+		if (opcode >= WsOpClose)
+		{
+			controlData[payloadIndex] = c ^ mask[payloadIndex & 3];
+		}
+		++payloadIndex;
+		if (payloadIndex == payloadLength)
+		{
+			return EndOfFrame();
+		}
+		break;
+	}
+	return Result::incomplete;
+}
+
+// End
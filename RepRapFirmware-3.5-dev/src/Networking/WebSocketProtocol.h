@@ -0,0 +1,87 @@
+/*
+ * WebSocketProtocol.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * The parts of the WebSocket protocol (RFC 6455) that don't depend on the connection: the frame parser, the frame header and the handshake key.
+ * This has no dependencies on the rest of the firmware so that it can be tested on a host. HttpWebSocket.cpp uses it to serve WebSocket clients.
+ */
+
+#ifndef SRC_NETWORKING_WEBSOCKETPROTOCOL_H_
+#define SRC_NETWORKING_WEBSOCKETPROTOCOL_H_
+
+#include <ecv_duet3d.h>
+#include <cstdint>
+#include <cstddef>
+
+// WebSocket opcodes
+constexpr uint8_t WsOpContinuation = 0x00;
+constexpr uint8_t WsOpText = 0x01;
+constexpr uint8_t WsOpBinary = 0x02;
+constexpr uint8_t WsOpClose = 0x08;
+constexpr uint8_t WsOpPing = 0x09;
+constexpr uint8_t WsOpPong = 0x0A;
+
+// WebSocket close status codes
+constexpr uint16_t WsCloseNormal = 1000;
+constexpr uint16_t WsCloseProtocolError = 1002;
+constexpr uint16_t WsClosePolicyViolation = 1008;
+constexpr uint16_t WsCloseMessageTooBig = 1009;
+
+constexpr size_t MaxWebSocketFrameHeaderLength = 10;		// the longest header of an unmasked frame
+constexpr size_t WebSocketAcceptKeyLength = 28;				// the length of the base64-encoded SHA1 hash in the Sec-WebSocket-Accept header
+
+// Write the header of an unfragmented, unmasked frame to 'header', returning its length
+size_t MakeWebSocketFrameHeader(uint8_t opcode, size_t payloadLength, uint8_t header[MaxWebSocketFrameHeaderLength]) noexcept;
+
+// Calculate the Sec-WebSocket-Accept value for a Sec-WebSocket-Key value, returning false if the hash failed
+bool MakeWebSocketAcceptKey(const char *_ecv_array clientKey, char acceptKey[WebSocketAcceptKeyLength + 1]) noexcept;
+
+// Parser for the frames that a client sends, one byte at a time. We keep the payload of control frames but not of data frames, which we don't need.
+class WebSocketFrameParser
+{
+public:
+	enum class Result : uint8_t
+	{
+		incomplete,									// the frame isn't complete yet
+		frameComplete,								// a complete frame has been received, so call the getters to find out what it was
+		protocolError,								// the client broke the protocol, so close the WebSocket with status WsCloseProtocolError
+		tooBig										// the frame is too long, so close the WebSocket with status WsCloseMessageTooBig
+	};
+
+	static constexpr size_t MaxControlDataLength = 125;	// control frames can't have a longer payload than this
+
+	WebSocketFrameParser() noexcept { Reset(); }
+
+	void Reset() noexcept { parseState = ParseState::opcode; }
+	Result ProcessByte(uint8_t c) noexcept;
+
+	uint8_t GetOpcode() const noexcept { return opcode; }
+	bool IsFinal() const noexcept { return isFinal; }
+	uint32_t GetPayloadLength() const noexcept { return payloadLength; }
+	const uint8_t *_ecv_array GetControlData() const noexcept { return controlData; }
+
+private:
+	enum class ParseState : uint8_t
+	{
+		opcode,										// expecting the byte containing the FIN bit and the opcode
+		length,										// expecting the byte containing the MASK bit and the payload length
+		extendedLength,								// receiving the 16- or 64-bit extended payload length
+		mask,										// receiving the masking key
+		payload										// receiving the payload
+	};
+
+	Result EndOfFrame() noexcept { parseState = ParseState::opcode; return Result::frameComplete; }
+
+	ParseState parseState;
+	bool isFinal;
+	uint8_t opcode;
+	uint8_t bytesLeft;
+	uint8_t mask[4];
+	uint32_t payloadLength;
+	uint32_t payloadIndex;
+	uint8_t controlData[MaxControlDataLength];
+};
+
+#endif /* SRC_NETWORKING_WEBSOCKETPROTOCOL_H_ */
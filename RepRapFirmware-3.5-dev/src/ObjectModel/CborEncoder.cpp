@@ -0,0 +1,198 @@
+/*
+ * CborEncoder.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ */
+
+#include "CborEncoder.h"
+
+#if SUPPORT_OBJECT_MODEL_CBOR
+
+#include "HalfFloat.h"
+#include <Platform/RepRap.h>
+#include <Platform/Platform.h>
+
+// Write the initial byte of a data item and its argument, using the shortest encoding
+void CborEncoder::WriteHead(uint8_t majorType, uint64_t val) noexcept
+{
+	char data[9];
+	size_t len;
+	majorType <<= 5;
+	if (val < 24)
+	{
+		data[0] = (char)(majorType | (uint8_t)val);
+		len = 1;
+	}
+	else if (val <= 0xFF)
+	{
+		data[0] = (char)(majorType | 24);
+		len = 2;
+	}
+	else if (val <= 0xFFFF)
+	{
+		data[0] = (char)(majorType | 25);
+		len = 3;
+	}
+	else if (val <= 0xFFFFFFFF)
+	{
+		data[0] = (char)(majorType | 26);
+		len = 5;
+	}
+	else
+	{
+		data[0] = (char)(majorType | 27);
+		len = 9;
+	}
+
+	// Store the argument in big-endian order
+	for (size_t i = len - 1; i != 0; --i)
+	{
+		data[i] = (char)(val & 0xFF);
+		val >>= 8;
+	}
+	buf->cat(data, len);
+}
+
+void CborEncoder::Int(int32_t val) noexcept
+{
+	if (val >= 0)
+	{
+		WriteHead(MajorUnsigned, (uint64_t)val);
+	}
+	else
+	{
+		WriteHead(MajorNegative, (uint64_t)(-1 - (int64_t)val));
+	}
+}
+
+// Write a float. If it can be represented exactly in half precision then we write it that way to save space, which is the case for many
+// of the values in the object model, e.g. zero, small integers and temperatures that have been set by the user.
+void CborEncoder::Float(float val) noexcept
+{
+	uint16_t half;
+	if (FloatToHalf(val, half))
+	{
+		const char data[3] = { (char)0xF9, (char)(half >> 8), (char)(half & 0xFF) };
+		buf->cat(data, sizeof(data));
+	}
+	else
+	{
+		uint32_t bits;
+		memcpy(&bits, &val, sizeof(bits));
+		const char data[5] = { (char)0xFA, (char)(bits >> 24), (char)((bits >> 16) & 0xFF), (char)((bits >> 8) & 0xFF), (char)(bits & 0xFF) };
+		buf->cat(data, sizeof(data));
+	}
+}
+
+void CborEncoder::Text(const char *_ecv_array str, size_t len) noexcept
+{
+	WriteHead(MajorText, len);
+	buf->cat(str, len);
+}
+
+void CborEncoder::Key(const char *_ecv_array name, bool first) noexcept
+{
+	if (first)
+	{
+		StartMap();
+	}
+	Text(name);
+}
+
+void CborEncoder::BitmapLong(uint64_t bits) noexcept
+{
+	StartArray();
+	Bitmap<uint64_t>::MakeFromRaw(bits).Iterate([this](unsigned int bn, unsigned int count) noexcept { Uint(bn); });
+	End();
+}
+
+// Report a primitive value in its native binary type
+void CborEncoder::Value(const ObjectExplorationContext& context, const ExpressionValue& val) noexcept
+{
+	switch (val.GetType())
+	{
+	case TypeCode::Float:
+		Float(val.fVal);
+		break;
+
+	case TypeCode::Uint32:
+		Uint(val.uVal);
+		break;
+
+	case TypeCode::Uint64:
+		Uint(((uint64_t)val.param << 32) | val.uVal);
+		break;
+
+	case TypeCode::Int32:
+		Int(val.iVal);
+		break;
+
+	case TypeCode::CString:
+		Text(val.sVal);
+		break;
+
+	case TypeCode::HeapString:
+		Text(val.shVal.Get().Ptr());
+		break;
+
+	case TypeCode::Enum32:
+		if (context.ShortFormReport())
+		{
+			Uint(val.uVal);
+		}
+		else
+		{
+			Text("unimplemented");
+		}
+		break;
+
+	case TypeCode::Bool:
+		Bool(val.bVal);
+		break;
+
+	case TypeCode::Char:
+		Text(&val.cVal, 1);
+		break;
+
+	case TypeCode::Special:
+#if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE
+		switch ((ExpressionValue::SpecialType)val.param)
+		{
+		case ExpressionValue::SpecialType::sysDir:
+			Text(reprap.GetPlatform().GetSysDir().Ptr());
+			break;
+		}
+#else
+		Null();
+#endif
+		break;
+
+	case TypeCode::IPAddress_tc:
+	case TypeCode::DateTime_tc:
+	case TypeCode::Duration:
+	case TypeCode::DriverId_tc:
+	case TypeCode::MacAddress_tc:
+	case TypeCode::Port:
+	case TypeCode::UniqueId_tc:
+#if SUPPORT_CAN_EXPANSION
+	case TypeCode::CanExpansionBoardDetails:
+#endif
+		// These are reported as strings in the same format as in JSON
+		{
+			String<StringLength50> str;
+			val.AppendAsString(str.GetRef());
+			Text(str.c_str());
+		}
+		break;
+
+	case TypeCode::None:
+	default:
+		Null();
+		break;
+	}
+}
+
+#endif
+
+// End
@@ -0,0 +1,56 @@
+/*
+ * CborEncoder.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Minimal CBOR (RFC 8949) encoder used to report the object model in binary form.
+ * Maps and arrays are written with indefinite lengths so that we don't need to know in advance how many members will be reported.
+ */
+
+#ifndef SRC_OBJECTMODEL_CBORENCODER_H_
+#define SRC_OBJECTMODEL_CBORENCODER_H_
+
+#include "ObjectModel.h"
+
+#if SUPPORT_OBJECT_MODEL_CBOR
+
+#include <Platform/OutputMemory.h>
+
+class CborEncoder final : public ObjectModelEncoder
+{
+public:
+	explicit CborEncoder(OutputBuffer *p_buf) noexcept : ObjectModelEncoder(p_buf) { }
+
+	void StartMap() noexcept { buf->cat((char)0xBF); }
+	void End() noexcept { buf->cat((char)0xFF); }
+	void Float(float val) noexcept;
+	void Text(const char *_ecv_array str) noexcept { Text(str, strlen(str)); }
+	void Text(const char *_ecv_array str, size_t len) noexcept;
+
+	// ObjectModelEncoder interface
+	void Key(const char *_ecv_array name, bool first) noexcept override;
+	void EndObject() noexcept override { End(); }
+	void EmptyObject() noexcept override { buf->cat((char)0xA0); }
+	void StartArray() noexcept override { buf->cat((char)0x9F); }
+	void ElementSeparator() noexcept override { }
+	void EndArray() noexcept override { End(); }
+
+	void Null() noexcept override { buf->cat((char)0xF6); }
+	void Bool(bool b) noexcept override { buf->cat((char)((b) ? 0xF5 : 0xF4)); }
+	void Uint(uint64_t val) noexcept override { WriteHead(MajorUnsigned, val); }
+	void Int(int32_t val) noexcept override;
+	void BitmapLong(uint64_t bits) noexcept override;
+	void Value(const ObjectExplorationContext& context, const ExpressionValue& val) noexcept override;
+
+private:
+	static constexpr uint8_t MajorUnsigned = 0;
+	static constexpr uint8_t MajorNegative = 1;
+	static constexpr uint8_t MajorText = 3;
+
+	void WriteHead(uint8_t majorType, uint64_t val) noexcept;
+};
+
+#endif
+
+#endif /* SRC_OBJECTMODEL_CBORENCODER_H_ */
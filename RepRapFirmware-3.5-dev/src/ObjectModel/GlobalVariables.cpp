@@ -14,27 +14,35 @@ const ObjectModelClassDescriptor *GlobalVariables::GetObjectModelClassDescriptor
 // Construct a JSON representation of those parts of the object model requested by the user
 // This overrides the standard definition because the variable names are not fixed
 // We ignore any remaining key or flags and just report all the variables
-void GlobalVariables::ReportAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor * null classDescriptor, uint8_t tableNumber, const char *filter) const THROWS(GCodeException)
+void GlobalVariables::ReportAsJson(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ObjectModelClassDescriptor * null classDescriptor, uint8_t tableNumber, const char *filter) const THROWS(GCodeException)
 {
 	if (*filter == 0)
 	{
 		// Report all global variables
-		buf->cat('{');
+		bool added = false;
 		if (context.IncreaseDepth())
 		{
 			{
 				ReadLocker locker(lock);			// make sure that no other task modifies the list while we are traversing it
-				vars.IterateWhile([this, buf, &context, classDescriptor, filter](unsigned int index, const Variable& v) noexcept -> bool
+				vars.IterateWhile([this, &enc, &context, classDescriptor, filter, &added](unsigned int index, const Variable& v) noexcept -> bool
 									{
-										buf->catf((index != 0) ? ",\"%s\":" : "\"%s\":", v.GetName().Ptr());
-										ReportItemAsJson(buf, context, classDescriptor, v.GetValue(), filter);
+										enc.Key(v.GetName().Ptr(), index == 0);
+										ReportItemAsJson(enc, context, classDescriptor, v.GetValue(), filter);
+										added = true;
 										return true;
 									}
 								 );
 			}
 			context.DecreaseDepth();
 		}
-		buf->cat('}');
+		if (added)
+		{
+			enc.EndObject();
+		}
+		else
+		{
+			enc.EmptyObject();
+		}
 	}
 	else
 	{
@@ -43,15 +51,15 @@ void GlobalVariables::ReportAsJson(OutputBuffer *buf, ObjectExplorationContext&
 		const Variable *const var = vars.Lookup(filter, pos - filter, false);
 		if (var == nullptr)
 		{
-			buf->cat("null");
+			enc.Null();
 		}
 		else if (context.IncreaseDepth())
 		{
-			ReportItemAsJson(buf, context, nullptr, var->GetValue(), pos);
+			ReportItemAsJson(enc, context, nullptr, var->GetValue(), pos);
 		}
 		else
 		{
-			buf->cat("{}");
+			enc.EmptyObject();
 		}
 	}
 }
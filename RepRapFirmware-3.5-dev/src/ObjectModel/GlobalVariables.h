@@ -27,7 +27,7 @@ protected:
 
 	// Construct a JSON representation of those parts of the object model requested by the user
 	// This overrides the standard definition because the variable names are not fixed
-	void ReportAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor * null classDescriptor, uint8_t tableNumber, const char *_ecv_array filter) const override
+	void ReportAsJson(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ObjectModelClassDescriptor * null classDescriptor, uint8_t tableNumber, const char *_ecv_array filter) const override
 			THROWS(GCodeException);
 
 private:
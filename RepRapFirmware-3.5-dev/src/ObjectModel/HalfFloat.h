@@ -0,0 +1,52 @@
+/*
+ * HalfFloat.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Conversion of single precision floats to IEEE 754 half precision, used by the CBOR encoder.
+ * This has no dependencies on the rest of the firmware so that it can be tested on the host.
+ */
+
+#ifndef SRC_OBJECTMODEL_HALFFLOAT_H_
+#define SRC_OBJECTMODEL_HALFFLOAT_H_
+
+#include <cstdint>
+#include <cstring>
+
+// Convert a float to half precision. Return true if the conversion is exact, in which case 'half' holds the result.
+// Infinities convert exactly and so do NaNs, although their payloads are not preserved.
+inline bool FloatToHalf(float val, uint16_t& half) noexcept
+{
+	uint32_t bits;
+	memcpy(&bits, &val, sizeof(bits));
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	const int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127;
+	const uint32_t mantissa = bits & 0x007FFFFF;
+
+	if ((bits & 0x7FFFFFFF) == 0)
+	{
+		half = (uint16_t)sign;																	// zero
+		return true;
+	}
+	if (exponent == 128)
+	{
+		half = (uint16_t)(sign | 0x7C00 | ((mantissa != 0) ? 0x0200 : 0));						// infinity or NaN
+		return true;
+	}
+	if (exponent >= -14 && exponent <= 15)
+	{
+		half = (uint16_t)(sign | ((uint32_t)(exponent + 15) << 10) | (mantissa >> 13));			// normal half-precision number
+		return (mantissa & 0x1FFF) == 0;
+	}
+	if (exponent >= -24 && exponent < -14)
+	{
+		const uint32_t fullMantissa = mantissa | 0x00800000;
+		const unsigned int shift = (unsigned int)(-1 - exponent);
+		half = (uint16_t)(sign | (fullMantissa >> shift));										// subnormal half-precision number
+		return (fullMantissa & ((1u << shift) - 1)) == 0;
+	}
+	return false;
+}
+
+#endif /* SRC_OBJECTMODEL_HALFFLOAT_H_ */
@@ -0,0 +1,260 @@
+/*
+ * JsonEncoder.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ */
+
+#include "JsonEncoder.h"
+
+#if SUPPORT_OBJECT_MODEL
+
+#include <Platform/RepRap.h>
+#include <Platform/Platform.h>
+#include <Platform/OutputMemory.h>
+#include <Hardware/IoPorts.h>
+#include <General/IPAddress.h>
+
+void JsonEncoder::Key(const char *_ecv_array name, bool first) noexcept
+{
+	buf->cat((first) ? "{\"" : ",\"");
+	buf->cat(name);
+	buf->cat("\":");
+}
+
+void JsonEncoder::EndObject() noexcept
+{
+	buf->cat('}');
+}
+
+void JsonEncoder::EmptyObject() noexcept
+{
+	buf->cat("{}");
+}
+
+void JsonEncoder::StartArray() noexcept
+{
+	buf->cat('[');
+}
+
+void JsonEncoder::ElementSeparator() noexcept
+{
+	buf->cat(',');
+}
+
+void JsonEncoder::EndArray() noexcept
+{
+	buf->cat(']');
+}
+
+void JsonEncoder::Null() noexcept
+{
+	buf->cat("null");
+}
+
+void JsonEncoder::Bool(bool b) noexcept
+{
+	buf->cat((b) ? "true" : "false");
+}
+
+void JsonEncoder::Uint(uint64_t val) noexcept
+{
+	buf->catf("%" PRIu64, val);
+}
+
+void JsonEncoder::Int(int32_t val) noexcept
+{
+	buf->catf("%" PRIi32, val);
+}
+
+void JsonEncoder::BitmapLong(uint64_t bits) noexcept
+{
+	buf->cat('[');
+	Bitmap<uint64_t>::MakeFromRaw(bits).Iterate
+		([this](unsigned int bn, unsigned int count) noexcept
+			{
+				if (count != 0)
+				{
+					buf->cat(',');
+				}
+				buf->catf("%u", bn);
+			}
+		);
+	buf->cat(']');
+}
+
+void JsonEncoder::Value(const ObjectExplorationContext& context, const ExpressionValue& val) noexcept
+{
+	switch (val.GetType())
+	{
+	case TypeCode::Float:
+		ReportFloat(val);
+		break;
+
+	case TypeCode::Uint32:
+		buf->catf("%" PRIu32, val.uVal);
+		break;
+
+	case TypeCode::Uint64:
+		buf->catf("%" PRIu64, ((uint64_t)val.param << 32) | val.uVal);	// convert unsigned integer to string
+		break;
+
+	case TypeCode::Int32:
+		buf->catf("%" PRIi32, val.iVal);
+		break;
+
+	case TypeCode::CString:
+		buf->catf("\"%.s\"", val.sVal);
+		break;
+
+	case TypeCode::HeapString:
+		buf->catf("\"%.s\"", val.shVal.Get().Ptr());
+		break;
+
+#if SUPPORT_CAN_EXPANSION
+	case TypeCode::CanExpansionBoardDetails:
+		ReportExpansionBoardDetail(val);
+		break;
+#endif
+
+	case TypeCode::Enum32:
+		if (context.ShortFormReport())
+		{
+			buf->catf("%" PRIu32, val.uVal);
+		}
+		else
+		{
+			buf->cat("\"unimplemented\"");
+			// TODO append the real name
+		}
+		break;
+
+	case TypeCode::Bool:
+		buf->cat((val.bVal) ? "true" : "false");
+		break;
+
+	case TypeCode::Char:
+		buf->cat('"');
+		buf->EncodeChar(val.cVal);
+		buf->cat('"');
+		break;
+
+	case TypeCode::IPAddress_tc:
+		{
+			const IPAddress ipVal(val.uVal);
+			char sep = '"';
+			for (unsigned int q = 0; q < 4; ++q)
+			{
+				buf->catf("%c%u", sep, ipVal.GetQuad(q));
+				sep = '.';
+			}
+			buf->cat('"');
+		}
+		break;
+
+	case TypeCode::DateTime_tc:
+		ReportDateTime(val);
+		break;
+
+	case TypeCode::Duration:
+		{
+			unsigned int hours = val.uVal/3600,
+				minutes = (val.uVal / 60) % 60,
+				seconds = val.uVal % 60;
+			buf->catf("%u:%02u:%02u", hours, minutes, seconds);
+		}
+		break;
+
+	case TypeCode::DriverId_tc:
+#if SUPPORT_CAN_EXPANSION
+		buf->catf("\"%u.%u\"", (unsigned int)val.param, (unsigned int)val.uVal);
+#else
+		buf->catf("\"%u\"", (unsigned int)val.uVal);
+#endif
+		break;
+
+	case TypeCode::MacAddress_tc:
+		buf->catf("\"%02x:%02x:%02x:%02x:%02x:%02x\"",
+					(unsigned int)(val.uVal & 0xFF), (unsigned int)((val.uVal >> 8) & 0xFF), (unsigned int)((val.uVal >> 16) & 0xFF), (unsigned int)((val.uVal >> 24) & 0xFF),
+					(unsigned int)(val.param & 0xFF), (unsigned int)((val.param >> 8) & 0xFF));
+		break;
+
+	case TypeCode::Special:
+#if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE
+		switch ((ExpressionValue::SpecialType)val.param)
+		{
+		case ExpressionValue::SpecialType::sysDir:
+			buf->catf("\"%.s\"", reprap.GetPlatform().GetSysDir().Ptr());
+			break;
+		}
+#endif
+		break;
+
+	case TypeCode::None:
+		buf->cat("null");
+		break;
+
+	case TypeCode::Port:
+		ReportPinName(val);
+		break;
+
+	case TypeCode::UniqueId_tc:
+		buf->cat('"');
+		val.uniqueIdVal->AppendCharsToBuffer(buf);
+		buf->cat('"');
+		break;
+
+	default:										// the reporting functions handle objects, arrays and bitmaps themselves
+		break;
+	}
+}
+
+// Separate function to avoid the tm object (44 bytes) being allocated on the stack frame of Value
+void JsonEncoder::ReportDateTime(const ExpressionValue& val) noexcept
+{
+	const time_t time = val.Get56BitValue();
+	tm timeInfo;
+	gmtime_r(&time, &timeInfo);
+	buf->catf("\"%04u-%02u-%02uT%02u:%02u:%02u\"",
+				timeInfo.tm_year + 1900, timeInfo.tm_mon + 1, timeInfo.tm_mday, timeInfo.tm_hour, timeInfo.tm_min, timeInfo.tm_sec);
+}
+
+void JsonEncoder::ReportFloat(const ExpressionValue& val) noexcept
+{
+	if (val.fVal == 0.0)
+	{
+		buf->cat('0');							// replace 0.000... in JSON by 0. This is mostly to save space when writing workplace coordinates.
+	}
+	else if (std::isnan(val.fVal) || std::isinf(val.fVal))
+	{
+		buf->cat("null");						// avoid generating bad JSON if the value is a NaN or infinity
+	}
+	else
+	{
+		buf->catf(val.GetFloatFormatString(), (double)val.fVal);
+	}
+}
+
+void JsonEncoder::ReportPinName(const ExpressionValue& val) noexcept
+{
+	buf->cat('"');
+	String<StringLength50> portName;
+	val.iopVal->AppendPinName(portName.GetRef());
+	buf->catf("%.0s", portName.c_str());				// the %.0s format specifier forces JSON escaping
+	buf->cat('"');
+}
+
+#if SUPPORT_CAN_EXPANSION
+
+void JsonEncoder::ReportExpansionBoardDetail(const ExpressionValue& val) noexcept
+{
+	String<StringLength50> rslt;
+	val.ExtractRequestedPart(rslt.GetRef());
+	buf->catf("\"%.s\"", rslt.c_str());
+}
+
+#endif
+
+#endif
+
+// End
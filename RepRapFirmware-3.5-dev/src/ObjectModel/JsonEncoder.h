@@ -0,0 +1,42 @@
+/*
+ * JsonEncoder.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ */
+
+#ifndef SRC_OBJECTMODEL_JSONENCODER_H_
+#define SRC_OBJECTMODEL_JSONENCODER_H_
+
+#include "ObjectModel.h"
+
+// Encoder that writes the object model as JSON
+class JsonEncoder final : public ObjectModelEncoder
+{
+public:
+	explicit JsonEncoder(OutputBuffer *p_buf) noexcept : ObjectModelEncoder(p_buf) { }
+
+	void Key(const char *_ecv_array name, bool first) noexcept override;
+	void EndObject() noexcept override;
+	void EmptyObject() noexcept override;
+	void StartArray() noexcept override;
+	void ElementSeparator() noexcept override;
+	void EndArray() noexcept override;
+
+	void Null() noexcept override;
+	void Bool(bool b) noexcept override;
+	void Uint(uint64_t val) noexcept override;
+	void Int(int32_t val) noexcept override;
+	void BitmapLong(uint64_t bits) noexcept override;
+	void Value(const ObjectExplorationContext& context, const ExpressionValue& val) noexcept override;
+
+private:
+	void ReportDateTime(const ExpressionValue& val) noexcept;
+	void ReportFloat(const ExpressionValue& val) noexcept;
+	void ReportPinName(const ExpressionValue& val) noexcept;
+#if SUPPORT_CAN_EXPANSION
+	void ReportExpansionBoardDetail(const ExpressionValue& val) noexcept;
+#endif
+};
+
+#endif /* SRC_OBJECTMODEL_JSONENCODER_H_ */
@@ -502,12 +502,12 @@ ObjectModel::ObjectModel() noexcept
 
 // Constructor used when reporting the OM as JSON
 ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null gbp, bool wal, const char *reportFlags, unsigned int initialMaxDepth, size_t initialBufferOffset) noexcept
-	: startMillis(millis()), initialBufOffset(initialBufferOffset), maxDepth(initialMaxDepth), currentDepth(0), startElement(0), nextElement(-1), numIndicesProvided(0), numIndicesCounted(0),
+	: startMillis(millis()), initialBufOffset(initialBufferOffset), maxDepth(initialMaxDepth), currentDepth(0), startElement(0), nextElement(-1), numIndicesProvided(0), numIndicesCounted(0), changesSince(0),
 	  line(-1), column(-1), gb(gbp),
 	  shortForm(false), wantArrayLength(wal), wantExists(false),
 	  includeNonLive(true), includeImportant(false), includeNulls(false),
 	  excludeVerbose(true), excludeObsolete(true),
-	  obsoleteFieldQueried(false), truncateLongArrays(true)
+	  obsoleteFieldQueried(false), truncateLongArrays(true), changesOnly(false)
 {
 	while (true)
 	{
@@ -541,6 +541,15 @@ ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null
 				++reportFlags;
 			}
 			break;
+		case 'c':
+			changesOnly = true;
+			changesSince = 0;
+			while (isdigit(*reportFlags))
+			{
+				changesSince = (10 * changesSince) + (*reportFlags - '0');
+				++reportFlags;
+			}
+			break;
 		case 'a':
 			startElement = 0;
 			truncateLongArrays = false;
@@ -562,12 +571,12 @@ ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null
 
 // Constructor when evaluating expressions
 ObjectExplorationContext::ObjectExplorationContext(const GCodeBuffer *_ecv_null gbp, bool wal, bool wex, int p_line, int p_col) noexcept
-	: startMillis(millis()), initialBufOffset(0), maxDepth(99), currentDepth(0), startElement(0), nextElement(-1), numIndicesProvided(0), numIndicesCounted(0),
+	: startMillis(millis()), initialBufOffset(0), maxDepth(99), currentDepth(0), startElement(0), nextElement(-1), numIndicesProvided(0), numIndicesCounted(0), changesSince(0),
 	  line(p_line), column(p_col), gb(gbp),
 	  shortForm(false), wantArrayLength(wal), wantExists(wex),
 	  includeNonLive(true), includeImportant(false), includeNulls(false),
 	  excludeVerbose(false), excludeObsolete(false),
-	  obsoleteFieldQueried(false), truncateLongArrays(false)
+	  obsoleteFieldQueried(false), truncateLongArrays(false), changesOnly(false)
 {
 }
 
@@ -597,6 +606,18 @@ int32_t ObjectExplorationContext::GetLastIndex() const noexcept
 	return 0;
 }
 
+// If the client wants only the changes since the generation it last fetched but that generation can't have come from us since we started,
+// or it hasn't fetched the object model before, it gets a snapshot instead. Return true if that is the case.
+bool ObjectExplorationContext::StartChangesReport(uint32_t currentGeneration) noexcept
+{
+	const bool snapshot = changesOnly && (changesSince == 0 || !reprap.IsGenerationSinceStart(changesSince, currentGeneration));
+	if (snapshot || !includeNonLive)
+	{
+		changesOnly = false;							// if we are reporting live values only then there is nothing to leave out
+	}
+	return snapshot;
+}
+
 bool ObjectExplorationContext::ShouldReport(const ObjectModelEntryFlags f) const noexcept
 {
 	const bool wanted = includeNonLive
@@ -638,7 +659,7 @@ void ObjectExplorationContext::CheckStack(uint32_t calledFunctionStackUsage) con
 }
 
 // Report this object
-void ObjectModel::ReportAsJson(OutputBuffer* buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor * null classDescriptor,
+void ObjectModel::ReportAsJson(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ObjectModelClassDescriptor * null classDescriptor,
 								uint8_t tableNumber, const char *_ecv_array filter) const THROWS(GCodeException)
 {
 	if (context.IncreaseDepth())
@@ -664,10 +685,15 @@ void ObjectModel::ReportAsJson(OutputBuffer* buf, ObjectExplorationContext& cont
 				size_t numEntries = descriptor[tableNumber + 1];
 				while (numEntries != 0)
 				{
+					if (context.ReportChangesOnly() && context.AtTopLevel())
+					{
+						// Report only the live values of root keys whose other values haven't changed since the client last fetched them
+						context.SetKeyUnchanged(!reprap.KeyChangedSince(tbl->GetName(), context.GetChangesSince()));
+					}
 					if (tbl->Matches(filter, context))
 					{
 						ReadLocker lock(GetObjectLock(tableNumber));
-						if (tbl->ReportAsJson(buf, context, classDescriptor, this, filter, !added))
+						if (tbl->ReportAsJson(enc, context, classDescriptor, this, filter, !added))
 						{
 							added = true;
 						}
@@ -687,72 +713,94 @@ void ObjectModel::ReportAsJson(OutputBuffer* buf, ObjectExplorationContext& cont
 		{
 			if (*filter == 0)
 			{
-				buf->cat('}');
+				enc.EndObject();
 			}
 		}
+		else if (*filter == 0)
+		{
+			enc.EmptyObject();
+		}
 		else
 		{
-			buf->cat((*filter == 0) ? "{}" : "null");
+			enc.Null();
 		}
 		context.DecreaseDepth();
 	}
 	else
 	{
-		buf->cat("{}");
+		enc.EmptyObject();
 	}
 }
 
-// Construct a JSON representation of those parts of the object model requested by the user. This version is called on the root of the tree.
-void ObjectModel::ReportAsJson(const GCodeBuffer *_ecv_null gb, OutputBuffer *buf, const char *_ecv_array filter, const char *_ecv_array reportFlags, bool wantArrayLength) const THROWS(GCodeException)
+// Construct a JSON or CBOR representation of those parts of the object model requested by the user. This version is called on the root of the tree.
+// The caller has already started the response object and written the key for the result.
+void ObjectModel::ReportAsJson(const GCodeBuffer *_ecv_null gb, ObjectModelEncoder& enc, const char *_ecv_array filter, const char *_ecv_array reportFlags, bool wantArrayLength) const THROWS(GCodeException)
 {
 	const unsigned int defaultMaxDepth = (wantArrayLength) ? 99 : (filter[0] == 0) ? 1 : 99;
-	ObjectExplorationContext context(gb, wantArrayLength, reportFlags, defaultMaxDepth, buf->Length());
-	ReportAsJson(buf, context, nullptr, 0, filter);
+	ObjectExplorationContext context(gb, wantArrayLength, reportFlags, defaultMaxDepth, enc.GetBuffer()->Length());
+
+	// Read the generation before we report so that any changes made while we do will be sent next time
+	const bool wantChanges = context.ReportChangesOnly();
+	const uint32_t generation = reprap.GetModelGeneration();
+	const bool snapshot = context.StartChangesReport(generation);
+
+	ReportAsJson(enc, context, nullptr, 0, filter);
 	if (context.GetNextElement() >= 0)
 	{
-		buf->catf(",\"next\":%d", context.GetNextElement());
+		enc.Key("next", false);
+		enc.Int(context.GetNextElement());
+	}
+	if (wantChanges)
+	{
+		enc.Key("gen", false);
+		enc.Uint(generation);
+		if (snapshot)
+		{
+			enc.Key("snapshot", false);
+			enc.Bool(true);
+		}
 	}
 }
 
-void ObjectModel::ReportArrayLengthAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ExpressionValue& val) const noexcept
+void ObjectModel::ReportArrayLengthAsJson(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ExpressionValue& val) const noexcept
 {
 	switch (val.GetType())
 	{
 	case TypeCode::ObjectModelArray:
 		{
 			const ObjectModelArrayTableEntry *const entry = val.omVal->GetObjectModelArrayEntry(val.param & 0xFF);
-			buf->catf("%u", entry->GetNumElements(this, context));
+			enc.Uint(entry->GetNumElements(this, context));
 		}
 		break;
 
 	case TypeCode::HeapArray:
 		{
 			ReadLocker lock(Heap::heapLock);				// must have a read lock on heapLock when calling GetNumElements or GetElement
-			buf->catf("%u", val.ahVal.GetNumElements());
+			enc.Uint(val.ahVal.GetNumElements());
 		}
 		break;
 
 	case TypeCode::Bitmap16:
 	case TypeCode::Bitmap32:
-		buf->catf("%u", Bitmap<uint32_t>::MakeFromRaw(val.uVal).CountSetBits());
+		enc.Uint(Bitmap<uint32_t>::MakeFromRaw(val.uVal).CountSetBits());
 		break;
 
 #if SUPPORT_BITMAP64
 	case TypeCode::Bitmap64:
-		buf->catf("%u", Bitmap<uint64_t>::MakeFromRaw(val.Get56BitValue()).CountSetBits());
+		enc.Uint(Bitmap<uint64_t>::MakeFromRaw(val.Get56BitValue()).CountSetBits());
 		break;
 #endif
 
 	case TypeCode::CString:
-		buf->catf("%u", strlen(val.sVal));
+		enc.Uint(strlen(val.sVal));
 		break;
 
 	case TypeCode::HeapString:
-		buf->catf("%u", val.shVal.GetLength());
+		enc.Uint(val.shVal.GetLength());
 		break;
 
 	default:
-		buf->cat("null");
+		enc.Null();
 		break;
 	}
 }
@@ -760,7 +808,7 @@ void ObjectModel::ReportArrayLengthAsJson(OutputBuffer *buf, ObjectExplorationCo
 // Function to report a value or object as JSON
 // This function is recursive, so keep its stack usage low.
 // The type of 'val' may not be ObjectModel_tc. That type is handled in function ReportItemAsJson, which is declared 'inline' to reduce stack usage.
-void ObjectModel::ReportItemAsJsonFull(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *null classDescriptor,
+void ObjectModel::ReportItemAsJsonFull(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ObjectModelClassDescriptor *null classDescriptor,
 										const ExpressionValue& val, const char *filter) const THROWS(GCodeException)
 {
 	switch (val.GetType())
@@ -773,7 +821,7 @@ void ObjectModel::ReportItemAsJsonFull(OutputBuffer *buf, ObjectExplorationConte
 				++filter;
 				if (*filter == ']')						// if reporting on [parts of] all elements in the array
 				{
-					ReportObjectModelArrayAsJson(buf, context, classDescriptor, entry, filter + 1);
+					ReportObjectModelArrayAsJson(enc, context, classDescriptor, entry, filter + 1);
 				}
 				else
 				{
@@ -781,34 +829,34 @@ void ObjectModel::ReportItemAsJsonFull(OutputBuffer *buf, ObjectExplorationConte
 					const int32_t index = StrToI32(filter, &endptr);
 					if (endptr == filter || *endptr != ']' || index < 0 || (size_t)index >= entry->GetNumElements(this, context))
 					{
-						buf->cat("null");					// avoid returning badly-formed JSON
+						enc.Null();							// avoid returning badly-formed output
 						break;								// invalid syntax, or index out of range
 					}
 					if (*filter == 0)
 					{
-						buf->cat('[');
+						enc.StartArray();
 					}
 					context.AddIndex(index);
 					{
 						// As at release 3.1.1 this next block uses the most stack of this entire function
 						ReadLocker lock(entry->lockPointer);
 						const ExpressionValue element = entry->GetElement(this, context);
-						ReportItemAsJson(buf, context, classDescriptor, element, endptr + 1);
+						ReportItemAsJson(enc, context, classDescriptor, element, endptr + 1);
 					}
 					context.RemoveIndex();
 					if (*filter == 0)
 					{
-						buf->cat(']');
+						enc.EndArray();
 					}
 				}
 			}
 			else if (*filter == 0)						// else reporting on all subparts of all elements in the array, or just the length
 			{
-				ReportObjectModelArrayAsJson(buf, context, classDescriptor, entry, filter);
+				ReportObjectModelArrayAsJson(enc, context, classDescriptor, entry, filter);
 			}
 			else
 			{
-				buf->cat("null");
+				enc.Null();
 			}
 		}
 		break;
@@ -819,7 +867,7 @@ void ObjectModel::ReportItemAsJsonFull(OutputBuffer *buf, ObjectExplorationConte
 			++filter;
 			if (*filter == ']')								// if reporting on [parts of] all elements in the array
 			{
-				ReportHeapArrayAsJson(buf, context, classDescriptor, val.ahVal, filter + 1);
+				ReportHeapArrayAsJson(enc, context, classDescriptor, val.ahVal, filter + 1);
 			}
 			else
 			{
@@ -830,29 +878,29 @@ void ObjectModel::ReportItemAsJsonFull(OutputBuffer *buf, ObjectExplorationConte
 					ReadLocker lock(Heap::heapLock);		// must have a read lock on heapLock when calling GetNumElements or GetElement
 					if (endptr == filter || *endptr != ']' || index < 0 || !val.ahVal.GetElement((size_t)index, element))
 					{
-						buf->cat("null");					// avoid returning badly-formed JSON
+						enc.Null();							// avoid returning badly-formed output
 						break;								// invalid syntax, or index out of range
 					}
 				}
 				if (*filter == 0)
 				{
-					buf->cat('[');
+					enc.StartArray();
 				}
-				ReportItemAsJson(buf, context, classDescriptor, element, endptr + 1);
+				ReportItemAsJson(enc, context, classDescriptor, element, endptr + 1);
 
 				if (*filter == 0)
 				{
-					buf->cat(']');
+					enc.EndArray();
 				}
 			}
 		}
 		else if (*filter == 0)								// else reporting on all subparts of all elements in the array, or just the length
 		{
-			ReportHeapArrayAsJson(buf, context, classDescriptor, val.ahVal, filter);
+			ReportHeapArrayAsJson(enc, context, classDescriptor, val.ahVal, filter);
 		}
 		else
 		{
-			buf->cat("null");
+			enc.Null();
 		}
 		break;
 
@@ -873,21 +921,21 @@ void ObjectModel::ReportItemAsJsonFull(OutputBuffer *buf, ObjectExplorationConte
 				int bitNumber;
 				if (endptr == filter || *endptr != ']' || index < 0 || (bitNumber = bm.GetSetBitNumber(index)) < 0)
 				{
-					buf->cat("null");				// avoid returning badly-formed JSON
+					enc.Null();						// avoid returning badly-formed output
 					break;							// invalid syntax, or index out of range
 				}
-				buf->catf("%d", bitNumber);
+				enc.Uint(bitNumber);
 				break;
 			}
 		}
 		else if (context.ShortFormReport())
 		{
-			buf->catf("%" PRIu32, val.uVal);
+			enc.Uint(val.uVal);
 			break;
 		}
 
 		// If we get here then we want a long form report
-		ReportBitmap1632Long(buf, val);
+		enc.BitmapLong(val.uVal);
 		break;
 
 #if SUPPORT_BITMAP64
@@ -907,21 +955,21 @@ void ObjectModel::ReportItemAsJsonFull(OutputBuffer *buf, ObjectExplorationConte
 				int bitNumber;
 				if (endptr == filter || *endptr != ']' || index < 0 || (bitNumber = bm.GetSetBitNumber(index)) < 0)
 				{
-					buf->cat("null");				// avoid returning badly-formed JSON
+					enc.Null();						// avoid returning badly-formed output
 					break;							// invalid syntax, or index out of range
 				}
-				buf->catf("%d", bitNumber);
+				enc.Uint(bitNumber);
 				break;
 			}
 		}
 		else if (context.ShortFormReport())
 		{
-			buf->catf("%" PRIu64, val.Get56BitValue());
+			enc.Uint(val.Get56BitValue());
 			break;
 		}
 
 		// If we get here then we want a long form report
-		ReportBitmap64Long(buf, val);
+		enc.BitmapLong(val.Get56BitValue());
 		break;
 #endif
 
@@ -929,155 +977,24 @@ void ObjectModel::ReportItemAsJsonFull(OutputBuffer *buf, ObjectExplorationConte
 		// Only primitive types remain so we should have reached the end of the filter string
 		if (*filter != 0)
 		{
-			buf->cat("null");
+			enc.Null();
 		}
 		else
 		{
-			switch (val.GetType())
-			{
-			case TypeCode::Float:
-				ReportFloat(buf, val);
-				break;
-
-			case TypeCode::Uint32:
-				buf->catf("%" PRIu32, val.uVal);
-				break;
-
-			case TypeCode::Uint64:
-				buf->catf("%" PRIu64, ((uint64_t)val.param << 32) | val.uVal);	// convert unsigned integer to string
-				break;
-
-			case TypeCode::Int32:
-				buf->catf("%" PRIi32, val.iVal);
-				break;
-
-			case TypeCode::CString:
-				buf->catf("\"%.s\"", val.sVal);
-				break;
-
-			case TypeCode::HeapString:
-				buf->catf("\"%.s\"", val.shVal.Get().Ptr());
-				break;
-
-#if SUPPORT_CAN_EXPANSION
-			case TypeCode::CanExpansionBoardDetails:
-				ReportExpansionBoardDetail(buf, val);
-				break;
-#endif
-
-			case TypeCode::Enum32:
-				if (context.ShortFormReport())
-				{
-					buf->catf("%" PRIu32, val.uVal);
-				}
-				else
-				{
-					buf->cat("\"unimplemented\"");
-					// TODO append the real name
-				}
-				break;
-
-			case TypeCode::Bool:
-				buf->cat((val.bVal) ? "true" : "false");
-				break;
-
-			case TypeCode::Char:
-				buf->cat('"');
-				buf->EncodeChar(val.cVal);
-				buf->cat('"');
-				break;
-
-			case TypeCode::IPAddress_tc:
-				{
-					const IPAddress ipVal(val.uVal);
-					char sep = '"';
-					for (unsigned int q = 0; q < 4; ++q)
-					{
-						buf->catf("%c%u", sep, ipVal.GetQuad(q));
-						sep = '.';
-					}
-					buf->cat('"');
-				}
-				break;
-
-			case TypeCode::DateTime_tc:
-				ReportDateTime(buf, val);
-				break;
-
-			case TypeCode::Duration:
-				{
-					unsigned int hours = val.uVal/3600,
-						minutes = (val.uVal / 60) % 60,
-						seconds = val.uVal % 60;
-					buf->catf("%u:%02u:%02u", hours, minutes, seconds);
-				}
-				break;
-
-			case TypeCode::DriverId_tc:
-#if SUPPORT_CAN_EXPANSION
-				buf->catf("\"%u.%u\"", (unsigned int)val.param, (unsigned int)val.uVal);
-#else
-				buf->catf("\"%u\"", (unsigned int)val.uVal);
-#endif
-				break;
-
-			case TypeCode::MacAddress_tc:
-				buf->catf("\"%02x:%02x:%02x:%02x:%02x:%02x\"",
-							(unsigned int)(val.uVal & 0xFF), (unsigned int)((val.uVal >> 8) & 0xFF), (unsigned int)((val.uVal >> 16) & 0xFF), (unsigned int)((val.uVal >> 24) & 0xFF),
-							(unsigned int)(val.param & 0xFF), (unsigned int)((val.param >> 8) & 0xFF));
-				break;
-
-			case TypeCode::Special:
-#if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE
-				switch ((ExpressionValue::SpecialType)val.param)
-				{
-				case ExpressionValue::SpecialType::sysDir:
-					buf->catf("\"%.s\"", reprap.GetPlatform().GetSysDir().Ptr());
-					break;
-				}
-#endif
-				break;
-
-			case TypeCode::None:
-				buf->cat("null");
-				break;
-
-			case TypeCode::Port:
-				ReportPinNameAsJson(buf, val);
-				break;
-
-			case TypeCode::UniqueId_tc:
-				buf->cat('"');
-				val.uniqueIdVal->AppendCharsToBuffer(buf);
-				buf->cat('"');
-				break;
-
-			case TypeCode::ObjectModel_tc:					// we already handled this case in the inline part
-			default:										// to keep gcc happy
-				break;
-			}
+			enc.Value(context, val);
 		}
 	}
 }
 
-// This is a separate function to avoid having a string buffer on the stack of a recursive function
-void ObjectModel::ReportPinNameAsJson(OutputBuffer *buf, const ExpressionValue& val) noexcept
-{
-	buf->cat('"');
-	String<StringLength50> portName;
-	val.iopVal->AppendPinName(portName.GetRef());
-	buf->catf("%.0s", portName.c_str());				// the %.0s format specifier forces JSON escaping
-	buf->cat('"');
-}
-
-// Report an entire array as JSON
-void ObjectModel::ReportObjectModelArrayAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *null classDescriptor,
+// Report an entire array
+void ObjectModel::ReportObjectModelArrayAsJson(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ObjectModelClassDescriptor *null classDescriptor,
 												const ObjectModelArrayTableEntry *entry, const char *_ecv_array filter) const THROWS(GCodeException)
 {
+	OutputBuffer * const buf = enc.GetBuffer();
 	const bool isRootArray = (buf->Length() == context.GetInitialBufferOffset());		// it's a root array if we haven't started writing to the buffer yet
 	ReadLocker lock(entry->lockPointer);
 
-	buf->cat('[');
+	enc.StartArray();
 	const size_t count = entry->GetNumElements(this, context);
 	const size_t startElement = (isRootArray) ? context.GetStartElement() : 0;
 	for (size_t i = startElement; i < count; ++i)
@@ -1091,26 +1008,27 @@ void ObjectModel::ReportObjectModelArrayAsJson(OutputBuffer *buf, ObjectExplorat
 				context.SetNextElement(i);
 				break;
 			}
-			buf->cat(',');
+			enc.ElementSeparator();
 		}
 		context.AddIndex(i);
 		const ExpressionValue element = entry->GetElement(this, context);
-		ReportItemAsJson(buf, context, classDescriptor, element, filter);
+		ReportItemAsJson(enc, context, classDescriptor, element, filter);
 		context.RemoveIndex();
 	}
 	if (isRootArray && context.GetNextElement() < 0)
 	{
 		context.SetNextElement(0);
 	}
-	buf->cat(']');
+	enc.EndArray();
 }
 
-// Report an entire array as JSON
-void ObjectModel::ReportHeapArrayAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *null classDescriptor,
+// Report an entire array
+void ObjectModel::ReportHeapArrayAsJson(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ObjectModelClassDescriptor *null classDescriptor,
 											ArrayHandle ah, const char *_ecv_array filter) const THROWS(GCodeException)
 {
+	OutputBuffer * const buf = enc.GetBuffer();
 	const bool isRootArray = (buf->Length() == context.GetInitialBufferOffset());		// it's a root array if we haven't started writing to the buffer yet
-	buf->cat('[');
+	enc.StartArray();
 
 	ReadLocker lock(Heap::heapLock);
 	const size_t count = ah.GetNumElements();
@@ -1126,17 +1044,17 @@ void ObjectModel::ReportHeapArrayAsJson(OutputBuffer *buf, ObjectExplorationCont
 				context.SetNextElement(i);
 				break;
 			}
-			buf->cat(',');
+			enc.ElementSeparator();
 		}
 		ExpressionValue element;
 		ah.GetElement(i, element);
-		ReportItemAsJson(buf, context, classDescriptor, element, filter);
+		ReportItemAsJson(enc, context, classDescriptor, element, filter);
 	}
 	if (isRootArray && context.GetNextElement() < 0)
 	{
 		context.SetNextElement(0);
 	}
-	buf->cat(']');
+	enc.EndArray();
 }
 
 // Find the requested entry
@@ -1195,7 +1113,7 @@ bool ObjectModelTableEntry::Matches(const char* filterString, const ObjectExplor
 }
 
 // Add the value of this element to the buffer, returning true if it matched and we did
-bool ObjectModelTableEntry::ReportAsJson(OutputBuffer* buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *classDescriptor, const ObjectModel *self, const char* filter, bool first) const THROWS(GCodeException)
+bool ObjectModelTableEntry::ReportAsJson(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ObjectModelClassDescriptor *classDescriptor, const ObjectModel *self, const char* filter, bool first) const THROWS(GCodeException)
 {
 	const char * nextElement = ObjectModel::GetNextElement(filter);
 	const ExpressionValue val = func(self, context);
@@ -1205,11 +1123,9 @@ bool ObjectModelTableEntry::ReportAsJson(OutputBuffer* buf, ObjectExplorationCon
 	{
 		if (*filter == 0)
 		{
-			buf->cat((first) ? "{\"" : ",\"");
-			buf->cat(name);
-			buf->cat("\":");
+			enc.Key(name, first);
 		}
-		self->ReportItemAsJson(buf, context, classDescriptor, val, nextElement);
+		self->ReportItemAsJson(enc, context, classDescriptor, val, nextElement);
 		return true;
 	}
 	return false;
@@ -1521,77 +1437,9 @@ decrease(strlen(idString))	// recursion variant
 	throw context.ConstructParseException("reached primitive type before end of selector string");
 }
 
-// Separate function to avoid the tm object (44 bytes) being allocated on the stack frame of a recursive function
-void ObjectModel::ReportDateTime(OutputBuffer *buf, const ExpressionValue& val) noexcept
-{
-	const time_t time = val.Get56BitValue();
-	tm timeInfo;
-	gmtime_r(&time, &timeInfo);
-	buf->catf("\"%04u-%02u-%02uT%02u:%02u:%02u\"",
-				timeInfo.tm_year + 1900, timeInfo.tm_mon + 1, timeInfo.tm_mday, timeInfo.tm_hour, timeInfo.tm_min, timeInfo.tm_sec);
-}
-
-// Separate function to avoid a recursive function saving all the FP registers
-void ObjectModel::ReportFloat(OutputBuffer *buf, const ExpressionValue& val) noexcept
-{
-	if (val.fVal == 0.0)
-	{
-		buf->cat('0');							// replace 0.000... in JSON by 0. This is mostly to save space when writing workplace coordinates.
-	}
-	else if (std::isnan(val.fVal) || std::isinf(val.fVal))
-	{
-		buf->cat("null");						// avoid generating bad JSON if the value is a NaN or infinity
-	}
-	else
-	{
-		buf->catf(val.GetFloatFormatString(), (double)val.fVal);
-	}
-}
-
-void ObjectModel::ReportBitmap1632Long(OutputBuffer *buf, const ExpressionValue& val) noexcept
-{
-	const auto bm = Bitmap<uint32_t>::MakeFromRaw(val.uVal);
-	buf->cat('[');
-	bm.Iterate
-		([buf](unsigned int bn, unsigned int count) noexcept
-			{
-				if (count != 0)
-				{
-					buf->cat(',');
-				}
-				buf->catf("%u", bn);
-			}
-		);
-	buf->cat(']');
-}
-
-void ObjectModel::ReportBitmap64Long(OutputBuffer *buf, const ExpressionValue& val) noexcept
-{
-	const auto bm = Bitmap<uint64_t>::MakeFromRaw(val.Get56BitValue());
-	buf->cat('[');
-	bm.Iterate
-		([buf](unsigned int bn, unsigned int count) noexcept
-			{
-				if (count != 0)
-				{
-					buf->cat(',');
-				}
-				buf->catf("%u", bn);
-			}
-		);
-	buf->cat(']');
-}
-
 #if SUPPORT_CAN_EXPANSION
 
-// Separate functions to avoid the string being allocated on the stack frame of a recursive function
-void ObjectModel::ReportExpansionBoardDetail(OutputBuffer *buf, const ExpressionValue& val) noexcept
-{
-	String<StringLength50> rslt;
-	val.ExtractRequestedPart(rslt.GetRef());
-	buf->catf("\"%.s\"", rslt.c_str());
-}
-
+// Separate function to avoid the string being allocated on the stack frame of a recursive function
 ExpressionValue ObjectModel::GetExpansionBoardDetailLength(const ExpressionValue& val) noexcept
 {
 	String<StringLength50> rslt;
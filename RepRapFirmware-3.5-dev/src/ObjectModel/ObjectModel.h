@@ -227,9 +227,16 @@ public:
 	bool ShouldIncludeNulls() const noexcept { return includeNulls; }
 	bool ShouldIncludeImportant() const noexcept { return includeImportant; }
 	bool TruncateLongArrays() const noexcept { return truncateLongArrays; }
+	bool AtTopLevel() const noexcept { return currentDepth == 1; }
 	uint64_t GetStartMillis() const { return startMillis; }
 	size_t GetInitialBufferOffset() const noexcept { return initialBufOffset; }
 
+	// Support for reporting only the parts of the object model that have changed since the client last fetched it
+	bool ReportChangesOnly() const noexcept { return changesOnly; }
+	uint32_t GetChangesSince() const noexcept { return changesSince; }
+	void SetKeyUnchanged(bool unchanged) noexcept { includeNonLive = !unchanged; }
+	bool StartChangesReport(uint32_t currentGeneration) noexcept;		// returns true if we must send a snapshot instead
+
 	bool ObsoleteFieldQueried() const noexcept { return obsoleteFieldQueried; }
 	void SetObsoleteFieldQueried() noexcept { obsoleteFieldQueried = true; }
 
@@ -246,6 +253,7 @@ private:
 	int nextElement;
 	size_t numIndicesProvided;						// the number of indices provided, when we are doing a value lookup
 	size_t numIndicesCounted;						// the number of indices passed in the search string
+	uint32_t changesSince;							// the object model generation that the client last fetched, if changesOnly is set
 	int32_t indices[MaxExpressionArrayIndices];
 	int line;
 	int column;
@@ -259,7 +267,8 @@ private:
 				excludeVerbose : 1,
 				excludeObsolete : 1,
 				obsoleteFieldQueried : 1,
-				truncateLongArrays : 1;
+				truncateLongArrays : 1,
+				changesOnly : 1;
 };
 
 // Entry to describe an array of objects or values. These must be brace-initializable into flash memory.
@@ -273,6 +282,33 @@ public:
 
 struct ObjectModelClassDescriptor;
 
+// The object model reporting functions write their output through this interface, so that the same functions can report the object model in JSON or CBOR format.
+// The reporting functions handle the filter, the flags and the structure of the model. The encoder handles the representation of the values, objects and arrays.
+class ObjectModelEncoder
+{
+public:
+	OutputBuffer *GetBuffer() const noexcept { return buf; }
+
+	virtual void Key(const char *_ecv_array name, bool first) noexcept = 0;			// start a member of an object. If it is the first member then start the object too.
+	virtual void EndObject() noexcept = 0;											// end an object that we started by calling Key
+	virtual void EmptyObject() noexcept = 0;
+	virtual void StartArray() noexcept = 0;
+	virtual void ElementSeparator() noexcept = 0;									// called before each element of an array except the first
+	virtual void EndArray() noexcept = 0;
+
+	virtual void Null() noexcept = 0;
+	virtual void Bool(bool b) noexcept = 0;
+	virtual void Uint(uint64_t val) noexcept = 0;
+	virtual void Int(int32_t val) noexcept = 0;
+	virtual void BitmapLong(uint64_t bits) noexcept = 0;							// report a bitmap as an array of the numbers of the bits that are set
+	virtual void Value(const ObjectExplorationContext& context, const ExpressionValue& val) noexcept = 0;	// report a value that is not an object, array or bitmap
+
+protected:
+	explicit ObjectModelEncoder(OutputBuffer *p_buf) noexcept : buf(p_buf) { }
+
+	OutputBuffer *buf;
+};
+
 // Class from which other classes that represent part of the object model are derived
 class ObjectModel
 {
@@ -283,14 +319,14 @@ public:
 	// Forwarding function so that we can make GetObjectModelArrayEntry() protected
 	const ObjectModelArrayTableEntry *FindObjectModelArrayEntry(unsigned int index) const noexcept { return GetObjectModelArrayEntry(index); }
 
-	// Construct a JSON representation of those parts of the object model requested by the user. This version is called only on the root of the tree.
-	void ReportAsJson(const GCodeBuffer *_ecv_null gb, OutputBuffer *buf, const char *_ecv_array filter, const char *_ecv_array reportFlags, bool wantArrayLength) const THROWS(GCodeException);
+	// Construct a JSON representation of those parts of the object model requested by the user, or a CBOR one if the encoder is a CborEncoder. This version is called only on the root of the tree.
+	void ReportAsJson(const GCodeBuffer *_ecv_null gb, ObjectModelEncoder& enc, const char *_ecv_array filter, const char *_ecv_array reportFlags, bool wantArrayLength) const THROWS(GCodeException);
 
 	// Get the value of an object via the table
 	ExpressionValue GetObjectValueUsingTableNumber(ObjectExplorationContext& context, const ObjectModelClassDescriptor * null classDescriptor, const char *_ecv_array idString, uint8_t tableNumber) const THROWS(GCodeException);
 
 	// Function to report a value or object as JSON. This does not need to handle 'var' or 'global' because those are checked for before this is called.
-	void ReportItemAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *classDescriptor,
+	void ReportItemAsJson(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ObjectModelClassDescriptor *classDescriptor,
 							const ExpressionValue& val, const char *_ecv_array filter) const THROWS(GCodeException);
 
 	// Skip the current element in the ID or filter string
@@ -299,13 +335,13 @@ public:
 protected:
 	// Construct a JSON representation of those parts of the object model requested by the user
 	// Overridden in class GlobalVariables
-	virtual void ReportAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor * null classDescriptor, uint8_t tableNumber, const char *_ecv_array filter) const THROWS(GCodeException);
+	virtual void ReportAsJson(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ObjectModelClassDescriptor * null classDescriptor, uint8_t tableNumber, const char *_ecv_array filter) const THROWS(GCodeException);
 
 	// Report an entire array as JSON
-	void ReportObjectModelArrayAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *null classDescriptor, const ObjectModelArrayTableEntry *entry, const char *_ecv_array filter) const THROWS(GCodeException);
+	void ReportObjectModelArrayAsJson(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ObjectModelClassDescriptor *null classDescriptor, const ObjectModelArrayTableEntry *entry, const char *_ecv_array filter) const THROWS(GCodeException);
 
 	// Report an entire array as JSON
-	void ReportHeapArrayAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *null classDescriptor, ArrayHandle ah, const char *_ecv_array filter) const THROWS(GCodeException);
+	void ReportHeapArrayAsJson(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ObjectModelClassDescriptor *null classDescriptor, ArrayHandle ah, const char *_ecv_array filter) const THROWS(GCodeException);
 
 	// Get the value of an object that we hold
 	ExpressionValue GetObjectValue(ObjectExplorationContext& context, const ObjectModelClassDescriptor *classDescriptor, const ExpressionValue& val, const char *_ecv_array idString) const THROWS(GCodeException);
@@ -326,17 +362,11 @@ protected:
 private:
 	// These functions have been separated from ReportItemAsJson to avoid high stack usage in the recursive functions, therefore they must not be inlined
 	// Report on a single item
-	__attribute__ ((noinline)) void ReportItemAsJsonFull(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *_ecv_null classDescriptor,
+	__attribute__ ((noinline)) void ReportItemAsJsonFull(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ObjectModelClassDescriptor *_ecv_null classDescriptor,
 															const ExpressionValue& val, const char *_ecv_array filter) const THROWS(GCodeException);
-	__attribute__ ((noinline)) void ReportArrayLengthAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ExpressionValue& val) const noexcept;
-	__attribute__ ((noinline)) static void ReportDateTime(OutputBuffer *buf, const ExpressionValue& val) noexcept;
-	__attribute__ ((noinline)) static void ReportFloat(OutputBuffer *buf, const ExpressionValue& val) noexcept;
-	__attribute__ ((noinline)) static void ReportBitmap1632Long(OutputBuffer *buf, const ExpressionValue& val) noexcept;
-	__attribute__ ((noinline)) static void ReportBitmap64Long(OutputBuffer *buf, const ExpressionValue& val) noexcept;
-	__attribute__ ((noinline)) static void ReportPinNameAsJson(OutputBuffer *buf, const ExpressionValue& val) noexcept;
+	__attribute__ ((noinline)) void ReportArrayLengthAsJson(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ExpressionValue& val) const noexcept;
 
 #if SUPPORT_CAN_EXPANSION
-	__attribute__ ((noinline)) static void ReportExpansionBoardDetail(OutputBuffer *buf, const ExpressionValue& val) noexcept;
 	__attribute__ ((noinline)) static ExpressionValue GetExpansionBoardDetailLength(const ExpressionValue& val) noexcept;
 #endif
 
@@ -346,12 +376,12 @@ private:
 // This function is recursive, so keep its stack usage low.
 // Most recursive calls are for non-array object values, so handle object values inline to reduce stack usage.
 // This saves about 240 bytes of stack space but costs 272 bytes of flash memory.
-inline void ObjectModel::ReportItemAsJson(OutputBuffer *buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *classDescriptor,
+inline void ObjectModel::ReportItemAsJson(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ObjectModelClassDescriptor *classDescriptor,
 											const ExpressionValue& val, const char *_ecv_array filter) const THROWS(GCodeException)
 {
 	if (context.WantArrayLength() && *filter == 0)
 	{
-		ReportArrayLengthAsJson(buf, context, val);
+		ReportArrayLengthAsJson(enc, context, val);
 	}
 	else if (val.GetType() == TypeCode::ObjectModel_tc)
 	{
@@ -359,7 +389,7 @@ inline void ObjectModel::ReportItemAsJson(OutputBuffer *buf, ObjectExplorationCo
 			|| val.omVal == nullptr					// OM arrays may contain null entries, so we need to handle them here
 		   )
 		{
-			buf->cat("null");
+			enc.Null();
 		}
 		else
 		{
@@ -367,12 +397,12 @@ inline void ObjectModel::ReportItemAsJson(OutputBuffer *buf, ObjectExplorationCo
 			{
 				++filter;
 			}
-			val.omVal->ReportAsJson(buf, context, (val.omVal == this) ? classDescriptor : nullptr, val.param, filter);
+			val.omVal->ReportAsJson(enc, context, (val.omVal == this) ? classDescriptor : nullptr, val.param, filter);
 		}
 	}
 	else
 	{
-		ReportItemAsJsonFull(buf, context, classDescriptor, val, filter);
+		ReportItemAsJsonFull(enc, context, classDescriptor, val, filter);
 	}
 }
 
@@ -406,7 +436,7 @@ public:
 	bool IsObsolete() const noexcept { return ((uint8_t)flags & (uint8_t)ObjectModelEntryFlags::obsolete) != 0; }
 
 	// See whether we should add the value of this element to the buffer, returning true if it matched the filter and we did add it
-	bool ReportAsJson(OutputBuffer* buf, ObjectExplorationContext& context, const ObjectModelClassDescriptor *classDescriptor, const ObjectModel *_ecv_from self, const char *_ecv_array filter, bool first) const THROWS(GCodeException);
+	bool ReportAsJson(ObjectModelEncoder& enc, ObjectExplorationContext& context, const ObjectModelClassDescriptor *classDescriptor, const ObjectModel *_ecv_from self, const char *_ecv_array filter, bool first) const THROWS(GCodeException);
 
 	// Return the name of this field
 	const char *_ecv_array  GetName() const noexcept { return name; }
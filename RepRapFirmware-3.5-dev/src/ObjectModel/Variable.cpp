@@ -76,38 +76,103 @@ void Variable::AssignIndexed(const ExpressionValue& ev, size_t numIndices, const
 	val.ahVal.AssignIndexed(ev, numIndices, indices);
 }
 
-Variable* VariableSet::Lookup(const char *str, bool wantParameter) noexcept
+// Calculate the hash of a variable name using the FNV-1a algorithm
+/*static*/ uint32_t VariableSet::HashName(const char *_ecv_array str, size_t length) noexcept
 {
-	LinkedVariable *lv;
-	for (lv = root; lv != nullptr; lv = lv->next)
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < length; ++i)
 	{
-		auto vname = lv->v.GetName();
-		if (strcmp(vname.Ptr(), str) == 0 && (wantParameter == (lv->v.GetScope() == -1)))
-		{
-			return &(lv->v);
-		}
+		hash = (hash ^ (uint8_t)str[i]) * 16777619u;
 	}
-	return nullptr;
+	return hash;
 }
 
-const Variable* VariableSet::Lookup(const char *str, size_t length, bool wantParameter) const noexcept
+bool VariableSet::LinkedVariable::Matches(const char *_ecv_array str, size_t length, uint32_t p_hash, bool wantParameter) const noexcept
 {
-	const LinkedVariable *lv;
-	for (lv = root; lv != nullptr; lv = lv->next)
+	if (hash != p_hash || wantParameter != (v.GetScope() == -1))
 	{
-		auto vname = lv->v.GetName();
-		if (strlen(vname.Ptr()) == length && memcmp(vname.Ptr(), str, length) == 0 && (wantParameter == (lv->v.GetScope() == -1)))
+		return false;
+	}
+	auto vname = v.GetName();
+	return strlen(vname.Ptr()) == length && memcmp(vname.Ptr(), str, length) == 0;
+}
+
+// Find the most recently created variable with the specified name
+const VariableSet::LinkedVariable *VariableSet::Find(const char *_ecv_array str, size_t length, bool wantParameter) const noexcept
+{
+	const uint32_t hash = HashName(str, length);
+	if (index.IsAllocated())
+	{
+		return index.Find(hash, [str, length, hash, wantParameter](const LinkedVariable *lv) noexcept -> bool { return lv->Matches(str, length, hash, wantParameter); });
+	}
+
+	for (const LinkedVariable *lv = root; lv != nullptr; lv = lv->next)
+	{
+		if (lv->Matches(str, length, hash, wantParameter))
 		{
-			return &(lv->v);
+			return lv;
 		}
 	}
 	return nullptr;
 }
 
+Variable* VariableSet::Lookup(const char *str, bool wantParameter) noexcept
+{
+	const LinkedVariable *const lv = Find(str, strlen(str), wantParameter);
+	return (lv == nullptr) ? nullptr : &(const_cast<LinkedVariable *>(lv)->v);
+}
+
+const Variable* VariableSet::Lookup(const char *str, size_t length, bool wantParameter) const noexcept
+{
+	const LinkedVariable *const lv = Find(str, length, wantParameter);
+	return (lv == nullptr) ? nullptr : &(lv->v);
+}
+
 void VariableSet::InsertNew(const char *str, ExpressionValue pVal, int16_t pScope) THROWS(GCodeException)
 {
 	LinkedVariable * const toInsert = new LinkedVariable(str, pVal, pScope, root);
 	root = toInsert;
+	++numVariables;
+	if (index.IsAllocated() && index.HasRoomFor(numVariables))
+	{
+		// Any existing variables with the same name and type are older than this one, so it must come before them in the probe sequence
+		const size_t length = strlen(str);
+		const bool isParameter = (pScope == -1);
+		index.Add(toInsert, [str, length, toInsert, isParameter](const LinkedVariable *lv) noexcept -> bool { return lv->Matches(str, length, toInsert->hash, isParameter); });
+	}
+	else if (numVariables >= MinVariablesToIndex)
+	{
+		RebuildIndex();
+	}
+}
+
+// Build the hash index from scratch, big enough for the set to double in size before we need to do this again
+void VariableSet::RebuildIndex() noexcept
+{
+	index.Allocate(numVariables);
+	for (LinkedVariable *lv = root; lv != nullptr; lv = lv->next)
+	{
+		index.Add(lv, [](const LinkedVariable *) noexcept -> bool { return false; });		// we add the variables most recent first, so no reordering is needed
+	}
+}
+
+// Remove a variable from the list and the index and delete it. 'prev' is the previous variable in the list, or nullptr if it is the first.
+void VariableSet::Unlink(LinkedVariable *lv, LinkedVariable * null prev) noexcept
+{
+	if (prev == nullptr)
+	{
+		root = lv->next;
+	}
+	else
+	{
+		prev->next = lv->next;
+	}
+	if (index.IsAllocated())
+	{
+		index.Remove(lv);
+	}
+	delete lv;
+	--numVariables;
 }
 
 // Remove all variables with a scope greater than the parameter
@@ -116,25 +181,16 @@ void VariableSet::EndScope(uint8_t blockNesting) noexcept
 	LinkedVariable *prev = nullptr;
 	for (LinkedVariable *lv = root; lv != nullptr; )
 	{
+		LinkedVariable *const next = lv->next;
 		if (lv->v.GetScope() > blockNesting)
 		{
-			LinkedVariable *temp = lv;
-			lv = lv->next;
-			if (prev == nullptr)
-			{
-				root = lv;
-			}
-			else
-			{
-				prev->next = lv;
-			}
-			delete temp;
+			Unlink(lv, prev);
 		}
 		else
 		{
 			prev = lv;
-			lv = lv->next;
 		}
+		lv = next;
 	}
 }
 
@@ -146,15 +202,7 @@ void VariableSet::Delete(const char *str) noexcept
 		auto vname = lv->v.GetName();
 		if (strcmp(vname.Ptr(), str) == 0)
 		{
-			if (prev == nullptr)
-			{
-				root = lv->next;
-			}
-			else
-			{
-				prev->next = lv->next;
-			}
-			delete lv;
+			Unlink(lv, prev);
 			break;
 		}
 		prev = lv;
@@ -163,12 +211,14 @@ void VariableSet::Delete(const char *str) noexcept
 
 void VariableSet::Clear() noexcept
 {
+	index.Release();
 	while (root != nullptr)
 	{
 		LinkedVariable *lv = root;
 		root = lv->next;
 		delete lv;
 	}
+	numVariables = 0;
 }
 
 VariableSet::~VariableSet()
@@ -181,7 +231,10 @@ void VariableSet::AssignFrom(VariableSet& other) noexcept
 {
 	Clear();
 	root = other.root;
+	index.TakeFrom(other.index);
+	numVariables = other.numVariables;
 	other.root = nullptr;
+	other.numVariables = 0;
 }
 
 void VariableSet::IterateWhile(function_ref_noexcept<bool(unsigned int, const Variable&) noexcept> func) const noexcept
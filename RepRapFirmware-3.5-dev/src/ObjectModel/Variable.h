@@ -14,6 +14,7 @@
 #include <ObjectModel/ObjectModel.h>
 #include <General/function_ref.h>
 #include <GCodes/GCodeException.h>
+#include "VariableIndex.h"
 
 // Class to represent a variable having a name and a value
 class Variable
@@ -35,11 +36,13 @@ private:
 };
 
 // Class to represent a collection of variables.
-// For now this is just a linked list, but it could be changed to a hash table for faster lookup and insertion.
+// The variables are held in a linked list with the most recently created one first. Each one caches the hash of its name, and when there are many variables
+// we also maintain an open-addressing hash index so that lookups don't need to scan the whole list.
+// All functions that modify the set are called with the write lock held if the set is shared, so they also maintain the hash index. Lookups never modify it.
 class VariableSet
 {
 public:
-	VariableSet() noexcept : root(nullptr) { }
+	VariableSet() noexcept : root(nullptr), numVariables(0) { }
 	~VariableSet();
 	VariableSet(const VariableSet&) = delete;
 	VariableSet& operator=(const VariableSet& other) = delete;
@@ -57,18 +60,31 @@ public:
 	void IterateWhile(function_ref_noexcept<bool(unsigned int index, const Variable& v) noexcept> func) const noexcept;
 
 private:
+	static constexpr size_t MinVariablesToIndex = 16;		// we only build a hash index when we have at least this number of variables
+
 	struct LinkedVariable
 	{
 		DECLARE_FREELIST_NEW_DELETE(LinkedVariable)
 
 		LinkedVariable(const char *_ecv_array str, ExpressionValue pVal, int16_t pScope, LinkedVariable *p_next) THROWS(GCodeException)
-			: next(p_next), v(str, pVal, pScope) {}
+			: next(p_next), hash(HashName(str, strlen(str))), v(str, pVal, pScope) {}
+
+		bool Matches(const char *_ecv_array str, size_t length, uint32_t p_hash, bool wantParameter) const noexcept;
 
 		LinkedVariable * null next;
+		uint32_t hash;										// hash of the variable name
 		Variable v;
 	};
 
+	static uint32_t HashName(const char *_ecv_array str, size_t length) noexcept;
+
+	const LinkedVariable * null Find(const char *_ecv_array str, size_t length, bool wantParameter) const noexcept;
+	void RebuildIndex() noexcept;
+	void Unlink(LinkedVariable *lv, LinkedVariable * null prev) noexcept;
+
 	LinkedVariable * null root;
+	VariableIndex<LinkedVariable> index;					// hash index of the variables, not allocated if we have too few variables to need one
+	size_t numVariables;
 };
 
 #endif /* SRC_GCODES_VARIABLE_H_ */
@@ -0,0 +1,132 @@
+/*
+ * VariableIndex.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Open-addressing hash index with linear probing, used by VariableSet to find variables without scanning its linked list.
+ * The index holds pointers to entries of type T, which must have a member 'uint32_t hash'. It does not own the entries.
+ * Entries with the same key are kept in the probe sequence in the order they were added, most recent first, so Find returns the most recent one.
+ * Removal uses backward shifting instead of tombstones, which keeps that order and means the index never needs to be rebuilt after removals.
+ * This has no dependencies on the rest of the firmware so that it can be tested on a host.
+ */
+
+#ifndef SRC_OBJECTMODEL_VARIABLEINDEX_H_
+#define SRC_OBJECTMODEL_VARIABLEINDEX_H_
+
+#include <ecv_duet3d.h>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+template<class T> class VariableIndex
+{
+public:
+	static constexpr size_t MinSize = 32;						// the minimum number of slots, must be a power of 2
+
+	VariableIndex() noexcept : slots(nullptr), size(0) { }
+	~VariableIndex() { Release(); }
+	VariableIndex(const VariableIndex&) = delete;
+	VariableIndex& operator=(const VariableIndex&) = delete;
+
+	bool IsAllocated() const noexcept { return slots != nullptr; }
+	bool HasRoomFor(size_t numEntries) const noexcept { return 2 * numEntries <= size; }		// we keep the index at most half full
+
+	// Allocate an empty index big enough for the number of entries to double before it needs to be enlarged
+	void Allocate(size_t numEntries) noexcept
+	{
+		Release();
+		size = MinSize;
+		while (size < 4 * numEntries)
+		{
+			size <<= 1;
+		}
+		slots = new T *[size];
+		for (size_t i = 0; i < size; ++i)
+		{
+			slots[i] = nullptr;
+		}
+	}
+
+	void Release() noexcept
+	{
+		delete[] slots;
+		slots = nullptr;
+		size = 0;
+	}
+
+	// Take over the index of another set, leaving it without one
+	void TakeFrom(VariableIndex& other) noexcept
+	{
+		Release();
+		std::swap(slots, other.slots);
+		std::swap(size, other.size);
+	}
+
+	// Return the first entry in the probe sequence for the hash that satisfies the predicate, or nullptr if there is none
+	template<class Pred> T *_ecv_null Find(uint32_t hash, Pred matches) const noexcept
+	{
+		const size_t mask = size - 1;
+		for (size_t slot = hash & mask; slots[slot] != nullptr; slot = (slot + 1) & mask)
+		{
+			if (matches(slots[slot]))
+			{
+				return slots[slot];
+			}
+		}
+		return nullptr;
+	}
+
+	// Add an entry, which must be more recent than any other entry with the same key. There must be room for it.
+	// 'sameKey' returns true for existing entries that have the same key as the new one. Each time we find one we put the entry we are adding in its slot
+	// and carry on adding the displaced one, so that entries with the same key stay in order. When adding entries most recent first there is no need
+	// for this, so 'sameKey' can always return false.
+	template<class Pred> void Add(T *entry, Pred sameKey) noexcept
+	{
+		const size_t mask = size - 1;
+		size_t slot = entry->hash & mask;
+		while (slots[slot] != nullptr)
+		{
+			if (sameKey(slots[slot]))
+			{
+				std::swap(entry, slots[slot]);
+			}
+			slot = (slot + 1) & mask;
+		}
+		slots[slot] = entry;
+	}
+
+	// Remove an entry, moving later entries in the same cluster back into the hole if their probe sequences allow it.
+	// An entry never moves past another one that started earlier in its probe sequence, so entries with the same key stay in order.
+	void Remove(const T *entry) noexcept
+	{
+		const size_t mask = size - 1;
+		size_t hole = entry->hash & mask;
+		while (slots[hole] != entry)
+		{
+			if (slots[hole] == nullptr)
+			{
+				return;											// not in the index
+			}
+			hole = (hole + 1) & mask;
+		}
+
+		for (size_t next = (hole + 1) & mask; slots[next] != nullptr; next = (next + 1) & mask)
+		{
+			// The entry in 'next' can fill the hole if the hole is not before its home slot
+			const size_t displacement = (next - (slots[next]->hash & mask)) & mask;
+			if (displacement >= ((next - hole) & mask))
+			{
+				slots[hole] = slots[next];
+				hole = next;
+			}
+		}
+		slots[hole] = nullptr;
+	}
+
+private:
+	T *_ecv_null *_ecv_null slots;								// the slots, or nullptr if the index is not allocated
+	size_t size;												// the number of slots, always a power of 2
+};
+
+#endif /* SRC_OBJECTMODEL_VARIABLEINDEX_H_ */
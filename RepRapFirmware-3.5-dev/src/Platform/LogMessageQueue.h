@@ -0,0 +1,150 @@
+/*
+ * LogMessageQueue.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Lock-free queue of variable length records, used by the asynchronous logger. Any number of tasks may add records at the same time and one task
+ * at a time removes them. A task that adds a record reserves space for it by advancing reserveIndex, copies its data in, then sets the committed flag
+ * in the record's control word. The consumer takes committed records in order, clears them and advances consumeIndex. Both indices increase without
+ * wrapping. If a record doesn't fit before the end of the buffer then the task that adds it also reserves the space up to the end and fills it with
+ * a padding record, so that the data of every record is contiguous.
+ * This class has no dependencies on the rest of the firmware, so that it can be tested on a host.
+ */
+
+#ifndef SRC_PLATFORM_LOGMESSAGEQUEUE_H_
+#define SRC_PLATFORM_LOGMESSAGEQUEUE_H_
+
+#include <ecv_duet3d.h>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <atomic>
+
+template<size_t Size> class LogMessageQueue
+{
+public:
+	static constexpr size_t Alignment = 8;									// the data of each record starts on this boundary, so the caller can store any type there
+	static constexpr size_t MaxDataLength = Size/4 - Alignment;				// the most data that one record can hold
+
+	LogMessageQueue() noexcept : reserveIndex(0), consumeIndex(0), dropped(0), maxUsed(0)
+	{
+		memset(buffer, 0, sizeof(buffer));									// records must be clear before they are reserved
+	}
+
+	// Reserve space for a record holding 'length' bytes of data and return a pointer to the data, or nullptr if the queue doesn't have room.
+	// The caller must fill in the data and then call Commit. May be called by any number of tasks at the same time.
+	void *_ecv_null Reserve(size_t length) noexcept pre(length <= MaxDataLength);
+
+	// Make a record that was returned by Reserve available to the consumer
+	void Commit(void *data) noexcept;
+
+	// Return the data of the oldest record if it has been committed, else nullptr. Only one task at a time may call this and Release.
+	const void *_ecv_null GetNext() noexcept;
+
+	// Discard the record whose data GetNext returned, making its space available again
+	void Release() noexcept;
+
+	uint32_t GetAndClearDropped() noexcept { return dropped.exchange(0); }
+	uint32_t GetAndClearMaxUsed() noexcept { return maxUsed.exchange(0); }
+
+private:
+	struct RecordControl
+	{
+		std::atomic<uint32_t> control;										// record length in bytes including this header, and flags
+		uint32_t length;													// record length in bytes including this header, set when the space is reserved
+	};
+
+	static constexpr uint32_t RecordCommitted = 0x80000000;
+	static constexpr uint32_t RecordPadding = 0x40000000;					// this record just fills the space at the end of the queue that was too small for the next one
+	static constexpr uint32_t RecordLengthMask = 0x0000FFFF;
+
+	static_assert(sizeof(RecordControl) == Alignment);
+	static_assert(Size % Alignment == 0 && Size <= RecordLengthMask + 1);
+
+	RecordControl *GetRecord(uint32_t index) noexcept { return reinterpret_cast<RecordControl *>(buffer + (index % Size)); }
+
+	std::atomic<uint32_t> reserveIndex;
+	std::atomic<uint32_t> consumeIndex;
+	std::atomic<uint32_t> dropped;											// the number of records we didn't have room for
+	std::atomic<uint32_t> maxUsed;											// the most space that was ever reserved, including padding
+	alignas(Alignment) char buffer[Size];
+};
+
+template<size_t Size> void *_ecv_null LogMessageQueue<Size>::Reserve(size_t length) noexcept
+{
+	const uint32_t recordLength = (sizeof(RecordControl) + length + (Alignment - 1)) & ~(uint32_t)(Alignment - 1);
+
+	// If there isn't room for the record before the end of the queue then we also reserve the space up to the end, and fill that with a padding record
+	uint32_t reserved = reserveIndex.load(std::memory_order_relaxed);
+	uint32_t spaceNeeded;
+	uint32_t queueUsed;
+	do
+	{
+		const uint32_t spaceToEnd = Size - (reserved % Size);
+		spaceNeeded = (recordLength <= spaceToEnd) ? recordLength : spaceToEnd + recordLength;
+		queueUsed = reserved + spaceNeeded - consumeIndex.load(std::memory_order_acquire);
+		if (queueUsed > Size)
+		{
+			++dropped;
+			return nullptr;
+		}
+	} while (!reserveIndex.compare_exchange_weak(reserved, reserved + spaceNeeded, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+	uint32_t previousMax = maxUsed.load(std::memory_order_relaxed);
+	while (queueUsed > previousMax && !maxUsed.compare_exchange_weak(previousMax, queueUsed, std::memory_order_relaxed)) { }
+
+	if (spaceNeeded != recordLength)
+	{
+		const uint32_t paddingLength = spaceNeeded - recordLength;
+		GetRecord(reserved)->control.store(paddingLength | RecordPadding | RecordCommitted, std::memory_order_release);
+		reserved += paddingLength;
+	}
+
+	RecordControl * const rec = GetRecord(reserved);
+	rec->length = recordLength;
+	return rec + 1;
+}
+
+template<size_t Size> void LogMessageQueue<Size>::Commit(void *data) noexcept
+{
+	RecordControl * const rec = static_cast<RecordControl *>(data) - 1;
+	rec->control.store(rec->length | RecordCommitted, std::memory_order_release);
+}
+
+template<size_t Size> const void *_ecv_null LogMessageQueue<Size>::GetNext() noexcept
+{
+	for (;;)
+	{
+		const uint32_t consumed = consumeIndex.load(std::memory_order_relaxed);
+		if (consumed == reserveIndex.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+
+		RecordControl * const rec = GetRecord(consumed);
+		const uint32_t control = rec->control.load(std::memory_order_acquire);
+		if ((control & RecordCommitted) == 0)
+		{
+			return nullptr;													// the task that reserved this record is still writing it
+		}
+		if ((control & RecordPadding) == 0)
+		{
+			return rec + 1;
+		}
+		Release();
+	}
+}
+
+template<size_t Size> void LogMessageQueue<Size>::Release() noexcept
+{
+	const uint32_t consumed = consumeIndex.load(std::memory_order_relaxed);
+	RecordControl * const rec = GetRecord(consumed);
+	const uint32_t recordLength = rec->control.load(std::memory_order_relaxed) & RecordLengthMask;
+
+	// Clear the record so that it isn't mistaken for a committed one when the space is reused, then release the space
+	memset(static_cast<void *>(rec), 0, recordLength);
+	consumeIndex.store(consumed + recordLength, std::memory_order_release);
+}
+
+#endif /* SRC_PLATFORM_LOGMESSAGEQUEUE_H_ */
@@ -14,6 +14,20 @@
 #include "Platform.h"
 #include "Version.h"
 
+#if SUPPORT_ASYNC_LOGGER
+# include "TaskPriorities.h"
+# include <AppNotifyIndices.h>
+
+constexpr size_t LoggerTaskStackWords = 400;		// the task calls FatFs to write and flush the file, and formats the date and time
+
+static Task<LoggerTaskStackWords> *_ecv_null loggerTask = nullptr;
+
+extern "C" [[noreturn]] void LoggerTaskStart(void *param) noexcept
+{
+	static_cast<Logger *>(param)->TaskLoop();
+}
+#endif
+
 // Simple lock class that sets a variable true when it is created and makes sure it gets set false when it falls out of scope
 class Lock
 {
@@ -26,7 +40,17 @@ private:
 };
 
 Logger::Logger(LogLevel logLvl) noexcept : logFile(), lastFlushTime(0), lastFlushFileSize(0), dirty(false), inLogger(false), logLevel(logLvl)
+#if SUPPORT_ASYNC_LOGGER
+	, messagesTruncated(0), messagesWritten(0), flushInterval(LogFlushInterval)
+#endif
 {
+#if SUPPORT_ASYNC_LOGGER
+	writeMutex.Create("Logger");
+
+	// There is only ever one logger, so we create its task here
+	loggerTask = new Task<LoggerTaskStackWords>();
+	loggerTask->Create(LoggerTaskStart, "LOGGER", this, TaskPriority::LoggerPriority);
+#endif
 }
 
 GCodeResult Logger::Start(time_t time, const StringRef& filename, const StringRef& reply) noexcept
@@ -34,6 +58,9 @@ GCodeResult Logger::Start(time_t time, const StringRef& filename, const StringRe
 	if (!inLogger && logLevel > LogLevel::off)
 	{
 		Lock loggerLock(inLogger);
+#if SUPPORT_ASYNC_LOGGER
+		MutexLocker lock(writeMutex);
+#endif
 		FileStore * const f = reprap.GetPlatform().OpenSysFile(filename.c_str(), OpenMode::append);
 		if (f == nullptr)
 		{
@@ -82,6 +109,10 @@ void Logger::Stop(time_t time) noexcept
 	{
 		Lock loggerLock(inLogger);
 		InternalLogMessage(time, "Event logging stopped\n", MessageLogLevel::info);
+#if SUPPORT_ASYNC_LOGGER
+		MutexLocker lock(writeMutex);
+		WriteQueuedMessages();
+#endif
 		logFile.Close();
 		reprap.StateUpdated();
 	}
@@ -107,7 +138,17 @@ bool Logger::IsLoggingEnabledFor(const MessageType mt) const noexcept
 
 void Logger::LogMessage(time_t time, const char *message, MessageType type) noexcept
 {
-
+#if SUPPORT_ASYNC_LOGGER
+	// Queuing the message doesn't do any file I/O so we don't need to check inLogger. This lets us log messages generated while writing to the file.
+	if (logFile.IsLive() && !IsEmptyMessage(message))
+	{
+		const auto messageLogLevel = GetMessageLogLevel(type);
+		if (IsLoggingEnabledFor(messageLogLevel))
+		{
+			QueueMessage(time, messageLogLevel, message, nullptr);
+		}
+	}
+#else
 	if (logFile.IsLive() && !inLogger && !IsEmptyMessage(message))
 	{
 		const auto messageLogLevel = GetMessageLogLevel(type);
@@ -118,10 +159,21 @@ void Logger::LogMessage(time_t time, const char *message, MessageType type) noex
 		Lock loggerLock(inLogger);
 		InternalLogMessage(time, message, messageLogLevel);
 	}
+#endif
 }
 
 void Logger::LogMessage(time_t time, OutputBuffer *buf, MessageType type) noexcept
 {
+#if SUPPORT_ASYNC_LOGGER
+	if (logFile.IsLive() && !IsEmptyMessage(buf->Data()))
+	{
+		const auto messageLogLevel = GetMessageLogLevel(type);
+		if (IsLoggingEnabledFor(messageLogLevel))
+		{
+			QueueMessage(time, messageLogLevel, nullptr, buf);
+		}
+	}
+#else
 	if (logFile.IsLive() && !inLogger && !IsEmptyMessage(buf->Data()))
 	{
 		const auto messageLogLevel = GetMessageLogLevel(type);
@@ -130,7 +182,7 @@ void Logger::LogMessage(time_t time, OutputBuffer *buf, MessageType type) noexce
 			return;
 		}
 		Lock loggerLock(inLogger);
-		bool ok = WriteDateTimeAndLogLevelPrefix(time, messageLogLevel);
+		bool ok = WriteDateTimeAndLogLevelPrefix(time, (uint32_t)(millis64()/1000u), messageLogLevel);
 		if (ok)
 		{
 			ok = buf->WriteToFile(logFile);
@@ -146,12 +198,16 @@ void Logger::LogMessage(time_t time, OutputBuffer *buf, MessageType type) noexce
 			reprap.StateUpdated();
 		}
 	}
+#endif
 }
 
 // Version of LogMessage for when we already know we want to proceed and we have already set inLogger
 void Logger::InternalLogMessage(time_t time, const char *message, const MessageLogLevel messageLogLevel) noexcept
 {
-	bool ok = WriteDateTimeAndLogLevelPrefix(time, messageLogLevel);
+#if SUPPORT_ASYNC_LOGGER
+	QueueMessage(time, messageLogLevel, message, nullptr);
+#else
+	bool ok = WriteDateTimeAndLogLevelPrefix(time, (uint32_t)(millis64()/1000u), messageLogLevel);
 	if (ok)
 	{
 		const size_t len = strlen(message);
@@ -174,11 +230,21 @@ void Logger::InternalLogMessage(time_t time, const char *message, const MessageL
 		logFile.Close();
 		reprap.StateUpdated();
 	}
+#endif
 }
 
 // This is called regularly by Platform to give the logger an opportunity to flush the file buffer
 void Logger::Flush(bool forced) noexcept
 {
+#if SUPPORT_ASYNC_LOGGER
+	// The logger task flushes the file when it is due, so we only need to do anything if a flush is forced
+	if (forced)
+	{
+		MutexLocker lock(writeMutex);
+		WriteQueuedMessages();
+		FlushFile(true);
+	}
+#else
 	if (logFile.IsLive() && dirty && !inLogger)
 	{
 		// Log file is dirty and can be flushed.
@@ -197,17 +263,17 @@ void Logger::Flush(bool forced) noexcept
 			dirty = false;
 		}
 	}
+#endif
 }
 
 // Write the data, time and message log level to the file followed by a space.
-// Caller must already have checked and set inLogger.
-bool Logger::WriteDateTimeAndLogLevelPrefix(time_t time, MessageLogLevel messageLogLevel) noexcept
+// Caller must already have checked and set inLogger, or own writeMutex if using the asynchronous logger.
+bool Logger::WriteDateTimeAndLogLevelPrefix(time_t time, uint32_t timeSincePowerUp, MessageLogLevel messageLogLevel) noexcept
 {
 	String<StringLength50> bufferSpace;
 	const StringRef buf = bufferSpace.GetRef();
 	if (time == 0)
 	{
-		const uint32_t timeSincePowerUp = (uint32_t)(millis64()/1000u);
 		buf.printf("power up + %02" PRIu32 ":%02" PRIu32 ":%02" PRIu32 " ", timeSincePowerUp/3600u, (timeSincePowerUp % 3600u)/60u, timeSincePowerUp % 60u);
 	}
 	else
@@ -221,6 +287,134 @@ bool Logger::WriteDateTimeAndLogLevelPrefix(time_t time, MessageLogLevel message
 	return logFile.Write(buf.c_str());
 }
 
+#if SUPPORT_ASYNC_LOGGER
+
+// Add a message to the queue. This may be called by any task, so it must not do any file I/O. Exactly one of 'message' and 'buf' must be non-null.
+void Logger::QueueMessage(time_t time, MessageLogLevel messageLogLevel, const char *_ecv_array null message, const OutputBuffer *null buf) noexcept
+{
+	size_t messageLength = 0;
+	if (message != nullptr)
+	{
+		messageLength = strlen(message);
+	}
+	else
+	{
+		for (const OutputBuffer *b = buf; b != nullptr; b = b->Next())
+		{
+			messageLength += b->DataLength();
+		}
+	}
+	if (messageLength > MaxMessageLength)
+	{
+		messageLength = MaxMessageLength;
+		++messagesTruncated;
+	}
+
+	MessageHeader * const rec = static_cast<MessageHeader *>(queue.Reserve(sizeof(MessageHeader) + messageLength));
+	if (rec == nullptr)
+	{
+		return;										// the queue is full, so the message is dropped
+	}
+
+	rec->time = time;
+	rec->secondsSincePowerUp = (uint32_t)(millis64()/1000u);
+	rec->messageLength = (uint16_t)messageLength;
+	rec->level = messageLogLevel.ToBaseType();
+	char *_ecv_array const dst = reinterpret_cast<char *_ecv_array>(rec + 1);
+	if (message != nullptr)
+	{
+		memcpy(dst, message, messageLength);
+	}
+	else
+	{
+		size_t copied = 0;
+		for (const OutputBuffer *b = buf; b != nullptr && copied < messageLength; b = b->Next())
+		{
+			const size_t toCopy = min<size_t>(b->DataLength(), messageLength - copied);
+			memcpy(dst + copied, b->Data(), toCopy);
+			copied += toCopy;
+		}
+	}
+	queue.Commit(rec);
+
+	if (loggerTask != nullptr)
+	{
+		loggerTask->Give(NotifyIndices::Logger);
+	}
+}
+
+// Write committed records to the file in order, stopping at the first one that hasn't been committed yet. Caller must own writeMutex.
+// If the file isn't open then we discard the records.
+void Logger::WriteQueuedMessages() noexcept
+{
+	bool ok = true;
+	const MessageHeader *_ecv_null rec;
+	while ((rec = static_cast<const MessageHeader *>(queue.GetNext())) != nullptr)
+	{
+		// If a task has reserved a record but not yet committed it then GetNext returns null, and we will be woken up again when the task has finished
+		if (ok && logFile.IsLive())
+		{
+			const char *_ecv_array const message = reinterpret_cast<const char *_ecv_array>(rec + 1);
+			const size_t messageLength = rec->messageLength;
+			ok = WriteDateTimeAndLogLevelPrefix(rec->time, rec->secondsSincePowerUp, (MessageLogLevel)rec->level)
+				&& (messageLength == 0 || logFile.Write(message, messageLength))
+				&& ((messageLength != 0 && message[messageLength - 1] == '\n') || logFile.Write('\n'));
+			if (ok)
+			{
+				dirty = true;
+				++messagesWritten;
+			}
+			else
+			{
+				logFile.Close();
+				reprap.StateUpdated();
+			}
+		}
+		queue.Release();
+	}
+}
+
+// Flush the file if it is due. FatFs only writes whole sectors until we flush the file, so writes to the card are already batched.
+// Caller must own writeMutex.
+void Logger::FlushFile(bool forced) noexcept
+{
+	if (logFile.IsLive() && dirty)
+	{
+		// To avoid excessive disk write operations, flush the file only if one of the following is true:
+		// 1. We have possibly allocated a new cluster since the last flush. To avoid lost clusters if we power down before flushing,
+		//    we should flush early in this case. Rather than determine the cluster size, we flush if we have started a new 512-byte sector.
+		// 2. If it hasn't been flushed for flushInterval milliseconds.
+		const FilePosition currentPos = logFile.GetPosition();
+		if (forced || millis() - lastFlushTime >= flushInterval || currentPos/512 != lastFlushFileSize/512)
+		{
+			logFile.Flush();
+			lastFlushTime = millis();
+			lastFlushFileSize = currentPos;
+			dirty = false;
+		}
+	}
+}
+
+// Logger task. Write queued messages whenever we are woken up, and flush the file when it is due.
+[[noreturn]] void Logger::TaskLoop() noexcept
+{
+	for (;;)
+	{
+		(void)TaskBase::TakeIndexed(NotifyIndices::Logger, flushInterval);
+		MutexLocker lock(writeMutex);
+		WriteQueuedMessages();
+		FlushFile(false);
+	}
+}
+
+void Logger::Diagnostics(MessageType mtype) noexcept
+{
+	reprap.GetPlatform().MessageF(mtype, "Logger: messages written %" PRIu32 ", dropped %" PRIu32 ", truncated %" PRIu32 ", max queue used %" PRIu32 " of %u bytes\n",
+									messagesWritten.exchange(0), queue.GetAndClearDropped(), messagesTruncated.exchange(0), queue.GetAndClearMaxUsed(), (unsigned int)QueueSize);
+}
+
+#endif
+
 #endif
 
 // End
@@ -15,6 +15,11 @@
 #include <ctime>
 #include <Storage/FileData.h>
 
+#if SUPPORT_ASYNC_LOGGER
+# include <RTOSIface/RTOSIface.h>
+# include "LogMessageQueue.h"
+#endif
+
 class OutputBuffer;
 
 class Logger
@@ -31,6 +36,12 @@ public:
 	const char *GetFileName() const noexcept { return (IsActive()) ? logFileName.c_str() : nullptr; }
 	LogLevel GetLogLevel() const noexcept { return logLevel; }
 	void SetLogLevel(LogLevel newLogLevel) noexcept;
+#if SUPPORT_ASYNC_LOGGER
+	void SetFlushInterval(uint32_t ms) noexcept { flushInterval = ms; }
+	uint32_t GetFlushInterval() const noexcept { return flushInterval; }
+	void Diagnostics(MessageType mtype) noexcept;
+	[[noreturn]] void TaskLoop() noexcept;
+#endif
 #if 0 // Currently not needed but might be useful in the future
 	bool IsLoggingEnabledFor(const MessageType mt) const noexcept;
 	bool IsWarnEnabled() const noexcept { return logLevel >= LogLevel::warn; }
@@ -44,7 +55,7 @@ private:
 
 	static const uint8_t LogEnabledThreshold = 3;
 
-	bool WriteDateTimeAndLogLevelPrefix(time_t time, MessageLogLevel messageLogLevel) noexcept;
+	bool WriteDateTimeAndLogLevelPrefix(time_t time, uint32_t secondsSincePowerUp, MessageLogLevel messageLogLevel) noexcept;
 	void InternalLogMessage(time_t time, const char *message, const MessageLogLevel messageLogLevel) noexcept;
 	bool IsLoggingEnabledFor(const MessageLogLevel mll) const noexcept { return (mll < MessageLogLevel::off) && (mll.ToBaseType() + logLevel.ToBaseType() >= LogEnabledThreshold); }
 	void LogFirmwareInfo(time_t time) noexcept;
@@ -57,6 +68,36 @@ private:
 	bool dirty;
 	bool inLogger;
 	LogLevel logLevel;
+
+#if SUPPORT_ASYNC_LOGGER
+	// Messages are queued by the tasks that log them and written to the file by the logger task
+	struct MessageHeader
+	{
+		time_t time;									// the time when the message was logged, or zero if we didn't know the time
+		uint32_t secondsSincePowerUp;
+		uint16_t messageLength;
+		uint8_t level;
+	};
+
+# if SAME70
+	static constexpr size_t QueueSize = 8192;
+# else
+	static constexpr size_t QueueSize = 4096;
+# endif
+	typedef LogMessageQueue<QueueSize> MessageQueue;
+	static constexpr size_t MaxMessageLength = MessageQueue::MaxDataLength - sizeof(MessageHeader);	// longer messages are truncated
+	static_assert(alignof(MessageHeader) <= MessageQueue::Alignment);
+
+	void QueueMessage(time_t time, MessageLogLevel messageLogLevel, const char *_ecv_array null message, const OutputBuffer *null buf) noexcept;
+	void WriteQueuedMessages() noexcept;
+	void FlushFile(bool forced) noexcept;
+
+	Mutex writeMutex;									// held by whoever is writing queued messages to the file
+	std::atomic<uint32_t> messagesTruncated;			// these counters are atomic because M122 reads and clears them while other tasks update them
+	std::atomic<uint32_t> messagesWritten;
+	uint32_t flushInterval;
+	MessageQueue queue;
+#endif
 };
 
 #endif
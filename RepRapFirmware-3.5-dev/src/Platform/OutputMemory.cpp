@@ -52,6 +52,13 @@ void OutputBuffer::IncreaseReferences(size_t refs) noexcept
 	}
 }
 
+void OutputBuffer::AddReference() noexcept
+{
+	TaskCriticalSectionLocker lock;
+	++references;
+	isReferenced = true;
+}
+
 size_t OutputBuffer::Length() const noexcept
 {
 	size_t totalLength = 0;
@@ -473,6 +480,21 @@ bool OutputBuffer::WriteToFile(FileData& f) const noexcept
 	}
 }
 
+/*static */ void OutputBuffer::ReleaseReference(OutputBuffer *buf) noexcept
+{
+	TaskCriticalSectionLocker lock;
+	if (buf->references > 1)
+	{
+		buf->references--;
+	}
+	else
+	{
+		buf->next = freeOutputBuffers;
+		freeOutputBuffers = buf;
+		usedOutputBuffers--;
+	}
+}
+
 /*static*/ void OutputBuffer::Diagnostics(MessageType mtype) noexcept
 {
 	reprap.GetPlatform().MessageF(mtype, "Used output buffers: %d of %d (%d max)\n",
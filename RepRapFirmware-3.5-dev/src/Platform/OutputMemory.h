@@ -29,6 +29,7 @@ public:
 	bool IsReferenced() const noexcept { return isReferenced; }
 	bool HadOverflow() const noexcept { return hadOverflow; }
 	void IncreaseReferences(size_t refs) noexcept;
+	void AddReference() noexcept;								// Add a reference to this buffer but not to the rest of its chain
 
 	const char *_ecv_array Data() const noexcept { return data; }
 	const char *_ecv_array UnreadData() const noexcept { return data + bytesRead; }
@@ -88,6 +89,9 @@ public:
 	// Release all OutputBuffer objects in a chain
 	static void ReleaseAll(OutputBuffer * volatile &buf) noexcept;
 
+	// Release a reference to one OutputBuffer that was added by AddReference. Unlike Release, this doesn't reset the read pointer if other references remain.
+	static void ReleaseReference(OutputBuffer *buf) noexcept;
+
 	static void Diagnostics(MessageType mtype) noexcept;
 
 	static unsigned int GetFreeBuffers() noexcept { return OUTPUT_BUFFER_COUNT - usedOutputBuffers; }
@@ -1827,6 +1827,12 @@ void Platform::Diagnostics(MessageType mtype) noexcept
 
 	Heap::Diagnostics(mtype, *this);
 	Event::Diagnostics(mtype, *this);
+#if SUPPORT_ASYNC_LOGGER
+	if (logger != nullptr)
+	{
+		logger->Diagnostics(mtype);
+	}
+#endif
 
 	// Show the motor position and stall status
 	for (size_t drive = 0; drive < NumDirectDrivers; ++drive)
@@ -2360,7 +2366,8 @@ GCodeResult Platform::DiagnosticTest(GCodeBuffer& gb, const StringRef& reply, Ou
 			now1 &= 0x00FFFFFF;
 			now2 &= 0x00FFFFFF;
 			uint32_t tim1 = ((now1 > now2) ? now1 : now1 + (SysTick->LOAD & 0x00FFFFFF) + 1) - now2;
-			reply.printf("CRC of %u bytes took %.2fus", length, (double)((1'000'000.0f * (float)tim1)/(float)SystemCoreClock));
+			const float microseconds = (1'000'000.0f * (float)tim1)/(float)SystemCoreClock;
+			reply.printf("CRC of %u bytes took %.2fus (%.1fMB/s)", length, (double)microseconds, (double)((float)length/microseconds));
 		}
 		break;
 
@@ -2416,6 +2423,17 @@ GCodeResult Platform::DiagnosticTest(GCodeBuffer& gb, const StringRef& reply, Ou
 		break;
 #endif
 
+#if SUPPORT_MOVE_PREP_PROFILING
+	case (unsigned int)DiagnosticTestType::PrintMovePrepTimings:
+		reprap.GetMove().GetPrepProfiler().Diagnostics(gb.GetResponseMessageType(), true);
+		break;
+
+	case (unsigned int)DiagnosticTestType::ResetMovePrepTimings:
+		MovePrepProfiler::Reset();
+		reply.copy("Move preparation timings cleared");
+		break;
+#endif
+
 #ifdef DUET_NG
 	case (unsigned int)DiagnosticTestType::PrintExpanderStatus:
 		reply.printf("Expander status %04X\n", DuetExpansion::DiagnosticRead());
@@ -3661,6 +3679,12 @@ GCodeResult Platform::ConfigureLogging(GCodeBuffer& gb, const StringRef& reply)
 			{
 				logger->SetLogLevel(logLevel);
 			}
+#if SUPPORT_ASYNC_LOGGER
+			if (gb.Seen('F'))
+			{
+				logger->SetFlushInterval(lrintf(gb.GetLimitedFValue('F', 0.1, 3600.0) * 1000.0));		// F is the flush interval in seconds
+			}
+#endif
 
 			char buf[MaxFilenameLength + 1];
 			StringRef filename(buf, ARRAY_SIZE(buf));
@@ -3685,6 +3709,9 @@ GCodeResult Platform::ConfigureLogging(GCodeBuffer& gb, const StringRef& reply)
 		{
 			const auto logLevel = logger->GetLogLevel();
 			reply.printf("Event logging is enabled at log level %s", logLevel.ToString());
+#if SUPPORT_ASYNC_LOGGER
+			reply.catf(", flush interval %.1fs", (double)(logger->GetFlushInterval() * 0.001));
+#endif
 		}
 	}
 	return GCodeResult::ok;
@@ -168,6 +168,8 @@ enum class DiagnosticTestType : unsigned int
 	TimeCRC32 = 107,				// time how long it takes to calculate CRC32
 	TimeGetTimerTicks = 108,		// time now long it takes to read the step clock
 	UndervoltageEvent = 109,		// pretend an undervoltage condition has occurred
+	PrintMovePrepTimings = 110,		// print the move preparation timing histograms
+	ResetMovePrepTimings = 111,		// clear the move preparation timing histograms
 
 	SetWriteBuffer = 500,			// enable/disable the write buffer
 
@@ -51,6 +51,11 @@
 # include <SBC/SbcInterface.h>
 #endif
 
+#include <ObjectModel/JsonEncoder.h>
+#if SUPPORT_OBJECT_MODEL_CBOR
+# include <ObjectModel/CborEncoder.h>
+#endif
+
 #ifdef DUET3_ATE
 # include <Duet3Ate.h>
 #endif
@@ -444,6 +449,7 @@ DEFINE_GET_OBJECT_MODEL_TABLE(RepRap)
 RepRap::RepRap() noexcept
 	: boardsSeq(0), directoriesSeq(0), fansSeq(0), heatSeq(0), inputsSeq(0), jobSeq(0), ledStripsSeq(0), moveSeq(0), globalSeq(0),
 	  networkSeq(0), scannerSeq(0), sensorsSeq(0), spindlesSeq(0), stateSeq(0), toolsSeq(0), volumesSeq(0),
+	  modelGeneration(0), startGeneration(0), keyGenerations{0},
 	  lastWarningMillis(0),
 	  ticksInSpinState(0), heatTaskIdleTicks(0),
 	  beepFrequency(0), beepDuration(0), beepTimer(0),
@@ -519,6 +525,19 @@ void RepRap::Init() noexcept
 #endif
 
 	platform->Init();
+
+	// Start the object model generation numbers at a random value, so that a client that kept a generation number from before we restarted gets a snapshot
+#if MCU_HAS_UNIQUE_ID
+	startGeneration = platform->Random();
+#else
+	startGeneration = StepTimer::GetTimerTicks();
+#endif
+	modelGeneration = startGeneration;
+	for (uint32_t& g : keyGenerations)
+	{
+		g = startGeneration;
+	}
+
 	network->Init();
 	SetName(DEFAULT_MACHINE_NAME);		// Network must be initialised before calling this because this calls SetHostName
 	gCodes->Init();						// must be called before Move::Init
@@ -1880,8 +1899,8 @@ OutputBuffer *RepRap::GetFilesResponse(const char *dir, unsigned int startAt, bo
 	{
 		err = 0;
 		FileInfo fileInfo;
-		unsigned int filesFound = 0;
-		bool gotFile = MassStorage::FindFirst(dir, fileInfo);
+		unsigned int filesFound = startAt;
+		bool gotFile = MassStorage::FindFirstFrom(dir, fileInfo, filesFound);	// this may resume where the previous page of the listing stopped
 
 		size_t bytesLeft = OutputBuffer::GetBytesLeft(response);	// don't write more bytes than we can
 
@@ -1895,7 +1914,7 @@ OutputBuffer *RepRap::GetFilesResponse(const char *dir, unsigned int startAt, bo
 					if (bytesLeft < fileInfo.fileName.strlen() * 2 + 20)
 					{
 						// No more space available - stop here
-						MassStorage::AbandonFindNext();
+						MassStorage::SaveFindPosition(dir, fileInfo, filesFound);
 						nextFile = filesFound;
 						break;
 					}
@@ -1959,8 +1978,8 @@ OutputBuffer *RepRap::GetFilelistResponse(const char *dir, unsigned int startAt)
 	{
 		err = 0;
 		FileInfo fileInfo;
-		unsigned int filesFound = 0;
-		bool gotFile = MassStorage::FindFirst(dir, fileInfo);
+		unsigned int filesFound = startAt;
+		bool gotFile = MassStorage::FindFirstFrom(dir, fileInfo, filesFound);	// this may resume where the previous page of the listing stopped
 		size_t bytesLeft = OutputBuffer::GetBytesLeft(response);	// don't write more bytes than we can
 
 		while (gotFile)
@@ -1973,7 +1992,7 @@ OutputBuffer *RepRap::GetFilelistResponse(const char *dir, unsigned int startAt)
 					if (bytesLeft < fileInfo.fileName.strlen() * 2 + 50)
 					{
 						// No more space available - stop here
-						MassStorage::AbandonFindNext();
+						MassStorage::SaveFindPosition(dir, fileInfo, filesFound);
 						nextFile = filesFound;
 						break;
 					}
@@ -2295,9 +2314,46 @@ void RepRap::AppendStringArray(OutputBuffer *buf, const char *name, size_t numVa
 	buf->cat(']');
 }
 
+// Names of the root keys whose generation numbers we track, in the same order as enum ModelKey
+const char *_ecv_array const RepRap::ModelKeyNames[(size_t)ModelKey::numKeys] =
+{
+	"boards", "directories", "fans", "global", "heat", "inputs", "job", "ledStrips", "move", "network", "scanner", "sensors", "spindles", "state", "tools", "volumes"
+};
+
+// Record that the non-live values of a root key have changed. This is called from many tasks, so the increment and store must not be interrupted.
+void RepRap::KeyUpdated(ModelKey key) noexcept
+{
+	AtomicCriticalSectionLocker lock;
+	const uint32_t gen = modelGeneration + 1;
+	modelGeneration = gen;
+	keyGenerations[(size_t)key] = gen;
+}
+
+// Return true if a generation number that a client sent us was issued by us since we started, given the current generation.
+// Generation numbers start at a random value and may wrap round, so we compare their offsets from the starting value.
+bool RepRap::IsGenerationSinceStart(uint32_t gen, uint32_t currentGeneration) const noexcept
+{
+	return gen - startGeneration <= currentGeneration - startGeneration;
+}
+
+// Return true if the non-live values of a root key have changed since the specified generation, which the caller has checked was issued since we started.
+// Other root keys such as 'limits' hold only values that are fixed at startup, so they never change.
+bool RepRap::KeyChangedSince(const char *_ecv_array key, uint32_t gen) const noexcept
+{
+	for (size_t i = 0; i < (size_t)ModelKey::numKeys; ++i)
+	{
+		if (strcmp(key, ModelKeyNames[i]) == 0)
+		{
+			return keyGenerations[i] - startGeneration > gen - startGeneration;
+		}
+	}
+	return false;
+}
+
 // Return a query into the object model, or return nullptr if no buffer available
 // We append a newline to help PanelDue resync after receiving corrupt or incomplete data. DWC ignores it.
-OutputBuffer *RepRap::GetModelResponse(const GCodeBuffer *_ecv_null gb, const char *key, const char *flags) const THROWS(GCodeException)
+// If CBOR is requested then the response is a CBOR map with the same members as the JSON object.
+OutputBuffer *RepRap::GetModelResponse(const GCodeBuffer *_ecv_null gb, const char *key, const char *flags, bool wantCbor) const THROWS(GCodeException)
 {
 	OutputBuffer *outBuf;
 	if (OutputBuffer::Allocate(outBuf))
@@ -2305,7 +2361,22 @@ OutputBuffer *RepRap::GetModelResponse(const GCodeBuffer *_ecv_null gb, const ch
 		if (key == nullptr) { key = ""; }
 		if (flags == nullptr) { flags = ""; }
 
-		outBuf->printf("{\"key\":\"%.s\",\"flags\":\"%.s\",\"result\":", key, flags);
+#if SUPPORT_OBJECT_MODEL_CBOR
+		CborEncoder enc(outBuf);
+		if (wantCbor)
+		{
+			enc.StartMap();
+			enc.Text("key");
+			enc.Text(key);
+			enc.Text("flags");
+			enc.Text(flags);
+			enc.Text("result");
+		}
+		else
+#endif
+		{
+			outBuf->printf("{\"key\":\"%.s\",\"flags\":\"%.s\",\"result\":", key, flags);
+		}
 
 		const bool wantArrayLength = (*key == '#');
 		if (wantArrayLength)
@@ -2315,8 +2386,19 @@ OutputBuffer *RepRap::GetModelResponse(const GCodeBuffer *_ecv_null gb, const ch
 
 		try
 		{
-			reprap.ReportAsJson(gb, outBuf, key, flags, wantArrayLength);
-			outBuf->cat("}\n");
+#if SUPPORT_OBJECT_MODEL_CBOR
+			if (wantCbor)
+			{
+				reprap.ReportAsJson(gb, enc, key, flags, wantArrayLength);
+				enc.End();
+			}
+			else
+#endif
+			{
+				JsonEncoder jsonEncoder(outBuf);
+				reprap.ReportAsJson(gb, jsonEncoder, key, flags, wantArrayLength);
+				outBuf->cat("}\n");
+			}
 			if (outBuf->HadOverflow())
 			{
 				OutputBuffer::ReleaseAll(outBuf);
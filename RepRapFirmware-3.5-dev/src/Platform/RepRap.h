@@ -115,7 +115,7 @@ public:
 #endif
 
 	GCodeResult GetFileInfoResponse(const char *filename, OutputBuffer *&response, bool quitEarly) noexcept;
-	OutputBuffer *GetModelResponse(const GCodeBuffer *_ecv_null gb, const char *key, const char *flags) const THROWS(GCodeException);
+	OutputBuffer *GetModelResponse(const GCodeBuffer *_ecv_null gb, const char *key, const char *flags, bool wantCbor = false) const THROWS(GCodeException);
 	Mutex& GetObjectModelReportMutex() noexcept { return objectModelReportMutex; }
 
 	void Beep(unsigned int freq, unsigned int ms) noexcept;
@@ -142,22 +142,27 @@ public:
 
 	void SaveConfigError(const char *filename, unsigned int lineNumber, const char *errorMessage) noexcept;
 
-	void BoardsUpdated() noexcept { ++boardsSeq; }
-	void DirectoriesUpdated() noexcept { ++directoriesSeq; }
-	void FansUpdated() noexcept { ++fansSeq; }
-	void GlobalUpdated() noexcept { ++globalSeq; }
-	void HeatUpdated() noexcept { ++heatSeq; }
-	void InputsUpdated() noexcept { ++inputsSeq; }
-	void LedStripsUpdated() noexcept { ++ledStripsSeq; }
-	void JobUpdated() noexcept { ++jobSeq; }
-	void MoveUpdated() noexcept { ++moveSeq; }
-	void NetworkUpdated() noexcept { ++networkSeq; }
-	void ScannerUpdated() noexcept { ++scannerSeq; }
-	void SensorsUpdated() noexcept { ++sensorsSeq; }
-	void SpindlesUpdated() noexcept { ++spindlesSeq; }
-	void StateUpdated() noexcept { ++stateSeq; }
-	void ToolsUpdated() noexcept { ++toolsSeq; }
-	void VolumesUpdated() noexcept { ++volumesSeq; }
+	void BoardsUpdated() noexcept { ++boardsSeq; KeyUpdated(ModelKey::boards); }
+	void DirectoriesUpdated() noexcept { ++directoriesSeq; KeyUpdated(ModelKey::directories); }
+	void FansUpdated() noexcept { ++fansSeq; KeyUpdated(ModelKey::fans); }
+	void GlobalUpdated() noexcept { ++globalSeq; KeyUpdated(ModelKey::global); }
+	void HeatUpdated() noexcept { ++heatSeq; KeyUpdated(ModelKey::heat); }
+	void InputsUpdated() noexcept { ++inputsSeq; KeyUpdated(ModelKey::inputs); }
+	void LedStripsUpdated() noexcept { ++ledStripsSeq; KeyUpdated(ModelKey::ledStrips); }
+	void JobUpdated() noexcept { ++jobSeq; KeyUpdated(ModelKey::job); }
+	void MoveUpdated() noexcept { ++moveSeq; KeyUpdated(ModelKey::move); }
+	void NetworkUpdated() noexcept { ++networkSeq; KeyUpdated(ModelKey::network); }
+	void ScannerUpdated() noexcept { ++scannerSeq; KeyUpdated(ModelKey::scanner); }
+	void SensorsUpdated() noexcept { ++sensorsSeq; KeyUpdated(ModelKey::sensors); }
+	void SpindlesUpdated() noexcept { ++spindlesSeq; KeyUpdated(ModelKey::spindles); }
+	void StateUpdated() noexcept { ++stateSeq; KeyUpdated(ModelKey::state); }
+	void ToolsUpdated() noexcept { ++toolsSeq; KeyUpdated(ModelKey::tools); }
+	void VolumesUpdated() noexcept { ++volumesSeq; KeyUpdated(ModelKey::volumes); }
+
+	// Generation numbers used to report only the parts of the object model that have changed since a client last fetched it
+	uint32_t GetModelGeneration() const noexcept { return modelGeneration; }
+	bool IsGenerationSinceStart(uint32_t gen, uint32_t currentGeneration) const noexcept;
+	bool KeyChangedSince(const char *_ecv_array key, uint32_t gen) const noexcept;
 
 	ReadLockedPointer<const VariableSet> GetGlobalVariablesForReading() noexcept { return globalVariables.GetForReading(); }
 	WriteLockedPointer<VariableSet> GetGlobalVariablesForWriting() noexcept { return globalVariables.GetForWriting(); }
@@ -216,6 +221,21 @@ private:
 	uint16_t boardsSeq, directoriesSeq, fansSeq, heatSeq, inputsSeq, jobSeq, ledStripsSeq, moveSeq, globalSeq;
 	uint16_t networkSeq, scannerSeq, sensorsSeq, spindlesSeq, stateSeq, toolsSeq, volumesSeq;
 
+	// Root keys of the object model whose non-live values we track. These are the ones that have sequence numbers.
+	enum class ModelKey : uint8_t
+	{
+		boards = 0, directories, fans, global, heat, inputs, job, ledStrips, move, network, scanner, sensors, spindles, state, tools, volumes,
+		numKeys
+	};
+
+	static const char *_ecv_array const ModelKeyNames[(size_t)ModelKey::numKeys];
+
+	void KeyUpdated(ModelKey key) noexcept;
+
+	volatile uint32_t modelGeneration;								// incremented whenever any tracked key changes
+	uint32_t startGeneration;										// the random value that modelGeneration started at, so that generation numbers from before a restart are not mistaken for ours
+	uint32_t keyGenerations[(size_t)ModelKey::numKeys];				// the value of modelGeneration when each key last changed
+
 	GlobalVariables globalVariables;
 
 	uint32_t lastWarningMillis;					// when we last sent a warning message for things that can happen very often
@@ -13,8 +13,17 @@ namespace TaskPriority
 {
 	constexpr unsigned int IdlePriority = 0;
 	constexpr unsigned int SpinPriority = 1;						// priority for tasks that rarely block
+#if SUPPORT_ASYNC_LOGGER
+	constexpr unsigned int LoggerPriority = 1;						// priority for the logger task, which shares time with the main task
+#endif
 #if HAS_SBC_INTERFACE
 	constexpr unsigned int SbcPriority = 2;							// priority for SBC task
+#endif
+#if SUPPORT_FILE_READ_AHEAD
+	constexpr unsigned int ReadAheadPriority = 2;					// priority for the file read-ahead task, which spends most of its time waiting for the SD card
+#endif
+#if SUPPORT_UPLOAD_WRITE_BEHIND
+	constexpr unsigned int WriteBehindPriority = 2;					// priority for the upload write-behind task, higher than the network task that feeds it
 #endif
     constexpr unsigned int HeatPriority = 3;
 	constexpr unsigned int UsbPriority = 3;							// priority of USB task when using tinyusb
@@ -18,6 +18,7 @@
 #include <PrintMonitor/PrintMonitor.h>
 #include <Tools/Filament.h>
 #include <Platform/RepRap.h>
+#include <ObjectModel/JsonEncoder.h>
 #include <RepRapFirmware.h>
 #include <Platform/Tasks.h>
 #include <Hardware/SoftwareReset.h>
@@ -303,7 +304,8 @@ void SbcInterface::ExchangeData() noexcept
 
 			try
 			{
-				OutputBuffer *outBuf = reprap.GetModelResponse(nullptr, key.c_str(), flags.c_str());
+				// Flag 'b' means that the SBC wants the response in CBOR format. The object model reporting functions ignore it.
+				OutputBuffer *outBuf = reprap.GetModelResponse(nullptr, key.c_str(), flags.c_str(), strchr(flags.c_str(), 'b') != nullptr);
 				if (outBuf != nullptr && outBuf->Length() > SbcTransferBufferSize - sizeof(PacketHeader) - sizeof(StringHeader))
 				{
 					if (!transfer.WriteObjectModel(nullptr))
@@ -578,7 +580,8 @@ void SbcInterface::ExchangeData() noexcept
 							if (OutputBuffer::Allocate(json))
 							{
 								ObjectExplorationContext context;
-								ReportHeapArrayAsJson(json, context, nullptr, val.ahVal, "");
+								JsonEncoder enc(json);
+								ReportHeapArrayAsJson(enc, context, nullptr, val.ahVal, "");
 								packetAcknowledged = transfer.WriteEvaluationResult(expression.c_str(), json);
 							}
 							else
@@ -851,7 +854,8 @@ void SbcInterface::ExchangeData() noexcept
 					if (OutputBuffer::Allocate(json))
 					{
 						ObjectExplorationContext context;
-						ReportHeapArrayAsJson(json, context, nullptr, ev.ahVal, "");
+						JsonEncoder enc(json);
+						ReportHeapArrayAsJson(enc, context, nullptr, ev.ahVal, "");
 						packetAcknowledged = transfer.WriteSetVariableResult(varName.c_str(), json);
 					}
 					else
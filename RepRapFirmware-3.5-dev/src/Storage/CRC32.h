@@ -9,6 +9,18 @@
 # define USE_SAME5x_HARDWARE_CRC	0
 #endif
 
+// Number of 1K lookup tables used by the software CRC algorithm: 1 for the original algorithm, 4 for slicing-by-4 or 8 for slicing-by-8.
+// More tables make the CRC faster but use more flash memory.
+#ifndef CRC32_SOFTWARE_TABLES
+# if SAME70
+#  define CRC32_SOFTWARE_TABLES		8
+# elif SAM4E || (SAME5x && !USE_SAME5x_HARDWARE_CRC)
+#  define CRC32_SOFTWARE_TABLES		4
+# else
+#  define CRC32_SOFTWARE_TABLES		1
+# endif
+#endif
+
 // Note: when USE_SAME5x_HARDWARE_CRC is true, the Update methods must not be called from an ISR!
 class CRC32
 {
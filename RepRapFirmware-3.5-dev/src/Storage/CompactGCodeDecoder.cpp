@@ -0,0 +1,212 @@
+/*
+ * CompactGCodeDecoder.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ */
+
+#include "CompactGCodeDecoder.h"
+#include <General/SimpleMath.h>
+#include <cstring>
+
+static constexpr char FieldLetters[CompactGCodeDecoder::NumFields] = { 'X', 'Y', 'Z', 'E', 'F' };
+static constexpr unsigned int FField = 4;
+static constexpr uint8_t MoveRecordFlag = 0x80, G0Flag = 0x20, FFirstFlag = 0x40;
+
+static_assert(CompactGCodeDecoder::MaxBlockEncodedLength <= 0xFFFF && CompactGCodeDecoder::MaxBlockTextLength <= 0xFFFF);	// the block header holds them in 16 bits
+
+int CompactGCodeDecoder::DecodeBlock(size_t encodedLength) noexcept
+{
+	textLength = 0;
+	encodedRemaining = encodedLength;
+	windowPos = windowLength = 0;
+
+	int64_t values[NumFields] = { 0 };
+	while (HaveEncodedData())
+	{
+		uint8_t recordType;
+		if (!GetByte(recordType))
+		{
+			return -1;
+		}
+
+		if (recordType == 0)
+		{
+			uint64_t len;
+			if (!GetVarint(len) || !CopyVerbatim(len))
+			{
+				return -1;
+			}
+		}
+		else if ((recordType & MoveRecordFlag) != 0)
+		{
+			if (!AppendText((recordType & G0Flag) ? "G0" : "G1", 2))
+			{
+				return -1;
+			}
+			for (unsigned int n = 0; n < NumFields; ++n)
+			{
+				// If the F-first flag is set then the fields are in the order F X Y Z E, else X Y Z E F
+				const unsigned int field = ((recordType & FFirstFlag) == 0) ? n : (n == 0) ? FField : n - 1;
+				if ((recordType & (1u << field)) != 0)
+				{
+					// The converter never writes a value whose magnitude is MaxMagnitude or more, so a delta that takes a value out of that range means the file is corrupt.
+					// Checking the delta first means that the addition can't overflow.
+					uint64_t zigzag;
+					if (!GetVarint(zigzag) || (zigzag >> 1) >= 2 * (uint64_t)MaxMagnitude)
+					{
+						return -1;
+					}
+					const int64_t newValue = values[field] + ((int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1));
+					if (newValue >= MaxMagnitude || newValue <= -MaxMagnitude)
+					{
+						return -1;
+					}
+					values[field] = newValue;
+					const char prefix[2] = { ' ', FieldLetters[field] };
+					if (!AppendText(prefix, 2) || !AppendNumber(newValue, decimals[field]))
+					{
+						return -1;
+					}
+				}
+			}
+			if (!AppendText("\n", 1))
+			{
+				return -1;
+			}
+		}
+		else
+		{
+			return -1;
+		}
+	}
+	return (int)textLength;
+}
+
+bool CompactGCodeDecoder::GetByte(uint8_t& b) noexcept
+{
+	if (windowPos == windowLength)
+	{
+		if (encodedRemaining == 0)
+		{
+			return false;
+		}
+		windowLength = min<size_t>(encodedRemaining, sizeof(window));
+		windowPos = 0;
+		if (!readEncoded(window, windowLength))
+		{
+			windowLength = 0;
+			return false;
+		}
+		encodedRemaining -= windowLength;
+	}
+	b = window[windowPos++];
+	return true;
+}
+
+// Read an unsigned LEB128 varint, returning false if it is truncated or too long
+bool CompactGCodeDecoder::GetVarint(uint64_t& val) noexcept
+{
+	val = 0;
+	for (unsigned int shift = 0; shift < 64; shift += 7)
+	{
+		uint8_t b;
+		if (!GetByte(b))
+		{
+			return false;
+		}
+		val |= (uint64_t)(b & 0x7F) << shift;
+		if ((b & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Copy text that is stored verbatim. We read whatever isn't already in the window straight into the text buffer.
+bool CompactGCodeDecoder::CopyVerbatim(uint64_t length) noexcept
+{
+	const size_t inWindow = windowLength - windowPos;
+	if (length > MaxBlockTextLength - textLength || length > inWindow + encodedRemaining)
+	{
+		return false;
+	}
+
+	const size_t fromWindow = min<size_t>((size_t)length, inWindow);
+	memcpy(text + textLength, window + windowPos, fromWindow);
+	windowPos += fromWindow;
+	textLength += fromWindow;
+
+	const size_t fromFile = (size_t)length - fromWindow;
+	if (fromFile != 0)
+	{
+		if (!readEncoded(reinterpret_cast<uint8_t *_ecv_array>(text + textLength), fromFile))
+		{
+			return false;
+		}
+		encodedRemaining -= fromFile;
+		textLength += fromFile;
+	}
+	return true;
+}
+
+bool CompactGCodeDecoder::AppendText(const char *_ecv_array s, size_t length) noexcept
+{
+	if (length > MaxBlockTextLength - textLength)
+	{
+		return false;
+	}
+	memcpy(text + textLength, s, length);
+	textLength += length;
+	return true;
+}
+
+// Append a quantised value as a decimal number with no trailing zeros after the decimal point. The caller has checked that its magnitude is less than MaxMagnitude.
+bool CompactGCodeDecoder::AppendNumber(int64_t value, uint8_t numDecimals) noexcept
+{
+	static_assert(MaxNumberLength >= MaxMagnitudeDigits + 3);
+	static_assert(MaxMagnitudeDigits >= MaxDecimals);				// so the digits after the point never need more room than the digits of the magnitude
+	char digits[MaxNumberLength];
+	size_t numDigits = 0;
+	const bool negative = (value < 0);
+	uint64_t magnitude = (negative) ? -(uint64_t)value : (uint64_t)value;
+
+	// Generate the digits in reverse order, skipping trailing zeros after the decimal point
+	bool stillTrailingZeros = true;
+	for (unsigned int n = 0; n < numDecimals; ++n)
+	{
+		const char c = '0' + (char)(magnitude % 10);
+		magnitude /= 10;
+		if (c != '0' || !stillTrailingZeros)
+		{
+			digits[numDigits++] = c;
+			stillTrailingZeros = false;
+		}
+	}
+	if (!stillTrailingZeros)
+	{
+		digits[numDigits++] = '.';
+	}
+	do
+	{
+		digits[numDigits++] = '0' + (char)(magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude != 0);
+	if (negative)
+	{
+		digits[numDigits++] = '-';
+	}
+
+	if (numDigits > MaxBlockTextLength - textLength)
+	{
+		return false;
+	}
+	while (numDigits != 0)
+	{
+		text[textLength++] = digits[--numDigits];
+	}
+	return true;
+}
+
+// End
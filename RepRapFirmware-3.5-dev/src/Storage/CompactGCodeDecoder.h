@@ -0,0 +1,59 @@
+/*
+ * CompactGCodeDecoder.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Decoder for the blocks of a compact GCode file, see CompactGCodeReader.h for the format.
+ * The encoded data is read in small pieces as it is decoded, so the only buffer needed is the one for the decoded text.
+ * This has no dependencies on the rest of the firmware so that it can be tested on a host.
+ */
+
+#ifndef SRC_STORAGE_COMPACTGCODEDECODER_H_
+#define SRC_STORAGE_COMPACTGCODEDECODER_H_
+
+#include <ecv_duet3d.h>
+#include <General/function_ref.h>
+#include <cstdint>
+#include <cstddef>
+
+class CompactGCodeDecoder
+{
+public:
+	static constexpr size_t MaxBlockTextLength = 1024;
+	static constexpr size_t MaxBlockEncodedLength = 1024;
+	static constexpr size_t NumFields = 5;						// X, Y, Z, E, F
+	static constexpr uint8_t MaxDecimals = 9;
+	static constexpr int64_t MaxMagnitude = (int64_t)1 << 53;	// quantised values must be smaller than this in magnitude, the same limit that the converter uses
+
+	// Function to read exactly the specified number of bytes of encoded data, returning false if it can't
+	typedef function_ref_noexcept<bool(uint8_t *_ecv_array buf, size_t length) noexcept> ReadFunction;
+
+	CompactGCodeDecoder(ReadFunction p_readEncoded, const uint8_t *_ecv_array p_decimals, char *_ecv_array p_text) noexcept
+		: readEncoded(p_readEncoded), decimals(p_decimals), text(p_text) { }
+
+	// Decode a block with the specified encoded length into the text buffer, which must have room for MaxBlockTextLength characters.
+	// Return the length of the decoded text, or -1 if the block is corrupt or could not be read.
+	int DecodeBlock(size_t encodedLength) noexcept;
+
+private:
+	static constexpr size_t MaxMagnitudeDigits = 16;			// the number of decimal digits in MaxMagnitude - 1
+	static constexpr size_t MaxNumberLength = MaxMagnitudeDigits + 3;	// allow for a sign, a decimal point and a leading zero
+
+	bool HaveEncodedData() const noexcept { return windowPos < windowLength || encodedRemaining != 0; }
+	bool GetByte(uint8_t& b) noexcept;
+	bool GetVarint(uint64_t& val) noexcept;
+	bool CopyVerbatim(uint64_t length) noexcept;
+	bool AppendText(const char *_ecv_array s, size_t length) noexcept;
+	bool AppendNumber(int64_t value, uint8_t numDecimals) noexcept;
+
+	ReadFunction readEncoded;
+	const uint8_t *_ecv_array decimals;							// the number of decimal places used to quantise each field
+	char *_ecv_array text;
+	size_t textLength = 0;
+	size_t encodedRemaining = 0;								// the number of encoded bytes of the block that we have not yet read
+	size_t windowPos = 0, windowLength = 0;						// the next byte and the number of bytes in the window
+	uint8_t window[32];											// encoded data that we have read but not yet decoded
+};
+
+#endif /* SRC_STORAGE_COMPACTGCODEDECODER_H_ */
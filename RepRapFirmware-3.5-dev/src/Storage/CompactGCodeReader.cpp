@@ -0,0 +1,207 @@
+/*
+ * CompactGCodeReader.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ */
+
+#include "CompactGCodeReader.h"
+
+#if SUPPORT_COMPACT_GCODE
+
+#include "FileStore.h"
+#include <Platform/RepRap.h>
+#include <Platform/Platform.h>
+
+static constexpr char CompactGCodeMagic[8] = { 'R', 'R', 'F', 'C', 'G', 'C', '1', '\n' };
+
+static inline uint16_t GetU16(const uint8_t *_ecv_array p) noexcept
+{
+	return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+static inline uint32_t GetU32(const uint8_t *_ecv_array p) noexcept
+{
+	return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*static*/ CompactGCodeReader *_ecv_null CompactGCodeReader::Create(FileStore& f) noexcept
+{
+	uint8_t header[HeaderLength];
+	if (f.ReadRaw(reinterpret_cast<char *_ecv_array>(header), HeaderLength) != (int)HeaderLength || memcmp(header, CompactGCodeMagic, sizeof(CompactGCodeMagic)) != 0)
+	{
+		(void)f.SeekRaw(0);
+		return nullptr;
+	}
+
+	for (size_t i = 0; i < NumFields; ++i)
+	{
+		if (header[20 + i] > MaxDecimals)
+		{
+			reprap.GetPlatform().Message(ErrorMessage, "Compact GCode file header is invalid\n");
+			(void)f.SeekRaw(0);
+			return nullptr;
+		}
+	}
+
+	CompactGCodeReader *const reader = new CompactGCodeReader(f);
+	reader->textLength = GetU32(header + 8);
+	reader->indexOffset = GetU32(header + 12);
+	reader->numBlocks = GetU32(header + 16);
+	memcpy(reader->decimals, header + 20, NumFields);
+	return reader;
+}
+
+// Create a reader for a copy of the file, with the same position as this one
+CompactGCodeReader *_ecv_null CompactGCodeReader::Duplicate(FileStore& f) const noexcept
+{
+	CompactGCodeReader *const reader = new CompactGCodeReader(f);
+	reader->textLength = textLength;
+	reader->indexOffset = indexOffset;
+	reader->numBlocks = numBlocks;
+	memcpy(reader->decimals, decimals, NumFields);
+	reader->blockTextStart = blockTextStart;
+	reader->nextBlockOffset = nextBlockOffset;
+	reader->blockTextLength = blockTextLength;
+	reader->readOffset = readOffset;
+	memcpy(reader->textBuffer, textBuffer, blockTextLength);
+	return reader;
+}
+
+// Read decoded text, returning the number of characters read or -1 if the file could not be read or is corrupt
+int CompactGCodeReader::Read(char *_ecv_array buf, size_t nBytes) noexcept
+{
+	size_t bytesRead = 0;
+	while (bytesRead < nBytes)
+	{
+		if (readOffset == blockTextLength)
+		{
+			const FilePosition nextTextStart = blockTextStart + blockTextLength;
+			if (nextTextStart >= textLength)
+			{
+				break;
+			}
+			if (!LoadBlock(nextBlockOffset, nextTextStart))
+			{
+				return -1;
+			}
+		}
+
+		const size_t bytesToCopy = min<size_t>(nBytes - bytesRead, blockTextLength - readOffset);
+		memcpy(buf + bytesRead, textBuffer + readOffset, bytesToCopy);
+		readOffset += bytesToCopy;
+		bytesRead += bytesToCopy;
+	}
+	return (int)bytesRead;
+}
+
+// Seek to a position in the decoded text
+bool CompactGCodeReader::Seek(FilePosition pos) noexcept
+{
+	if (pos >= blockTextStart && pos - blockTextStart < blockTextLength)
+	{
+		readOffset = pos - blockTextStart;
+		return true;
+	}
+
+	if (pos >= textLength)
+	{
+		if (pos > textLength)
+		{
+			return false;
+		}
+		blockTextStart = textLength;
+		blockTextLength = readOffset = 0;
+		return true;
+	}
+
+	if (numBlocks == 0)
+	{
+		return false;
+	}
+
+	// Binary search the block index for the last block that starts at or before the requested position
+	uint32_t low = 0, high = numBlocks;
+	uint32_t textStart = 0, fileOffset = HeaderLength;
+	while (high - low > 1)
+	{
+		const uint32_t mid = (low + high)/2;
+		uint32_t midTextStart, midFileOffset;
+		if (!ReadIndexEntry(mid, midTextStart, midFileOffset))
+		{
+			return false;
+		}
+		if (midTextStart <= pos)
+		{
+			low = mid;
+			textStart = midTextStart;
+			fileOffset = midFileOffset;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+	if (low == 0 && !ReadIndexEntry(0, textStart, fileOffset))
+	{
+		return false;
+	}
+
+	if (!LoadBlock(fileOffset, textStart) || pos - textStart >= blockTextLength)
+	{
+		return false;
+	}
+	readOffset = pos - textStart;
+	return true;
+}
+
+bool CompactGCodeReader::ReadIndexEntry(uint32_t blockNumber, uint32_t& textStart, uint32_t& fileOffset) noexcept
+{
+	uint8_t entry[8];
+	if (!file.SeekRaw(indexOffset + 8 * blockNumber) || file.ReadRaw(reinterpret_cast<char *_ecv_array>(entry), sizeof(entry)) != (int)sizeof(entry))
+	{
+		return false;
+	}
+	textStart = GetU32(entry);
+	fileOffset = GetU32(entry + 4);
+	return true;
+}
+
+// Read and decode the block at the specified file offset
+bool CompactGCodeReader::LoadBlock(FilePosition fileOffset, FilePosition textStart) noexcept
+{
+	uint8_t blockHeader[4];
+	blockTextLength = readOffset = 0;
+	if (   file.SeekRaw(fileOffset)
+		&& file.ReadRaw(reinterpret_cast<char *_ecv_array>(blockHeader), sizeof(blockHeader)) == (int)sizeof(blockHeader)
+	   )
+	{
+		const size_t encodedLength = GetU16(blockHeader);
+		const size_t expectedTextLength = GetU16(blockHeader + 2);
+		if (   encodedLength <= MaxBlockEncodedLength
+			&& expectedTextLength <= MaxBlockTextLength
+			&& expectedTextLength != 0
+		   )
+		{
+			auto readEncoded = [this](uint8_t *_ecv_array buf, size_t length) noexcept -> bool
+								{ return file.ReadRaw(reinterpret_cast<char *_ecv_array>(buf), length) == (int)length; };
+			CompactGCodeDecoder decoder(readEncoded, decimals, textBuffer);
+			const int decodedLength = decoder.DecodeBlock(encodedLength);
+			if (decodedLength == (int)expectedTextLength)
+			{
+				blockTextLength = expectedTextLength;
+				blockTextStart = textStart;
+				nextBlockOffset = fileOffset + sizeof(blockHeader) + encodedLength;
+				return true;
+			}
+		}
+	}
+
+	blockTextLength = 0;
+	reprap.GetPlatform().MessageF(ErrorMessage, "Compact GCode file is corrupt at offset %" PRIu32 "\n", fileOffset);
+	return false;
+}
+
+#endif
+
+// End
@@ -0,0 +1,89 @@
+/*
+ * CompactGCodeReader.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Reader for GCode files in compact pre-tokenised format (.cgcode files), as produced by Tools/CompactGCode/cgcode.py.
+ * When a FileStore has a reader attached, reads, seeks, positions and lengths all refer to the original GCode text that the file was converted from.
+ * So file positions used by pause/resume, loops, macros and print progress are the same as when printing the original file, and the file info parser
+ * finds the slicer's metadata comments in the usual places.
+ *
+ * File format (all multi-byte values are little-endian):
+ *   Header:
+ *     char[8]   magic "RRFCGC1\n"
+ *     uint32    length of the original text
+ *     uint32    file offset of the block index
+ *     uint32    number of blocks
+ *     uint8[5]  number of decimal places used to quantise X, Y, Z, E and F values
+ *     uint8[3]  reserved, zero
+ *   Blocks, each one holding up to MaxBlockTextLength characters of the original text (a move record never spans two blocks):
+ *     uint16    length of the encoded records that follow
+ *     uint16    length of the text they decode to
+ *     records:
+ *       0x00, varint n, n bytes     text copied verbatim
+ *       0x80 | flags, deltas        a G0 or G1 command: flags bits 0-4 say which of X, Y, Z, E and F are present, bit 5 means G0 instead of G1,
+ *                                   bit 6 means F is written before the other parameters. Each value present is encoded as the zigzag varint difference
+ *                                   between its quantised value and the previous value of the same parameter in this block (which starts at zero).
+ *                                   Quantised values are always less than 2^53 in magnitude; a delta that takes a value outside that range means the file is corrupt.
+ *                                   It decodes to e.g. "G1 X12.5 Y-3 E0.02\n", with no trailing zeros after the decimal point.
+ *   Block index, one entry per block:
+ *     uint32    position in the original text of the start of the block
+ *     uint32    file offset of the block
+ */
+
+#ifndef SRC_STORAGE_COMPACTGCODEREADER_H_
+#define SRC_STORAGE_COMPACTGCODEREADER_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_COMPACT_GCODE
+
+#include "CompactGCodeDecoder.h"
+
+class FileStore;
+
+class CompactGCodeReader
+{
+public:
+	static constexpr size_t HeaderLength = 28;
+	static constexpr size_t MaxBlockTextLength = CompactGCodeDecoder::MaxBlockTextLength;
+	static constexpr size_t MaxBlockEncodedLength = CompactGCodeDecoder::MaxBlockEncodedLength;
+	static constexpr size_t NumFields = CompactGCodeDecoder::NumFields;
+	static constexpr uint8_t MaxDecimals = CompactGCodeDecoder::MaxDecimals;
+
+	// Check whether the file has a compact GCode header. If it does, return a new reader for it, else return nullptr. Leaves the file positioned at the start.
+	static CompactGCodeReader *_ecv_null Create(FileStore& f) noexcept;
+
+	CompactGCodeReader(const CompactGCodeReader&) = delete;
+	CompactGCodeReader& operator=(const CompactGCodeReader&) = delete;
+
+	CompactGCodeReader *_ecv_null Duplicate(FileStore& f) const noexcept;		// create a reader with the same position for a copy of the file
+
+	int Read(char *_ecv_array buf, size_t nBytes) noexcept;
+	bool Seek(FilePosition pos) noexcept;
+	FilePosition Position() const noexcept { return blockTextStart + readOffset; }
+	FilePosition Length() const noexcept { return textLength; }
+
+private:
+	CompactGCodeReader(FileStore& f) noexcept : file(f) { }
+
+	bool LoadBlock(FilePosition fileOffset, FilePosition textStart) noexcept;
+	bool ReadIndexEntry(uint32_t blockNumber, uint32_t& textStart, uint32_t& fileOffset) noexcept;
+
+	FileStore& file;
+	uint32_t textLength;										// length of the original text
+	uint32_t indexOffset;										// file offset of the block index
+	uint32_t numBlocks;
+	uint8_t decimals[NumFields];
+
+	FilePosition blockTextStart = 0;							// position in the text of the start of the block in textBuffer
+	FilePosition nextBlockOffset = HeaderLength;				// file offset of the block following the one in textBuffer
+	size_t blockTextLength = 0;									// number of characters of text in textBuffer
+	size_t readOffset = 0;										// offset in textBuffer of the next character to read
+	char textBuffer[MaxBlockTextLength];						// the decoder reads the encoded data a little at a time, so this is the only block buffer
+};
+
+#endif
+
+#endif /* SRC_STORAGE_COMPACTGCODEREADER_H_ */
@@ -159,7 +159,7 @@ public:
 		}
 	}
 
-#if SUPPORT_ASYNC_MOVES
+#if SUPPORT_ASYNC_MOVES || SUPPORT_FILE_READ_AHEAD
 	const FileStore *GetUnderlyingFile() const noexcept { return f; }
 #endif
 
@@ -0,0 +1,158 @@
+/*
+ * FileInfoIndex.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ */
+
+#include "FileInfoIndex.h"
+
+#if SUPPORT_FILE_INFO_INDEX
+
+#include "MassStorage.h"
+#include "FileInfoIndexFile.h"
+#include <Platform/Platform.h>
+#include <Platform/RepRap.h>
+#include <Libraries/Fatfs/ff.h>
+
+namespace FileInfoIndex
+{
+	typedef FileInfoIndexFile<FileStore, GCodeFileInfo, MaxFilenameLength> IndexFile;
+
+	constexpr FilePosition MinDeadBytesToCompact = 8192;	// we compact the index when replaced records take up at least this much space and more than the live ones
+
+	static uint32_t numHits = 0, numMisses = 0, numStores = 0, numCompactions = 0;
+}
+
+using FileInfoIndex::IndexFile;
+
+// Build the path of the index file for the directory that filePath is in, returning a pointer to the file name part of filePath or nullptr if it can't be done
+static const char *_ecv_array null GetIndexPath(const char *_ecv_array filePath, const StringRef& indexPath) noexcept
+{
+#if HAS_SBC_INTERFACE
+	if (reprap.UsingSbcInterface())
+	{
+		return nullptr;								// the SBC looks after its own files
+	}
+#endif
+	const char *_ecv_array const lastSlash = strrchr(filePath, '/');
+	if (lastSlash == nullptr || lastSlash[1] == 0 || indexPath.copy(filePath, lastSlash + 1 - filePath) || indexPath.cat(FileInfoIndex::IndexFileName))
+	{
+		return nullptr;
+	}
+	return lastSlash + 1;
+}
+
+// Look for a record for the specified file. If we find one with the same size and last modified time, copy it to 'info' and return true.
+bool FileInfoIndex::Lookup(const char *_ecv_array filePath, GCodeFileInfo& info) noexcept
+{
+	String<MaxFilenameLength> indexPath;
+	const char *_ecv_array const fileName = GetIndexPath(filePath, indexPath.GetRef());
+	bool found = false;
+	if (fileName != nullptr && MassStorage::FileExists(indexPath.c_str()))
+	{
+		FileStore * const f = MassStorage::OpenFile(indexPath.c_str(), OpenMode::read, 0);
+		if (f != nullptr)
+		{
+			IndexFile index(f);
+			GCodeFileInfo rec;
+			if (   index.ReadHeader()
+				&& index.Find(fileName, rec)
+				&& rec.isValid
+				&& rec.fileSize == info.fileSize
+				&& rec.lastModifiedTime == info.lastModifiedTime
+			   )
+			{
+				info = rec;
+				found = true;
+			}
+			f->Close();
+		}
+	}
+
+	if (found)
+	{
+		++numHits;
+	}
+	else
+	{
+		++numMisses;
+	}
+	return found;
+}
+
+// Store the information for a file that we have just parsed, creating the index file if necessary
+void FileInfoIndex::Store(const char *_ecv_array filePath, const GCodeFileInfo& info) noexcept
+{
+	String<MaxFilenameLength> indexPath;
+	const char *_ecv_array const fileName = GetIndexPath(filePath, indexPath.GetRef());
+	if (fileName == nullptr)
+	{
+		return;
+	}
+	const size_t nameLength = strlen(fileName);
+	if (nameLength >= MaxFilenameLength)
+	{
+		return;
+	}
+
+	FileStore * const f = MassStorage::OpenFile(indexPath.c_str(), OpenMode::append, 0);
+	if (f == nullptr)
+	{
+		return;
+	}
+
+	const bool isNewFile = (f->Length() == 0);
+	IndexFile index(f);
+	FilePosition endOfRecords;
+	bool compacted;
+	const bool ok = index.PrepareToStore(fileName, MinDeadBytesToCompact, endOfRecords, compacted)
+					&& index.Append(endOfRecords, fileName, info);		// this discards anything after the new record, such as a partly-written record or the space freed by compacting
+	if (compacted)
+	{
+		++numCompactions;
+	}
+
+	if (f->Close() && ok)
+	{
+		++numStores;
+		if (isNewFile)
+		{
+			(void)f_chmod(indexPath.c_str(), AM_HID, AM_HID);		// hide it from PCs that the card is plugged into
+		}
+	}
+}
+
+// Forget any record for the specified file. Called when the file has been written, because its size and timestamp might not have changed.
+void FileInfoIndex::Remove(const char *_ecv_array filePath) noexcept
+{
+	String<MaxFilenameLength> indexPath;
+	const char *_ecv_array const fileName = GetIndexPath(filePath, indexPath.GetRef());
+	if (fileName == nullptr || !MassStorage::FileExists(indexPath.c_str()))
+	{
+		return;
+	}
+
+	FileStore * const f = MassStorage::OpenFile(indexPath.c_str(), OpenMode::append, 0);
+	if (f != nullptr)
+	{
+		IndexFile index(f);
+		if (index.ReadHeader())
+		{
+			FilePosition liveBytes, deadBytes;
+			(void)index.KillMatchingRecords(fileName, liveBytes, deadBytes);
+		}
+		f->Close();
+	}
+}
+
+void FileInfoIndex::Diagnostics(MessageType mtype) noexcept
+{
+	reprap.GetPlatform().MessageF(mtype, "File info index hits %" PRIu32 ", misses %" PRIu32 ", updates %" PRIu32 ", compactions %" PRIu32 "\n",
+									numHits, numMisses, numStores, numCompactions);
+	numHits = numMisses = numStores = numCompactions = 0;
+}
+
+#endif
+
+// End
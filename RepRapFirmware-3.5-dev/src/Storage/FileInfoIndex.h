@@ -0,0 +1,38 @@
+/*
+ * FileInfoIndex.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Persistent store for the information that FileInfoParser extracts from G-code files, so that we don't need to parse a file every time a client asks about it.
+ * Each directory that contains parsed files gets a hidden index file. We append a record to it for each file we parse, holding the file name,
+ * a hash of the name so that lookups can skip most records after reading a short header, and the file information. Storing a record kills any
+ * earlier record for the same name, and the index is compacted when dead records take up more space than live ones, so its size follows the
+ * number of files that have been parsed. A record is only used if the file still has the size and last modified time that it had when it was parsed,
+ * so changing a file by other means just causes it to be parsed again next time. The caller must serialise calls to these functions.
+ */
+
+#ifndef SRC_STORAGE_FILEINFOINDEX_H_
+#define SRC_STORAGE_FILEINFOINDEX_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_FILE_INFO_INDEX
+
+#include <GCodes/GCodeFileInfo.h>
+
+namespace FileInfoIndex
+{
+	constexpr const char *_ecv_array IndexFileName = ".fileinfo.idx";
+
+	bool Lookup(const char *_ecv_array filePath, GCodeFileInfo& info) noexcept;		// on entry info.fileSize and info.lastModifiedTime must be set
+	void Store(const char *_ecv_array filePath, const GCodeFileInfo& info) noexcept;
+	void Remove(const char *_ecv_array filePath) noexcept;
+	void Diagnostics(MessageType mtype) noexcept;
+
+	inline bool IsIndexFile(const char *_ecv_array fileName) noexcept { return StringEqualsIgnoreCase(fileName, IndexFileName); }
+}
+
+#endif
+
+#endif /* SRC_STORAGE_FILEINFOINDEX_H_ */
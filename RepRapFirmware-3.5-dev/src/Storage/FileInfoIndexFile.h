@@ -0,0 +1,300 @@
+/*
+ * FileInfoIndexFile.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Record format of the file info index, see FileInfoIndex.h. The file starts with a header that identifies the format, followed by records,
+ * each of which is a RecordHeader followed by the file name padded to a multiple of 4 bytes and then the information about the file.
+ * New records are appended to the end. A record is killed by zeroing its name hash, which also makes its checksum wrong, and compacting
+ * the index moves the live records down over the dead ones. If a record was only partly written (e.g. because the card was removed) then either
+ * it is incomplete, so reading stops there and the next record we store overwrites it, or its checksum is wrong, so it is skipped and then
+ * dropped when the index is compacted.
+ * This is a template so that it can be tested on a host with a fake file. File must provide Seek, Read, Write, Length and Truncate like FileStore,
+ * and Info is the information that we store about each file, which must be trivially copyable.
+ */
+
+#ifndef SRC_STORAGE_FILEINFOINDEXFILE_H_
+#define SRC_STORAGE_FILEINFOINDEXFILE_H_
+
+#include "CRC32.h"
+#include <General/StringFunctions.h>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cctype>
+#include <type_traits>
+
+template<class File, class Info, size_t MaxNameLength> class FileInfoIndexFile
+{
+public:
+	typedef uint32_t Position;										// the same as FilePosition
+
+	static constexpr uint32_t Magic = 0x49464652;					// "RFFI" when read as little-endian
+	static constexpr uint16_t Version = 2;
+
+	explicit FileInfoIndexFile(File *p_f) noexcept : f(p_f) { }
+
+	bool ReadHeader() noexcept;										// return true if the file has a header that matches our format
+	bool WriteHeader() noexcept;									// write a new header at the start of the file
+
+	// Find the live record for the specified file name and copy its information to info. Return true if found.
+	bool Find(const char *_ecv_array fileName, Info& info) noexcept;
+
+	// Kill all the live records for the specified file name, returning the offset of the end of the intact records.
+	// Also count the bytes taken by live and dead records, so that the caller can decide whether to compact the index.
+	Position KillMatchingRecords(const char *_ecv_array fileName, Position& liveBytes, Position& deadBytes) noexcept;
+
+	// Move the live records down over the dead ones, returning the offset of the end of the live records
+	Position Compact() noexcept;
+
+	// Get ready to store a record for the specified file. If the file doesn't have a valid header then start a new index, otherwise kill any records
+	// for the file and compact the index if dead records take up at least minDeadBytesToCompact and more space than the live ones.
+	// Return the offset at which to append the new record in endOfRecords, and false if we failed to write the header.
+	bool PrepareToStore(const char *_ecv_array fileName, Position minDeadBytesToCompact, Position& endOfRecords, bool& compacted) noexcept;
+
+	// Write a record at the specified offset, normally the end of the intact records, and discard anything after it
+	bool Append(Position offset, const char *_ecv_array fileName, const Info& info) noexcept;
+
+	static constexpr Position FirstRecordOffset() noexcept { return sizeof(IndexHeader); }
+	static constexpr Position RecordLength(size_t nameLength) noexcept { return sizeof(RecordHeader) + PaddedNameLength(nameLength) + sizeof(Info); }
+
+private:
+	// If any field of the header doesn't match what we expect, e.g. because a firmware update has changed the layout of Info, then the caller
+	// ignores the contents and starts a new index
+	struct IndexHeader
+	{
+		uint32_t magic;
+		uint16_t version;
+		uint16_t infoSize;
+		uint32_t zero[2];
+	};
+
+	// Lookups only need to read the record headers until they find one with the right name hash and length
+	struct RecordHeader
+	{
+		uint32_t nameHash;											// hash of the file name, or zero if the record has been replaced or removed
+		uint16_t nameLength;										// the length of the file name that follows this header, without a null terminator
+		uint16_t zero;
+		uint32_t checksum;											// CRC32 of the rest of the record, so that we can detect partly-written records
+	};
+
+	// A whole record read into memory
+	struct IndexRecord
+	{
+		RecordHeader hdr;
+		char name[MaxNameLength + 4];								// room for the padding as well
+		Info info;
+
+		uint32_t CalcChecksum() const noexcept;
+	};
+
+	static_assert(std::is_trivially_copyable<Info>::value);
+
+	static constexpr size_t PaddedNameLength(size_t nameLength) noexcept { return (nameLength + 3) & ~(size_t)3; }
+	static uint32_t HashName(const char *_ecv_array fileName) noexcept;
+
+	bool ReadRecordHeader(Position offset, RecordHeader& hdr) noexcept;
+	bool ReadRecordBody(IndexRecord& rec) noexcept;
+	bool ReadRecordIfNameMatches(IndexRecord& rec, const char *_ecv_array fileName, uint32_t hash, size_t nameLength) noexcept;
+	bool WriteRecord(Position offset, const IndexRecord& rec) noexcept;
+	bool KillRecord(Position offset) noexcept;
+
+	File *f;
+};
+
+template<class File, class Info, size_t MaxNameLength> uint32_t FileInfoIndexFile<File, Info, MaxNameLength>::IndexRecord::CalcChecksum() const noexcept
+{
+	CRC32 crc;
+	crc.Update(reinterpret_cast<const char *_ecv_array>(&hdr.nameHash), sizeof(hdr.nameHash));
+	crc.Update(reinterpret_cast<const char *_ecv_array>(&hdr.nameLength), sizeof(hdr.nameLength));
+	crc.Update(name, hdr.nameLength);
+	crc.Update(reinterpret_cast<const char *_ecv_array>(&info), sizeof(info));
+	return crc.Get();
+}
+
+// Hash a file name. FAT file names are not case sensitive, so neither is the hash. We never return zero because that denotes a dead record.
+template<class File, class Info, size_t MaxNameLength> uint32_t FileInfoIndexFile<File, Info, MaxNameLength>::HashName(const char *_ecv_array fileName) noexcept
+{
+	CRC32 crc;
+	while (*fileName != 0)
+	{
+		crc.Update((char)tolower(*fileName++));
+	}
+	const uint32_t hash = crc.Get();
+	return (hash == 0) ? 1 : hash;
+}
+
+template<class File, class Info, size_t MaxNameLength> bool FileInfoIndexFile<File, Info, MaxNameLength>::ReadHeader() noexcept
+{
+	IndexHeader hdr;
+	return f->Seek(0)
+		&& f->Read(reinterpret_cast<char *_ecv_array>(&hdr), sizeof(hdr)) == (int)sizeof(hdr)
+		&& hdr.magic == Magic
+		&& hdr.version == Version
+		&& hdr.infoSize == sizeof(Info);
+}
+
+template<class File, class Info, size_t MaxNameLength> bool FileInfoIndexFile<File, Info, MaxNameLength>::WriteHeader() noexcept
+{
+	const IndexHeader hdr = { Magic, Version, sizeof(Info), { 0, 0 } };
+	return f->Seek(0) && f->Write(reinterpret_cast<const char *_ecv_array>(&hdr), sizeof(hdr));
+}
+
+// Read the header of the record at the specified offset, returning false if there is no complete record there
+template<class File, class Info, size_t MaxNameLength> bool FileInfoIndexFile<File, Info, MaxNameLength>::ReadRecordHeader(Position offset, RecordHeader& hdr) noexcept
+{
+	return offset + sizeof(hdr) <= f->Length()
+		&& f->Seek(offset)
+		&& f->Read(reinterpret_cast<char *_ecv_array>(&hdr), sizeof(hdr)) == (int)sizeof(hdr)
+		&& hdr.nameLength != 0
+		&& hdr.nameLength < MaxNameLength
+		&& hdr.zero == 0
+		&& offset + RecordLength(hdr.nameLength) <= f->Length();
+}
+
+// Read the rest of a live record whose header we have just read, returning true if it is intact
+template<class File, class Info, size_t MaxNameLength> bool FileInfoIndexFile<File, Info, MaxNameLength>::ReadRecordBody(IndexRecord& rec) noexcept
+{
+	const size_t paddedLength = PaddedNameLength(rec.hdr.nameLength);
+	if (   rec.hdr.nameHash == 0
+		|| f->Read(rec.name, paddedLength) != (int)paddedLength
+		|| f->Read(reinterpret_cast<char *_ecv_array>(&rec.info), sizeof(rec.info)) != (int)sizeof(rec.info)
+	   )
+	{
+		return false;
+	}
+	rec.name[rec.hdr.nameLength] = 0;
+	return rec.hdr.checksum == rec.CalcChecksum();
+}
+
+// Return true if the record is for the specified file name. It's only worth reading the rest of the record if the hash and the name length match.
+template<class File, class Info, size_t MaxNameLength> bool FileInfoIndexFile<File, Info, MaxNameLength>::ReadRecordIfNameMatches(IndexRecord& rec, const char *_ecv_array fileName, uint32_t hash, size_t nameLength) noexcept
+{
+	return rec.hdr.nameHash == hash
+		&& rec.hdr.nameLength == nameLength
+		&& ReadRecordBody(rec)
+		&& StringEqualsIgnoreCase(rec.name, fileName);
+}
+
+template<class File, class Info, size_t MaxNameLength> bool FileInfoIndexFile<File, Info, MaxNameLength>::WriteRecord(Position offset, const IndexRecord& rec) noexcept
+{
+	return f->Seek(offset)
+		&& f->Write(reinterpret_cast<const char *_ecv_array>(&rec.hdr), sizeof(rec.hdr))
+		&& f->Write(rec.name, PaddedNameLength(rec.hdr.nameLength))
+		&& f->Write(reinterpret_cast<const char *_ecv_array>(&rec.info), sizeof(rec.info));
+}
+
+// Mark the record at the specified offset as dead
+template<class File, class Info, size_t MaxNameLength> bool FileInfoIndexFile<File, Info, MaxNameLength>::KillRecord(Position offset) noexcept
+{
+	const uint32_t deadHash = 0;
+	return f->Seek(offset) && f->Write(reinterpret_cast<const char *_ecv_array>(&deadHash), sizeof(deadHash));
+}
+
+// Storing a record kills any earlier records for the same file name, so there is at most one live record for each file and we can stop at the first one
+template<class File, class Info, size_t MaxNameLength> bool FileInfoIndexFile<File, Info, MaxNameLength>::Find(const char *_ecv_array fileName, Info& info) noexcept
+{
+	const uint32_t hash = HashName(fileName);
+	const size_t nameLength = strlen(fileName);
+	IndexRecord rec;
+	for (Position offset = FirstRecordOffset(); ReadRecordHeader(offset, rec.hdr); offset += RecordLength(rec.hdr.nameLength))
+	{
+		if (ReadRecordIfNameMatches(rec, fileName, hash, nameLength))
+		{
+			info = rec.info;
+			return true;
+		}
+	}
+	return false;
+}
+
+template<class File, class Info, size_t MaxNameLength> typename FileInfoIndexFile<File, Info, MaxNameLength>::Position
+FileInfoIndexFile<File, Info, MaxNameLength>::KillMatchingRecords(const char *_ecv_array fileName, Position& liveBytes, Position& deadBytes) noexcept
+{
+	const uint32_t hash = HashName(fileName);
+	const size_t nameLength = strlen(fileName);
+	liveBytes = deadBytes = 0;
+	Position offset = FirstRecordOffset();
+	IndexRecord rec;
+	while (ReadRecordHeader(offset, rec.hdr))
+	{
+		const Position length = RecordLength(rec.hdr.nameLength);
+		if (ReadRecordIfNameMatches(rec, fileName, hash, nameLength))
+		{
+			(void)KillRecord(offset);
+			deadBytes += length;
+		}
+		else if (rec.hdr.nameHash == 0)
+		{
+			deadBytes += length;
+		}
+		else
+		{
+			liveBytes += length;
+		}
+		offset += length;
+	}
+	return offset;
+}
+
+template<class File, class Info, size_t MaxNameLength> typename FileInfoIndexFile<File, Info, MaxNameLength>::Position
+FileInfoIndexFile<File, Info, MaxNameLength>::Compact() noexcept
+{
+	Position readOffset = FirstRecordOffset(), writeOffset = FirstRecordOffset();
+	IndexRecord rec;
+	while (ReadRecordHeader(readOffset, rec.hdr))
+	{
+		const Position length = RecordLength(rec.hdr.nameLength);
+		if (ReadRecordBody(rec))
+		{
+			if (writeOffset != readOffset && !WriteRecord(writeOffset, rec))
+			{
+				break;
+			}
+			writeOffset += length;
+		}
+		readOffset += length;
+	}
+	return writeOffset;
+}
+
+template<class File, class Info, size_t MaxNameLength>
+bool FileInfoIndexFile<File, Info, MaxNameLength>::PrepareToStore(const char *_ecv_array fileName, Position minDeadBytesToCompact, Position& endOfRecords, bool& compacted) noexcept
+{
+	compacted = false;
+	if (!ReadHeader())
+	{
+		endOfRecords = FirstRecordOffset();
+		return WriteHeader();										// new or incompatible index, so start again
+	}
+
+	Position liveBytes, deadBytes;
+	endOfRecords = KillMatchingRecords(fileName, liveBytes, deadBytes);
+	if (deadBytes >= minDeadBytesToCompact && deadBytes > liveBytes)
+	{
+		endOfRecords = Compact();
+		compacted = true;
+	}
+	return true;
+}
+
+template<class File, class Info, size_t MaxNameLength> bool FileInfoIndexFile<File, Info, MaxNameLength>::Append(Position offset, const char *_ecv_array fileName, const Info& info) noexcept
+{
+	const size_t nameLength = strlen(fileName);
+	if (nameLength == 0 || nameLength >= MaxNameLength)
+	{
+		return false;
+	}
+
+	IndexRecord rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.hdr.nameHash = HashName(fileName);
+	rec.hdr.nameLength = nameLength;
+	memcpy(rec.name, fileName, nameLength);
+	rec.info = info;
+	rec.hdr.checksum = rec.CalcChecksum();
+	return WriteRecord(offset, rec) && f->Truncate();
+}
+
+#endif /* SRC_STORAGE_FILEINFOINDEXFILE_H_ */
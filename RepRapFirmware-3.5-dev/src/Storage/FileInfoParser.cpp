@@ -12,6 +12,10 @@
 #include <PrintMonitor/PrintMonitor.h>
 #include <GCodes/GCodes.h>
 
+#if SUPPORT_FILE_INFO_INDEX
+# include "FileInfoIndex.h"
+#endif
+
 #if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
 
 FileInfoParser::FileInfoParser() noexcept
@@ -61,6 +65,10 @@ GCodeResult FileInfoParser::GetFileInfo(const char *filePath, GCodeFileInfo& inf
 			return GCodeResult::error;
 		}
 
+#if SUPPORT_COMPACT_GCODE
+		(void)fileBeingParsed->UseCompactGCodeReader();		// if it's a compact GCode file then parse the original text
+#endif
+
 		// File has been opened, let's start now
 		filenameBeingParsed.copy(filePath);
 		fileOverlapLength = 0;
@@ -81,7 +89,11 @@ GCodeResult FileInfoParser::GetFileInfo(const char *filePath, GCodeFileInfo& inf
 		}
 
 		// If the file is empty or not a G-Code file, we don't need to parse anything
-		constexpr const char *GcodeFileExtensions[] = { ".gcode", ".g", ".gco", ".gc", ".nc" };
+		constexpr const char *GcodeFileExtensions[] = { ".gcode", ".g", ".gco", ".gc", ".nc"
+#if SUPPORT_COMPACT_GCODE
+															, ".cgcode"
+#endif
+														};
 		bool isGcodeFile = false;
 		for (const char *ext : GcodeFileExtensions)
 		{
@@ -92,7 +104,11 @@ GCodeResult FileInfoParser::GetFileInfo(const char *filePath, GCodeFileInfo& inf
 			}
 		}
 
-		if (fileBeingParsed->Length() == 0 || !isGcodeFile)
+		if (fileBeingParsed->Length() == 0 || !isGcodeFile
+#if SUPPORT_FILE_INFO_INDEX
+			|| FileInfoIndex::Lookup(filePath, parsedFileInfo)		// if we parsed this file before and it hasn't changed then we don't need to parse it again
+#endif
+		   )
 		{
 			fileBeingParsed->Close();
 			parsedFileInfo.incomplete = false;
@@ -343,6 +359,9 @@ GCodeResult FileInfoParser::GetFileInfo(const char *filePath, GCodeFileInfo& inf
 						parsedFileInfo.numLayers = lrintf(parsedFileInfo.objectHeight / parsedFileInfo.layerHeight);
 					}
 					parsedFileInfo.incomplete = false;
+#if SUPPORT_FILE_INFO_INDEX
+					FileInfoIndex::Store(filePath, parsedFileInfo);
+#endif
 					info = parsedFileInfo;
 					return GCodeResult::ok;
 				}
@@ -374,6 +393,17 @@ GCodeResult FileInfoParser::GetFileInfo(const char *filePath, GCodeFileInfo& inf
 	return GCodeResult::notFinished;
 }
 
+#if SUPPORT_FILE_INFO_INDEX
+
+// Forget any stored information about a file because it has just been written
+void FileInfoParser::FileWritten(const char *filePath) noexcept
+{
+	MutexLocker lock(parserMutex);
+	FileInfoIndex::Remove(filePath);
+}
+
+#endif
+
 // Scan the buffer for a G1 Zxxx command. The buffer is null-terminated.
 // This parsing algorithm needs to be fast. The old one sometimes took 5 seconds or more to parse about 120K of data.
 // To speed up parsing, we now parse forwards from the start of the buffer. This means we can't stop when we have found a G1 Z command,
@@ -47,6 +47,10 @@ public:
 	// The following method needs to be called repeatedly until it doesn't return GCodeResult::notFinished - this may take a few runs
 	GCodeResult GetFileInfo(const char *filePath, GCodeFileInfo& info, bool quitEarly) noexcept;
 
+#if SUPPORT_FILE_INFO_INDEX
+	void FileWritten(const char *_ecv_array filePath) noexcept;
+#endif
+
 	static constexpr const char *_ecv_array SimulatedTimeString = "\n; Simulated print time";	// used by FileInfoParser and MassStorage
 
 private:
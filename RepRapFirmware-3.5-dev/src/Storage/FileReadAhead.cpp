@@ -0,0 +1,256 @@
+/*
+ * FileReadAhead.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ */
+
+#include "FileReadAhead.h"
+
+#if SUPPORT_FILE_READ_AHEAD
+
+#include "MassStorage.h"
+#include <Platform/RepRap.h>
+#include <Platform/Platform.h>
+#include <Platform/TaskPriorities.h>
+#include <Movement/StepTimer.h>
+#include <AppNotifyIndices.h>
+
+constexpr size_t ReadAheadTaskStackWords = 400;		// FileStore::Read reports read errors using MessageF as well as calling FatFs, so we need as much stack as the write-behind task
+
+static Task<ReadAheadTaskStackWords> *_ecv_null readAheadTask = nullptr;
+
+extern "C" [[noreturn]] void ReadAheadTaskStart(void *param) noexcept
+{
+	FileReadAhead::TaskLoop();
+}
+
+constexpr uint32_t FileReadAhead::LatencyBucketLimits[];
+
+Mutex FileReadAhead::mutex;
+FileReadAhead *_ecv_null FileReadAhead::readers[MaxReaders] = { nullptr };
+std::atomic<size_t> FileReadAhead::numReaders = 0;
+uint32_t FileReadAhead::latencyCounts[NumLatencyBuckets] = { 0 };
+uint32_t FileReadAhead::maxLatency = 0;
+uint32_t FileReadAhead::numReads = 0;
+
+#if SAME70
+// FatFs only transfers whole sectors directly into the caller's buffer if the buffer is in non-cached RAM, otherwise it copies every sector through the
+// single FF_FS_TINY window. So on the SAME70 the buffers live in the non-cached RAM section, like the sector and write buffers in MassStorage.
+alignas(4) static __nocache char readerBuffers[FileReadAhead::MaxReaders][FileReadAhead::NumBuffers][FileReadAhead::BufferSize];
+#endif
+
+// Create a new reader. The readers and the task are created when a file input first needs one, so that they use no memory on machines that don't print from SD card.
+// Readers are never deleted because file inputs are never deleted.
+/*static*/ FileReadAhead *_ecv_null FileReadAhead::Create() noexcept
+{
+	if (numReaders == MaxReaders)
+	{
+		return nullptr;
+	}
+
+	if (readAheadTask == nullptr)
+	{
+		mutex.Create("ReadAhead");
+		readAheadTask = new Task<ReadAheadTaskStackWords>();
+		readAheadTask->Create(ReadAheadTaskStart, "READAHEAD", nullptr, TaskPriority::ReadAheadPriority);
+	}
+
+#if SAME70
+	FileReadAhead *const reader = new FileReadAhead(readerBuffers[numReaders]);
+#else
+	FileReadAhead *const reader = new FileReadAhead(new char[NumBuffers][BufferSize]);	// the allocator returns 32-bit aligned memory, which is what HSMCI needs
+#endif
+	readers[numReaders] = reader;
+	++numReaders;											// do this after storing the pointer, because the task may be looking at the readers
+	return reader;
+}
+
+// Start reading ahead from the current position of the file. Return true if successful.
+bool FileReadAhead::Start(const FileData& file) noexcept
+{
+	if (active)
+	{
+		return false;
+	}
+
+	MutexLocker lock(mutex);
+	readFile.Set(MassStorage::DuplicateOpenHandle(file.GetUnderlyingFile()));
+	if (!readFile.IsLive())
+	{
+		return false;
+	}
+
+	readPosition = consumerPosition = file.GetPosition();
+	if (!readFile.Seek(readPosition))
+	{
+		readFile.Close();
+		return false;
+	}
+
+	sourceFile.CopyFrom(file);
+	consumedInBuffer = 0;
+	buffersFilled = 0;
+	buffersConsumed = 0;
+	endReached = false;
+	readFailed = false;
+	active = true;
+	readAheadTask->Give(NotifyIndices::FileReadAhead);
+	return true;
+}
+
+// Stop reading ahead. If the task is reading the file then we wait for it to finish.
+void FileReadAhead::Stop() noexcept
+{
+	if (active)
+	{
+		MutexLocker lock(mutex);
+		active = false;
+		readFile.Close();
+		sourceFile.Close();
+	}
+}
+
+// Get the data at the current position. The caller must call Consume to say how much of it was used before calling this again.
+ReadAheadResult FileReadAhead::GetData(const char *_ecv_array& data, size_t& length) noexcept
+{
+	// Read the end and error flags before we check for data, because the task sets them after it has filled the last buffer
+	const bool failed = readFailed;
+	const bool ended = endReached;
+	const uint32_t consumed = buffersConsumed;
+	if (buffersFilled != consumed)
+	{
+		const size_t index = consumed % NumBuffers;
+		data = buffers[index] + consumedInBuffer;
+		length = bufferLengths[index] - consumedInBuffer;
+		return ReadAheadResult::haveData;
+	}
+	return (failed) ? ReadAheadResult::error : (ended) ? ReadAheadResult::endOfFile : ReadAheadResult::notReady;
+}
+
+// Advance the current position. When all the data in a buffer has been used, hand the buffer back to the task to be filled again.
+void FileReadAhead::Consume(size_t length) noexcept
+{
+	if (length != 0)
+	{
+		const uint32_t consumed = buffersConsumed;
+		consumedInBuffer += length;
+		consumerPosition += length;
+		if (consumedInBuffer >= bufferLengths[consumed % NumBuffers])
+		{
+			consumedInBuffer = 0;
+			buffersConsumed = consumed + 1;
+			readAheadTask->Give(NotifyIndices::FileReadAhead);
+		}
+	}
+}
+
+// Read-ahead task. Keep filling the empty buffers of all the readers until none of them has anything to do, then wait to be woken up.
+/*static*/ [[noreturn]] void FileReadAhead::TaskLoop() noexcept
+{
+	for (;;)
+	{
+		(void)TaskBase::TakeIndexed(NotifyIndices::FileReadAhead);
+		bool busy;
+		do
+		{
+			busy = false;
+			for (size_t i = 0; i < numReaders; ++i)
+			{
+				MutexLocker lock(mutex);
+				busy = readers[i]->FillBuffer() || busy;
+			}
+		} while (busy);
+	}
+}
+
+// Fill the next buffer if we are active and there is one free. Return true if we filled a buffer. Called by the task with the mutex held.
+bool FileReadAhead::FillBuffer() noexcept
+{
+	const uint32_t filled = buffersFilled;
+	if (!active || endReached || readFailed || filled - buffersConsumed == NumBuffers)
+	{
+		return false;
+	}
+
+	// Read up to the next sector boundary, so that subsequent reads are of whole aligned sectors. FatFs transfers those directly into the buffer
+	// if the buffer is suitable for DMA, which it is because of where FileReadAhead::Create puts it.
+	const size_t index = filled % NumBuffers;
+	const size_t bytesToRead = BufferSize - (readPosition % SectorSize);
+	const uint32_t startTime = StepTimer::GetTimerTicks();
+	const int bytesRead = readFile.Read(buffers[index], bytesToRead);
+	RecordLatency(StepTimer::TicksToIntegerMicroseconds(StepTimer::GetTimerTicks() - startTime));
+	if (bytesRead <= 0)
+	{
+		if (bytesRead < 0)
+		{
+			readFailed = true;								// FileStore::Read has already reported the error
+		}
+		else
+		{
+			endReached = true;
+		}
+		return false;
+	}
+
+	bufferLengths[index] = (size_t)bytesRead;
+	readPosition += (FilePosition)bytesRead;
+	buffersFilled = filled + 1;
+	return true;
+}
+
+/*static*/ void FileReadAhead::RecordLatency(uint32_t microseconds) noexcept
+{
+	size_t bucket = 0;
+	while (bucket < NumLatencyBuckets - 1 && microseconds > LatencyBucketLimits[bucket])
+	{
+		++bucket;
+	}
+	++latencyCounts[bucket];
+	++numReads;
+	if (microseconds > maxLatency)
+	{
+		maxLatency = microseconds;
+	}
+}
+
+// Return an upper bound for the specified percentile of the read latency in microseconds
+/*static*/ uint32_t FileReadAhead::GetLatencyPercentile(unsigned int percent) noexcept
+{
+	const uint32_t threshold = (numReads * percent + 99)/100;
+	uint32_t count = 0;
+	for (size_t bucket = 0; bucket < NumLatencyBuckets - 1; ++bucket)
+	{
+		count += latencyCounts[bucket];
+		if (count >= threshold)
+		{
+			return min<uint32_t>(LatencyBucketLimits[bucket], maxLatency);
+		}
+	}
+	return maxLatency;
+}
+
+/*static*/ void FileReadAhead::Diagnostics(MessageType mtype) noexcept
+{
+	unsigned int numActive = 0;
+	for (size_t i = 0; i < numReaders; ++i)
+	{
+		if (!readers[i]->IsIdle())
+		{
+			++numActive;
+		}
+	}
+	reprap.GetPlatform().MessageF(mtype, "File read-ahead %u of %u active, reads %" PRIu32 ", latency p50 %.1fms p90 %.1fms p99 %.1fms max %.1fms\n",
+									numActive, (unsigned int)numReaders, numReads,
+									(double)(GetLatencyPercentile(50) * 0.001), (double)(GetLatencyPercentile(90) * 0.001), (double)(GetLatencyPercentile(99) * 0.001),
+									(double)(maxLatency * 0.001));
+	for (uint32_t& count : latencyCounts)
+	{
+		count = 0;
+	}
+	numReads = maxLatency = 0;
+}
+
+#endif	// SUPPORT_FILE_READ_AHEAD
+
+// End
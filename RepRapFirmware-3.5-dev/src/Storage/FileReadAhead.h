@@ -0,0 +1,95 @@
+/*
+ * FileReadAhead.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Background reading of a GCode file ahead of the position being parsed into a ring of large buffers, so that slow SD card reads
+ * (e.g. when FatFs has to follow the cluster chain, or when the card is busy) don't hold up the task that parses the file.
+ * Each file input that prints files has its own FileReadAhead, so both input streams of a machine with multiple motion systems can use it.
+ * A single task fills the buffers of all of them. The reader uses its own duplicate of the file handle, so the position of the original handle
+ * doesn't change while the file is being read ahead. The consumer is responsible for setting the position of the original handle
+ * if it stops reading ahead and continues reading the file directly.
+ */
+
+#ifndef SRC_STORAGE_FILEREADAHEAD_H_
+#define SRC_STORAGE_FILEREADAHEAD_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_FILE_READ_AHEAD
+
+#include "FileData.h"
+#include <RTOSIface/RTOSIface.h>
+#include <atomic>
+
+enum class ReadAheadResult : uint8_t { haveData, notReady, endOfFile, error };
+
+class FileReadAhead
+{
+public:
+#if SAME70
+	static constexpr size_t NumBuffers = 4;
+	static constexpr size_t BufferSize = 2048;
+#else
+	static constexpr size_t NumBuffers = 3;
+	static constexpr size_t BufferSize = 1024;
+#endif
+	static constexpr size_t SectorSize = 512;
+	static constexpr FilePosition MinimumRemainingLength = 2 * BufferSize;	// don't bother reading ahead if the file has less than this left to read
+	static constexpr size_t MaxReaders = 2;									// one for each file input, see GCodes::GCodes
+
+	static_assert(BufferSize % SectorSize == 0);
+
+	static FileReadAhead *_ecv_null Create() noexcept;						// create a new reader, or return nullptr if there are already MaxReaders
+
+	bool IsIdle() const noexcept { return !active; }
+	bool IsReadingFor(const FileData& file) const noexcept { return active && sourceFile == file; }
+
+	bool Start(const FileData& file) noexcept;								// start reading ahead from the current position of the file
+	void Stop() noexcept;													// stop reading ahead and release the file
+
+	ReadAheadResult GetData(const char *_ecv_array& data, size_t& length) noexcept;	// get the data at the current position without consuming it
+	void Consume(size_t length) noexcept;									// advance the current position, releasing the buffer if we have used all its data
+	FilePosition GetPosition() const noexcept { return consumerPosition; }	// get the file position of the next byte that hasn't been consumed
+
+	static void Diagnostics(MessageType mtype) noexcept;
+
+	[[noreturn]] static void TaskLoop() noexcept;
+
+private:
+	static constexpr size_t NumLatencyBuckets = 10;
+	static constexpr uint32_t LatencyBucketLimits[NumLatencyBuckets - 1] = { 250, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000 };	// microseconds
+
+	explicit FileReadAhead(char (*_ecv_array p_buffers)[BufferSize]) noexcept : buffers(p_buffers) { }
+
+	bool FillBuffer() noexcept;												// called by the task to fill the next buffer, returns false if there is nothing to do
+
+	static void RecordLatency(uint32_t microseconds) noexcept;
+	static uint32_t GetLatencyPercentile(unsigned int percent) noexcept;
+
+	static Mutex mutex;												// held by the task while it reads into a buffer, and by a client while it starts or stops reading ahead
+	static FileReadAhead *_ecv_null readers[MaxReaders];
+	static std::atomic<size_t> numReaders;
+
+	volatile bool active = false;									// true if we are reading ahead for our client
+	FileData sourceFile;											// the client's handle of the file we are reading ahead
+	FileData readFile;												// our duplicate handle of the file
+	FilePosition readPosition = 0;									// the file position at which the next buffer will be read
+	FilePosition consumerPosition = 0;								// the file position of the next byte to be consumed
+	size_t consumedInBuffer = 0;									// how many bytes of the oldest full buffer have been consumed
+	std::atomic<uint32_t> buffersFilled = 0;						// total number of buffers filled, only written by the task
+	std::atomic<uint32_t> buffersConsumed = 0;						// total number of buffers consumed, only written by the client
+	std::atomic<bool> endReached = false;
+	std::atomic<bool> readFailed = false;
+	size_t bufferLengths[NumBuffers];								// the number of bytes read into each buffer
+	char (*_ecv_array buffers)[BufferSize];							// NumBuffers buffers, see FileReadAhead::Create for where they live
+
+	static uint32_t latencyCounts[NumLatencyBuckets];
+	static uint32_t maxLatency;
+	static uint32_t numReads;
+};
+
+#endif	// SUPPORT_FILE_READ_AHEAD
+
+#endif /* SRC_STORAGE_FILEREADAHEAD_H_ */
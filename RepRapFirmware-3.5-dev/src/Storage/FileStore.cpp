@@ -22,6 +22,10 @@
 # include <SBC/SbcInterface.h>
 #endif
 
+#if SUPPORT_COMPACT_GCODE
+# include "CompactGCodeReader.h"
+#endif
+
 FileStore::FileStore() noexcept
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 	: writeBuffer(nullptr)
@@ -47,6 +51,12 @@ void FileStore::Init() noexcept
 #if HAS_EMBEDDED_FILES || HAS_SBC_INTERFACE
 	offset = 0;
 #endif
+#if SUPPORT_COMPACT_GCODE
+	compactReader = nullptr;
+#endif
+#if HAS_MASS_STORAGE && FF_USE_FASTSEEK
+	clusterMapFailed = false;
+#endif
 }
 
 // Open a local file (for example on an SD card).
@@ -163,6 +173,9 @@ bool FileStore::Open(const char *_ecv_array filePath, OpenMode mode, uint32_t pr
 	calcCrc = (mode == OpenMode::writeWithCrc);
 	usageMode = (writing) ? FileUseMode::readWrite : FileUseMode::readOnly;
 	openCount = 1;
+# if HAS_MASS_STORAGE && FF_USE_FASTSEEK
+	clusterMapFailed = false;
+# endif
 # if HAS_MASS_STORAGE
 	if (preAllocSize != 0 && (mode == OpenMode::write || mode == OpenMode::writeWithCrc))
 	{
@@ -234,6 +247,9 @@ bool FileStore::Close() noexcept
 				{
 					MassStorage::ReleaseWriteBuffer(wb);
 				}
+#endif
+#if SUPPORT_COMPACT_GCODE
+				DeleteObject(compactReader);
 #endif
 				usageMode = FileUseMode::free;
 			}
@@ -243,6 +259,17 @@ bool FileStore::Close() noexcept
 }
 
 bool FileStore::Seek(FilePosition pos) noexcept
+{
+#if SUPPORT_COMPACT_GCODE
+	if (compactReader != nullptr && (usageMode == FileUseMode::readOnly || usageMode == FileUseMode::readWrite))
+	{
+		return compactReader->Seek(pos);
+	}
+#endif
+	return SeekRaw(pos);
+}
+
+bool FileStore::SeekRaw(FilePosition pos) noexcept
 {
 	switch (usageMode)
 	{
@@ -264,7 +291,7 @@ bool FileStore::Seek(FilePosition pos) noexcept
 		}
 #endif
 #if HAS_MASS_STORAGE
-		return f_lseek(&file, pos) == FR_OK;
+		return SeekFile(pos) == FR_OK;
 #elif HAS_EMBEDDED_FILES
 		offset = min<FilePosition>(pos, EmbeddedFiles::Length(fileIndex));
 		return true;
@@ -280,6 +307,12 @@ bool FileStore::Seek(FilePosition pos) noexcept
 
 FilePosition FileStore::Position() const noexcept
 {
+#if SUPPORT_COMPACT_GCODE
+	if (compactReader != nullptr)
+	{
+		return (usageMode == FileUseMode::readOnly || usageMode == FileUseMode::readWrite) ? compactReader->Position() : 0;
+	}
+#endif
 #if HAS_SBC_INTERFACE
 	if (reprap.UsingSbcInterface())
 	{
@@ -304,6 +337,12 @@ FilePosition FileStore::Length() const noexcept
 		return 0;
 
 	case FileUseMode::readOnly:
+#if SUPPORT_COMPACT_GCODE
+		if (compactReader != nullptr)
+		{
+			return compactReader->Length();
+		}
+#endif
 #if HAS_SBC_INTERFACE
 		if (reprap.UsingSbcInterface())
 		{
@@ -381,6 +420,17 @@ bool FileStore::Truncate() noexcept
 
 // Returns the number of bytes read or -1 if the read process failed
 int FileStore::Read(char *_ecv_array extBuf, size_t nBytes) noexcept
+{
+#if SUPPORT_COMPACT_GCODE
+	if (compactReader != nullptr && (usageMode == FileUseMode::readOnly || usageMode == FileUseMode::readWrite))
+	{
+		return compactReader->Read(extBuf, nBytes);
+	}
+#endif
+	return ReadRaw(extBuf, nBytes);
+}
+
+int FileStore::ReadRaw(char *_ecv_array extBuf, size_t nBytes) noexcept
 {
 	switch (usageMode)
 	{
@@ -404,12 +454,15 @@ int FileStore::Read(char *_ecv_array extBuf, size_t nBytes) noexcept
 #if HAS_MASS_STORAGE
 		{
 			UINT bytes_read;
+			const uint32_t startTime = StepTimer::GetTimerTicks();
 			const FRESULT readStatus = f_read(&file, extBuf, nBytes, &bytes_read);
 			if (readStatus != FR_OK)
 			{
 				reprap.GetPlatform().MessageF(ErrorMessage, "Cannot read file, error code %d\n", (int)readStatus);
 				return -1;
 			}
+			totalReadTicks += StepTimer::GetTimerTicks() - startTime;
+			totalBytesRead += bytes_read;
 			return (int)bytes_read;
 		}
 #elif HAS_EMBEDDED_FILES
@@ -468,6 +521,10 @@ int FileStore::ReadLine(char *_ecv_array buf, size_t nBytes) noexcept
 
 bool FileStore::ForceClose() noexcept
 {
+#if SUPPORT_COMPACT_GCODE
+	DeleteObject(compactReader);
+#endif
+
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 	bool ok = true;
 	if (usageMode == FileUseMode::readWrite)
@@ -734,6 +791,98 @@ uint32_t FileStore::ClusterSize() const noexcept
 	return (usageMode == FileUseMode::readOnly || usageMode == FileUseMode::readWrite) ? file.obj.fs->csize * 512u : 1;	// we divide by the cluster size so return 1 not 0 if there is an error
 }
 
+// Seek the underlying FatFs file. If the file is open read-only and FatFs would have to follow the FAT chain from the start of the file
+// or across more than one cluster to get to the new position, first try to build a cluster map so that this and later seeks don't need to read the FAT.
+// We don't use cluster maps for files that we may write because FatFs can't extend a file in fast seek mode.
+FRESULT FileStore::SeekFile(FilePosition pos) noexcept
+{
+	const uint32_t clusterSize = ClusterSize();
+	const uint32_t currentCluster = file.fptr/clusterSize;
+	const uint32_t newCluster = pos/clusterSize;
+#if FF_USE_FASTSEEK
+	if (file.cltbl == nullptr && !clusterMapFailed && usageMode == FileUseMode::readOnly)
+	{
+		if (newCluster != 0 && (newCluster < currentCluster || newCluster > currentCluster + 1))
+		{
+			BuildClusterMap();
+		}
+	}
+	const size_t seekType = (file.cltbl != nullptr) ? 1 : 0;
+#else
+	const size_t seekType = 0;
+#endif
+
+	const uint32_t startTime = StepTimer::GetTimerTicks();
+	const FRESULT rslt = f_lseek(&file, pos);
+	if (newCluster != currentCluster)
+	{
+		const uint32_t ticks = StepTimer::GetTimerTicks() - startTime;
+		++numLongSeeks[seekType];
+		longSeekTicks[seekType] += ticks;
+		if (ticks > longestSeekTicks[seekType])
+		{
+			longestSeekTicks[seekType] = ticks;
+		}
+	}
+	return rslt;
+}
+
+#if FF_USE_FASTSEEK
+
+uint32_t FileStore::clusterMapsBuilt = 0;
+uint32_t FileStore::clusterMapsFailed = 0;
+
+void FileStore::BuildClusterMap() noexcept
+{
+	clusterMap[0] = ClusterMapLength;
+	file.cltbl = clusterMap;
+	if (f_lseek(&file, CREATE_LINKMAP) == FR_OK)
+	{
+		++clusterMapsBuilt;
+	}
+	else
+	{
+		// Most likely the file has too many fragments, so carry on using the FAT chain
+		file.cltbl = nullptr;
+		clusterMapFailed = true;
+		++clusterMapsFailed;
+	}
+}
+
+#endif
+
+uint32_t FileStore::numLongSeeks[2] = { 0 };
+uint32_t FileStore::longSeekTicks[2] = { 0 };
+uint32_t FileStore::longestSeekTicks[2] = { 0 };
+uint64_t FileStore::totalBytesRead = 0;
+uint64_t FileStore::totalReadTicks = 0;
+
+/*static*/ void FileStore::Diagnostics(MessageType mtype) noexcept
+{
+	Platform& p = reprap.GetPlatform();
+	const char *_ecv_array const seekTypeNames[2] = { "FAT chain", "cluster map" };
+	for (size_t i = 0; i < 2; ++i)
+	{
+		p.MessageF(mtype, "Seeks to another cluster using %s %" PRIu32 ", average %.2fms, longest %.2fms\n",
+						seekTypeNames[i], numLongSeeks[i],
+						(double)((numLongSeeks[i] == 0) ? 0.0 : (float)longSeekTicks[i] * StepClocksToMillis/(float)numLongSeeks[i]),
+						(double)((float)longestSeekTicks[i] * StepClocksToMillis));
+		numLongSeeks[i] = longSeekTicks[i] = longestSeekTicks[i] = 0;
+	}
+
+	// Bytes per microsecond is the same as MB/sec
+	const float readMicroseconds = (float)totalReadTicks * (1000000.0f/StepClockRate);
+	p.MessageF(mtype, "File data read %.1fKb at %.2fMB/sec\n",
+					(double)((float)totalBytesRead/1024.0f), (double)((readMicroseconds == 0.0f) ? 0.0f : (float)totalBytesRead/readMicroseconds));
+	totalBytesRead = totalReadTicks = 0;
+
+#if FF_USE_FASTSEEK
+	p.MessageF(mtype, "Cluster maps built %" PRIu32 ", too fragmented %" PRIu32 ", RAM %u bytes\n",
+					clusterMapsBuilt, clusterMapsFailed, MAX_FILES * ClusterMapLength * sizeof(DWORD));
+	clusterMapsBuilt = clusterMapsFailed = 0;
+#endif
+}
+
 
 #endif	// HAS_MASS_STORAGE
 
@@ -744,36 +893,32 @@ bool FileStore::GoToEnd()
 	return Seek(Length());
 }
 
-// Provide a cluster map for fast seeking. Needs _USE_FASTSEEK defined as 1 in conf_fatfs to make any difference.
-// The first element of the table must be set to the total number of 32-bit entries in the table before calling this.
-bool FileStore::SetClusterMap(uint32_t tbl[]) noexcept
-{
-	switch (usageMode)
-	{
-	case FileUseMode::free:
-		INTERNAL_ERROR;
-		return false;
+#endif
 
-	case FileUseMode::readOnly:
-	case FileUseMode::readWrite:
-		{
-			file.cltbl = tbl;
-			const FRESULT ret = f_lseek(&file, CREATE_LINKMAP);
-//			debugPrintf("ret %d need %u\n", (int)ret, tbl[0]);
-			return ret == FR_OK;
-		}
+#endif	// HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 
-	case FileUseMode::invalidated:
-	default:
+#if SUPPORT_COMPACT_GCODE
+
+// If this file is in compact GCode format then attach a decoder to it, so that it reads as the original GCode text. Return true if it is a compact GCode file.
+// The file must be open for reading and positioned at the start.
+bool FileStore::UseCompactGCodeReader() noexcept
+{
+# if HAS_SBC_INTERFACE
+	if (reprap.UsingSbcInterface())
+	{
 		return false;
 	}
+# endif
+	if (usageMode == FileUseMode::readOnly && compactReader == nullptr)
+	{
+		compactReader = CompactGCodeReader::Create(*this);
+	}
+	return compactReader != nullptr;
 }
 
 #endif
 
-#endif	// HAS_MASS_STORAGE || HAS_SBC_INTERFACE
-
-#if SUPPORT_ASYNC_MOVES && (HAS_MASS_STORAGE || HAS_EMBEDDED_FILES)
+#if (SUPPORT_ASYNC_MOVES || SUPPORT_FILE_READ_AHEAD) && (HAS_MASS_STORAGE || HAS_EMBEDDED_FILES)
 
 // Copy an open file handle to make a duplicate with its own position. Intended for use on files opened in read-only mode.
 // We assume that FatFs doesn't keep a count of open files, so it's OK for us to just make a copy of the FIL structure.
@@ -787,9 +932,21 @@ void FileStore::CopyFrom(const FileStore *f) noexcept
 	writeBuffer = nullptr;
 	crc.Reset();
 	calcCrc = false;
+# if FF_USE_FASTSEEK
+	// The copied FIL points to the other file's cluster map, so we need our own copy of it
+	clusterMapFailed = f->clusterMapFailed;
+	if (f->file.cltbl != nullptr)
+	{
+		memcpy(clusterMap, f->clusterMap, sizeof(clusterMap));
+		file.cltbl = clusterMap;
+	}
+# endif
 #endif
 	closeRequested = false;
 	openCount = 1;
+#if SUPPORT_COMPACT_GCODE
+	compactReader = (f->compactReader != nullptr) ? f->compactReader->Duplicate(*this) : nullptr;
+#endif
 	reprap.VolumesUpdated();
 }
 
@@ -13,6 +13,9 @@
 
 class Platform;
 class FileWriteBuffer;
+#if SUPPORT_COMPACT_GCODE
+class CompactGCodeReader;
+#endif
 
 #if HAS_EMBEDDED_FILES
 typedef int32_t FileIndex;
@@ -60,10 +63,14 @@ public:
 	FilePosition Position() const noexcept;						// Return the current position in the file, assuming we are reading the file
 	void Duplicate() noexcept;									// Create a second reference to this file
 
-# if SUPPORT_ASYNC_MOVES && (HAS_MASS_STORAGE || HAS_EMBEDDED_FILES)
+# if (SUPPORT_ASYNC_MOVES || SUPPORT_FILE_READ_AHEAD) && (HAS_MASS_STORAGE || HAS_EMBEDDED_FILES)
 	void CopyFrom(const FileStore *f) noexcept;					// Copy an open file handle to make a duplicate with its own position
 # endif
 
+#if SUPPORT_COMPACT_GCODE
+	bool UseCompactGCodeReader() noexcept;						// If this is a compact GCode file then read it as the original text, returning true if it is
+#endif
+
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
 	FileWriteBuffer *GetWriteBuffer() const noexcept;			// Return a pointer to the remaining space for writing
 	bool Write(char b) noexcept;								// Write 1 byte
@@ -84,9 +91,10 @@ public:
 	bool Invalidate(const FATFS *fs) noexcept;					// Invalidate the file if it uses the specified FATFS object
 	bool IsOpenOn(const FATFS *fs) const noexcept;				// Return true if the file is open on the specified file system
 	bool IsSameFile(const FIL& otherFile) const noexcept;		// Return true if the passed file is the same as ours
-# if 0	// not currently used
-	bool SetClusterMap(uint32_t[]) noexcept;					// Provide a cluster map for fast seeking
-# endif
+#endif
+
+#if HAS_MASS_STORAGE
+	static void Diagnostics(MessageType mtype) noexcept;		// Report seek time, read throughput and fast seek statistics
 #endif
 
 #if 0	// not currently used
@@ -94,9 +102,23 @@ public:
 #endif
 
 private:
+#if SUPPORT_COMPACT_GCODE
+	friend class CompactGCodeReader;
+#endif
+
 	void Init() noexcept;
+	int ReadRaw(char *_ecv_array buf, size_t nBytes) noexcept;					// Read a block of data from the file without decoding it
+	bool SeekRaw(FilePosition pos) noexcept;									// Jump to pos in the file without decoding it
 	bool Store(const char *_ecv_array s, size_t len, size_t *bytesWritten) noexcept;	// Write data to the non-volatile storage
 
+#if HAS_MASS_STORAGE
+	FRESULT SeekFile(FilePosition pos) noexcept;								// Seek the underlying FatFs file
+#endif
+
+#if HAS_MASS_STORAGE && FF_USE_FASTSEEK
+	void BuildClusterMap() noexcept;											// Try to create a cluster map so that seeks don't need to follow the FAT chain
+#endif
+
 	volatile unsigned int openCount;
 
 #if HAS_MASS_STORAGE || HAS_SBC_INTERFACE
@@ -107,6 +129,20 @@ private:
 #if HAS_MASS_STORAGE
     FIL file;
 	static uint32_t longestWriteTime;
+
+	// Statistics reported by M122 so that the effect of fast seek on seek time, and the read throughput we get, can be measured on real cards.
+	// A long seek is one to a different cluster. Index 0 is for seeks that follow the FAT chain, index 1 for seeks that use a cluster map.
+	// Files are read by more than one task and we don't lock these, so an occasional update may be lost. That doesn't matter for statistics.
+	static uint32_t numLongSeeks[2], longSeekTicks[2], longestSeekTicks[2];
+	static uint64_t totalBytesRead, totalReadTicks;
+#endif
+
+#if HAS_MASS_STORAGE && FF_USE_FASTSEEK
+	// A cluster map holds the number of entries used, then a length and start cluster for each fragment of the file, then a zero terminator
+	static constexpr size_t ClusterMapLength = 2 + 2 * 15;		// enough for a file in up to 15 fragments
+	DWORD clusterMap[ClusterMapLength];
+	bool clusterMapFailed;										// true if we tried to build a cluster map but the file has too many fragments
+	static uint32_t clusterMapsBuilt, clusterMapsFailed;
 #endif
 
 #if HAS_SBC_INTERFACE
@@ -122,6 +158,10 @@ private:
 	FilePosition offset;
 #endif
 
+#if SUPPORT_COMPACT_GCODE
+	CompactGCodeReader *_ecv_null compactReader;				// the decoder if this is a compact GCode file being read as text
+#endif
+
 	volatile bool closeRequested;
 	FileUseMode usageMode;
 
@@ -0,0 +1,231 @@
+/*
+ * FileWriteBehind.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ */
+
+#include "FileWriteBehind.h"
+
+#if SUPPORT_UPLOAD_WRITE_BEHIND
+
+#include <Platform/RepRap.h>
+#include <Platform/Platform.h>
+#include <Platform/TaskPriorities.h>
+#include <AppNotifyIndices.h>
+
+constexpr size_t WriteBehindTaskStackWords = 400;		// FileStore::Write may report an error message as well as calling FatFs
+
+static Task<WriteBehindTaskStackWords> *_ecv_null writeBehindTask = nullptr;
+
+extern "C" [[noreturn]] void WriteBehindTaskStart(void *param) noexcept
+{
+	FileWriteBehind::TaskLoop();
+}
+
+Mutex FileWriteBehind::mutex;
+const UploadingNetworkResponder *_ecv_null volatile FileWriteBehind::owner = nullptr;
+FileData FileWriteBehind::targetFile;
+size_t FileWriteBehind::fillLength = 0;
+std::atomic<uint32_t> FileWriteBehind::buffersQueued = 0;
+std::atomic<uint32_t> FileWriteBehind::buffersWritten = 0;
+std::atomic<bool> FileWriteBehind::writeFailed = false;
+FileWriteBehind::BufferRing *_ecv_null FileWriteBehind::buffers = nullptr;
+TaskBase *_ecv_null volatile FileWriteBehind::waitingClient = nullptr;
+uint32_t FileWriteBehind::whenStarted = 0;
+uint32_t FileWriteBehind::bytesThisUpload = 0;
+uint32_t FileWriteBehind::uploadsFinished = 0;
+uint32_t FileWriteBehind::kilobytesUploaded = 0;
+uint32_t FileWriteBehind::uploadMillis = 0;
+uint32_t FileWriteBehind::numStalls = 0;
+uint32_t FileWriteBehind::totalStallMillis = 0;
+uint32_t FileWriteBehind::maxStallMillis = 0;
+
+// Start writing behind to the file at its current position. Return true if successful, false if we are already writing another upload.
+// The task and the buffers are created the first time we are called.
+/*static*/ bool FileWriteBehind::Start(const UploadingNetworkResponder *client, const FileData& p_file) noexcept
+{
+	if (owner != nullptr || !p_file.IsLive())
+	{
+		return false;
+	}
+
+#if HAS_SBC_INTERFACE
+	if (reprap.UsingSbcInterface())
+	{
+		return false;								// the SBC receives uploads itself, and its file writes must be made from the SBC task
+	}
+#endif
+
+	if (writeBehindTask == nullptr)
+	{
+		mutex.Create("WriteBehind");
+		buffers = new BufferRing;
+		writeBehindTask = new Task<WriteBehindTaskStackWords>();
+		writeBehindTask->Create(WriteBehindTaskStart, "WRITEBEHIND", nullptr, TaskPriority::WriteBehindPriority);
+	}
+
+	MutexLocker lock(mutex);
+	targetFile.CopyFrom(p_file);
+	fillLength = 0;
+	buffersQueued = 0;
+	buffersWritten = 0;
+	writeFailed = false;
+	bytesThisUpload = 0;
+	whenStarted = millis();
+	owner = client;
+	return true;
+}
+
+// Copy some data into the buffers, handing each buffer to the task when it is full.
+// We only start filling a buffer when the task has finished writing the data that was previously in it, so we may have to wait here.
+/*static*/ bool FileWriteBehind::Write(const uint8_t *_ecv_array data, size_t length) noexcept
+{
+	while (length != 0)
+	{
+		if (fillLength == 0)
+		{
+			WaitForBuffers(NumBuffers - 1, true);
+		}
+		if (writeFailed)
+		{
+			return false;
+		}
+
+		const size_t bytesToCopy = min<size_t>(length, BufferSize - fillLength);
+		memcpy(buffers->data[buffersQueued % NumBuffers] + fillLength, data, bytesToCopy);
+		fillLength += bytesToCopy;
+		bytesThisUpload += bytesToCopy;
+		data += bytesToCopy;
+		length -= bytesToCopy;
+		if (fillLength == BufferSize)
+		{
+			QueueBuffer();
+		}
+	}
+	return true;
+}
+
+// Queue any partly-filled buffer, wait for the task to write everything and release the file
+/*static*/ bool FileWriteBehind::Finish() noexcept
+{
+	if (owner == nullptr)
+	{
+		return false;
+	}
+
+	if (fillLength != 0)
+	{
+		QueueBuffer();
+	}
+	WaitForBuffers(0, false);								// waiting for the last writes to complete is not a stall because the client has no more data to give us
+
+	MutexLocker lock(mutex);
+	owner = nullptr;
+	targetFile.Close();
+	++uploadsFinished;
+	kilobytesUploaded += (bytesThisUpload + 512)/1024;
+	uploadMillis += millis() - whenStarted;
+	return !writeFailed;
+}
+
+// Discard the queued data. If the task is writing a buffer then we wait for it to finish, after which it will leave the file alone.
+/*static*/ void FileWriteBehind::Abort() noexcept
+{
+	if (owner != nullptr)
+	{
+		MutexLocker lock(mutex);
+		owner = nullptr;
+		targetFile.Close();
+	}
+}
+
+// Hand the buffer that the client has been filling to the task
+/*static*/ void FileWriteBehind::QueueBuffer() noexcept
+{
+	const uint32_t queued = buffersQueued;
+	buffers->lengths[queued % NumBuffers] = fillLength;
+	fillLength = 0;
+	buffersQueued = queued + 1;
+	writeBehindTask->Give(NotifyIndices::FileWriteBehind);
+}
+
+// Wait until no more than the specified number of buffers are waiting to be written. If isStall is true then record how long we were held up.
+// The task wakes us up each time it finishes writing a buffer. We set waitingClient before checking the counts, so we can't miss a wakeup.
+/*static*/ void FileWriteBehind::WaitForBuffers(uint32_t maxQueued, bool isStall) noexcept
+{
+	(void)TaskBase::ClearCurrentTaskNotifyCount(NotifyIndices::FileWriteBehind);
+	waitingClient = TaskBase::GetCallerTaskHandle();
+	if (buffersQueued - buffersWritten > maxQueued && !writeFailed)
+	{
+		const uint32_t startTime = millis();
+		do
+		{
+			(void)TaskBase::TakeIndexed(NotifyIndices::FileWriteBehind);
+		} while (buffersQueued - buffersWritten > maxQueued && !writeFailed);
+
+		if (isStall)
+		{
+			const uint32_t stallMillis = millis() - startTime;
+			++numStalls;
+			totalStallMillis += stallMillis;
+			if (stallMillis > maxStallMillis)
+			{
+				maxStallMillis = stallMillis;
+			}
+		}
+	}
+	waitingClient = nullptr;
+}
+
+// Write-behind task. Whenever there is a full buffer and no write has failed, write it to the file.
+/*static*/ [[noreturn]] void FileWriteBehind::TaskLoop() noexcept
+{
+	for (;;)
+	{
+		(void)TaskBase::TakeIndexed(NotifyIndices::FileWriteBehind);
+		for (;;)
+		{
+			MutexLocker lock(mutex);
+			const uint32_t written = buffersWritten;
+			if (owner == nullptr || writeFailed || written == buffersQueued)
+			{
+				break;
+			}
+
+			const size_t index = written % NumBuffers;
+			const bool ok = targetFile.Write(buffers->data[index], buffers->lengths[index]);
+			if (ok)
+			{
+				buffersWritten = written + 1;
+			}
+			else
+			{
+				writeFailed = true;
+			}
+
+			TaskBase *_ecv_null const client = waitingClient;
+			if (client != nullptr)
+			{
+				client->Give(NotifyIndices::FileWriteBehind);		// the client task isn't the write-behind task, so it is safe to use the same index
+			}
+			if (!ok)
+			{
+				break;
+			}
+		}
+	}
+}
+
+/*static*/ void FileWriteBehind::Diagnostics(MessageType mtype) noexcept
+{
+	reprap.GetPlatform().MessageF(mtype, "Upload write-behind %s, uploads %" PRIu32 ", %" PRIu32 "KiB at %.1fKiB/s, stalls %" PRIu32 " total %" PRIu32 "ms max %" PRIu32 "ms\n",
+									(owner == nullptr) ? "idle" : "active", uploadsFinished, kilobytesUploaded,
+									(uploadMillis == 0) ? 0.0 : (double)kilobytesUploaded * 1000.0/(double)uploadMillis,
+									numStalls, totalStallMillis, maxStallMillis);
+	uploadsFinished = kilobytesUploaded = uploadMillis = numStalls = totalStallMillis = maxStallMillis = 0;
+}
+
+#endif	// SUPPORT_UPLOAD_WRITE_BEHIND
+
+// End
@@ -0,0 +1,86 @@
+/*
+ * FileWriteBehind.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Background task that writes uploaded data to a file from a ring of large buffers, so that slow SD card writes (e.g. when the card is erasing
+ * or FatFs is updating the FAT) don't stop the network task from receiving more data. The network task only waits if all the buffers are full.
+ * Only one upload is written behind at a time; other uploads are written directly. The client must not use the file between calling Start
+ * and calling Finish or Abort, because the task may be writing to it.
+ * The task and its buffers are allocated when the first upload starts, so they use no memory on machines that never receive uploads.
+ */
+
+#ifndef SRC_STORAGE_FILEWRITEBEHIND_H_
+#define SRC_STORAGE_FILEWRITEBEHIND_H_
+
+#include <RepRapFirmware.h>
+
+#if SUPPORT_UPLOAD_WRITE_BEHIND
+
+#include "FileData.h"
+#include <RTOSIface/RTOSIface.h>
+#include <Platform/Tasks.h>
+#include <atomic>
+
+class UploadingNetworkResponder;
+
+class FileWriteBehind
+{
+public:
+#if SAME70
+	static constexpr size_t NumBuffers = 4;
+	static constexpr size_t BufferSize = 4096;
+#else
+	static constexpr size_t NumBuffers = 3;
+	static constexpr size_t BufferSize = 2048;
+#endif
+
+	static bool IsWritingFor(const UploadingNetworkResponder *client) noexcept { return owner == client; }
+
+	static bool Start(const UploadingNetworkResponder *client, const FileData& file) noexcept;	// start writing behind to the file
+	static bool Write(const uint8_t *_ecv_array data, size_t length) noexcept;	// queue some data, returning false if an earlier write failed
+	static bool Finish() noexcept;											// write all queued data and release the file, returning true if all writes succeeded
+	static void Abort() noexcept;											// discard any queued data and release the file
+
+	static void Diagnostics(MessageType mtype) noexcept;
+
+	[[noreturn]] static void TaskLoop() noexcept;
+
+private:
+	// The ring of buffers. The task writes them to the file using FileStore::Write, so they don't need any special alignment.
+	struct BufferRing
+	{
+		void* operator new(size_t count) noexcept { return Tasks::AllocPermanent(count); }
+		void operator delete(void* ptr) noexcept { }
+
+		size_t lengths[NumBuffers];									// the number of bytes queued in each buffer
+		char data[NumBuffers][BufferSize];
+	};
+
+	static void QueueBuffer() noexcept;
+	static void WaitForBuffers(uint32_t maxQueued, bool isStall) noexcept;
+
+	static Mutex mutex;												// held by the task while it writes a buffer, and by the client while it releases the file
+	static const UploadingNetworkResponder *_ecv_null volatile owner;	// the client that we are writing for, or nullptr if we are idle
+	static FileData targetFile;										// our reference to the client's file
+	static size_t fillLength;										// how many bytes the client has put in the buffer it is filling
+	static std::atomic<uint32_t> buffersQueued;						// total number of buffers queued, only written by the client
+	static std::atomic<uint32_t> buffersWritten;					// total number of buffers written, only written by the task
+	static std::atomic<bool> writeFailed;
+	static BufferRing *_ecv_null buffers;							// allocated along with the task
+	static TaskBase *_ecv_null volatile waitingClient;				// the client task if it is waiting for the task to write a buffer
+
+	static uint32_t whenStarted;									// the time at which the current upload started
+	static uint32_t bytesThisUpload;
+	static uint32_t uploadsFinished;								// statistics since the last call to Diagnostics
+	static uint32_t kilobytesUploaded;
+	static uint32_t uploadMillis;
+	static uint32_t numStalls;										// times that Write had to wait for a free buffer
+	static uint32_t totalStallMillis;
+	static uint32_t maxStallMillis;
+};
+
+#endif	// SUPPORT_UPLOAD_WRITE_BEHIND
+
+#endif /* SRC_STORAGE_FILEWRITEBEHIND_H_ */
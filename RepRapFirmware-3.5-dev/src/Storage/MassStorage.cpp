@@ -19,6 +19,18 @@ static_assert(SD_MMC_MEM_CNT == NumSdCards);
 # include <SBC/SbcInterface.h>
 #endif
 
+#if SUPPORT_FILE_READ_AHEAD
+# include "FileReadAhead.h"
+#endif
+
+#if SUPPORT_FILE_INFO_INDEX
+# include "FileInfoIndex.h"
+#endif
+
+#if SUPPORT_UPLOAD_WRITE_BEHIND
+# include "FileWriteBehind.h"
+#endif
+
 #ifdef DUET3_MB6HC
 # include <GCodes/GCodeBuffer/GCodeBuffer.h>
 #endif
@@ -136,6 +148,30 @@ static SdCardInfo info[NumSdCards];
 static DIR findDir;
 #endif
 
+#if SUPPORT_DIRECTORY_CURSORS
+
+// Where a paged directory listing stopped. FAT directory entries never move, so we can resume reading the directory from here
+// until a file is created, deleted or renamed or the volume is remounted. Creating, deleting or renaming a file increments directoryChanges,
+// including temporary .part files which don't change the volume sequence number, and remounting increments the volume sequence number.
+struct FindCursor
+{
+	String<MaxFilenameLength> directory;		// the directory being listed, without a trailing '/'
+	FileInfo pendingEntry;						// the entry that the listing stopped at, which the next page starts with
+	DIR dir;									// positioned after pendingEntry
+	uint32_t whenSaved;
+	unsigned int fileNumber;					// the number of pendingEntry within the listing, as counted by the caller
+	uint32_t directoryChangesWhenSaved;
+	uint16_t seq;								// the volume sequence number when the cursor was saved
+	bool inUse;
+};
+
+constexpr size_t NumFindCursors = 2;			// allow a couple of clients to fetch long listings at the same time
+static FindCursor findCursors[NumFindCursors];
+static uint32_t findCursorHits = 0, findCursorMisses = 0;
+static uint32_t directoryChanges = 0;			// incremented whenever a directory entry may have been created, deleted or renamed on any volume
+
+#endif
+
 #if HAS_MASS_STORAGE || HAS_EMBEDDED_FILES
 static Mutex dirMutex;
 static FileInfoParser infoParser;
@@ -237,17 +273,42 @@ uint16_t MassStorage::GetVolumeSeq(unsigned int volume) noexcept
 	return info[volume].seq;
 }
 
-// If 'path' is not the name of a temporary file, update the sequence number of its volume
-// Return true if we did update the sequence number
+uint32_t MassStorage::GetStorageSeq() noexcept
+{
+	uint32_t seq = 0;
+	for (const SdCardInfo& inf : info)
+	{
+		seq += inf.seq;
+	}
+	return seq;
+}
+
+static inline unsigned int GetVolumeNumber(const char *path) noexcept
+{
+	return (isdigit(path[0]) && path[1] == ':') ? path[0] - '0' : 0;
+}
+
+// Record that a directory entry may have been created, deleted or renamed
+static inline void DirectoryChanged() noexcept
+{
+#if SUPPORT_DIRECTORY_CURSORS
+	++directoryChanges;
+#endif
+}
+
+// Record that a directory entry for 'path' may have been created, deleted or renamed.
+// If 'path' is not the name of a temporary file, update the sequence number of its volume. Return true if we did update the sequence number.
+// Clients use the sequence number to decide when to fetch file lists again, so we don't change it for temporary files that they never see.
 static bool VolumeUpdated(const char *path) noexcept
 {
+	DirectoryChanged();
 	if (!StringEndsWithIgnoreCase(path, ".part")
 #if HAS_SBC_INTERFACE
 		&& !reprap.UsingSbcInterface()
 #endif
 	   )
 	{
-		const unsigned int volume = (isdigit(path[0]) && path[1] == ':') ? path[0] - '0' : 0;
+		const unsigned int volume = GetVolumeNumber(path);
 		if (volume < ARRAY_SIZE(info))
 		{
 			++info[volume].seq;
@@ -463,9 +524,16 @@ FileStore* MassStorage::OpenFile(const char* filePath, OpenMode mode, uint32_t p
 			{
 				FileStore * const ret = (fs.Open(filePath, mode, preAllocSize)) ? &fs: nullptr;
 # if HAS_MASS_STORAGE
-				if (ret != nullptr && (mode == OpenMode::write || mode == OpenMode::writeWithCrc))
+				if (ret != nullptr)
 				{
-					(void)VolumeUpdated(filePath);
+					if (mode == OpenMode::write || mode == OpenMode::writeWithCrc)
+					{
+						(void)VolumeUpdated(filePath);
+					}
+					else if (mode == OpenMode::append && ret->Length() == 0)
+					{
+						DirectoryChanged();				// the file may have just been created
+					}
 				}
 # endif
 				return ret;
@@ -476,7 +544,7 @@ FileStore* MassStorage::OpenFile(const char* filePath, OpenMode mode, uint32_t p
 	return nullptr;
 }
 
-# if (HAS_MASS_STORAGE || HAS_EMBEDDED_FILES) && SUPPORT_ASYNC_MOVES
+# if (HAS_MASS_STORAGE || HAS_EMBEDDED_FILES) && (SUPPORT_ASYNC_MOVES || SUPPORT_FILE_READ_AHEAD)
 
 // Duplicate a file handle, with the duplicate having its own position in the file. Use only with files opened in read-only mode.
 FileStore *MassStorage::DuplicateOpenHandle(const FileStore *f) noexcept
@@ -641,6 +709,22 @@ static bool InternalDelete(const char* filePath, ErrorMessageMode errorMessageMo
 		if (!isOpen)
 		{
 			unlinkReturn = f_unlink(filePath);
+#if SUPPORT_FILE_INFO_INDEX
+			if (unlinkReturn == FR_NOT_EMPTY)
+			{
+				// The folder may contain nothing except a file info index that the user doesn't know about. If it contains other files too then
+				// deleting the index does no harm because it will be rebuilt when needed.
+				String<MaxFilenameLength> indexPath;
+				indexPath.copy(filePath);
+				if (   (indexPath.EndsWith('/') || !indexPath.cat('/'))
+					&& !indexPath.cat(FileInfoIndex::IndexFileName)
+					&& f_unlink(indexPath.c_str()) == FR_OK
+				   )
+				{
+					unlinkReturn = f_unlink(filePath);
+				}
+			}
+#endif
 		}
 	}
 
@@ -824,7 +908,11 @@ bool MassStorage::FindFirst(const char *directory, FileInfo &file_info) noexcept
 		{
 			const FRESULT res = f_readdir(&findDir, &entry);
 			if (res != FR_OK || entry.fname[0] == 0) break;
-			if (!StringEqualsIgnoreCase(entry.fname, ".") && !StringEqualsIgnoreCase(entry.fname, ".."))
+			if (!StringEqualsIgnoreCase(entry.fname, ".") && !StringEqualsIgnoreCase(entry.fname, "..")
+#if SUPPORT_FILE_INFO_INDEX
+				&& !FileInfoIndex::IsIndexFile(entry.fname)
+#endif
+			   )
 			{
 				file_info.isDirectory = (entry.fattrib & AM_DIR);
 				file_info.fileName.copy(entry.fname);
@@ -858,8 +946,15 @@ bool MassStorage::FindNext(FileInfo &file_info) noexcept
 #if HAS_MASS_STORAGE
 	FILINFO entry;
 
-	if (f_readdir(&findDir, &entry) == FR_OK && entry.fname[0] != 0)
+	while (f_readdir(&findDir, &entry) == FR_OK && entry.fname[0] != 0)
 	{
+#if SUPPORT_FILE_INFO_INDEX
+		if (FileInfoIndex::IsIndexFile(entry.fname))
+		{
+			continue;
+		}
+#endif
+
 		file_info.isDirectory = (entry.fattrib & AM_DIR);
 		file_info.size = entry.fsize;
 		file_info.fileName.copy(entry.fname);
@@ -889,6 +984,93 @@ void MassStorage::AbandonFindNext() noexcept
 	}
 }
 
+// Start listing a directory from file number 'fileNumber', as counted by the caller. If we saved the position where an earlier call to SaveFindPosition
+// left off at that file number then continue from there, otherwise start from the beginning and set fileNumber to zero.
+// The return value and mutex ownership are as for FindFirst.
+bool MassStorage::FindFirstFrom(const char *directory, FileInfo &file_info, unsigned int& fileNumber) noexcept
+{
+#if SUPPORT_DIRECTORY_CURSORS
+	if (fileNumber != 0)
+	{
+		String<MaxFilenameLength> loc;
+		loc.copy(directory);
+		if (loc.EndsWith('/') || loc.EndsWith('\\'))
+		{
+			loc.Truncate(loc.strlen() - 1);
+		}
+
+		if (!dirMutex.Take(10000))
+		{
+			return false;
+		}
+
+		const unsigned int volume = GetVolumeNumber(loc.c_str());
+		for (FindCursor& fc : findCursors)
+		{
+			if (   fc.inUse
+				&& fc.fileNumber == fileNumber
+				&& volume < ARRAY_SIZE(info)
+				&& fc.seq == info[volume].seq
+				&& fc.directoryChangesWhenSaved == directoryChanges
+				&& StringEqualsIgnoreCase(fc.directory.c_str(), loc.c_str())
+			   )
+			{
+				fc.inUse = false;
+				findDir = fc.dir;
+				file_info = fc.pendingEntry;
+				++findCursorHits;
+				return true;							// we still own the mutex
+			}
+		}
+		dirMutex.Release();
+		++findCursorMisses;
+	}
+#endif
+	fileNumber = 0;
+	return FindFirst(directory, file_info);
+}
+
+// Stop listing a directory, remembering that file_info was the most recent entry returned and that the caller numbered it 'fileNumber'.
+// The caller must own the mutex, i.e. the last call to FindFirst, FindFirstFrom or FindNext must have returned true. This releases the mutex.
+void MassStorage::SaveFindPosition(const char *directory, const FileInfo &file_info, unsigned int fileNumber) noexcept
+{
+#if SUPPORT_DIRECTORY_CURSORS
+	if (dirMutex.GetHolder() == RTOSIface::GetCurrentTask())
+	{
+		// Use a free cursor if there is one, else the one saved longest ago
+		FindCursor *best = &findCursors[0];
+		for (FindCursor& fc : findCursors)
+		{
+			if (!fc.inUse)
+			{
+				best = &fc;
+				break;
+			}
+			if (millis() - fc.whenSaved > millis() - best->whenSaved)
+			{
+				best = &fc;
+			}
+		}
+
+		best->directory.copy(directory);
+		if (best->directory.EndsWith('/') || best->directory.EndsWith('\\'))
+		{
+			best->directory.Truncate(best->directory.strlen() - 1);
+		}
+		const unsigned int volume = GetVolumeNumber(best->directory.c_str());
+		best->inUse = (volume < ARRAY_SIZE(info));
+		best->seq = (best->inUse) ? info[volume].seq : 0;
+		best->directoryChangesWhenSaved = directoryChanges;
+		best->dir = findDir;
+		best->pendingEntry = file_info;
+		best->fileNumber = fileNumber;
+		best->whenSaved = millis();
+		f_closedir(&findDir);
+	}
+#endif
+	AbandonFindNext();
+}
+
 #endif
 
 #if HAS_MASS_STORAGE
@@ -1283,6 +1465,33 @@ void MassStorage::Diagnostics(MessageType mtype) noexcept
 	// Show the longest SD card write time
 	platform.MessageF(mtype, "SD card longest read time %.1fms, write time %.1fms, max retries %u\n",
 								(double)DiskioGetAndClearLongestReadTime(), (double)DiskioGetAndClearLongestWriteTime(), DiskioGetAndClearMaxRetryCount());
+
+	// Show the number of single and multiple block transfers on each card. The counts are updated while the volume mutex is held, so we must hold it too.
+	for (size_t card = 0; card < NumSdCards; ++card)
+	{
+		MutexLocker lock(info[card].volMutex, 200);
+		if (lock.IsAcquired())
+		{
+			DiskioTransferCounts counts;
+			DiskioGetAndClearTransferCounts(card, counts);
+			platform.MessageF(mtype, "SD card %u reads %" PRIu32 " single %" PRIu32 " multi, writes %" PRIu32 " single %" PRIu32 " multi, read-aheads %" PRIu32 " hits %" PRIu32 "\n",
+										card, counts.singleBlockReads, counts.multiBlockReads, counts.singleBlockWrites, counts.multiBlockWrites, counts.readAheads, counts.readAheadHits);
+		}
+	}
+	FileStore::Diagnostics(mtype);
+# endif
+# if SUPPORT_FILE_READ_AHEAD
+	FileReadAhead::Diagnostics(mtype);
+# endif
+# if SUPPORT_FILE_INFO_INDEX
+	FileInfoIndex::Diagnostics(mtype);
+# endif
+# if SUPPORT_UPLOAD_WRITE_BEHIND
+	FileWriteBehind::Diagnostics(mtype);
+# endif
+# if SUPPORT_DIRECTORY_CURSORS
+	platform.MessageF(mtype, "Directory listings resumed %" PRIu32 ", restarted %" PRIu32 "\n", findCursorHits, findCursorMisses);
+	findCursorHits = findCursorMisses = 0;
 # endif
 }
 
@@ -1290,6 +1499,15 @@ void MassStorage::Diagnostics(MessageType mtype) noexcept
 
 #if HAS_MASS_STORAGE
 
+# if SUPPORT_FILE_INFO_INDEX
+
+void MassStorage::FileWritten(const char *filePath) noexcept
+{
+	infoParser.FileWritten(filePath);
+}
+
+# endif
+
 // Append the simulated printing time to the end of the file
 void MassStorage::RecordSimulationTime(const char *printingFilePath, uint32_t simSeconds) noexcept
 {
@@ -1335,6 +1553,9 @@ void MassStorage::RecordSimulationTime(const char *printingFilePath, uint32_t si
 		{
 			ok = SetLastModifiedTime(printingFilePath, lastModtime);
 		}
+# if SUPPORT_FILE_INFO_INDEX
+		FileWritten(printingFilePath);									// the file may have the same size and timestamp as before, so make sure we don't use the old information
+# endif
 	}
 
 	if (!ok)
@@ -83,12 +83,14 @@ namespace MassStorage
 	bool FindFirst(const char *_ecv_array directory, FileInfo &file_info) noexcept;
 	bool FindNext(FileInfo &file_info) noexcept;
 	void AbandonFindNext() noexcept;
+	bool FindFirstFrom(const char *_ecv_array directory, FileInfo &file_info, unsigned int& fileNumber) noexcept;
+	void SaveFindPosition(const char *_ecv_array directory, const FileInfo &file_info, unsigned int fileNumber) noexcept;
 	GCodeResult GetFileInfo(const char *_ecv_array filePath, GCodeFileInfo& info, bool quitEarly) noexcept;
 	GCodeResult Mount(size_t card, const StringRef& reply, bool reportSuccess) noexcept;
 	GCodeResult Unmount(size_t card, const StringRef& reply) noexcept;
 	void Diagnostics(MessageType mtype) noexcept;
 
-# if SUPPORT_ASYNC_MOVES
+# if SUPPORT_ASYNC_MOVES || SUPPORT_FILE_READ_AHEAD
 	FileStore *DuplicateOpenHandle(const FileStore *f) noexcept;	// Duplicate a file handle, with the duplicate having its own position in the file. Use only when files opened in read-only mode.
 # endif
 #endif
@@ -106,6 +108,10 @@ namespace MassStorage
 	Mutex& GetVolumeMutex(size_t vol) noexcept;
 	void RecordSimulationTime(const char *_ecv_array printingFilePath, uint32_t simSeconds) noexcept;	// Append the simulated printing time to the end of the file
 	uint16_t GetVolumeSeq(unsigned int volume) noexcept;
+	uint32_t GetStorageSeq() noexcept;														// Return a number that changes whenever any volume changes
+# if SUPPORT_FILE_INFO_INDEX
+	void FileWritten(const char *_ecv_array filePath) noexcept;								// Forget any stored information about a file that has just been written
+# endif
 
 	enum class InfoResult : uint8_t
 	{
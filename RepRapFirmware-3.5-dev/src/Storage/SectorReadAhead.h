@@ -0,0 +1,103 @@
+/*
+ * SectorReadAhead.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: David
+ *
+ * Read-ahead buffer for an SD card, used by the FatFs disk I/O layer.
+ * FatFs reads directory entries, FAT sectors and partial file sectors one sector at a time. When it asks for the sector following the one it last read,
+ * we read several sectors in a single multi-block transfer instead and satisfy the following single-sector reads from this buffer.
+ * This class knows nothing about the card itself and has no dependencies on the rest of the firmware, so that it can be tested on a host.
+ * The caller must serialise all calls for one card, which the FatFs volume mutex does.
+ */
+
+#ifndef SRC_STORAGE_SECTORREADAHEAD_H_
+#define SRC_STORAGE_SECTORREADAHEAD_H_
+
+#include <ecv_duet3d.h>
+#include <General/function_ref.h>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+class SectorReadAhead
+{
+public:
+	typedef uint32_t SectorNumber;									// the same as LBA_t because we don't use FF_LBA64
+
+	static constexpr size_t SectorSize = 512;
+#if SAME70
+	static constexpr size_t NumSectors = 8;
+#else
+	static constexpr size_t NumSectors = 4;
+#endif
+
+	// Function to read the specified sectors from the card, returning false if it can't
+	typedef function_ref_noexcept<bool(uint8_t *_ecv_array buf, SectorNumber sector, unsigned int count) noexcept> ReadFunction;
+
+	SectorReadAhead() noexcept : start(0), numValid(0), nextSector(0), readAheads(0), hits(0) { }
+
+	// Try to satisfy a read from the buffer, reading ahead first if FatFs is reading single sectors sequentially.
+	// Return true if the data has been copied to buff, false if the caller must read it from the card itself.
+	bool Read(SectorNumber sector, unsigned int count, SectorNumber lastSector, uint8_t *_ecv_array buff, ReadFunction readSectors) noexcept;
+
+	void Invalidate() noexcept { numValid = 0; nextSector = 0; }
+	void Invalidate(SectorNumber sector, unsigned int count) noexcept;	// invalidate the buffer if it holds any of the specified sectors
+
+	void GetAndClearCounts(uint32_t& p_readAheads, uint32_t& p_hits) noexcept { p_readAheads = readAheads; p_hits = hits; readAheads = hits = 0; }
+
+private:
+	bool CopySector(SectorNumber sector, uint8_t *_ecv_array buff) const noexcept;
+
+	SectorNumber start;												// the first sector in the buffer
+	unsigned int numValid;											// the number of valid sectors in the buffer
+	SectorNumber nextSector;										// the sector following the last one that FatFs asked for
+	uint32_t readAheads, hits;										// counts for diagnostics
+	alignas(32) uint8_t buffer[NumSectors * SectorSize];			// aligned to cache lines because the SD card driver reads into it using DMA
+};
+
+inline bool SectorReadAhead::CopySector(SectorNumber sector, uint8_t *_ecv_array buff) const noexcept
+{
+	if (sector >= start && sector - start < numValid)
+	{
+		memcpy(buff, buffer + (sector - start) * SectorSize, SectorSize);
+		return true;
+	}
+	return false;
+}
+
+inline bool SectorReadAhead::Read(SectorNumber sector, unsigned int count, SectorNumber lastSector, uint8_t *_ecv_array buff, ReadFunction readSectors) noexcept
+{
+	const bool sequential = (count == 1 && sector == nextSector);
+	nextSector = sector + count;
+	if (count == 1 && CopySector(sector, buff))
+	{
+		++hits;
+		return true;
+	}
+
+	if (sequential)
+	{
+		const unsigned int numSectors = (lastSector - sector < NumSectors) ? lastSector - sector + 1 : NumSectors;
+		numValid = 0;												// the buffer contents will be overwritten even if the read fails
+		if (readSectors(buffer, sector, numSectors))
+		{
+			++readAheads;
+			start = sector;
+			numValid = numSectors;
+			(void)CopySector(sector, buff);
+			return true;
+		}
+	}
+	return false;
+}
+
+inline void SectorReadAhead::Invalidate(SectorNumber sector, unsigned int count) noexcept
+{
+	if (numValid != 0 && sector < start + numValid && sector + count > start)
+	{
+		numValid = 0;
+	}
+}
+
+#endif /* SRC_STORAGE_SECTORREADAHEAD_H_ */
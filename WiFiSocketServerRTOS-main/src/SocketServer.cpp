@@ -1206,6 +1206,7 @@ void ProcessRequest()
 				}
 
 				response->freeHeap = esp_get_free_heap_size();
+				response->maxSocketDataLength = MaxDataLength;
 
 #ifdef ESP8266
 				response->vcc = esp_wifi_get_vdd33();
@@ -272,6 +272,10 @@ struct NetworkStatusResponse
 			ht:	2,					// HT20, HT40 above, HT40 below
 			zero3: 2;				// unused, set to zero
 	uint8_t zero4;					// unused, set to zero
+
+	// Added at version 2.2
+	uint16_t maxSocketDataLength;	// the maximum data length that the module accepts in connRead and connWrite commands, at least MaxDataLength
+	uint16_t zero5;					// unused, set to zero
 };
 
 constexpr size_t MinimumStatusResponseLength = offsetof(NetworkStatusResponse, clockReg);		// valid status responses should be at least this long